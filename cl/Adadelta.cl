@@ -0,0 +1,31 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// one Adadelta step, reading and writing each element of the weights and
+// the state once, see Adadelta::updateWeightsCpu
+kernel void updateWeights(
+        const int N,
+        const float decay,
+        global float *weights,
+        global const float *gradWeights,
+        global float *sumGradSquared,
+        global float *sumUpdateSquared
+            ) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    const float grad = gradWeights[globalId];
+    const float newSumGradSquared = decay * sumGradSquared[globalId] + (1 - decay) * grad * grad;
+    const float oldSumUpdateSquared = sumUpdateSquared[globalId];
+    // a zero gradient gives a zero update, even once the sums have decayed
+    // to zero, eg in the padding of a ParameterArena
+    const float update = grad == 0 ? 0.0f : - sqrt(oldSumUpdateSquared / newSumGradSquared) * grad;
+    sumGradSquared[globalId] = newSumGradSquared;
+    weights[globalId] += update;
+    sumUpdateSquared[globalId] = decay * oldSumUpdateSquared + (1 - decay) * update * update;
+}
+
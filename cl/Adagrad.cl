@@ -0,0 +1,29 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// one Adagrad step, reading and writing each element of the weights and
+// the state once, see Adagrad::updateWeightsCpu
+kernel void updateWeights(
+        const int N,
+        const float learningRate,
+        global float *weights,
+        global const float *gradWeights,
+        global float *sumSquares
+            ) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    const float grad = gradWeights[globalId];
+    const float newSumSquares = sumSquares[globalId] + grad * grad;
+    sumSquares[globalId] = newSumSquares;
+    // a zero gradient leaves the weight alone, even with no sum of squares
+    // yet to divide by, eg in the padding of a ParameterArena
+    if (grad != 0) {
+        weights[globalId] -= learningRate * grad / sqrt(newSumSquares);
+    }
+}
+
@@ -71,3 +71,80 @@ kernel void col2im(
   }
 }
 
+// several images at once, so a single gemm can cover them all: the column
+// matrix has numImages * {{colSize}} * {{colSize}} values per row, and image b's
+// columns start at b * {{colSize}} * {{colSize}} in each row
+kernel void im2col_batched(
+    const int n, const int numImages,
+    global float const * im_data, int im_offset,
+    global float* data_col) {
+  const int imageColSize = {{colSize}} * {{colSize}};
+  const int rowStride = numImages * imageColSize;
+  CL_KERNEL_LOOP(index, n) {
+    int w_out = index % {{colSize}};
+    int rest = index / {{colSize}};
+    int h_out = rest % {{colSize}};
+    rest /= {{colSize}};
+    int channel_in = rest % {{channels}};
+    int image = rest / {{channels}};
+    int channel_out = channel_in * {{filterSize}} * {{filterSize}};
+    int h_in = h_out * {{stride}} - {{padding}};
+    int w_in = w_out * {{stride}} - {{padding}};
+    global float *col = data_col + channel_out * rowStride + image * imageColSize + h_out * {{colSize}} + w_out;
+    global const float *im = im_data + im_offset + ((image * {{channels}} + channel_in) * {{size}} + h_in) * {{size}} + w_in;
+    for (int i = 0; i < {{filterSize}}; ++i) {
+      for (int j = 0; j < {{filterSize}}; ++j) {
+        int h = h_in + i;
+        int w = w_in + j;
+        *col = (h >= 0 && w >= 0 && h < {{size}} && w < {{size}}) ?
+          im[i * {{size}} + j] : 0;
+        col += rowStride;
+      }
+    }
+  }
+}
+
+// inverse of im2col_batched: sums each image's columns back into numImages images
+kernel void col2im_batched(
+    const int n, const int numImages,
+    global float const *data_col,
+    global float* im_data, int im_offset) {
+  const int imageColSize = {{colSize}} * {{colSize}};
+  const int rowStride = numImages * imageColSize;
+  CL_KERNEL_LOOP(index, n) {
+    float val = 0;
+    int w = index % {{size}} + {{padding}};
+    int h = (index / {{size}}) % {{size}} + {{padding}};
+    int c = (index / ({{size}} * {{size}})) % {{channels}};
+    int image = index / ({{size}} * {{size}} * {{channels}});
+    int w_col_start = (w < {{filterSize}}) ? 0 : (w - {{filterSize}}) / {{stride}} + 1;
+    int w_col_end = min(w / {{stride}} + 1, {{colSize}});
+    int h_col_start = (h < {{filterSize}}) ? 0 : (h - {{filterSize}}) / {{stride}} + 1;
+    int h_col_end = min(h / {{stride}} + 1, {{colSize}});
+    global float const *col = data_col + image * imageColSize;
+    for (int h_col = h_col_start; h_col < h_col_end; ++h_col) {
+      for (int w_col = w_col_start; w_col < w_col_end; ++w_col) {
+        int row = (c * {{filterSize}} + h - h_col * {{stride}}) * {{filterSize}} + w - w_col * {{stride}};
+        val += col[row * rowStride + h_col * {{colSize}} + w_col];
+      }
+    }
+    im_data[im_offset + index] = val;
+  }
+}
+
+// out[j][i][k] = in[i][j][k], for i < dim0, j < dim1, k < inner
+// moves between the [image][filter][pixel] layout of the layer outputs, and
+// the [filter][image][pixel] layout that a batched gemm reads and writes
+kernel void swap_outer_dims(
+    const int n, const int dim0, const int dim1, const int inner,
+    global float const *in_data, int in_offset,
+    global float *out_data, int out_offset) {
+  CL_KERNEL_LOOP(index, n) {
+    int k = index % inner;
+    int rest = index / inner;
+    int j = rest % dim1;
+    int i = rest / dim1;
+    out_data[out_offset + (j * dim0 + i) * inner + k] = in_data[in_offset + index];
+  }
+}
+
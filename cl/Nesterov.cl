@@ -0,0 +1,44 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// the two halves of a Nesterov step, each reading and writing each element
+// once, see Nesterov::loadFutureWeightsCpu and Nesterov::updateWeightsCpu
+
+// saves the weights, then adds momentum * gradWeights to them
+kernel void loadFutureWeights(
+        const int N,
+        const float momentum,
+        global float *weights,
+        global const float *gradWeights,
+        global float *oldWeights
+            ) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    const float weight = weights[globalId];
+    oldWeights[globalId] = weight;
+    weights[globalId] = momentum * gradWeights[globalId] + weight;
+}
+
+kernel void updateWeights(
+        const int N,
+        const float learningRate,
+        const float momentum,
+        global float *weights,
+        global const float *gradWeights,
+        global float *lastUpdate,
+        global const float *oldWeights
+            ) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    const float newLastUpdate = momentum * lastUpdate[globalId] - learningRate * gradWeights[globalId];
+    lastUpdate[globalId] = newLastUpdate;
+    weights[globalId] = oldWeights[globalId] + newLastUpdate;
+}
+
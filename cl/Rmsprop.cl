@@ -0,0 +1,29 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// one Rmsprop step, reading and writing each element of the weights and
+// the state once, see Rmsprop::updateWeightsCpu
+kernel void updateWeights(
+        const int N,
+        const float learningRate,
+        global float *weights,
+        global const float *gradWeights,
+        global float *meanSquare
+            ) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    const float grad = gradWeights[globalId];
+    const float newMeanSquare = 0.9f * meanSquare[globalId] + 0.1f * grad * grad;
+    meanSquare[globalId] = newMeanSquare;
+    // a zero gradient leaves the weight alone, even once the mean square has
+    // decayed to zero, eg in the padding of a ParameterArena
+    if (grad != 0) {
+        weights[globalId] -= learningRate * grad / sqrt(newMeanSquare);
+    }
+}
+
@@ -0,0 +1,68 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// the activation that follows a convolution, folded into the convolution's
+// own passes over its output, see ConvEpilogue
+
+// expected defines:
+// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ]
+// BIASED, if there is a bias to add before the activation
+// same functions as activate.cl and applyActivationDeriv.cl
+
+#ifdef TANH
+    #define ACTIVATION_FUNCTION(output) (tanh(output))
+    #define ACTIVATION_DERIV(output) (1 - output * output)
+#elif defined SCALEDTANH
+    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))
+    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )
+#elif defined SIGMOID
+    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))
+    #define ACTIVATION_DERIV(output) (output * (1 - output) )
+#elif defined RELU
+    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)
+    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)
+#elif defined ELU
+    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)
+    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)
+#elif defined LINEAR
+    #define ACTIVATION_FUNCTION(output) (output)
+    #define ACTIVATION_DERIV(output) (1.0f)
+#endif
+
+#ifdef ACTIVATION_FUNCTION // protect against not defined
+// output = activation(output + bias[filter]), in place, in one pass
+kernel void biasAndActivate(
+        const int N,
+        const int numFilters,
+        const int outputSizeSquared,
+        global float *output,
+        global const float *bias) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    float value = output[globalId];
+    #ifdef BIASED
+    value += bias[(globalId / outputSizeSquared) % numFilters];
+    #endif
+    output[globalId] = ACTIVATION_FUNCTION(value);
+}
+
+// gradient wrt the pre-activation values, from the activated output, and
+// the gradient wrt the activated output
+kernel void activationDeriv(
+        const int N,
+        global const float *output,
+        global const float *gradOutput,
+        global float *gradPreActivation) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    gradPreActivation[globalId] = ACTIVATION_DERIV(output[globalId]) * gradOutput[globalId];
+}
+#endif
+
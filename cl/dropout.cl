@@ -4,27 +4,80 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+// masks are bitmasks: bit (i % 32) of mask[i / 32] is 1 if element i is kept
+// see src/dropout/DropoutMasks.h, which does the same as forwardGenerate,
+// on the host
+
+// Philox4x32-10, Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"
+uint4 philox4x32(uint4 counter, uint2 key) {
+    for (int round = 0; round < 10; round++) {
+        uint hi0 = mul_hi(0xD2511F53u, counter.x);
+        uint lo0 = 0xD2511F53u * counter.x;
+        uint hi1 = mul_hi(0xCD9E8D57u, counter.z);
+        uint lo1 = 0xCD9E8D57u * counter.z;
+        counter = (uint4)(hi1 ^ counter.y ^ key.x, lo1, hi0 ^ counter.w ^ key.y, lo0);
+        key += (uint2)(0x9E3779B9u, 0xBB67AE85u);
+    }
+    return counter;
+}
+
+// one work item per mask word, ie per 32 elements: makes the mask word, from
+// 8 philox calls, writes it, for backward, and applies it
+// an element is dropped if the top 24 bits of its random number are below
+// dropThreshold
+kernel void forwardGenerate(
+        const int N,
+        const int seed,
+        const int batchCounter,
+        const int dropThreshold,
+        global int *mask,
+        global const float *input,
+        global float *output) {
+    const int word = get_global_id(0);
+    if (word * 32 >= N) {
+        return;
+    }
+    const uint2 key = (uint2)((uint)seed, 0);
+    uint bits = 0;
+    for (int q = 0; q < 8; q++) {
+        uint4 random = philox4x32((uint4)((uint)(word * 8 + q), (uint)batchCounter, 0, 0), key);
+        bits |= ((random.x >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4);
+        bits |= ((random.y >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 1);
+        bits |= ((random.z >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 2);
+        bits |= ((random.w >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 3);
+    }
+    const int first = word * 32;
+    const int count = min(32, N - first);
+    if (count < 32) {
+        bits &= (1u << count) - 1;
+    }
+    mask[word] = (int)bits;
+    for (int b = 0; b < count; b++) {
+        output[first + b] = ((bits >> b) & 1) ? input[first + b] : 0.0f;
+    }
+}
+
 kernel void forwardNaive(
         const int N, 
-        global const unsigned char *mask,
+        global const int *mask,
         global const float *input,
         global float *output) {
     const int globalId = get_global_id(0);
     if (globalId >= N) {
         return;
     }
-    output[globalId] = mask[globalId] == 1 ? input[globalId] : 0.0f;
+    output[globalId] = (((uint)mask[globalId >> 5] >> (globalId & 31)) & 1) ? input[globalId] : 0.0f;
 }
 
 kernel void backpropNaive(
         const int N,
-        global const unsigned char *mask,
+        global const int *mask,
         global const float *gradOutput,
         global float *output) {
     const int globalId = get_global_id(0);
     if (globalId >= N) {
         return;
     }
-    output[globalId] = mask[globalId] == 1 ? gradOutput[globalId] : 0.0f;
+    output[globalId] = (((uint)mask[globalId >> 5] >> (globalId & 31)) & 1) ? gradOutput[globalId] : 0.0f;
 }
 
@@ -0,0 +1,198 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// FFT convolution: planes are zero-padded into {{fftSize}} x {{fftSize}}
+// complex planes, transformed, multiplied pointwise, summed, and transformed
+// back.  {{fftSize}} is a power of 2, large enough that the circular
+// convolutions never wrap round onto the part of the result that is kept
+//
+// complex planes are [plane][row][col] float2s, {{fftSize}} x {{fftSize}} each
+// each work item transforms one whole row, or column, in private memory,
+// using an iterative radix-2 fft
+
+#define N {{fftSize}}
+#define LOG2_N {{log2FftSize}}
+
+// CL: grid stride looping
+#define CL_KERNEL_LOOP(i, n)                        \
+  for (int i = get_group_id(0) * get_local_size(0) + get_local_id(0); \
+      i < (n);                                       \
+      i += get_local_size(0) * get_num_groups(0))
+
+// in place; sign is -1 for the forward transform, +1 for the inverse, which
+// is left unscaled
+void fft_private(float2 *buf, const float sign) {
+  for (int i = 0; i < N; i++) {
+    int j = 0;
+    int v = i;
+    for (int b = 0; b < LOG2_N; b++) {
+      j = (j << 1) | (v & 1);
+      v >>= 1;
+    }
+    if (i < j) {
+      float2 t = buf[i];
+      buf[i] = buf[j];
+      buf[j] = t;
+    }
+  }
+  for (int len = 2; len <= N; len <<= 1) {
+    int half = len >> 1;
+    float angleStep = sign * 2.0f * M_PI_F / len;
+    for (int k = 0; k < half; k++) {
+      float c;
+      float s = sincos(angleStep * k, &c);
+      for (int start = 0; start < N; start += len) {
+        float2 u = buf[start + k];
+        float2 v = buf[start + k + half];
+        float2 t = (float2)(v.x * c - v.y * s, v.x * s + v.y * c);
+        buf[start + k] = u + t;
+        buf[start + k + half] = u - t;
+      }
+    }
+  }
+}
+
+// real planeSize x planeSize planes, placed at (shift, shift) in the padded
+// planes, and transformed along the rows
+// n = numPlanes * N
+kernel void fft_rows_from_real(
+    const int n,
+    global const float *real, int realOffset,
+    const int planeSize, const int shift,
+    global float2 *freq) {
+  CL_KERNEL_LOOP(index, n) {
+    int row = index % N;
+    int plane = index / N;
+    global float2 *dst = freq + (plane * N + row) * N;
+    int srcRow = row - shift;
+    if (srcRow < 0 || srcRow >= planeSize) {
+      for (int x = 0; x < N; x++) {
+        dst[x] = (float2)(0.0f, 0.0f);
+      }
+      continue;
+    }
+    global const float *src = real + realOffset + (plane * planeSize + srcRow) * planeSize;
+    float2 buf[N];
+    for (int x = 0; x < N; x++) {
+      int srcCol = x - shift;
+      buf[x] = (float2)((srcCol >= 0 && srcCol < planeSize) ? src[srcCol] : 0.0f, 0.0f);
+    }
+    fft_private(buf, -1.0f);
+    for (int x = 0; x < N; x++) {
+      dst[x] = buf[x];
+    }
+  }
+}
+
+// n = numPlanes * N
+kernel void fft_columns(
+    const int n, const float sign,
+    global float2 *freq) {
+  CL_KERNEL_LOOP(index, n) {
+    int col = index % N;
+    int plane = index / N;
+    global float2 *p = freq + plane * N * N + col;
+    float2 buf[N];
+    for (int y = 0; y < N; y++) {
+      buf[y] = p[y * N];
+    }
+    fft_private(buf, sign);
+    for (int y = 0; y < N; y++) {
+      p[y * N] = buf[y];
+    }
+  }
+}
+
+// inverse transforms rows start to start + outSize - 1, of planes whose
+// columns have already been inverse transformed, and writes out the
+// outSize x outSize real block starting at (start, start), scaled by 1 / N^2
+// n = numPlanes * outSize
+kernel void fft_rows_to_real(
+    const int n,
+    global const float2 *freq,
+    const int start, const int outSize,
+    global float *real, int realOffset) {
+  const float scale = 1.0f / (N * N);
+  CL_KERNEL_LOOP(index, n) {
+    int row = index % outSize;
+    int plane = index / outSize;
+    global const float2 *src = freq + (plane * N + row + start) * N;
+    float2 buf[N];
+    for (int x = 0; x < N; x++) {
+      buf[x] = src[x];
+    }
+    fft_private(buf, 1.0f);
+    global float *dst = real + realOffset + (plane * outSize + row) * outSize;
+    for (int x = 0; x < outSize; x++) {
+      dst[x] = buf[x + start].x * scale;
+    }
+  }
+}
+
+// out[i][j] = sum over s of a[i * aStrideI + j * aStrideJ + s * aStrideS] *
+//     b[i * bStrideI + j * bStrideJ + s * bStrideS], pointwise, where each
+// index picks out a whole complex plane
+// conjugateB turns the convolution into a correlation; accumulate adds onto
+// what is already in out
+// n = numI * numJ * N * N
+kernel void fft_multiply_accumulate(
+    const int n, const int numJ, const int numS,
+    const int aStrideI, const int aStrideJ, const int aStrideS,
+    const int bStrideI, const int bStrideJ, const int bStrideS,
+    const int conjugateB, const int accumulate,
+    global const float2 *a, global const float2 *b,
+    global float2 *out) {
+  const int planeArea = N * N;
+  CL_KERNEL_LOOP(index, n) {
+    int k = index % planeArea;
+    int rest = index / planeArea;
+    int j = rest % numJ;
+    int i = rest / numJ;
+    global const float2 *aPlane = a + (i * aStrideI + j * aStrideJ) * planeArea + k;
+    global const float2 *bPlane = b + (i * bStrideI + j * bStrideJ) * planeArea + k;
+    float2 sum = accumulate ? out[index] : (float2)(0.0f, 0.0f);
+    for (int s = 0; s < numS; s++) {
+      float2 x = aPlane[s * aStrideS * planeArea];
+      float2 y = bPlane[s * bStrideS * planeArea];
+      if (conjugateB) {
+        y.y = -y.y;
+      }
+      sum += (float2)(x.x * y.x - x.y * y.y, x.x * y.y + x.y * y.x);
+    }
+    out[index] = sum;
+  }
+}
+
+// the dc term of a transformed plane is the sum of the original plane
+// sums[plane] += sum over images of that, for freq laid out [image][plane]
+kernel void fft_add_dc(
+    const int numPlanes, const int numImages,
+    global const float2 *freq,
+    global float *sums) {
+  CL_KERNEL_LOOP(plane, numPlanes) {
+    float sum = 0.0f;
+    for (int image = 0; image < numImages; image++) {
+      sum += freq[(image * numPlanes + plane) * N * N].x;
+    }
+    sums[plane] += sum;
+  }
+}
+
+// copies weights into snapshot, and sets changed[0] to 1 if they differed
+kernel void fft_snapshot_changed(
+    const int n,
+    global const float *weights,
+    global float *snapshot,
+    global int *changed) {
+  CL_KERNEL_LOOP(i, n) {
+    float w = weights[i];
+    if (w != snapshot[i]) {
+      snapshot[i] = w;
+      changed[0] = 1;
+    }
+  }
+}
+
@@ -60,6 +60,10 @@
 //     - loads a whole upstream cube
 //     - loads a whole filter cube
 //     - writes one output...
+// with gSkip > 0, output (row, col) reads from input (row, col) * (gSkip + 1)
+
+#define gStride (gSkip + 1)
+
 void kernel convolve_imagecubes_float2(
     const int numExamples,
       global const float *inputs, global const float *filters, 
@@ -86,9 +90,9 @@ void kernel convolve_imagecubes_float2(
             for (int u = -gHalfFilterSize; u <= gHalfFilterSize - gEven; u++) {
                 // trying to reduce register pressure...
                 #if gPadZeros == 1
-                    #define inputRowIdx (outputRow + u)
+                    #define inputRowIdx (outputRow * gStride + u)
                 #else
-                    #define inputRowIdx (outputRow + u + gHalfFilterSize)
+                    #define inputRowIdx (outputRow * gStride + u + gHalfFilterSize)
                 #endif
                 global float const *inputRow = inputPlane + inputRowIdx * gInputSize;
                 global float const *filterRow = filterPlane + (u+gHalfFilterSize) * gFilterSize + gHalfFilterSize;
@@ -96,9 +100,9 @@ void kernel convolve_imagecubes_float2(
                 #pragma unroll
                 for (int v = -gHalfFilterSize; v <= gHalfFilterSize - gEven; v++) {
                     #if gPadZeros == 1
-                        #define inputColIdx (outputCol + v)
+                        #define inputColIdx (outputCol * gStride + v)
                     #else
-                        #define inputColIdx (outputCol + v + gHalfFilterSize)
+                        #define inputColIdx (outputCol * gStride + v + gHalfFilterSize)
                     #endif
                     bool process = rowOk && inputColIdx >= 0 && inputColIdx < gInputSize;
                     if (process) {
@@ -0,0 +1,20 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// same sums, in the same order, as NormalizationHelper::translateAndScale
+kernel void translateAndScale(
+        const int N,
+        const float translate,
+        const float scale,
+        global const float *in,
+        global float *out) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    out[globalId] = (in[globalId] + translate) * scale;
+}
+
@@ -0,0 +1,104 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// the input is numVectors contiguous vectors, of vectorSize values each, and
+// each vector gets its own softmax: one per plane, for perPlane, otherwise
+// one per example, over the planes
+
+// one work item per vector
+kernel void softmaxForward(
+        const int numVectors,
+        const int vectorSize,
+        global const float *input,
+        global float *output) {
+    const int vectorId = get_global_id(0);
+    if (vectorId >= numVectors) {
+        return;
+    }
+    global const float *in = input + vectorId * vectorSize;
+    global float *out = output + vectorId * vectorSize;
+    float maxValue = in[0];
+    for (int i = 1; i < vectorSize; i++) {
+        maxValue = max(maxValue, in[i]);
+    }
+    float denominator = 0;
+    for (int i = 0; i < vectorSize; i++) {
+        denominator += exp(in[i] - maxValue);
+    }
+    for (int i = 0; i < vectorSize; i++) {
+        out[i] = exp(in[i] - maxValue) / denominator;
+    }
+}
+
+// a single workgroup, whose size is a power of two, strides over the vectors,
+// and, for each, does the softmax, as softmaxForward, then the gradient,
+// output minus one-hot label, the cross-entropy loss, -log(output[label]),
+// and whether the largest output is at the label
+// the losses and the counts are summed across the workgroup, so only those
+// two totals need to go back to the host
+// if inputIsSoftmax, input already holds the probabilities, and is output
+kernel void softmaxLossFromLabels(
+        const int numVectors,
+        const int vectorSize,
+        const int inputIsSoftmax,
+        global const int *labels,
+        global const float *input,
+        global float *output,
+        global float *gradInput,
+        global float *lossTotal,
+        global int *numRightTotal,
+        local float *losses,
+        local int *numRights) {
+    const int localId = get_local_id(0);
+    const int workgroupSize = get_local_size(0);
+    float loss = 0;
+    int numRight = 0;
+    for (int vectorId = localId; vectorId < numVectors; vectorId += workgroupSize) {
+        global const float *in = input + vectorId * vectorSize;
+        global float *out = output + vectorId * vectorSize;
+        global float *grad = gradInput + vectorId * vectorSize;
+        const int label = labels[vectorId];
+        float maxValue = in[0];
+        float denominator = 1;
+        if (!inputIsSoftmax) {
+            for (int i = 1; i < vectorSize; i++) {
+                maxValue = max(maxValue, in[i]);
+            }
+            denominator = 0;
+            for (int i = 0; i < vectorSize; i++) {
+                denominator += exp(in[i] - maxValue);
+            }
+        }
+        float bestValue = -1;
+        int best = 0;
+        for (int i = 0; i < vectorSize; i++) {
+            float value = inputIsSoftmax ? in[i] : exp(in[i] - maxValue) / denominator;
+            out[i] = value;
+            grad[i] = i == label ? value - 1.0f : value;
+            if (value > bestValue) {
+                bestValue = value;
+                best = i;
+            }
+        }
+        loss -= log(out[label]);
+        numRight += best == label ? 1 : 0;
+    }
+    losses[localId] = loss;
+    numRights[localId] = numRight;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int offset = workgroupSize >> 1; offset > 0; offset >>= 1) {
+        if (localId < offset) {
+            losses[localId] += losses[localId + offset];
+            numRights[localId] += numRights[localId + offset];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    if (localId == 0) {
+        lossTotal[0] = losses[0];
+        numRightTotal[0] = numRights[0];
+    }
+}
+
@@ -0,0 +1,153 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// Winograd F(2x2,3x3) convolution, as in Lavin and Gray, "Fast Algorithms for
+// Convolutional Neural Networks":
+//     Y = A^T [ (G g G^T) .* (B^T d B) ] A
+// for each 2x2 output tile Y, its 4x4 input patch d, and 3x3 filter g
+// the elementwise product, summed over the input planes, becomes 16 gemms,
+// one per element xi of the 4x4 transformed tiles, which are done in between
+// these kernels, using clblas
+//
+// layouts:
+//   U: [xi][filter][inputplane]     transformed filters
+//   V: [xi][inputplane][tile]       transformed input patches
+//   M: [xi][filter][tile]           gemm results
+// tile runs over all the images in the chunk: image * {{tiles}}^2 + tilerow * {{tiles}} + tilecol
+//
+// {{flip}} == 1 transforms the filters for the backward pass, ie rotated by
+// 180 degrees, with the filter and input plane axes swapped
+
+// CL: grid stride looping
+#define CL_KERNEL_LOOP(i, n)                        \
+  for (int i = get_group_id(0) * get_local_size(0) + get_local_id(0); \
+      i < (n);                                       \
+      i += get_local_size(0) * get_num_groups(0))
+
+kernel void winograd_filter_transform(
+    const int n,
+    global const float *weights,
+    global float *U) {
+  CL_KERNEL_LOOP(index, n) {
+    int inPlane = index % {{inputPlanes}};
+    int filter = index / {{inputPlanes}};
+    float g[3][3];
+    for (int r = 0; r < 3; r++) {
+      for (int s = 0; s < 3; s++) {
+#if {{flip}} == 1
+        g[r][s] = weights[(inPlane * {{numFilters}} + filter) * 9 + (2 - r) * 3 + (2 - s)];
+#else
+        g[r][s] = weights[(filter * {{inputPlanes}} + inPlane) * 9 + r * 3 + s];
+#endif
+      }
+    }
+    // G g
+    float Gg[4][3];
+    for (int s = 0; s < 3; s++) {
+      Gg[0][s] = g[0][s];
+      Gg[1][s] = 0.5f * (g[0][s] + g[1][s] + g[2][s]);
+      Gg[2][s] = 0.5f * (g[0][s] - g[1][s] + g[2][s]);
+      Gg[3][s] = g[2][s];
+    }
+    // (G g) G^T
+    const int xiStride = {{numFilters}} * {{inputPlanes}};
+    global float *dst = U + filter * {{inputPlanes}} + inPlane;
+    for (int r = 0; r < 4; r++) {
+      dst[(r * 4 + 0) * xiStride] = Gg[r][0];
+      dst[(r * 4 + 1) * xiStride] = 0.5f * (Gg[r][0] + Gg[r][1] + Gg[r][2]);
+      dst[(r * 4 + 2) * xiStride] = 0.5f * (Gg[r][0] - Gg[r][1] + Gg[r][2]);
+      dst[(r * 4 + 3) * xiStride] = Gg[r][2];
+    }
+  }
+}
+
+kernel void winograd_input_transform(
+    const int n, const int numImages,
+    global const float *images, int imagesOffset,
+    global float *V) {
+  const int tilesSquared = {{tiles}} * {{tiles}};
+  const int numTiles = numImages * tilesSquared;
+  CL_KERNEL_LOOP(index, n) {
+    int tile = index % tilesSquared;
+    int rest = index / tilesSquared;
+    int plane = rest % {{inputPlanes}};
+    int image = rest / {{inputPlanes}};
+    int row0 = (tile / {{tiles}}) * 2 - {{padding}};
+    int col0 = (tile % {{tiles}}) * 2 - {{padding}};
+    global const float *src = images + imagesOffset + (image * {{inputPlanes}} + plane) * {{inputSize}} * {{inputSize}};
+    float d[4][4];
+    for (int r = 0; r < 4; r++) {
+      int row = row0 + r;
+      for (int c = 0; c < 4; c++) {
+        int col = col0 + c;
+        d[r][c] = (row >= 0 && col >= 0 && row < {{inputSize}} && col < {{inputSize}}) ?
+          src[row * {{inputSize}} + col] : 0;
+      }
+    }
+    // B^T d
+    float t[4][4];
+    for (int c = 0; c < 4; c++) {
+      t[0][c] = d[0][c] - d[2][c];
+      t[1][c] = d[1][c] + d[2][c];
+      t[2][c] = d[2][c] - d[1][c];
+      t[3][c] = d[1][c] - d[3][c];
+    }
+    // (B^T d) B
+    const int xiStride = {{inputPlanes}} * numTiles;
+    global float *dst = V + plane * numTiles + image * tilesSquared + tile;
+    for (int r = 0; r < 4; r++) {
+      dst[(r * 4 + 0) * xiStride] = t[r][0] - t[r][2];
+      dst[(r * 4 + 1) * xiStride] = t[r][1] + t[r][2];
+      dst[(r * 4 + 2) * xiStride] = t[r][2] - t[r][1];
+      dst[(r * 4 + 3) * xiStride] = t[r][1] - t[r][3];
+    }
+  }
+}
+
+kernel void winograd_output_transform(
+    const int n, const int numImages,
+    global const float *M,
+    global float *output, int outputOffset) {
+  const int tilesSquared = {{tiles}} * {{tiles}};
+  const int numTiles = numImages * tilesSquared;
+  CL_KERNEL_LOOP(index, n) {
+    int tile = index % tilesSquared;
+    int rest = index / tilesSquared;
+    int filter = rest % {{numFilters}};
+    int image = rest / {{numFilters}};
+    const int xiStride = {{numFilters}} * numTiles;
+    global const float *src = M + filter * numTiles + image * tilesSquared + tile;
+    float m[4][4];
+    for (int r = 0; r < 4; r++) {
+      for (int c = 0; c < 4; c++) {
+        m[r][c] = src[(r * 4 + c) * xiStride];
+      }
+    }
+    // A^T m
+    float t[2][4];
+    for (int c = 0; c < 4; c++) {
+      t[0][c] = m[0][c] + m[1][c] + m[2][c];
+      t[1][c] = m[1][c] - m[2][c] - m[3][c];
+    }
+    // (A^T m) A, written out, except where the tile overhangs the output
+    int row0 = (tile / {{tiles}}) * 2;
+    int col0 = (tile % {{tiles}}) * 2;
+    global float *dst = output + outputOffset + (image * {{numFilters}} + filter) * {{outputSize}} * {{outputSize}};
+    for (int r = 0; r < 2; r++) {
+      int row = row0 + r;
+      if (row >= {{outputSize}}) {
+        continue;
+      }
+      float y0 = t[r][0] + t[r][1] + t[r][2];
+      float y1 = t[r][1] - t[r][2] - t[r][3];
+      dst[row * {{outputSize}} + col0] = y0;
+      if (col0 + 1 < {{outputSize}}) {
+        dst[row * {{outputSize}} + col0 + 1] = y1;
+      }
+    }
+  }
+}
+
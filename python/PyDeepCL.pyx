@@ -10,6 +10,7 @@ from cpython cimport array as c_array
 from array import array
 import threading
 from libcpp cimport bool
+from libc.stdlib cimport malloc, free
 import platform
 
 cimport CppRuntimeBoundary
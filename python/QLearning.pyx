@@ -16,6 +16,37 @@ cdef class QLearner:
         self.thisptr.setMaxSamples( maxSamples )
     def setEpsilon( self, float epsilon ):
         self.thisptr.setEpsilon( epsilon )
+    def setReplayCapacity( self, int replayCapacity ):
+        self.thisptr.setReplayCapacity( replayCapacity )
+    def setPrioritizedReplay( self, bool prioritizedReplay ):
+        self.thisptr.setPrioritizedReplay( prioritizedReplay )
+    def setNumEnvironments( self, int numEnvironments ):
+        self.thisptr.setNumEnvironments( numEnvironments )
+    def getNumEnvironments( self ):
+        return self.thisptr.getNumEnvironments()
+    def getPerceptionCubeSize( self ):
+        return self.thisptr.getPerceptionCubeSize()
+    def stepAll( self, const float[:] lastRewards, wasResets, const float[:] perceptions ):
+        # one step in each environment, without callbacks: pass in what each
+        # one got for its last action, whether it was reset, and all their
+        # perceptions, one after the other, and get back an action for each
+        cdef int numEnvironments = self.thisptr.getNumEnvironments()
+        if len(lastRewards) != numEnvironments or len(wasResets) != numEnvironments:
+            raise Exception('need one lastReward and wasReset per environment, ie ' + str(numEnvironments))
+        cdef int perceptionCubeSize = self.thisptr.getPerceptionCubeSize()
+        if len(perceptions) != numEnvironments * perceptionCubeSize:
+            raise Exception('need planes * size * size perception values per environment, ie ' +
+                str(numEnvironments * perceptionCubeSize) + ', not ' + str(len(perceptions)))
+        cdef c_array.array actionsArray = array(intArrayType, [0] * numEnvironments)
+        cdef int[:] actions = actionsArray
+        cdef bool *cWasResets = <bool *>malloc(numEnvironments * sizeof(bool))
+        for i in range(numEnvironments):
+            cWasResets[i] = wasResets[i]
+        try:
+            self.thisptr.stepAll(&lastRewards[0], cWasResets, &perceptions[0], &actions[0])
+        finally:
+            free(cWasResets)
+        return actionsArray
     # def setLearningRate( self, float learningRate ):
     #     self.thisptr.setLearningRate( learningRate )
 
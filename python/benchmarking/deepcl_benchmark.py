@@ -49,6 +49,13 @@ runs = [
       'filterSize': 3, # filter size
       'inputSize': 13, # input size
       'batchSize': 128, # batchsize
+   },
+   {
+      'inputPlanes': 128, # maddison-style 3x3 layers, as used by the go nets
+      'outputPlanes': 128,
+      'filterSize': 3,
+      'inputSize': 19,
+      'batchSize': 128,
    }
 ]
 
@@ -31,6 +31,7 @@ runs = [
     ('soumith4', '128i16-128c7', 'layer'),
     ('soumith5', '384i13-384c3', 'layer'),
     ('maddison-convolve', '128i19-128c3', 'layer'),
+    ('maddison-convolve-padded', '128i19-128c3z', 'layer'),
     ('maddison-fc', '128i19-361n', 'layer'),
     ('mnist-c1', '1i28-8c5', 'layer'),
     ('mnist-c2', '8i14-16c5', 'layer'),
@@ -69,9 +70,10 @@ def time_layer(num_epochs, label, batch_size, net_string):
                           # this layer
     print( net.asString() )
     if 'c' in layer_string:
-        num_filters, filter_size = map(lambda x: int(x), layer_string.split('c'))
+        pad_zeros = layer_string.endswith('z')
+        num_filters, filter_size = map(lambda x: int(x), layer_string.rstrip('z').split('c'))
         net.addLayer( PyDeepCL.ConvolutionalMaker().numFilters(num_filters)
-            .filterSize(filter_size).biased() )
+            .filterSize(filter_size).padZeros(pad_zeros).biased() )
     elif 'n' in layer_string:
         num_neurons = int(layer_string.split('n')[0])
         net.addLayer( PyDeepCL.FullyConnectedMaker().numPlanes(num_neurons).imageSize(1).biased() )
@@ -5,6 +5,12 @@ cdef extern from "qlearning/QLearner.h":
         void setLambda( float thislambda )
         void setMaxSamples( int maxSamples )
         void setEpsilon( float epsilon )
+        void setReplayCapacity( int replayCapacity ) except +
+        void setPrioritizedReplay( bool prioritizedReplay )
+        void setNumEnvironments( int numEnvironments ) except +
+        int getNumEnvironments()
+        int getPerceptionCubeSize()
+        void stepAll( const float *lastRewards, const bool *wasResets, const float *perceptions, int *actions ) except +
         # void setLearningRate( float learningRate )
 
 cdef extern from "CyScenario.h":
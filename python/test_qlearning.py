@@ -228,6 +228,12 @@ def go():
     # qlearner.setMaxSamples(32)
     # probability of exploring, instead of exploiting
     # qlearner.setEpsilon(0.1)
+    # how many past moves to keep, to draw those samples from
+    # qlearner.setReplayCapacity(10000)
+    # learn more often from the moves q got most wrong
+    # qlearner.setPrioritizedReplay(True)
+    # to play several games at once, without callbacks, see stepAll
+    # qlearner.setNumEnvironments(4)
     # learning rate of the neural net
     # qlearner.setLearningRate(0.1)
     qlearner.run()
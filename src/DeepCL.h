@@ -34,6 +34,9 @@
 
 #include "weights/WeightsPersister.h"
 #include "util/FileHelper.h"
+#include "util/AllocationCounter.h"
+#include "net/LayerTimer.h"
+#include "clmath/ProfilingQueue.h"
 #include "loaders/GenericLoader.h"
 #include "loaders/GenericLoaderv2.h"
 
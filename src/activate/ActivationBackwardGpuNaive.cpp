@@ -44,7 +44,6 @@ VIRTUAL void ActivationBackwardGpuNaive::backward(int batchSize, CLWrapper *inpu
     workgroupSize = 64;
     numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("ActivationBackwardGpuNaive::backward end");
 }
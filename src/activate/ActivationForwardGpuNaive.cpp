@@ -40,7 +40,6 @@ VIRTUAL void ActivationForwardGpuNaive::forward(int batchSize, CLWrapper *inputW
     globalSize = (( globalSize + workgroupsize - 1) / workgroupsize) * workgroupsize;
 //    cout << "ActivationForwardGpuNaive::forward batchsize=" << batchSize << " g=" << globalSize << " w=" << workgroupsize << endl;
     kernel->run_1d(globalSize, workgroupsize);
-    cl->finish();
 
 //    cout << "ActivationForwardGpuNaive::forward selectorswrapper:" << endl;
 //    PrintBuffer::printInts(cl, selectorsWrapper, outputSize, outputSize);
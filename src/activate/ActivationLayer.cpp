@@ -8,6 +8,8 @@
 #include "util/stringhelper.h"
 
 #include "activate/ActivationLayer.h"
+#include "clmath/CLWrapperCache.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "activate/ActivationMaker.h"
 #include "activate/ActivationForward.h"
 #include "activate/ActivationBackward.h"
@@ -26,14 +28,15 @@ ActivationLayer::ActivationLayer(EasyCL *cl, Layer *previousLayer, ActivationMak
         outputSize(previousLayer->getOutputSize()),
         fn(maker->_activationFunction),
         cl(cl),
-        output(0),
-        gradInput(0),
         outputWrapper(0),
         gradInputWrapper(0),
+        upstreamWrapperCache(0),
+        gradOutputWrapperCache(0),
 //        outputCopiedToHost(false),
 //        gradInputCopiedToHost(false),
         batchSize(0),
-        allocatedSize(0) {
+        allocatedSize(0),
+        fused(false) {
     if(inputSize == 0){
 //        maker->net->print();
         throw runtime_error("Error: Activation layer " + toString(layerIndex) + ": input image size is 0");
@@ -44,22 +47,19 @@ ActivationLayer::ActivationLayer(EasyCL *cl, Layer *previousLayer, ActivationMak
     }
     activationForwardImpl = ActivationForward::instance(cl, numPlanes, inputSize, fn);
     activationBackpropImpl = ActivationBackward::instance(cl, numPlanes, inputSize, fn);
+    upstreamWrapperCache = new CLWrapperCache(cl);
+    gradOutputWrapperCache = new CLWrapperCache(cl);
 }
 VIRTUAL ActivationLayer::~ActivationLayer() {
     delete activationForwardImpl;
     delete activationBackpropImpl;
-    if(outputWrapper != 0) {
+    delete upstreamWrapperCache;
+    delete gradOutputWrapperCache;
+    // in inference, our output is a view, owned by the net's OutputArenas
+    if(!inference) {
         delete outputWrapper;
     }
-    if(output != 0) {
-        delete[] output;
-    }
-    if(gradInputWrapper != 0) {
-        delete gradInputWrapper;
-    }
-    if(gradInput != 0) {
-        delete[] gradInput;
-    }
+    delete gradInputWrapper;
 }
 VIRTUAL std::string ActivationLayer::getClassName() const {
     return "ActivationLayer";
@@ -69,7 +69,26 @@ VIRTUAL float ActivationLayer::getOutput(int n, int plane, int row, int col) {
         * numPlanes + plane)
         * outputSize + row)
         * outputSize + col;
-    return output[ index ];
+    return getOutput()[ index ];
+}
+/// \brief the previous layer has taken over the activation
+///
+/// so we dont allocate any buffers, forward and backward do nothing, and
+/// the output is the previous layer's, see NeuralNet::fuseLayers
+VIRTUAL void ActivationLayer::setFused(bool fused) {
+    this->fused = fused;
+}
+VIRTUAL bool ActivationLayer::isFused() const {
+    return fused;
+}
+VIRTUAL bool ActivationLayer::passesOutputThrough() const {
+    return fused;
+}
+VIRTUAL bool ActivationLayer::takesOutputView() const {
+    return !fused;
+}
+VIRTUAL void ActivationLayer::setOutputView(CLDeviceWrapper *outputView) {
+    outputWrapper = outputView;
 }
 VIRTUAL void ActivationLayer::printOutput() {
 //    float const*output = getOutput();
@@ -102,41 +121,31 @@ VIRTUAL void ActivationLayer::printOutput() {
 }
 VIRTUAL void ActivationLayer::setBatchSize(int batchSize) {
 //    cout << "ActivationLayer::setBatchSize" << endl;
-    if(batchSize <= allocatedSize) {
+    if(fused || batchSize <= allocatedSize) {
         this->batchSize = batchSize;
         return;
     }
-    if(outputWrapper != 0) {
-        delete outputWrapper;
-    }
-    if(output != 0) {
-        delete[] output;
-    }
-    if(gradInputWrapper != 0) {
-        delete gradInputWrapper;
-    }
-    if(gradInput != 0) {
-        delete[] gradInput;
+    if(inference) {
+        // output comes from setOutputView, and there's no backward
+        this->batchSize = batchSize;
+        this->allocatedSize = batchSize;
+        return;
     }
+    delete outputWrapper;
+    delete gradInputWrapper;
     this->batchSize = batchSize;
     this->allocatedSize = batchSize;
-    output = new float[ getOutputNumElements() ];
-    outputWrapper = cl->wrap(getOutputNumElements(), output);
-    outputWrapper->createOnDevice();
-    gradInput = new float[ previousLayer->getOutputNumElements() ];
-    gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
-    gradInputWrapper->createOnDevice();
+    outputWrapper = new CLDeviceWrapper(cl, getOutputNumElements());
+    gradInputWrapper = new CLDeviceWrapper(cl, previousLayer->getOutputNumElements());
 }
 VIRTUAL int ActivationLayer::getOutputNumElements() {
     return batchSize * numPlanes * outputSize * outputSize;
 }
 VIRTUAL float *ActivationLayer::getOutput() {
-    if(outputWrapper->isDeviceDirty()) {
-        outputWrapper->copyToHost();
-//        outputCopiedToHost = true;
+    if(fused) {
+        return previousLayer->getOutput();
     }
-//    cout << "getOutput output[0] " << output[0] << " output[1] " << output[1] << endl;
-    return output;
+    return outputWrapper->copyToStaging();
 }
 VIRTUAL bool ActivationLayer::needsBackProp() {
     return previousLayer->needsBackProp();
@@ -155,15 +164,21 @@ VIRTUAL int ActivationLayer::getOutputPlanes() const {
     return numPlanes;
 }
 VIRTUAL bool ActivationLayer::providesGradInputWrapper() const {
-    return true;
+    return !fused;
 }
 VIRTUAL CLWrapper *ActivationLayer::getGradInputWrapper() {
+    if(fused) {
+        throw runtime_error("ActivationLayer " + toString(layerIndex) + " is fused into the previous layer, and has no gradInput");
+    }
     return gradInputWrapper;
 }
 VIRTUAL bool ActivationLayer::hasOutputWrapper() const {
     return true;
 }
 VIRTUAL CLWrapper *ActivationLayer::getOutputWrapper() {
+    if(fused) {
+        return previousLayer->getOutputWrapper();
+    }
     return outputWrapper;
 }
 VIRTUAL int ActivationLayer::getWeightsSize() const {
@@ -173,32 +188,36 @@ VIRTUAL int ActivationLayer::getBiasSize() const {
     return 0;
 }
 VIRTUAL float *ActivationLayer::getGradInput() {
-    if(gradInputWrapper->isDeviceDirty()) {
-        gradInputWrapper->copyToHost();
-//        gradInputCopiedToHost = true;
+    if(fused) {
+        throw runtime_error("ActivationLayer " + toString(layerIndex) + " is fused into the previous layer, and has no gradInput");
     }
-    return gradInput;
+    return gradInputWrapper->copyToStaging();
 }
 VIRTUAL ActivationFunction const *ActivationLayer::getActivationFunction() {
     return fn;
 }
 VIRTUAL void ActivationLayer::forward() {
+    if(fused) {
+        return;
+    }
     CLWrapper *inputWrapper = 0;
     if(previousLayer->hasOutputWrapper()) {
         inputWrapper = previousLayer->getOutputWrapper();
     } else {
         float *input = previousLayer->getOutput();
-        inputWrapper = cl->wrap(previousLayer->getOutputNumElements(), input);
+        inputWrapper = upstreamWrapperCache->wrap(previousLayer->getOutputNumElements(), input);
         inputWrapper->copyToDevice();
     }
+    outputWrapper->releaseStaging();
     activationForwardImpl->forward(batchSize, inputWrapper, outputWrapper);
 //    outputCopiedToHost = false;
-    if(!previousLayer->hasOutputWrapper()) {
-        delete inputWrapper;
-    }
 }
 VIRTUAL void ActivationLayer::backward() {
     // have no weights to backprop to, just need to backprop the errors
+    if(fused) {
+        // done by the previous layer, as part of its own backward
+        return;
+    }
 
 //    CLWrapper *imagesWrapper = 0;
 //    if(previousLayer->hasOutputWrapper()) {
@@ -209,27 +228,23 @@ VIRTUAL void ActivationLayer::backward() {
 //    }
 
     CLWrapper *gradOutputWrapper = 0;
-    bool weOwnGradOutputWrapper = false;
     if(nextLayer->providesGradInputWrapper()) {
         gradOutputWrapper = nextLayer->getGradInputWrapper();
     } else {
-        gradOutputWrapper = cl->wrap(getOutputNumElements(), nextLayer->getGradInput());
+        gradOutputWrapper = gradOutputWrapperCache->wrap(getOutputNumElements(), nextLayer->getGradInput());
         gradOutputWrapper->copyToDevice();
-        weOwnGradOutputWrapper = true;
     }
 
+    gradInputWrapper->releaseStaging();
     activationBackpropImpl->backward(batchSize, outputWrapper, gradOutputWrapper, gradInputWrapper);
 //    gradInputCopiedToHost = false;
 
 //    if(!previousLayer->hasOutputWrapper()) {
 //        delete imagesWrapper;
 //    }
-    if(weOwnGradOutputWrapper) {
-        delete gradOutputWrapper;
-    }
 }
 VIRTUAL std::string ActivationLayer::asString() const {
-    return std::string("ActivationLayer{ ") + fn->getDefineName() + " }";
+    return std::string("ActivationLayer{ ") + fn->getDefineName() + (fused ? " fused" : "") + " }";
 }
 VIRTUAL int ActivationLayer::getPersistSize(int version) const {
     // no weights, so:
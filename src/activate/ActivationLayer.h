@@ -16,6 +16,8 @@
 class ActivationForward;
 class ActivationBackward;
 class ActivationMaker;
+class CLWrapperCache;
+class CLDeviceWrapper;
 
 // this will contain only activation, and then we can factorize activations away from
 // the convolutional layers etc
@@ -33,13 +35,13 @@ public:
     ActivationForward *activationForwardImpl;
     ActivationBackward *activationBackpropImpl;
 
-    float *output; // this is not guaranteed to be up to date
-                // unless outputCopiedToHost is true
-    float *gradInput; // this is not guaranteed to be up to date
-                // unless gradInputCopiedToHost is true
+    // device only, copied to the host when asked for, see CLDeviceWrapper
+    CLDeviceWrapper *outputWrapper;
+    CLDeviceWrapper *gradInputWrapper;
 
-    CLWrapper *outputWrapper; // this is guaranteed to be up to date
-    CLWrapper *gradInputWrapper; // this is guaranteed to be up to date
+    // only used if our neighbours dont have their own wrappers
+    CLWrapperCache *upstreamWrapperCache;
+    CLWrapperCache *gradOutputWrapperCache;
 
 //    bool outputCopiedToHost;
 //    bool gradInputCopiedToHost;
@@ -47,6 +49,10 @@ public:
     int batchSize;
     int allocatedSize;
 
+    // the previous layer applies the activation itself, see
+    // NeuralNet::fuseLayers, and we just pass its output along
+    bool fused;
+
     // [[[cog
     // import cog_addheaders
     // cog_addheaders.add()
@@ -56,6 +62,11 @@ public:
     VIRTUAL ~ActivationLayer();
     VIRTUAL std::string getClassName() const;
     VIRTUAL float getOutput(int n, int plane, int row, int col);
+    VIRTUAL void setFused(bool fused);
+    VIRTUAL bool isFused() const;
+    VIRTUAL bool passesOutputThrough() const;
+    VIRTUAL bool takesOutputView() const;
+    VIRTUAL void setOutputView(CLDeviceWrapper *outputView);
     VIRTUAL void printOutput();
     VIRTUAL void setBatchSize(int batchSize);
     VIRTUAL int getOutputNumElements();
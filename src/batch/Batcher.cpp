@@ -75,6 +75,12 @@ VIRTUAL void Batcher::setN(int N) {
     this->N = N;
     this->numBatches = (N + batchSize - 1) / batchSize;
 }
+/// \brief point at a different lot of already-loaded data, eg when
+/// the caller double-buffers
+VIRTUAL void Batcher::setData(float const*data, int const*labels) {
+    this->data = data;
+    this->labels = labels;
+}
 /// \brief processes one single batch of data
 ///
 /// could be learning for one batch, or prediction/testing for one batch
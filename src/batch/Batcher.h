@@ -61,6 +61,7 @@ public:
     PUBLICAPI VIRTUAL bool getEpochDone();
     VIRTUAL void setBatchState(int nextBatch, int numRight, float loss);
     VIRTUAL void setN(int N);
+    VIRTUAL void setData(float const*data, int const*labels);
     PUBLICAPI bool tick(int epoch);
     PUBLICAPI EpochResult run(int epoch);
 
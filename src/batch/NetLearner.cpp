@@ -8,6 +8,8 @@
 #include <string>
 
 #include "util/StatefulTimer.h"
+#include "util/AllocationCounter.h"
+#include "net/LayerTimer.h"
 #include "util/Timer.h"
 #include "net/NeuralNet.h"
 #include "net/Trainable.h"
@@ -63,6 +65,8 @@ PUBLICAPI VIRTUAL void NetLearner::reset() {
 VIRTUAL void NetLearner::postEpochTesting() {
     if(dumpTimings) {
         StatefulTimer::dump(true);
+        AllocationCounter::dump();
+        LayerTimer::dump();
     }
 //        cout << "-----------------------" << endl;
     cout << endl;
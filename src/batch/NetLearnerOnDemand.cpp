@@ -5,6 +5,8 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "util/StatefulTimer.h"
+#include "util/AllocationCounter.h"
+#include "net/LayerTimer.h"
 #include "util/Timer.h"
 #include "batch/BatchLearnerOnDemand.h"
 #include "net/NeuralNet.h"
@@ -99,6 +101,8 @@ VIRTUAL void NetLearnerOnDemand::postEpochTesting() {
     cout << "dumpTimings " << dumpTimings << endl;
     if(dumpTimings) {
         StatefulTimer::dump(true);
+        AllocationCounter::dump();
+        LayerTimer::dump();
     }
 //        cout << "-----------------------" << endl;
     cout << endl;
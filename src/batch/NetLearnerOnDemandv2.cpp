@@ -5,6 +5,8 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "util/StatefulTimer.h"
+#include "util/AllocationCounter.h"
+#include "net/LayerTimer.h"
 #include "util/Timer.h"
 #include "batch/BatchLearnerOnDemand.h"
 #include "net/NeuralNet.h"
@@ -57,6 +59,18 @@ VIRTUAL void NetLearnerOnDemandv2::setSchedule(int numEpochs) {
 VIRTUAL void NetLearnerOnDemandv2::setDumpTimings(bool dumpTimings) {
     this->dumpTimings = dumpTimings;
 }
+/// \brief load this many file batches ahead, in a background thread,
+/// whilst training or testing on the current one.  0 means dont prefetch
+PUBLICAPI VIRTUAL void NetLearnerOnDemandv2::setPrefetchDepth(int prefetchDepth) {
+    learnBatcher->setPrefetchDepth(prefetchDepth);
+    testBatcher->setPrefetchDepth(prefetchDepth);
+}
+/// \brief have the loaders normalize the data as they load it, see
+/// NormalizationLayer::setInputPreNormalized
+PUBLICAPI VIRTUAL void NetLearnerOnDemandv2::setLoadNormalization(float translate, float scale) {
+    learnBatcher->setLoadNormalization(translate, scale);
+    testBatcher->setLoadNormalization(translate, scale);
+}
 VIRTUAL void NetLearnerOnDemandv2::setSchedule(int numEpochs, int nextEpoch) {
     this->numEpochs = numEpochs;
     this->nextEpoch = nextEpoch;
@@ -100,6 +114,8 @@ VIRTUAL void NetLearnerOnDemandv2::postEpochTesting() {
     cout << "dumpTimings " << dumpTimings << endl;
     if(dumpTimings) {
         StatefulTimer::dump(true);
+        AllocationCounter::dump();
+        LayerTimer::dump();
     }
 //        cout << "-----------------------" << endl;
     cout << endl;
@@ -71,6 +71,8 @@ public:
     VIRTUAL ~NetLearnerOnDemandv2();
     VIRTUAL void setSchedule(int numEpochs);
     VIRTUAL void setDumpTimings(bool dumpTimings);
+    PUBLICAPI VIRTUAL void setPrefetchDepth(int prefetchDepth);
+    PUBLICAPI VIRTUAL void setLoadNormalization(float translate, float scale);
     VIRTUAL void setSchedule(int numEpochs, int nextEpoch);
     PUBLICAPI VIRTUAL bool getEpochDone();
     PUBLICAPI VIRTUAL int getNextEpoch();
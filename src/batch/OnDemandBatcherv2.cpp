@@ -4,10 +4,13 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <stdexcept>
+
 #include "batch/NetAction.h"
 #include "net/Trainable.h"
 #include "loaders/GenericLoaderv2.h"
 #include "batch/Batcher.h"
+#include "util/stringhelper.h"
 
 #include "batch/OnDemandBatcherv2.h"
 
@@ -28,18 +31,150 @@ PUBLICAPI OnDemandBatcherv2::OnDemandBatcherv2(Trainable *net, NetAction *netAct
             fileReadBatches(fileReadBatches),
             batchSize(batchSize),
             fileBatchSize(batchSize * fileReadBatches),
-            inputCubeSize(net->getInputCubeSize())
+            inputCubeSize(net->getInputCubeSize()),
+            loadTranslate(0.0f),
+            loadScale(1.0f),
+            prefetchDepth(0),
+            numBuffers(0),
+            prefetchRunning(false),
+            prefetchStopping(false),
+            prefetchStart(0),
+            nextLoadSeq(0),
+            consumeSeq(0)
         {
     numFileBatches = (N + fileBatchSize - 1) / fileBatchSize;
-    dataBuffer = new float[ fileBatchSize * inputCubeSize ];
-    labelsBuffer = new int[ fileBatchSize ];
-    netActionBatcher = new NetActionBatcher(net, batchSize, fileBatchSize, dataBuffer, labelsBuffer, netAction);
+    allocateBuffers(1);
+    netActionBatcher = new NetActionBatcher(net, batchSize, fileBatchSize, dataBuffers[0], labelsBuffers[0], netAction);
     reset();
 }
 VIRTUAL OnDemandBatcherv2::~OnDemandBatcherv2() {
+    stopPrefetch();
     delete netActionBatcher;
-    delete[] dataBuffer;
-    delete[] labelsBuffer;
+    freeBuffers();
+}
+/// \brief how many file batches to load ahead, in a background thread
+///
+/// 0, the default, loads each file batch just before it's used, in the
+/// calling thread
+PUBLICAPI void OnDemandBatcherv2::setPrefetchDepth(int prefetchDepth) {
+    if(prefetchDepth < 0) {
+        throw runtime_error("prefetchDepth should be >= 0, but was " + toString(prefetchDepth));
+    }
+    #ifdef NOTHREADS
+    prefetchDepth = 0;
+    #endif
+    if(prefetchDepth == this->prefetchDepth) {
+        return;
+    }
+    stopPrefetch();
+    freeBuffers();
+    this->prefetchDepth = prefetchDepth;
+    allocateBuffers(prefetchDepth + 1);
+    netActionBatcher->setData(dataBuffers[0], labelsBuffers[0]);
+}
+PUBLICAPI int OnDemandBatcherv2::getPrefetchDepth() {
+    return prefetchDepth;
+}
+/// \brief have the loader write the data out as (value + translate) * scale
+///
+/// for when the net's NormalizationLayer has been told its input is
+/// pre-normalized.  default is translate 0, scale 1, ie the raw values
+PUBLICAPI void OnDemandBatcherv2::setLoadNormalization(float translate, float scale) {
+    stopPrefetch(); // anything already prefetched used the old values
+    this->loadTranslate = translate;
+    this->loadScale = scale;
+}
+void OnDemandBatcherv2::allocateBuffers(int numBuffers) {
+    this->numBuffers = numBuffers;
+    for(int i = 0; i < numBuffers; i++) {
+        dataBuffers.push_back(new float[ fileBatchSize * inputCubeSize ]);
+        labelsBuffers.push_back(new int[ fileBatchSize ]);
+        bufferSeq.push_back(-1);
+    }
+}
+void OnDemandBatcherv2::freeBuffers() {
+    for(int i = 0; i < (int)dataBuffers.size(); i++) {
+        delete[] dataBuffers[i];
+        delete[] labelsBuffers[i];
+    }
+    dataBuffers.clear();
+    labelsBuffers.clear();
+    bufferSeq.clear();
+    numBuffers = 0;
+}
+int OnDemandBatcherv2::getFileBatchSize(int fileBatch) {
+    if(fileBatch == numFileBatches - 1) {
+        return N - fileBatch * fileBatchSize;
+    }
+    return fileBatchSize;
+}
+void OnDemandBatcherv2::startPrefetch(int fileBatch) {
+    #ifndef NOTHREADS
+    prefetchStart = fileBatch;
+    nextLoadSeq = 0;
+    consumeSeq = 0;
+    prefetchStopping = false;
+    prefetchError = "";
+    for(int i = 0; i < numBuffers; i++) {
+        bufferSeq[i] = -1;
+    }
+    prefetchThread = std::thread(&OnDemandBatcherv2::prefetchLoop, this);
+    prefetchRunning = true;
+    #endif
+}
+void OnDemandBatcherv2::stopPrefetch() {
+    #ifndef NOTHREADS
+    if(!prefetchRunning) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(prefetchMutex);
+        prefetchStopping = true;
+    }
+    prefetchChanged.notify_all();
+    prefetchThread.join();
+    prefetchRunning = false;
+    #endif
+}
+// runs in the prefetch thread: keeps loading file batches, in order, as long
+// as there's a buffer that the net isnt using, and that it hasnt used yet
+// only touches the loader and the buffers, never the net
+void OnDemandBatcherv2::prefetchLoop() {
+    #ifndef NOTHREADS
+    while(true) {
+        int seq = 0;
+        {
+            std::unique_lock<std::mutex> lock(prefetchMutex);
+            while(!prefetchStopping && nextLoadSeq >= consumeSeq + numBuffers) {
+                prefetchChanged.wait(lock);
+            }
+            if(prefetchStopping) {
+                return;
+            }
+            seq = nextLoadSeq;
+        }
+        int fileBatch = (prefetchStart + seq) % numFileBatches;
+        int buffer = seq % numBuffers;
+        string error = "";
+        try {
+            loader->load(dataBuffers[buffer], labelsBuffers[buffer], fileBatch * fileBatchSize, getFileBatchSize(fileBatch),
+                loadTranslate, loadScale);
+        } catch(std::exception &e) {
+            error = e.what();
+        }
+        {
+            std::unique_lock<std::mutex> lock(prefetchMutex);
+            if(error != "") {
+                prefetchError = error;
+                prefetchChanged.notify_all();
+                return;
+            }
+            bufferSeq[buffer] = seq;
+            nextLoadSeq++;
+        }
+        prefetchChanged.notify_all();
+    }
+    #endif
 }
 VIRTUAL void OnDemandBatcherv2::setBatchState(int nextBatch, int numRight, float loss) {
     this->nextFileBatch = nextBatch / fileReadBatches;
@@ -77,6 +212,46 @@ PUBLICAPI VIRTUAL int OnDemandBatcherv2::getN() {
 ////        updateBuffers();
 //    }
 //}
+// blocks until the prefetch thread has loaded fileBatch, then points the
+// batcher at it.  (re)starts the prefetch thread if fileBatch isnt the one
+// it was going to load next, eg first time through, or after setBatchState
+void OnDemandBatcherv2::waitForPrefetch(int fileBatch) {
+    #ifndef NOTHREADS
+    if(!prefetchRunning || (prefetchStart + consumeSeq) % numFileBatches != fileBatch) {
+        stopPrefetch();
+        startPrefetch(fileBatch);
+    }
+    int buffer = consumeSeq % numBuffers;
+    string error = "";
+    {
+        std::unique_lock<std::mutex> lock(prefetchMutex);
+        while(bufferSeq[buffer] != consumeSeq && prefetchError == "") {
+            prefetchChanged.wait(lock);
+        }
+        // the error might be from a later file batch, loaded ahead; that's
+        // for the tick that needs it to report
+        if(bufferSeq[buffer] != consumeSeq) {
+            error = prefetchError;
+        }
+    }
+    if(error != "") {
+        stopPrefetch();
+        throw runtime_error("OnDemandBatcherv2 failed to load file batch " + toString(fileBatch) + ": " + error);
+    }
+    netActionBatcher->setData(dataBuffers[buffer], labelsBuffers[buffer]);
+    #endif
+}
+// the net has finished with the current buffer, so the prefetch thread can
+// reuse it
+void OnDemandBatcherv2::releasePrefetch() {
+    #ifndef NOTHREADS
+    {
+        std::unique_lock<std::mutex> lock(prefetchMutex);
+        consumeSeq++;
+    }
+    prefetchChanged.notify_all();
+    #endif
+}
 PUBLICAPI void OnDemandBatcherv2::reset() {
 //    cout << "OnDemandBatcherv2::reset()" << endl;
     numRight = 0;
@@ -99,8 +274,15 @@ PUBLICAPI bool OnDemandBatcherv2::tick(int epoch) {
     }
     netActionBatcher->setN(thisFileBatchSize);
 //    cout << "batchlearnerondemand, read data... filebatchstart=" << fileBatchStart << " filebatchsize=" << thisFileBatchSize << endl;
-    loader->load(dataBuffer, labelsBuffer, fileBatchStart, thisFileBatchSize);
+    if(prefetchDepth == 0) {
+        loader->load(dataBuffers[0], labelsBuffers[0], fileBatchStart, thisFileBatchSize, loadTranslate, loadScale);
+    } else {
+        waitForPrefetch(fileBatch);
+    }
     EpochResult epochResult = netActionBatcher->run(epoch);
+    if(prefetchDepth > 0) {
+        releasePrefetch();
+    }
     loss += epochResult.loss;
     numRight += epochResult.numRight;
 
@@ -14,7 +14,11 @@ class Trainable;
 class NetAction;
 class GenericLoaderv2;
 
+#include <vector>
+#include <string>
+
 #include "batch/NetAction.h"
+#include "util/ThreadPool.h"
 
 #include "DeepCLDllExport.h"
 
@@ -31,6 +35,10 @@ class GenericLoaderv2;
 ///
 /// compared to v1, v2 recevies a GenericLoaderv2 loader object, instead of a filepath
 /// so we can handle imagenet manifests etc
+///
+/// With setPrefetchDepth(n), n > 0, a background thread loads up to n file
+/// batches ahead, into their own buffers, whilst the net works through
+/// the current one.  Costs n extra file batches of host memory
 PUBLICAPI
 class OnDemandBatcherv2 {
 protected:
@@ -48,9 +56,35 @@ protected:
     const int fileBatchSize;
     const int inputCubeSize;
     int numFileBatches;
+    float loadTranslate;
+    float loadScale;
 
-    float *dataBuffer;
-    int *labelsBuffer;
+    int prefetchDepth;
+    int numBuffers; // prefetchDepth + 1
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<float *> dataBuffers;
+    std::vector<int *> labelsBuffers;
+    #ifndef NOTHREADS
+    // prefetch state. sequence numbers count file batches handed out since
+    // the prefetch thread started, at file batch prefetchStart, and wrap
+    // round into the next epoch; sequence number seq lives in buffer
+    // seq % numBuffers
+    std::thread prefetchThread;
+    std::mutex prefetchMutex;
+    std::condition_variable prefetchChanged;
+    #endif
+    std::vector<int> bufferSeq; // which sequence number each buffer holds, or -1
+    std::string prefetchError;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    bool prefetchRunning;
+    bool prefetchStopping;
+    int prefetchStart;
+    int nextLoadSeq;
+    int consumeSeq; // the net is using this one, so the loader must not overwrite it
 
     bool epochDone;
     int numRight;
@@ -67,6 +101,15 @@ public:
     PUBLICAPI OnDemandBatcherv2(Trainable *net, NetAction *netAction,
     GenericLoaderv2 *loader, int N, int fileReadBatches, int batchSize);
     VIRTUAL ~OnDemandBatcherv2();
+    PUBLICAPI void setPrefetchDepth(int prefetchDepth);
+    PUBLICAPI int getPrefetchDepth();
+    PUBLICAPI void setLoadNormalization(float translate, float scale);
+    void allocateBuffers(int numBuffers);
+    void freeBuffers();
+    int getFileBatchSize(int fileBatch);
+    void startPrefetch(int fileBatch);
+    void stopPrefetch();
+    void prefetchLoop();
     VIRTUAL void setBatchState(int nextBatch, int numRight, float loss);
     VIRTUAL int getBatchSize();
     PUBLICAPI VIRTUAL int getNextFileBatch();
@@ -75,6 +118,8 @@ public:
     PUBLICAPI VIRTUAL int getNumRight();
     PUBLICAPI VIRTUAL bool getEpochDone();
     PUBLICAPI VIRTUAL int getN();
+    void waitForPrefetch(int fileBatch);
+    void releasePrefetch();
     PUBLICAPI void reset();
     PUBLICAPI bool tick(int epoch);
     PUBLICAPI EpochResult run(int epoch);
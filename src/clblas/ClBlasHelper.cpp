@@ -64,6 +64,8 @@ PUBLIC STATIC void ClBlasHelper::Gemm(
    if (err != CL_SUCCESS) {
        throw runtime_error("clblasSgemm() failed with " + toString(err));
    }    
+   // like a kernel's out(), so the host copies C again before reading it
+   CWrapper->markDeviceDirty();
 }
 
 PUBLIC STATIC void ClBlasHelper::Gemv(
@@ -104,5 +106,6 @@ PUBLIC STATIC void ClBlasHelper::Gemv(
    if (err != CL_SUCCESS) {
        throw runtime_error("clblasSgemv() failed with " + toString(err));
    }        
+   CWrapper->markDeviceDirty();
 }
 
@@ -0,0 +1,140 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+#include <cstring>
+
+#include "util/stringhelper.h"
+#include "util/AllocationCounter.h"
+#include "clmath/HostStagingPool.h"
+#include "clmath/CLDeviceWrapper.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+// allocated on the device straight away, and counted by AllocationCounter;
+// contents undefined
+PUBLIC CLDeviceWrapper::CLDeviceWrapper(EasyCL *cl, int N) :
+        CLFloatWrapper(N, 0, cl),
+        stagingCapacity(0),
+        stagingValid(false) {
+    createOnDevice();
+    AllocationCounter::countAllocation();
+}
+// N elements starting at offset in parent, as an opencl sub-buffer, like
+// CLFloatWrapperView, but without touching the parent's host array, which
+// it needn't have
+// the parent has to be on the device, and outlive us, and offset has to be
+// aligned, see CLFloatWrapperView::getAlignFloats()
+PUBLIC CLDeviceWrapper::CLDeviceWrapper(CLWrapper *parent, int offset, int N) :
+        CLFloatWrapper(N, 0, parent->getCl()),
+        stagingCapacity(0),
+        stagingValid(false) {
+    if(offset < 0 || offset + N > parent->size()) {
+        throw runtime_error("CLDeviceWrapper: view [" + toString(offset) + ", " + toString(offset + N) +
+            ") doesnt fit in parent of size " + toString(parent->size()));
+    }
+    if(!parent->isOnDevice()) {
+        throw runtime_error("CLDeviceWrapper: parent must be on the device before creating views");
+    }
+    cl_buffer_region region;
+    region.origin = offset * sizeof(float);
+    region.size = N * sizeof(float);
+    cl_int error = CL_SUCCESS;
+    devicearray = clCreateSubBuffer(parent->getBuffer(), CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION,
+        &region, &error);
+    if(error != CL_SUCCESS) {
+        throw runtime_error("CLDeviceWrapper: clCreateSubBuffer failed, error " + toString(error) +
+            ", offset " + toString(offset));
+    }
+    onDevice = true;
+}
+PUBLIC VIRTUAL CLDeviceWrapper::~CLDeviceWrapper() {
+    releaseStaging();
+}
+// the buffer's contents, on the host; the array stays ours, and stays valid
+// until releaseStaging(), or until we're deleted
+// only copies if a kernel wrote to the buffer since the last copy
+PUBLIC float *CLDeviceWrapper::copyToStaging() {
+    if(hostarray == 0) {
+        hostarray = HostStagingPool::acquire(N, &stagingCapacity);
+        stagingValid = false;
+    }
+    if(!stagingValid || deviceDirty) {
+        cl_int error = clEnqueueReadBuffer(*(cl->queue), devicearray, CL_TRUE, 0, N * sizeof(float),
+            hostarray, 0, 0, 0);
+        if(error != CL_SUCCESS) {
+            throw runtime_error("CLDeviceWrapper::copyToStaging: clEnqueueReadBuffer failed, error " + toString(error));
+        }
+        stagingValid = true;
+        deviceDirty = false;
+    }
+    return hostarray;
+}
+PUBLIC bool CLDeviceWrapper::hasStaging() const {
+    return hostarray != 0;
+}
+// gives the host copy back to the pool, eg once it's been persisted
+PUBLIC void CLDeviceWrapper::releaseStaging() {
+    HostStagingPool::release(hostarray, stagingCapacity);
+    hostarray = 0;
+    stagingCapacity = 0;
+    stagingValid = false;
+}
+// N elements from data to the device; data can be freed straight after
+PUBLIC void CLDeviceWrapper::copyFromHost(float const *data) {
+    cl_int error = clEnqueueWriteBuffer(*(cl->queue), devicearray, CL_TRUE, 0, N * sizeof(float),
+        data, 0, 0, 0);
+    if(error != CL_SUCCESS) {
+        throw runtime_error("CLDeviceWrapper::copyFromHost: clEnqueueWriteBuffer failed, error " + toString(error));
+    }
+    if(hostarray != 0) {
+        if(hostarray != data) {
+            memcpy(hostarray, data, N * sizeof(float));
+        }
+        stagingValid = true;
+    }
+    deviceDirty = false;
+}
+// for host code that's handed a CLWrapper that may or may not be device
+// only, eg ForwardCpuIm2Col, which the autotuner runs on the layers' buffers:
+// the wrapper's contents, in its host array, or in our staging array
+PUBLIC STATIC float *CLDeviceWrapper::copyToHostArray(CLWrapper *wrapper) {
+    CLDeviceWrapper *deviceWrapper = dynamic_cast< CLDeviceWrapper * >(wrapper);
+    if(deviceWrapper != 0) {
+        return deviceWrapper->copyToStaging();
+    }
+    wrapper->copyToHost();
+    return (float *)wrapper->getHostArray();
+}
+// the other way: writes what's in the array from copyToHostArray() back
+PUBLIC STATIC void CLDeviceWrapper::copyHostArrayToDevice(CLWrapper *wrapper) {
+    CLDeviceWrapper *deviceWrapper = dynamic_cast< CLDeviceWrapper * >(wrapper);
+    if(deviceWrapper != 0) {
+        deviceWrapper->copyFromHost(deviceWrapper->hostarray);
+        return;
+    }
+    wrapper->copyToDevice();
+}
+// sets every element to value, going through a staging array, which is
+// given back afterwards, unless we already had one
+PUBLIC void CLDeviceWrapper::fill(float value) {
+    bool hadStaging = hostarray != 0;
+    if(!hadStaging) {
+        hostarray = HostStagingPool::acquire(N, &stagingCapacity);
+    }
+    for(int i = 0; i < N; i++) {
+        hostarray[i] = value;
+    }
+    copyFromHost(hostarray);
+    if(!hadStaging) {
+        releaseStaging();
+    }
+}
@@ -0,0 +1,54 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "EasyCL.h"
+#include "CLFloatWrapper.h"
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// a buffer of N 4-byte elements that lives only on the device: there is no
+// host array mirroring it.  kernels use it like any other CLWrapper, as
+// floats, or as ints, eg pooling selectors
+// a host copy is only made when asked for, by copyToStaging(), into an array
+// borrowed from HostStagingPool, and kept until releaseStaging(), or until
+// we're deleted, so later reads only copy again if a kernel has written to
+// the buffer since
+// layers hand theirs back once they're about to write the buffer again, so a
+// pointer from their getOutput() stays good until their next forward(), and
+// one from getGradInput(), or getGradWeights(), until their next backward()
+// CLWrapper's copyToHost() and copyToDevice() go through the host array, so
+// dont use them; use copyToStaging(), copyFromHost() and fill() instead
+class DeepCL_EXPORT CLDeviceWrapper : public CLFloatWrapper {
+    private:
+    int stagingCapacity;
+    bool stagingValid; // staging holds what's on the device, unless deviceDirty
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    CLDeviceWrapper(EasyCL *cl, int N);
+    CLDeviceWrapper(CLWrapper *parent, int offset, int N);
+    VIRTUAL ~CLDeviceWrapper();
+    float *copyToStaging();
+    bool hasStaging() const;
+    void releaseStaging();
+    void copyFromHost(float const *data);
+    STATIC float *copyToHostArray(CLWrapper *wrapper);
+    STATIC void copyHostArrayToDevice(CLWrapper *wrapper);
+    void fill(float value);
+
+    // [[[end]]]
+};
+
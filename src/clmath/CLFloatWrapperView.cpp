@@ -0,0 +1,50 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "util/stringhelper.h"
+#include "clmath/CLFloatWrapperView.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+// the sub-buffer is created straight away, so we count as already on the
+// device; CLWrapper's destructor releases it, which leaves the parent alone
+PUBLIC CLFloatWrapperView::CLFloatWrapperView(CLWrapper *parent, int offset, int N) :
+        CLFloatWrapper(N, (float *)parent->getHostArray() + offset, parent->getCl()) {
+    if(offset < 0 || offset + N > parent->size()) {
+        throw runtime_error("CLFloatWrapperView: view [" + toString(offset) + ", " + toString(offset + N) +
+            ") doesnt fit in parent of size " + toString(parent->size()));
+    }
+    if(!parent->isOnDevice()) {
+        throw runtime_error("CLFloatWrapperView: parent must be on the device before creating views");
+    }
+    cl_buffer_region region;
+    region.origin = offset * sizeof(float);
+    region.size = N * sizeof(float);
+    cl_int error = CL_SUCCESS;
+    devicearray = clCreateSubBuffer(parent->getBuffer(), CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION,
+        &region, &error);
+    if(error != CL_SUCCESS) {
+        throw runtime_error("CLFloatWrapperView: clCreateSubBuffer failed, error " + toString(error) +
+            ", offset " + toString(offset));
+    }
+    onDevice = true;
+}
+// sub-buffer origins have to be aligned to CL_DEVICE_MEM_BASE_ADDR_ALIGN
+// this returns that, in floats
+PUBLIC STATIC int CLFloatWrapperView::getAlignFloats(EasyCL *cl) {
+    cl_uint alignBits = 0;
+    clGetDeviceInfo(cl->device, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(alignBits), &alignBits, 0);
+    int alignFloats = (int)(alignBits / 8 / sizeof(float));
+    return alignFloats < 1 ? 1 : alignFloats;
+}
+
@@ -0,0 +1,39 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "EasyCL.h"
+#include "CLFloatWrapper.h"
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// a CLFloatWrapper over N floats starting at offset in some other, parent,
+// CLWrapper, using an opencl sub-buffer, so kernels can use it just like
+// any other buffer, and writes through it land in the parent
+// the host array is the matching slice of the parent's host array
+// the parent has to be on the device already, and has to outlive the view
+// offset * sizeof(float) has to be a multiple of CL_DEVICE_MEM_BASE_ADDR_ALIGN,
+// see getAlignFloats()
+class DeepCL_EXPORT CLFloatWrapperView : public CLFloatWrapper {
+    private:
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    CLFloatWrapperView(CLWrapper *parent, int offset, int N);
+    STATIC int getAlignFloats(EasyCL *cl);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,103 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "CLFloatWrapper.h"
+#include "util/stringhelper.h"
+#include "clmath/GpuOp.h"
+#include "clmath/CLMathWrapper.h"
+#include "clmath/CLMathExpression.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+PUBLIC CLMathExpression::CLMathExpression(const CLMathWrapper &wrapper) {
+    CLMathExpressionNode node;
+    node.type = CLMathExpressionNode::BUFFER;
+    node.wrapper = wrapper.wrapper;
+    node.scalar = 0;
+    nodes.push_back(node);
+}
+PUBLIC CLMathExpression::CLMathExpression(float scalar) {
+    CLMathExpressionNode node;
+    node.type = CLMathExpressionNode::SCALAR;
+    node.wrapper = 0;
+    node.scalar = scalar;
+    nodes.push_back(node);
+}
+PUBLIC CLMathExpression::CLMathExpression(const CLMathExpression &one, Op1 *op) :
+        nodes(one.nodes) {
+    CLMathExpressionNode node;
+    node.type = CLMathExpressionNode::OP1;
+    node.wrapper = 0;
+    node.scalar = 0;
+    node.operation = op->getOperationString();
+    nodes.push_back(node);
+}
+PUBLIC CLMathExpression::CLMathExpression(const CLMathExpression &one, Op2 *op, const CLMathExpression &two) :
+        nodes(one.nodes) {
+    int oneSize = one.size();
+    int twoSize = two.size();
+    if(oneSize != -1 && twoSize != -1 && oneSize != twoSize) {
+        throw runtime_error("CLMathExpression array size mismatch, cannot combine " + toString(oneSize) +
+            " vs " + toString(twoSize) );
+    }
+    nodes.insert(nodes.end(), two.nodes.begin(), two.nodes.end());
+    CLMathExpressionNode node;
+    node.type = CLMathExpressionNode::OP2;
+    node.wrapper = 0;
+    node.scalar = 0;
+    node.operation = op->getOperationString();
+    nodes.push_back(node);
+}
+PUBLIC CLMathExpression CLMathExpression::sqrt() const {
+    Op1Sqrt op;
+    return CLMathExpression(*this, &op);
+}
+PUBLIC CLMathExpression CLMathExpression::inv() const {
+    Op1Inv op;
+    return CLMathExpression(*this, &op);
+}
+PUBLIC CLMathExpression CLMathExpression::squared() const {
+    Op1Squared op;
+    return CLMathExpression(*this, &op);
+}
+// number of elements in the buffers used, or -1 if it's all scalars
+PUBLIC int CLMathExpression::size() const {
+    for(int i = 0; i < (int)nodes.size(); i++) {
+        if(nodes[i].type == CLMathExpressionNode::BUFFER) {
+            return nodes[i].wrapper->size();
+        }
+    }
+    return -1;
+}
+PUBLIC std::vector<CLMathExpressionNode> const &CLMathExpression::getNodes() const {
+    return nodes;
+}
+
+CLMathExpression operator+(const CLMathExpression &one, const CLMathExpression &two) {
+    Op2Add op;
+    return CLMathExpression(one, &op, two);
+}
+CLMathExpression operator-(const CLMathExpression &one, const CLMathExpression &two) {
+    Op2Sub op;
+    return CLMathExpression(one, &op, two);
+}
+CLMathExpression operator*(const CLMathExpression &one, const CLMathExpression &two) {
+    Op2Mul op;
+    return CLMathExpression(one, &op, two);
+}
+CLMathExpression operator/(const CLMathExpression &one, const CLMathExpression &two) {
+    Op2Div op;
+    return CLMathExpression(one, &op, two);
+}
+
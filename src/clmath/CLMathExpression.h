@@ -0,0 +1,74 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+class CLFloatWrapper;
+class CLMathWrapper;
+class Op1;
+class Op2;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// one step of a CLMathExpression, in postfix order
+class DeepCL_EXPORT CLMathExpressionNode {
+public:
+    enum NodeType { BUFFER, SCALAR, OP1, OP2 };
+    NodeType type;
+    CLFloatWrapper *wrapper; // for BUFFER, dont delete
+    float scalar; // for SCALAR
+    std::string operation; // for OP1, OP2: the Op1/Op2 operation string, with val_one, val_two
+};
+
+// per-element expression over CLMathWrappers and floats, that doesnt do
+// anything until it's assigned to a CLMathWrapper, or handed to a FusedGpuOp
+// then the whole thing runs as a single kernel, with no temporary buffers, eg:
+//
+//     weights_ = weights_ + lastUpdates_ * momentum - gradWeights_ * learningRate;
+//
+// sqrt(), inv() and squared() return a new expression here; they dont
+// modify anything in place, unlike the CLMathWrapper methods of the same name
+class DeepCL_EXPORT CLMathExpression {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<CLMathExpressionNode> nodes;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    CLMathExpression(const CLMathWrapper &wrapper);
+    CLMathExpression(float scalar);
+    CLMathExpression(const CLMathExpression &one, Op1 *op);
+    CLMathExpression(const CLMathExpression &one, Op2 *op, const CLMathExpression &two);
+    CLMathExpression sqrt() const;
+    CLMathExpression inv() const;
+    CLMathExpression squared() const;
+    int size() const;
+    std::vector<CLMathExpressionNode> const &getNodes() const;
+
+    // [[[end]]]
+};
+
+DeepCL_EXPORT CLMathExpression operator+(const CLMathExpression &one, const CLMathExpression &two);
+DeepCL_EXPORT CLMathExpression operator-(const CLMathExpression &one, const CLMathExpression &two);
+DeepCL_EXPORT CLMathExpression operator*(const CLMathExpression &one, const CLMathExpression &two);
+DeepCL_EXPORT CLMathExpression operator/(const CLMathExpression &one, const CLMathExpression &two);
+
@@ -11,6 +11,8 @@
 #include "util/stringhelper.h"
 #include "clmath/GpuOp.h"
 #include "clmath/CLMathWrapper.h"
+#include "clmath/CLMathExpression.h"
+#include "clmath/FusedGpuOp.h"
 
 using namespace std;
 
@@ -70,6 +72,13 @@ VIRTUAL CLMathWrapper &CLMathWrapper::operator=(const CLMathWrapper &rhs) {
     gpuOp->apply2_inplace(N, wrapper, ((CLMathWrapper &)rhs).wrapper, &op);
     return *this;
 }
+// evaluates the whole expression in a single kernel
+VIRTUAL CLMathWrapper &CLMathWrapper::operator=(const CLMathExpression &expression) {
+    FusedGpuOp fusedOp(cl);
+    fusedOp.assign(*this, expression);
+    fusedOp.run();
+    return *this;
+}
 VIRTUAL CLMathWrapper &CLMathWrapper::sqrt() {
     Op1Sqrt op;
     gpuOp->apply1_inplace(N, wrapper, &op);
@@ -90,7 +99,6 @@ VIRTUAL void CLMathWrapper::runKernel(CLKernel *kernel) {
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 }
 CLMathWrapper::CLMathWrapper(CLWrapper *wrapper) {
     CLFloatWrapper *floatWrapper = dynamic_cast< CLFloatWrapper * >(wrapper);
@@ -18,6 +18,7 @@ class GpuOp;
 class CLFloatBuffer;
 class EasyCL;
 class CLKernel;
+class CLMathExpression;
 
 #include "DeepCLDllExport.h"
 
@@ -25,6 +26,8 @@ class CLKernel;
 // like per-element add, inplace scalar multiply etc
 // a bit basic for now.  can extend gradually :-)
 // something to consider: pros/cons of using eg clBLAS instead?
+// each operator here is one kernel launch; to do several in one pass, assign
+// a CLMathExpression instead, eg a = a * 0.9f + CLMathExpression(b).squared() * 0.1f
 class DeepCL_EXPORT CLMathWrapper {
     EasyCL *cl; // dont delete
     GpuOp *gpuOp;
@@ -32,6 +35,8 @@ class DeepCL_EXPORT CLMathWrapper {
     int N;
     CLFloatWrapper *wrapper; // dont delete
 
+    friend class CLMathExpression;
+
 public:
     
     // [[[cog
@@ -46,6 +51,7 @@ public:
     VIRTUAL CLMathWrapper &operator*=(const CLMathWrapper &two);
     VIRTUAL CLMathWrapper &operator+=(const CLMathWrapper &two);
     VIRTUAL CLMathWrapper &operator=(const CLMathWrapper &rhs);
+    VIRTUAL CLMathWrapper &operator=(const CLMathExpression &expression);
     VIRTUAL CLMathWrapper &sqrt();
     VIRTUAL CLMathWrapper &inv();
     VIRTUAL CLMathWrapper &squared();
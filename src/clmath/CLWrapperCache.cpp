@@ -0,0 +1,39 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+#include "util/AllocationCounter.h"
+#include "clmath/CLWrapperCache.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+PUBLIC CLWrapperCache::CLWrapperCache(EasyCL *cl) :
+        cl(cl),
+        wrapper(0),
+        hostArray(0),
+        N(0) {
+}
+PUBLIC VIRTUAL CLWrapperCache::~CLWrapperCache() {
+    delete wrapper;
+}
+// caller still needs to copyToDevice(), since the host data will have changed
+PUBLIC CLWrapper *CLWrapperCache::wrap(int N, float *hostArray) {
+    if(wrapper != 0 && this->hostArray == hostArray && this->N == N) {
+        return wrapper;
+    }
+    delete wrapper;
+    wrapper = cl->wrap(N, hostArray);
+    this->hostArray = hostArray;
+    this->N = N;
+    AllocationCounter::countAllocation();
+    return wrapper;
+}
+
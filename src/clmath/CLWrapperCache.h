@@ -0,0 +1,42 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class CLWrapper;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// for layers whose neighbour only has a host-side buffer: keeps one
+// CLWrapper around that host array, and only rewraps it when the array, or
+// its size, changes, rather than creating and freeing a device buffer
+// every batch
+// each rewrap is counted by AllocationCounter
+class DeepCL_EXPORT CLWrapperCache {
+    private:
+    EasyCL *cl; // NOT belong to us, dont delete
+    CLWrapper *wrapper;
+    float *hostArray; // NOT belong to us
+    int N;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    CLWrapperCache(EasyCL *cl);
+    VIRTUAL ~CLWrapperCache();
+    CLWrapper *wrap(int N, float *hostArray);
+
+    // [[[end]]]
+};
+
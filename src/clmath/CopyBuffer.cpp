@@ -28,7 +28,6 @@ VIRTUAL void CopyBuffer::copy(int N, CLWrapper *in, CLWrapper *out) {
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("CopyBuffer::copy end");
 }
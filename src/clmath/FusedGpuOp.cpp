@@ -0,0 +1,173 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "util/StatefulTimer.h"
+#include "EasyCL.h"
+#include "CLFloatWrapper.h"
+#include "util/stringhelper.h"
+#include "clmath/CLMathWrapper.h"
+#include "clmath/CLMathExpression.h"
+#include "clmath/FusedGpuOp.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+PUBLIC FusedGpuOp::FusedGpuOp(EasyCL *cl) :
+        cl(cl),
+        N(-1) {
+}
+PUBLIC VIRTUAL FusedGpuOp::~FusedGpuOp() {
+}
+// target = expression, evaluated per-element, when run() is called
+PUBLIC void FusedGpuOp::assign(CLMathWrapper &target, const CLMathExpression &expression) {
+    CLFloatWrapper *targetWrapper = CLMathExpression(target).getNodes()[0].wrapper;
+    checkSize(targetWrapper->size());
+    checkSize(expression.size());
+    string value = render(expression);
+    int targetIndex = bufferIndex(targetWrapper);
+    bufferWritten[targetIndex] = true;
+    statements += "    v" + toString(targetIndex) + " = " + value + ";\n";
+}
+PUBLIC void FusedGpuOp::run() {
+    if(N == -1) {
+        return;
+    }
+    StatefulTimer::instance()->timeCheck("FusedGpuOp::run start");
+
+    string kernelName = getKernelName();
+    if(!cl->kernelExists(kernelName)) {
+        CLKernel *newKernel = cl->buildKernelFromString(getKernelSource(), "fused_op", "", "FusedGpuOp");
+        cl->storeKernel(kernelName, newKernel, true);
+    }
+    CLKernel *kernel = cl->getKernel(kernelName);
+
+    kernel->in(N);
+    for(int i = 0; i < (int)buffers.size(); i++) {
+        if(bufferWritten[i]) {
+            kernel->inout(buffers[i]);
+        } else {
+            kernel->in(buffers[i]);
+        }
+    }
+    for(int i = 0; i < (int)scalars.size(); i++) {
+        kernel->in(scalars[i]);
+    }
+    int globalSize = N;
+    int workgroupSize = 64;
+    int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
+    kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+
+    // ready for the next lot of assignments
+    N = -1;
+    buffers.clear();
+    bufferRead.clear();
+    bufferWritten.clear();
+    scalars.clear();
+    statements = "";
+
+    StatefulTimer::instance()->timeCheck("FusedGpuOp::run end");
+}
+// what the kernel for the assignments so far is stored under, in cl.  the
+// scalars are kernel arguments, so only the shape of the expressions counts
+PUBLIC std::string FusedGpuOp::getKernelName() {
+    return "FusedGpuOp::" + getKernelSource();
+}
+// each buffer is loaded into a private variable once, at the start, if it's
+// read at all, and stored once at the end, if it was written
+PUBLIC std::string FusedGpuOp::getKernelSource() {
+    string args = "const int N";
+    string loads = "";
+    string stores = "";
+    for(int i = 0; i < (int)buffers.size(); i++) {
+        string index = toString(i);
+        if(bufferWritten[i]) {
+            args += ", global float *buf" + index;
+            stores += "    buf" + index + "[globalId] = v" + index + ";\n";
+        } else {
+            args += ", global const float *buf" + index;
+        }
+        if(bufferRead[i]) {
+            loads += "    float v" + index + " = buf" + index + "[globalId];\n";
+        } else {
+            loads += "    float v" + index + ";\n";
+        }
+    }
+    for(int i = 0; i < (int)scalars.size(); i++) {
+        args += ", const float s" + toString(i);
+    }
+    string source = "";
+    source += "kernel void fused_op(" + args + ") {\n";
+    source += "    const int globalId = get_global_id(0);\n";
+    source += "    if (globalId >= N) {\n";
+    source += "        return;\n";
+    source += "    }\n";
+    source += loads;
+    source += statements;
+    source += stores;
+    source += "}\n";
+    return source;
+}
+PRIVATE void FusedGpuOp::checkSize(int size) {
+    if(size == -1) {
+        return;
+    }
+    if(N == -1) {
+        N = size;
+    }
+    if(size != N) {
+        throw runtime_error("FusedGpuOp array size mismatch, cannot combine " + toString(size) +
+            " vs " + toString(N) );
+    }
+}
+PRIVATE int FusedGpuOp::bufferIndex(CLFloatWrapper *wrapper) {
+    for(int i = 0; i < (int)buffers.size(); i++) {
+        if(buffers[i] == wrapper) {
+            return i;
+        }
+    }
+    buffers.push_back(wrapper);
+    bufferRead.push_back(false);
+    bufferWritten.push_back(false);
+    return (int)buffers.size() - 1;
+}
+// walks the postfix nodes with a stack, substituting each operand into the
+// val_one / val_two placeholders of the Op1 / Op2 operation strings
+PRIVATE std::string FusedGpuOp::render(const CLMathExpression &expression) {
+    vector<CLMathExpressionNode> const &nodes = expression.getNodes();
+    vector<string> stack;
+    for(int i = 0; i < (int)nodes.size(); i++) {
+        CLMathExpressionNode const &node = nodes[i];
+        if(node.type == CLMathExpressionNode::BUFFER) {
+            int index = bufferIndex(node.wrapper);
+            if(!bufferWritten[index]) {
+                bufferRead[index] = true;
+            }
+            stack.push_back("v" + toString(index));
+        } else if(node.type == CLMathExpressionNode::SCALAR) {
+            stack.push_back("s" + toString(scalars.size()));
+            scalars.push_back(node.scalar);
+        } else if(node.type == CLMathExpressionNode::OP1) {
+            string one = stack.back();
+            stack.pop_back();
+            stack.push_back("(" + replaceGlobal(node.operation, "val_one", one) + ")");
+        } else {
+            string two = stack.back();
+            stack.pop_back();
+            string one = stack.back();
+            stack.pop_back();
+            string operation = replaceGlobal(node.operation, "val_one", one);
+            stack.push_back("(" + replaceGlobal(operation, "val_two", two) + ")");
+        }
+    }
+    return stack.back();
+}
+
@@ -0,0 +1,75 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class CLFloatWrapper;
+class CLMathWrapper;
+class CLMathExpression;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// collects one or more assignments of CLMathExpressions to CLMathWrappers,
+// then runs them all as a single per-element kernel, eg
+//
+//     FusedGpuOp op(cl);
+//     op.assign(lastUpdates_, lastUpdates_ * momentum - gradWeights_ * learningRate);
+//     op.assign(weights_, weights_ + lastUpdates_);
+//     op.run();
+//
+// assignments happen in order, so later ones see the new values from
+// earlier ones.  each buffer is read at most once, and written at most once
+// the generated kernel is cached on the EasyCL object, keyed by the shape of
+// the expressions; scalars are passed as kernel arguments, so changing eg
+// the learning rate doesnt need a rebuild
+// doesnt call cl->finish(): anything that reads the results back via EasyCL
+// goes through the same queue
+class DeepCL_EXPORT FusedGpuOp {
+    private:
+    EasyCL *cl; // NOT belong to us, dont delete
+    int N;
+
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<CLFloatWrapper *> buffers; // dont delete
+    std::vector<bool> bufferRead; // read before it was first written, so needs loading
+    std::vector<bool> bufferWritten;
+    std::vector<float> scalars;
+    std::string statements;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    FusedGpuOp(EasyCL *cl);
+    VIRTUAL ~FusedGpuOp();
+    void assign(CLMathWrapper &target, const CLMathExpression &expression);
+    void run();
+    std::string getKernelName();
+    std::string getKernelSource();
+
+    private:
+    void checkSize(int size);
+    int bufferIndex(CLFloatWrapper *wrapper);
+    std::string render(const CLMathExpression &expression);
+
+    // [[[end]]]
+};
+
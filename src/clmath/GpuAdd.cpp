@@ -28,7 +28,6 @@ VIRTUAL void GpuAdd::add(int N, CLWrapper*destinationWrapper, CLWrapper *deltaWr
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("GpuAdd::add end");
 }
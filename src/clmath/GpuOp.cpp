@@ -35,7 +35,6 @@ VIRTUAL void GpuOp::apply2_inplace(int N, CLWrapper*destinationWrapper, float sc
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("GpuOp::apply inplace end");
 }
@@ -55,7 +54,6 @@ VIRTUAL void GpuOp::apply2_inplace(int N, CLWrapper*destinationWrapper, CLWrappe
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("GpuOp::apply inplace end");
 }
@@ -76,7 +74,6 @@ VIRTUAL void GpuOp::apply2_outofplace(int N, CLWrapper*destinationWrapper, CLWra
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("GpuOp::apply inplace end");
 }
@@ -95,7 +92,6 @@ VIRTUAL void GpuOp::apply1_inplace(int N, CLWrapper*destinationWrapper, Op1 *op)
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("GpuOp::apply inplace end");
 }
@@ -115,7 +111,6 @@ VIRTUAL void GpuOp::apply1_outofplace(int N, CLWrapper*destinationWrapper, CLWra
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("GpuOp::apply inplace end");
 }
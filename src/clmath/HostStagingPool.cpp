@@ -0,0 +1,86 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "util/stringhelper.h"
+#include "util/AllocationCounter.h"
+#include "clmath/HostStagingPool.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+#ifndef NOTHREADS
+#define HOSTSTAGINGPOOL_LOCK lock_guard<std::mutex> lock(mutex)
+#else
+#define HOSTSTAGINGPOOL_LOCK
+#endif
+
+std::multimap<int, float *> HostStagingPool::freeArrays;
+#ifndef NOTHREADS
+std::mutex HostStagingPool::mutex;
+#endif
+long HostStagingPool::numFreeFloats = 0;
+long HostStagingPool::maxFreeFloats = 16l * 1024l * 1024l;
+
+// an array of at least N floats, whose size goes in capacity
+// give it back with release, passing that capacity
+PUBLIC STATIC float *HostStagingPool::acquire(int N, int *capacity) {
+    {
+        HOSTSTAGINGPOOL_LOCK;
+        multimap<int, float *>::iterator it = freeArrays.lower_bound(N);
+        if(it != freeArrays.end() && it->first / 2 <= N) {
+            float *array = it->second;
+            *capacity = it->first;
+            numFreeFloats -= it->first;
+            freeArrays.erase(it);
+            return array;
+        }
+    }
+    AllocationCounter::countAllocation();
+    *capacity = N;
+    return new float[N];
+}
+PUBLIC STATIC void HostStagingPool::release(float *array, int capacity) {
+    if(array == 0) {
+        return;
+    }
+    {
+        HOSTSTAGINGPOOL_LOCK;
+        if(numFreeFloats + capacity <= maxFreeFloats) {
+            freeArrays.insert(pair<int, float *>(capacity, array));
+            numFreeFloats += capacity;
+            return;
+        }
+    }
+    delete[] array;
+}
+PUBLIC STATIC long HostStagingPool::getNumFreeFloats() {
+    HOSTSTAGINGPOOL_LOCK;
+    return numFreeFloats;
+}
+// default is 16M floats, ie 64MB; arrays already free over the new limit
+// are kept until clear()
+PUBLIC STATIC void HostStagingPool::setMaxFreeFloats(long maxFreeFloats) {
+    if(maxFreeFloats < 0) {
+        throw runtime_error("HostStagingPool::setMaxFreeFloats: maxFreeFloats should be at least 0, not " + toString(maxFreeFloats));
+    }
+    HOSTSTAGINGPOOL_LOCK;
+    HostStagingPool::maxFreeFloats = maxFreeFloats;
+}
+// frees the arrays waiting for reuse
+PUBLIC STATIC void HostStagingPool::clear() {
+    HOSTSTAGINGPOOL_LOCK;
+    for(multimap<int, float *>::iterator it = freeArrays.begin(); it != freeArrays.end(); it++) {
+        delete[] it->second;
+    }
+    freeArrays.clear();
+    numFreeFloats = 0;
+}
@@ -0,0 +1,55 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <map>
+#ifndef NOTHREADS
+#include <mutex>
+#endif
+
+#include "DeepCLDllExport.h"
+
+#define STATIC static
+#define VIRTUAL virtual
+
+// the host arrays that CLDeviceWrapper copies into, when a device-only
+// buffer is read from the host
+// arrays given back are kept for reuse, up to maxFreeFloats in all, so eg a
+// layer reallocating its buffers, for a new batch size, takes over the old
+// staging array, rather than allocating another
+// a free array is only handed out for a request of at least half its size
+class DeepCL_EXPORT HostStagingPool {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    STATIC std::multimap<int, float *> freeArrays; // by capacity
+    #ifndef NOTHREADS
+    STATIC std::mutex mutex;
+    #endif
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    STATIC long numFreeFloats;
+    STATIC long maxFreeFloats;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC float *acquire(int N, int *capacity);
+    STATIC void release(float *array, int capacity);
+    STATIC long getNumFreeFloats();
+    STATIC void setMaxFreeFloats(long maxFreeFloats);
+    STATIC void clear();
+
+    // [[[end]]]
+};
+
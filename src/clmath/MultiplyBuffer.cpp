@@ -30,7 +30,6 @@ VIRTUAL void MultiplyBuffer::multiply(int N, float multiplier, CLWrapper *in, CL
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("MultiplyBuffer::multiply end");
 }
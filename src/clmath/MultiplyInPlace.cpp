@@ -30,7 +30,6 @@ VIRTUAL void MultiplyInPlace::multiply(int N, float multiplier, CLWrapper *data)
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("MultiplyInPlace::multiply end");
 }
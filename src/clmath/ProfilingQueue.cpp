@@ -0,0 +1,45 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+#include "clmath/ProfilingQueue.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC STATIC bool ProfilingQueue::isEnabled(EasyCL *cl) {
+    cl_command_queue_properties properties = 0;
+    if(clGetCommandQueueInfo(*cl->queue, CL_QUEUE_PROPERTIES, sizeof(properties), &properties, 0) != CL_SUCCESS) {
+        return false;
+    }
+    return (properties & CL_QUEUE_PROFILING_ENABLE) != 0;
+}
+// returns whether cl's queue profiles now; if the new queue cant be created,
+// the old one is left as it was
+PUBLIC STATIC bool ProfilingQueue::enable(EasyCL *cl) {
+    cl_command_queue_properties properties = 0;
+    if(clGetCommandQueueInfo(*cl->queue, CL_QUEUE_PROPERTIES, sizeof(properties), &properties, 0) != CL_SUCCESS) {
+        return false;
+    }
+    if((properties & CL_QUEUE_PROFILING_ENABLE) != 0) {
+        return true;
+    }
+    cl_int error = CL_SUCCESS;
+    cl_command_queue profilingQueue = clCreateCommandQueue(*cl->context, cl->device,
+        properties | CL_QUEUE_PROFILING_ENABLE, &error);
+    if(error != CL_SUCCESS) {
+        return false;
+    }
+    cl->finish();
+    clReleaseCommandQueue(*cl->queue);
+    *cl->queue = profilingQueue;
+    return true;
+}
+
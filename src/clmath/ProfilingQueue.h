@@ -0,0 +1,37 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// turns on CL_QUEUE_PROFILING_ENABLE for an EasyCL's queue, so that markers
+// on it get device timestamps, for LayerTimer and KernelTimer
+// EasyCL creates its queue without profiling, and a queue's properties cant
+// be changed once it exists, so enable() waits for the queue to empty, then
+// swaps in a new one, on the same context and device.  EasyCL, clBLAS, and
+// our own wrappers all read *cl->queue each time they queue something, so
+// nothing holds on to the old one
+// nothing else should be queueing on cl, from another thread, meanwhile
+class DeepCL_EXPORT ProfilingQueue {
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC bool isEnabled(EasyCL *cl);
+    STATIC bool enable(EasyCL *cl);
+
+    // [[[end]]]
+};
+
@@ -33,7 +33,6 @@ VIRTUAL void AddBias::forward(
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::timeCheck("AddBias::forward after repeatedAdd");
 }
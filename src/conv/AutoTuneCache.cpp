@@ -0,0 +1,230 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "EasyCL.h"
+#include "util/stringhelper.h"
+#include "util/FileHelper.h"
+#include "conv/LayerDimensions.h"
+#include "conv/AutoTuneCache.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+#ifndef NOTHREADS
+#define AUTOTUNECACHE_LOCK lock_guard<std::mutex> lock(mutex)
+#else
+#define AUTOTUNECACHE_LOCK
+#endif
+
+// goes into every key.  the cached choices are indexes into the lists of
+// implementations in Forward, Backward and BackpropWeights, so bump this
+// whenever one of those lists is reordered, or has an entry replaced
+const int AutoTuneCache::keyVersion = 1;
+
+PUBLIC AutoTuneCache::AutoTuneCache(std::string filepath) :
+        filepath(filepath),
+        loaded(false) {
+}
+PUBLIC STATIC std::string AutoTuneCache::defaultFilepath() {
+    char const *fromEnv = getenv("DEEPCL_TUNE_CACHE");
+    if(fromEnv != 0) {
+        return fromEnv;
+    }
+    #ifdef _WIN32
+    char const *home = getenv("USERPROFILE");
+    #else
+    char const *home = getenv("HOME");
+    #endif
+    if(home == 0 || string(home) == "") {
+        return ".deepcl_tunecache.txt";
+    }
+    return string(home) + "/.deepcl_tunecache.txt";
+}
+PUBLIC STATIC AutoTuneCache *AutoTuneCache::instance() {
+    static AutoTuneCache *thisInstance = new AutoTuneCache(defaultFilepath());
+    return thisInstance;
+}
+// kind is eg "forward", "backward", "backpropweights".  numCandidates is how
+// many implementations there are of that kind, so that adding one also
+// starts afresh
+PUBLIC STATIC std::string AutoTuneCache::makeKey(EasyCL *cl, std::string kind, LayerDimensions const &dim, int batchSize,
+        int numCandidates) {
+    string key = deviceInfo(cl, CL_DEVICE_NAME) + "|" + deviceInfo(cl, CL_DRIVER_VERSION) + "|" + kind;
+    key += "|" + toString(dim.inputPlanes) + "," + toString(dim.inputSize) + "," + toString(dim.numFilters);
+    key += "," + toString(dim.filterSize) + "," + toString(dim.padZeros ? 1 : 0) + "," + toString(dim.biased ? 1 : 0);
+    key += "," + toString(dim.skip);
+    key += "|" + toString(batchSize);
+    key += "|v" + toString(keyVersion) + "," + toString(numCandidates);
+    return key;
+}
+PUBLIC std::string AutoTuneCache::getFilepath() const {
+    return filepath;
+}
+// empty filepath turns off reading and writing, but choices are still
+// remembered for the rest of this process
+PUBLIC void AutoTuneCache::setFilepath(std::string filepath) {
+    AUTOTUNECACHE_LOCK;
+    this->filepath = filepath;
+    loaded = false;
+}
+PUBLIC bool AutoTuneCache::lookup(std::string key, int *p_chosenIndex) {
+    AUTOTUNECACHE_LOCK;
+    if(!loaded) {
+        loadLocked();
+    }
+    map<string, AutoTuneCacheEntry>::iterator it = entries.find(key);
+    if(it == entries.end()) {
+        return false;
+    }
+    *p_chosenIndex = it->second.chosenIndex;
+    return true;
+}
+PUBLIC void AutoTuneCache::store(std::string key, int chosenIndex, std::vector<int> const &microseconds) {
+    AUTOTUNECACHE_LOCK;
+    AutoTuneCacheEntry entry;
+    entry.chosenIndex = chosenIndex;
+    entry.microseconds = microseconds;
+    entries[key] = entry;
+    saveLocked();
+}
+// the choice for this layer and batchSize, if there is one, and it's a valid
+// index into numCandidates kernels; a stale file, from a version with more
+// kernels, can have ones that arent
+PUBLIC bool AutoTuneCache::lookupChoice(EasyCL *cl, std::string kind, LayerDimensions const &dim, int batchSize,
+        int numCandidates, int *p_chosenIndex) {
+    int chosenIndex = -1;
+    if(!lookup(makeKey(cl, kind, dim, batchSize, numCandidates), &chosenIndex)) {
+        return false;
+    }
+    if(chosenIndex < 0 || chosenIndex >= numCandidates) {
+        return false;
+    }
+    *p_chosenIndex = chosenIndex;
+    return true;
+}
+PUBLIC void AutoTuneCache::storeChoice(EasyCL *cl, std::string kind, LayerDimensions const &dim, int batchSize,
+        int chosenIndex, std::vector<int> const &microseconds) {
+    store(makeKey(cl, kind, dim, batchSize, (int)microseconds.size()), chosenIndex, microseconds);
+}
+// drops what we have in memory; the file is read again next time
+PUBLIC void AutoTuneCache::clear() {
+    AUTOTUNECACHE_LOCK;
+    entries.clear();
+    loaded = false;
+}
+PUBLIC int AutoTuneCache::size() {
+    AUTOTUNECACHE_LOCK;
+    if(!loaded) {
+        loadLocked();
+    }
+    return (int)entries.size();
+}
+// one line per entry: key<tab>chosenIndex<tab>microseconds,microseconds,...
+// entries already in memory win over the ones in the file
+PRIVATE void AutoTuneCache::loadLocked() {
+    loaded = true;
+    if(filepath == "") {
+        return;
+    }
+    ifstream in(FileHelper::localizePath(filepath).c_str());
+    if(!in) {
+        return;
+    }
+    string line;
+    while(getline(in, line)) {
+        vector<string> fields = split(trim(line), "\t");
+        if(fields.size() != 3 || fields[0] == "") {
+            continue;
+        }
+        if(entries.find(fields[0]) != entries.end()) {
+            continue;
+        }
+        AutoTuneCacheEntry entry;
+        entry.chosenIndex = atoi(fields[1]);
+        vector<string> times = split(fields[2], ",");
+        for(int i = 0; i < (int)times.size(); i++) {
+            entry.microseconds.push_back(atoi(times[i]));
+        }
+        entries[fields[0]] = entry;
+    }
+}
+// picks up anything other processes added since we loaded, then writes
+// the lot to a file of our own, filepath~ plus our process id, and renames
+// that over filepath, so a reader sees either the old file or the new one
+// failing to write is not fatal: we just tune again next time
+PRIVATE void AutoTuneCache::saveLocked() {
+    if(filepath == "") {
+        return;
+    }
+    loadLocked();
+    ostringstream contents;
+    for(map<string, AutoTuneCacheEntry>::iterator it = entries.begin(); it != entries.end(); it++) {
+        contents << it->first << "\t" << it->second.chosenIndex << "\t";
+        for(int i = 0; i < (int)it->second.microseconds.size(); i++) {
+            if(i > 0) {
+                contents << ",";
+            }
+            contents << it->second.microseconds[i];
+        }
+        contents << "\n";
+    }
+    #ifdef _WIN32
+    string tempFilepath = filepath + "~" + toString(_getpid());
+    #else
+    string tempFilepath = filepath + "~" + toString(getpid());
+    #endif
+    {
+        ofstream out(FileHelper::localizePath(tempFilepath).c_str());
+        out << contents.str();
+        out.close();
+        if(!out) {
+            cout << "AutoTuneCache: couldnt write " << filepath << ", not saving kernel choices" << endl;
+            FileHelper::remove(tempFilepath);
+            return;
+        }
+    }
+    #ifdef _WIN32
+    // rename wont replace an existing file here
+    FileHelper::remove(filepath);
+    #endif
+    FileHelper::rename(tempFilepath, filepath);
+    if(FileHelper::exists(tempFilepath)) {
+        // someone else's rename won on windows; theirs has our entries
+        // too, unless they loaded before we stored, and then we retune
+        FileHelper::remove(tempFilepath);
+    }
+}
+// tabs and | are our separators, so they're blanked out of the device strings
+PRIVATE STATIC std::string AutoTuneCache::deviceInfo(EasyCL *cl, unsigned int param) {
+    char buffer[256];
+    buffer[0] = 0;
+    clGetDeviceInfo(cl->device, param, sizeof(buffer) - 1, buffer, 0);
+    buffer[sizeof(buffer) - 1] = 0;
+    string value = trim(buffer);
+    for(int i = 0; i < (int)value.size(); i++) {
+        if(value[i] == '\t' || value[i] == '|' || value[i] == '\n' || value[i] == '\r') {
+            value[i] = ' ';
+        }
+    }
+    return value;
+}
+
@@ -0,0 +1,93 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <map>
+#include <vector>
+
+#include "util/ThreadPool.h"
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class LayerDimensions;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// one tuned choice: which kernel index won, and the median time each
+// candidate took, in microseconds, or -1 for candidates that were skipped,
+// or couldnt be used
+class DeepCL_EXPORT AutoTuneCacheEntry {
+public:
+    int chosenIndex;
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<int> microseconds;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+};
+
+// remembers which kernel ForwardAuto, BackwardAuto and BackpropWeightsAuto
+// picked, keyed by device name, driver version, LayerDimensions and
+// batchSize, in a small text file, so later processes can skip the tuning
+//
+// the file is $DEEPCL_TUNE_CACHE if that is set (set it to empty to turn
+// the cache off), otherwise .deepcl_tunecache.txt in the home directory
+// it's read the first time it's needed, and rewritten each time a new
+// choice is stored.  the `tune` tool fills it in ahead of time
+class DeepCL_EXPORT AutoTuneCache {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::string filepath;
+    std::map<std::string, AutoTuneCacheEntry> entries;
+    #ifndef NOTHREADS
+    std::mutex mutex;
+    #endif
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    bool loaded;
+
+    STATIC const int keyVersion;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    AutoTuneCache(std::string filepath);
+    STATIC std::string defaultFilepath();
+    STATIC AutoTuneCache *instance();
+    STATIC std::string makeKey(EasyCL *cl, std::string kind, LayerDimensions const &dim, int batchSize,
+    int numCandidates);
+    std::string getFilepath() const;
+    void setFilepath(std::string filepath);
+    bool lookup(std::string key, int *p_chosenIndex);
+    void store(std::string key, int chosenIndex, std::vector<int> const &microseconds);
+    bool lookupChoice(EasyCL *cl, std::string kind, LayerDimensions const &dim, int batchSize,
+    int numCandidates, int *p_chosenIndex);
+    void storeChoice(EasyCL *cl, std::string kind, LayerDimensions const &dim, int batchSize,
+    int chosenIndex, std::vector<int> const &microseconds);
+    void clear();
+    int size();
+
+    private:
+    void loadLocked();
+    void saveLocked();
+    STATIC std::string deviceInfo(EasyCL *cl, unsigned int param);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,135 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "util/StatefulTimer.h"
+#include "util/stringhelper.h"
+#include "conv/AutoTuneCache.h"
+#include "conv/AutoTuner.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+int AutoTuner::warmupRuns = 1;
+int AutoTuner::timedRuns = 5;
+
+// kind is the name used in the cache keys, and the messages, eg "forward"
+PUBLIC AutoTuner::AutoTuner(EasyCL *cl, std::string kind, LayerDimensions dim, int num) :
+        cl(cl),
+        dim(dim),
+        num(num),
+        kind(kind) {
+}
+// the warmup runs arent timed: they cover kernel builds, eg in clblas,
+// and first-touch costs
+PUBLIC STATIC void AutoTuner::setRuns(int warmupRuns, int timedRuns) {
+    if(warmupRuns < 0 || timedRuns < 1) {
+        throw runtime_error("AutoTuner::setRuns: need warmupRuns >= 0 and timedRuns >= 1, not " +
+            toString(warmupRuns) + " and " + toString(timedRuns));
+    }
+    AutoTuner::warmupRuns = warmupRuns;
+    AutoTuner::timedRuns = timedRuns;
+}
+PUBLIC STATIC int AutoTuner::getWarmupRuns() {
+    return warmupRuns;
+}
+PUBLIC STATIC int AutoTuner::getTimedRuns() {
+    return timedRuns;
+}
+PUBLIC STATIC float AutoTuner::median(std::vector<float> values) {
+    if(values.size() == 0) {
+        return -1;
+    }
+    sort(values.begin(), values.end());
+    int mid = (int)values.size() / 2;
+    if(values.size() % 2 == 1) {
+        return values[mid];
+    }
+    return (values[mid - 1] + values[mid]) / 2.0f;
+}
+// -1 if this batchSize is still being tuned
+PUBLIC int AutoTuner::getChosenIndex(int batchSize) {
+    return getState(batchSize).chosenIndex;
+}
+// true until a kernel is chosen, or read from the cache, for this batchSize
+PUBLIC bool AutoTuner::isTuning(int batchSize) {
+    return getState(batchSize).chosenIndex == -1;
+}
+// -1 once every candidate has had its turn; caller should then choose()
+PUBLIC int AutoTuner::nextCandidate(int batchSize) {
+    AutoTunerBatchState &state = getState(batchSize);
+    if(state.nextIndex >= num) {
+        return -1;
+    }
+    return state.nextIndex++;
+}
+PUBLIC void AutoTuner::recordTimes(int batchSize, int index, std::vector<float> const &microseconds) {
+    float thisMedian = median(microseconds);
+    getState(batchSize).medianMicroseconds[index] = thisMedian;
+    cout << StatefulTimer::instance()->prefix << kind << " kernel " << index << " batchsize " << batchSize << ": median " <<
+        thisMedian << "us over " << microseconds.size() << " runs" << endl;
+}
+PUBLIC void AutoTuner::markUnusable(int batchSize, int index, std::string reason) {
+    getState(batchSize).medianMicroseconds[index] = -1;
+    cout << StatefulTimer::instance()->prefix << kind << " kernel " << index << ": this instance cant be used: " << reason << endl;
+}
+// eg when the cached choice cant be instantiated any more: start tuning
+// this batchSize from scratch
+PUBLIC void AutoTuner::forgetChoice(int batchSize) {
+    AutoTunerBatchState &state = getState(batchSize);
+    state.chosenIndex = -1;
+    state.nextIndex = 0;
+}
+// lowest median wins; ties go to the lower index
+PUBLIC int AutoTuner::choose(int batchSize) {
+    AutoTunerBatchState &state = getState(batchSize);
+    int bestIndex = -1;
+    for(int i = 0; i < num; i++) {
+        float thisTime = state.medianMicroseconds[i];
+        if(thisTime < 0) {
+            continue;
+        }
+        if(bestIndex == -1 || thisTime < state.medianMicroseconds[bestIndex]) {
+            bestIndex = i;
+        }
+    }
+    if(bestIndex == -1) {
+        throw runtime_error(StatefulTimer::instance()->prefix + "No valid " + kind + " implementations found");
+    }
+    cout << StatefulTimer::instance()->prefix << kind << " batchsize " << batchSize << " selected kernel " << bestIndex << endl;
+    state.chosenIndex = bestIndex;
+    vector<int> microseconds;
+    for(int i = 0; i < num; i++) {
+        microseconds.push_back((int)(state.medianMicroseconds[i] + 0.5f));
+    }
+    AutoTuneCache::instance()->storeChoice(cl, kind, dim, batchSize, bestIndex, microseconds);
+    return bestIndex;
+}
+// the first time we see a batchSize, we check the cache for it
+PRIVATE AutoTunerBatchState &AutoTuner::getState(int batchSize) {
+    map<int, AutoTunerBatchState>::iterator it = states.find(batchSize);
+    if(it != states.end()) {
+        return it->second;
+    }
+    AutoTunerBatchState &state = states[batchSize];
+    state.chosenIndex = -1;
+    state.nextIndex = 0;
+    state.medianMicroseconds = vector<float>(num, -1.0f);
+    int cachedIndex = -1;
+    if(AutoTuneCache::instance()->lookupChoice(cl, kind, dim, batchSize, num, &cachedIndex)) {
+        cout << StatefulTimer::instance()->prefix << kind << " batchsize " << batchSize << ": using cached kernel " << cachedIndex << endl;
+        state.chosenIndex = cachedIndex;
+    }
+    return state;
+}
+
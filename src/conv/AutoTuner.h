@@ -0,0 +1,87 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "conv/LayerDimensions.h"
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// how far tuning has got, for one batchSize
+// medianMicroseconds is -1 for candidates not timed (yet), or that couldnt be used
+class DeepCL_EXPORT AutoTunerBatchState {
+public:
+    int chosenIndex;
+    int nextIndex;
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<float> medianMicroseconds;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+};
+
+// bookkeeping shared by ForwardAuto, BackwardAuto and BackpropWeightsAuto:
+// which candidate each batchSize should try next, the median of its timed
+// runs, and, once every candidate has had a turn, the fastest one
+// each batchSize is tuned separately, since which kernels are plausible,
+// and which is fastest, depends on it.  choices are stored in, and
+// read back from, the AutoTuneCache
+// the Auto classes do the running and timing themselves, since the
+// arguments differ for each
+class DeepCL_EXPORT AutoTuner {
+    private:
+    EasyCL *cl; // NOT owned by us
+    LayerDimensions dim;
+    int num;
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::string kind;
+    std::map<int, AutoTunerBatchState> states;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+
+    STATIC int warmupRuns;
+    STATIC int timedRuns;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    AutoTuner(EasyCL *cl, std::string kind, LayerDimensions dim, int num);
+    STATIC void setRuns(int warmupRuns, int timedRuns);
+    STATIC int getWarmupRuns();
+    STATIC int getTimedRuns();
+    STATIC float median(std::vector<float> values);
+    int getChosenIndex(int batchSize);
+    bool isTuning(int batchSize);
+    int nextCandidate(int batchSize);
+    void recordTimes(int batchSize, int index, std::vector<float> const &microseconds);
+    void markUnusable(int batchSize, int index, std::string reason);
+    void forgetChoice(int batchSize);
+    int choose(int batchSize);
+
+    private:
+    AutoTunerBatchState &getState(int batchSize);
+
+    // [[[end]]]
+};
+
@@ -16,6 +16,8 @@
 #include "BackpropWeightsScratch.h"
 #include "BackpropWeightsScratchLarge.h"
 #include "BackpropWeightsIm2Col.h"
+#include "BackpropWeightsFft.h"
+#include "Fft.h"
 #include "BackpropWeightsAuto.h"
 
 using namespace std;
@@ -46,17 +48,27 @@ STATIC BackpropWeights *BackpropWeights::instance(EasyCL *cl, LayerDimensions di
 //    }
 }
 STATIC int BackpropWeights::getNumImplementations() {
-    return 5;
+    return 6;
 }
 STATIC bool BackpropWeights::plausiblyOptimal(int index, int batchSize, LayerDimensions dim) {
     if(index == 0) { 
         return false;
     }
-    if(index >= 5) {
+    if(index >= 6) {
+        return false;
+    }
+    if(index == 5 && (!Fft::supports(dim) || dim.filterSize < 7)) {
+        return false;
+    }
+    if(dim.skip > 0 && !supportsSkip(index)) {
         return false;
     }
     return true;
 }
+// which implementations can handle skip > 0, ie a stride other than 1
+STATIC bool BackpropWeights::supportsSkip(int index) {
+    return index == 0 || index == 4;
+}
 STATIC BackpropWeights *BackpropWeights::instanceForTest(EasyCL *cl, LayerDimensions layerDimensions) {
     return new BackpropWeightsScratchLarge(cl, layerDimensions);
 }
@@ -64,6 +76,9 @@ STATIC BackpropWeights *BackpropWeights::instanceSpecific(int idx, EasyCL *cl, L
     if(idx == -1) {
         return new BackpropWeightsAuto(cl, layerDimensions);
     }
+    if(layerDimensions.skip > 0 && !supportsSkip(idx)) {
+        throw std::runtime_error("BackpropWeights::instanceSpecific: implementation " + toString(idx) + " doesnt support skip > 0");
+    }
     if(idx == 0) {
         return new BackpropWeightsCpu(cl, layerDimensions);
     }
@@ -79,6 +94,9 @@ STATIC BackpropWeights *BackpropWeights::instanceSpecific(int idx, EasyCL *cl, L
     if(idx == 4) {
         return new BackpropWeightsIm2Col(cl, layerDimensions);
     }
+    if(idx == 5) {
+        return new BackpropWeightsFft(cl, layerDimensions);
+    }
     throw std::runtime_error("BackpropWeights::instanceSpecific doesnt handle idx " + toString(idx));
 }
 
@@ -24,6 +24,8 @@ public:
     bool debug; // = false;
 
     virtual ~BackpropWeights() {}
+    // true while calcGradWeights calls, at this batchSize, are still timing kernels
+    virtual bool isTuning(int batchSize) { return false; }
     virtual void calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *inputsWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) = 0;
 
     // [[[cog
@@ -35,6 +37,7 @@ public:
     STATIC BackpropWeights *instance(EasyCL *cl, LayerDimensions dim);
     STATIC int getNumImplementations();
     STATIC bool plausiblyOptimal(int index, int batchSize, LayerDimensions dim);
+    STATIC bool supportsSkip(int index);
     STATIC BackpropWeights *instanceForTest(EasyCL *cl, LayerDimensions layerDimensions);
     STATIC BackpropWeights *instanceSpecific(int idx, EasyCL *cl, LayerDimensions layerDimensions);
     VIRTUAL void calcGradWeights(int batchSize, float *gradOutput, float *inputs, float *gradWeights, float *gradBias);
@@ -9,9 +9,10 @@
 #include <stdexcept>
 
 #include "conv/BackpropWeightsAuto.h"
+#include "conv/AutoTuner.h"
+#include "conv/KernelTimer.h"
 #include "util/stringhelper.h"
 #include "util/StatefulTimer.h"
-#include "util/Timer.h"
 
 using namespace std;
 
@@ -23,21 +24,15 @@ using namespace std;
 
 BackpropWeightsAuto::BackpropWeightsAuto(EasyCL *cl, LayerDimensions dim) :
         BackpropWeights(cl, dim),
-        milliseconds(0),
-        valid(0),
-        chosenIndex(-1),
-        instances(0)
+        instances(0),
+        tuner(0)
          {
     num = BackpropWeights::getNumImplementations();
-    milliseconds = new int[ num];
-    valid = new bool[ num ];
     instances = new BackpropWeights *[ num ];
     for(int i = 0; i < num; i++) {
         instances[i] = 0;
-        valid[i] = false;
-        milliseconds[i] = -1;
     }
-    nextIndex = 0;
+    tuner = new AutoTuner(cl, "backpropweights", dim, num);
 }
 VIRTUAL BackpropWeightsAuto::~BackpropWeightsAuto() {
     for(int i = 0; i < num; i++) {
@@ -45,73 +40,61 @@ VIRTUAL BackpropWeightsAuto::~BackpropWeightsAuto() {
             delete instances[i];
         }
     }
+    delete[] instances;
+    delete tuner;
 }
+VIRTUAL bool BackpropWeightsAuto::isTuning(int batchSize) {
+    return tuner->isTuning(batchSize);
+}
+// while a batchSize is being tuned, each call times one more candidate:
+// a warmup run, then AutoTuner::getTimedRuns() timed runs, keeping the
+// median.  the output is from the candidate's last run
 VIRTUAL void BackpropWeightsAuto::calcGradWeights(
         int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *weightsWrapper,
         CLWrapper *gradInput) {
-    while(chosenIndex == -1 && nextIndex < num) {
-        int thisIndex = nextIndex;
-        nextIndex++;
-        cout << "calcGradWeights try kernel " << thisIndex << endl;
-        if(BackpropWeights::plausiblyOptimal(thisIndex, batchSize, dim)) {
-            BackpropWeights *candidate = 0;
-            try {
-                candidate = BackpropWeights::instanceSpecific(thisIndex, cl, dim);
-                instances[thisIndex] = candidate;
-                valid[thisIndex] = true;
-                cout << "   ... seems valid" << endl;
-            } catch(runtime_error &e) {
-                cout << StatefulTimer::instance()->prefix << "BackpropWeightsAuto: kernel " << thisIndex << ": this instance cant be used: " << e.what() << endl;
-                valid[thisIndex] = false;
-            }
-            if(valid[thisIndex]) {
-                Timer timer;
-                try {
-                    candidate->calcGradWeights(batchSize, inputDataWrapper, gradOutput, weightsWrapper, gradInput);
-                    milliseconds[thisIndex] = (int)timer.lap();
-                    cout << StatefulTimer::instance()->prefix << "BackpropWeightsAuto: kernel " << thisIndex << " " << milliseconds[thisIndex] << "ms" << endl;
-                    return;
-                } catch(runtime_error &e) {
-                    cout << StatefulTimer::instance()->prefix << "BackpropWeightsAuto: kernel " << thisIndex << " this instance cant be used: " << e.what() << endl;
-                    valid[thisIndex] = false;
-                    delete instances[thisIndex];
-                    instances[thisIndex] = 0;
-                }
-            } else {
-                cout << "   ... not valid" << endl;
-            }
-        } else {
-            cout << "  ... not plausibly optimal, skipping" << endl;
+    int index = tuner->getChosenIndex(batchSize);
+    if(index != -1 && instances[index] == 0) {
+        // chosen by an earlier run, and read from the cache
+        try {
+            instances[index] = BackpropWeights::instanceSpecific(index, cl, dim);
+        } catch(runtime_error &e) {
+            tuner->markUnusable(batchSize, index, e.what());
+            tuner->forgetChoice(batchSize);
+            index = -1;
         }
     }
-    if(chosenIndex == -1) {
-//        cout << StatefulTimer::instance()->prefix + "BackpropWeightsAuto::calcGradWeights choosing best instance:" << endl;
-        int bestIndex = -1;
-        int bestTime = 0;
-        for(int i = 0; i < num; i++) {
-            if(!valid[i]) {
-                cout << "   calcGradWeights kernel " << i << ": cannot be used" << endl;
-                continue;
+    while(index == -1) {
+        int thisIndex = tuner->nextCandidate(batchSize);
+        if(thisIndex == -1) {
+            index = tuner->choose(batchSize);
+            break;
+        }
+        if(!BackpropWeights::plausiblyOptimal(thisIndex, batchSize, dim)) {
+            continue;
+        }
+        try {
+            if(instances[thisIndex] == 0) {
+                instances[thisIndex] = BackpropWeights::instanceSpecific(thisIndex, cl, dim);
             }
-            cout << "   calcGradWeights kernel " << i << " time: " << milliseconds[i] << "ms" << endl;
-            if(bestIndex == -1) {
-                bestIndex = i;
-                bestTime = milliseconds[i];
-                continue;
+            BackpropWeights *candidate = instances[thisIndex];
+            for(int i = 0; i < AutoTuner::getWarmupRuns(); i++) {
+                candidate->calcGradWeights(batchSize, inputDataWrapper, gradOutput, weightsWrapper, gradInput);
             }
-            if(milliseconds[i] < bestTime) {
-                bestTime = milliseconds[i];
-                bestIndex = i;
+            KernelTimer timer(cl);
+            vector<float> microseconds;
+            for(int i = 0; i < AutoTuner::getTimedRuns(); i++) {
+                timer.start();
+                candidate->calcGradWeights(batchSize, inputDataWrapper, gradOutput, weightsWrapper, gradInput);
+                microseconds.push_back(timer.stop());
             }
-        }
-        if(bestIndex != -1) {
-            cout << "   calcGradWeights layer selected kernel " << bestIndex << endl;
-            this->chosenIndex = bestIndex;
-        } else {
-            throw runtime_error(StatefulTimer::instance()->prefix + "No valid calcGradWeights implementations found");
+            tuner->recordTimes(batchSize, thisIndex, microseconds);
+            return;
+        } catch(runtime_error &e) {
+            tuner->markUnusable(batchSize, thisIndex, e.what());
+            delete instances[thisIndex];
+            instances[thisIndex] = 0;
         }
     }
-//    cout << "BackpropWeightsAuto::calcGradWeights using instance index: " << chosenIndex << endl;
-    instances[chosenIndex]->calcGradWeights(batchSize, inputDataWrapper, gradOutput, weightsWrapper, gradInput);
+    instances[index]->calcGradWeights(batchSize, inputDataWrapper, gradOutput, weightsWrapper, gradInput);
 }
 
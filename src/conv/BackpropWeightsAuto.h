@@ -16,6 +16,8 @@
 #include "conv/LayerDimensions.h"
 #include "DeepCLDllExport.h"
 
+class AutoTuner;
+
 using namespace std;
 
 //inline float square(float value) {
@@ -32,11 +34,8 @@ public:
 //    ActivationFunction const*fn;
 
     int num;
-    int *milliseconds;
-    bool *valid;
-    int chosenIndex;
     BackpropWeights **instances;
-    int nextIndex;
+    AutoTuner *tuner;
 
     // [[[cog
     // import cog_addheaders
@@ -45,6 +44,7 @@ public:
     // generated, using cog:
     BackpropWeightsAuto(EasyCL *cl, LayerDimensions dim);
     VIRTUAL ~BackpropWeightsAuto();
+    VIRTUAL bool isTuning(int batchSize);
     VIRTUAL void calcGradWeights(
     int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *weightsWrapper,
     CLWrapper *gradInput);
@@ -46,6 +46,7 @@ VIRTUAL void BackpropWeightsCpu::calcGradWeights(int batchSize, float *gradOutpu
 
     const int halfFilterSize = dim.filterSize >> 1;
     const int margin = dim.padZeros ? halfFilterSize : 0;
+    const int stride = dim.skip + 1;
     for(int outPlane = 0; outPlane < dim.numFilters; outPlane++) {
         for(int inputPlane = 0; inputPlane < dim.inputPlanes; inputPlane++) {
             for(int filterRow = 0; filterRow < dim.filterSize; filterRow++) {
@@ -59,12 +60,12 @@ VIRTUAL void BackpropWeightsCpu::calcGradWeights(int batchSize, float *gradOutpu
                     // gradWeights:     [outPlane][inputPlane][filterRow][filterCol]
                     //       aggregate over:  [outRow][outCol][n]
                     for(int outRow = 0; outRow < dim.outputSize; outRow++) {
-                        int inputRow = outRow - margin + filterRow;
+                        int inputRow = outRow * stride - margin + filterRow;
                         if(inputRow < 0 || inputRow > dim.inputSize - 1) {
                             continue;
                         }
                         for(int outCol = 0; outCol < dim.outputSize; outCol++) {
-                            int inputCol = outCol - margin + filterCol;
+                            int inputCol = outCol * stride - margin + filterCol;
                             if(inputCol < 0 || inputCol > dim.inputSize - 1) {
                                 continue;
                             }
@@ -0,0 +1,82 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "util/stringhelper.h"
+#include "util/StatefulTimer.h"
+#include "clmath/CLMathWrapper.h"
+#include "conv/Fft.h"
+#include "conv/Im2ColWorkspace.h"
+#include "conv/BackpropWeightsFft.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC BackpropWeightsFft::BackpropWeightsFft(EasyCL *cl, LayerDimensions dim) :
+            BackpropWeights(cl, dim),
+            fft(0),
+            inputWorkspace(0),
+            gradOutputWorkspace(0),
+            gradWeightsWorkspace(0) {
+    if(!Fft::supports(dim)) {
+        throw runtime_error("BackpropWeightsFft needs skip 0, and padded inputs of at most 256, not skip " +
+            toString(dim.skip) + " fft size " + toString(Fft::fftSizeFor(dim)));
+    }
+    fft = new Fft(cl, Fft::fftSizeFor(dim));
+    inputWorkspace = new Im2ColWorkspace(cl);
+    gradOutputWorkspace = new Im2ColWorkspace(cl);
+    gradWeightsWorkspace = new Im2ColWorkspace(cl);
+}
+PUBLIC VIRTUAL BackpropWeightsFft::~BackpropWeightsFft() {
+    delete fft;
+    delete inputWorkspace;
+    delete gradOutputWorkspace;
+    delete gradWeightsWorkspace;
+}
+// as forward, the images are shifted by the padding, and then gradWeights
+// start at (0, 0) of the correlation
+PUBLIC VIRTUAL void BackpropWeightsFft::calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *inputWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
+    StatefulTimer::timeCheck("BackpropWeightsFft::calcGradWeights START");
+    const int fftSize = fft->getFftSize();
+    const long planeFloats = 2l * fftSize * fftSize;
+    const int padding = dim.padZeros ? dim.halfFilterSize : 0;
+
+    int chunkSize = Im2ColWorkspace::imagesPerChunk(batchSize, planeFloats * (dim.inputPlanes + dim.numFilters));
+    CLWrapper *inputFreqWrapper = inputWorkspace->get((int)(chunkSize * dim.inputPlanes * planeFloats));
+    CLWrapper *gradOutputFreqWrapper = gradOutputWorkspace->get((int)(chunkSize * dim.numFilters * planeFloats));
+    CLWrapper *gradWeightsFreqWrapper = gradWeightsWorkspace->get((int)(dim.numFilters * dim.inputPlanes * planeFloats));
+    if(dim.biased) {
+        CLMathWrapper gradBias_(gradBiasWrapper);
+        gradBias_ = 0.0f;
+    }
+    for(int b = 0; b < batchSize; b += chunkSize) {
+        int numImages = std::min(chunkSize, batchSize - b);
+        fft->forwardPlanes(inputWrapper, b * dim.inputCubeSize, numImages * dim.inputPlanes,
+            dim.inputSize, padding, inputFreqWrapper);
+        fft->forwardPlanes(gradOutputWrapper, b * dim.outputCubeSize, numImages * dim.numFilters,
+            dim.outputSize, 0, gradOutputFreqWrapper);
+        // [filter][inputplane] += sum over image of [image][inputplane] * conj([image][filter])
+        fft->multiplyAccumulate(
+            dim.numFilters, dim.inputPlanes, numImages,
+            inputFreqWrapper, 0, 1, dim.inputPlanes,
+            gradOutputFreqWrapper, 1, 0, dim.numFilters,
+            true, b > 0, gradWeightsFreqWrapper);
+        if(dim.biased) {
+            fft->addDcTerms(gradOutputFreqWrapper, numImages, dim.numFilters, gradBiasWrapper);
+        }
+    }
+    fft->inversePlanes(gradWeightsFreqWrapper, dim.numFilters * dim.inputPlanes, 0, dim.filterSize,
+        gradWeightsWrapper, 0);
+    StatefulTimer::timeCheck("BackpropWeightsFft::calcGradWeights END");
+}
+
@@ -0,0 +1,43 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "BackpropWeights.h"
+
+class Fft;
+class Im2ColWorkspace;
+
+#include "DeepCLDllExport.h"
+
+#define STATIC static
+#define VIRTUAL virtual
+
+// gradWeights are the input correlated with gradOutput, summed over the
+// images.  the sum is kept in the frequency domain, over all the chunks of
+// the batch, so there's only one inverse transform, of filter size planes.
+// the bias gradients are the dc terms of the transformed gradOutput.  no skip
+class DeepCL_EXPORT BackpropWeightsFft : public BackpropWeights {
+    private:
+    Fft *fft;
+    Im2ColWorkspace *inputWorkspace;
+    Im2ColWorkspace *gradOutputWorkspace;
+    Im2ColWorkspace *gradWeightsWorkspace;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    BackpropWeightsFft(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~BackpropWeightsFft();
+    VIRTUAL void calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *inputWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper);
+
+    // [[[end]]]
+};
+
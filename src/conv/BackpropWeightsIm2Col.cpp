@@ -2,6 +2,7 @@
 #include "util/stringhelper.h"
 #include "util/StatefulTimer.h"
 
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <string>
@@ -10,6 +11,7 @@
 #include "clblas/ClBlasHelper.h"
 #include "BackpropWeightsIm2Col.h"
 #include "conv/Im2Col.h"
+#include "conv/Im2ColWorkspace.h"
 #include "clmath/CLMathWrapper.h"
 
 using namespace std;
@@ -23,33 +25,47 @@ using namespace std;
 #define PUBLIC
 
 PUBLIC BackpropWeightsIm2Col::BackpropWeightsIm2Col(EasyCL *cl, LayerDimensions dim) :
-            BackpropWeights(cl, dim)
+            BackpropWeights(cl, dim),
+            onesFilled(0)
         {
 //    ClBlasInstance::initializeIfNecessary();
 
 //    addBias = new AddBias(cl);
 
     this->im2Col = new Im2Col(cl, dim);
+    columnsWorkspace = new Im2ColWorkspace(cl);
+    gradOutputWorkspace = new Im2ColWorkspace(cl);
+    onesWorkspace = new Im2ColWorkspace(cl);
 }
 PUBLIC VIRTUAL BackpropWeightsIm2Col::~BackpropWeightsIm2Col() {
     delete im2Col;
+    delete columnsWorkspace;
+    delete gradOutputWorkspace;
+    delete onesWorkspace;
 //    delete addBias;
 }
+// as ForwardIm2Col, several images per gemm: the gemm over a chunk's
+// columns, against its gradOutput swapped into [filter][image][pixel] order,
+// sums the chunk's gradWeights in one go
 //int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *imagesWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper
 PUBLIC VIRTUAL void BackpropWeightsIm2Col::calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *inputWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
     StatefulTimer::timeCheck("BackpropWeightsIm2Col::calcGradWeights START");
 
-    int columnsSize = dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared;
-    float *columns = new float[columnsSize];
-    CLWrapper *columnsWrapper = cl->wrap(columnsSize, columns);
-    columnsWrapper->createOnDevice();
-
-    int onesSize = dim.outputSizeSquared;
-    float *ones = new float[onesSize];
-    CLWrapper *onesWrapper = cl->wrap(onesSize, ones);
-    onesWrapper->createOnDevice();
-    CLMathWrapper ones_(onesWrapper);
-    ones_ = 1.0f;
+    int64 m = dim.inputPlanes * dim.filterSizeSquared;
+    int64 n = dim.numFilters;
+    int64 pixels = dim.outputSizeSquared;
+    int chunkSize = Im2ColWorkspace::imagesPerChunk(batchSize, m * pixels + n * pixels);
+    CLWrapper *columnsWrapper = columnsWorkspace->get((int)(chunkSize * m * pixels));
+    CLWrapper *gradOutputSwappedWrapper = chunkSize > 1 ? gradOutputWorkspace->get((int)(chunkSize * n * pixels)) : 0;
+    CLWrapper *onesWrapper = 0;
+    if(dim.biased) {
+        onesWrapper = onesWorkspace->get((int)(chunkSize * pixels));
+        if(onesFilled < onesWorkspace->getAllocated()) {
+            CLMathWrapper ones_(onesWrapper);
+            ones_ = 1.0f;
+            onesFilled = onesWorkspace->getAllocated();
+        }
+    }
 
 //    cout << "gradColumnsSize: " << gradColumnsSize << endl;
 //    cout << "weightsize: " << weightsWrapper->size() << endl;
@@ -62,17 +78,22 @@ PUBLIC VIRTUAL void BackpropWeightsIm2Col::calcGradWeights(int batchSize, CLWrap
         CLMathWrapper gradBias_(gradBiasWrapper);
         gradBias_ = 0.0f;
     }
-    for (int b = 0; b < batchSize; b ++) {
-//        cout << "b=" << b << " numkernels=" << numKernels << endl;
+    for (int b = 0; b < batchSize; b += chunkSize) {
+        int numImages = std::min(chunkSize, batchSize - b);
+//        cout << "b=" << b << " numImages=" << numImages << endl;
 
-        im2Col->im2Col(
-            inputWrapper, b * dim.inputCubeSize,
+        im2Col->im2ColBatched(
+            inputWrapper, b * dim.inputCubeSize, numImages,
             columnsWrapper
         );
-        
-        int64 m = dim.inputPlanes * dim.filterSizeSquared;
-        int64 n = dim.numFilters;
-        int64 k = dim.outputSizeSquared;
+        CLWrapper *gemmInputWrapper = gradOutputWrapper;
+        int gemmInputOffset = b * dim.outputCubeSize;
+        if(numImages > 1) {
+            im2Col->swapOuterDims(gradOutputWrapper, b * dim.outputCubeSize, numImages, (int)n, (int)pixels, gradOutputSwappedWrapper, 0);
+            gemmInputWrapper = gradOutputSwappedWrapper;
+            gemmInputOffset = 0;
+        }
+        int64 k = numImages * pixels;
 
         ClBlasHelper::Gemm(
             cl,
@@ -81,20 +102,18 @@ PUBLIC VIRTUAL void BackpropWeightsIm2Col::calcGradWeights(int batchSize, CLWrap
             m, k, n,
             1,
             columnsWrapper, 0,
-            gradOutputWrapper, b * dim.outputCubeSize,
+            gemmInputWrapper, gemmInputOffset,
             1,
             gradWeightsWrapper, 0
         );
         if(dim.biased) {
-            int64 m_ = dim.outputSizeSquared;
-            int64 n_ = dim.numFilters;
             ClBlasHelper::Gemv(
                 cl,
                 clblasColumnMajor,
                 clblasTrans,
-                m_, n_,
+                k, n,
                 1,
-                gradOutputWrapper, b * dim.outputCubeSize,
+                gemmInputWrapper, gemmInputOffset,
                 onesWrapper, 0,
                 1,
                 gradBiasWrapper, 0
@@ -102,12 +121,6 @@ PUBLIC VIRTUAL void BackpropWeightsIm2Col::calcGradWeights(int batchSize, CLWrap
         }
     }
 
-    delete onesWrapper;
-    delete[] ones;
-
-    delete columnsWrapper;
-    delete[] columns;
-
     StatefulTimer::timeCheck("BackpropWeightsIm2Col::calcGradWeights after call calcGradWeights");
 
     StatefulTimer::timeCheck("BackpropWeightsIm2Col::calcGradWeights END");
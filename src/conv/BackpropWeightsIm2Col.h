@@ -6,6 +6,7 @@
 #include "DeepCLDllExport.h"
 
 class Im2Col;
+class Im2ColWorkspace;
 class CLWrapper;
 class EasyCL;
 class CLKernel;
@@ -18,9 +19,10 @@ class DeepCL_EXPORT BackpropWeightsIm2Col : public BackpropWeights {
 //    CLKernel *kernelIm2Col;
     Im2Col *im2Col;
 
-    float *columns;
-    CLWrapper *columnsWrapper;
-    int numKernels;
+    Im2ColWorkspace *columnsWorkspace;
+    Im2ColWorkspace *gradOutputWorkspace;
+    Im2ColWorkspace *onesWorkspace;
+    int onesFilled; // how much of onesWorkspace has been set to 1
 
     // [[[cog
     // import cog_addheaders
@@ -40,8 +40,6 @@ VIRTUAL void BackpropWeightsNaive::calcGradWeights(int batchSize, CLWrapper *gra
     globalSize = ((globalSize + workgroupsize - 1) / workgroupsize) * workgroupsize;
     kernel->run_1d(globalSize, workgroupsize);
 
-    cl->finish();
-
     StatefulTimer::instance()->timeCheck("BackpropWeightsNaive end");
 }
 BackpropWeightsNaive::BackpropWeightsNaive(EasyCL *cl, LayerDimensions dim) :
@@ -53,8 +53,6 @@ VIRTUAL void BackpropWeightsScratch::calcGradWeights(int batchSize, CLWrapper *g
 
     kernel->run_1d(globalSize, workgroupsize);
 
-    cl->finish();
-
     StatefulTimer::instance()->timeCheck("BackpropWeightsScratch end");
 }
 BackpropWeightsScratch::BackpropWeightsScratch(EasyCL *cl, LayerDimensions dim) :
@@ -48,8 +48,6 @@ VIRTUAL void BackpropWeightsScratchLarge::calcGradWeights(int batchSize, CLWrapp
 
     kernel->run_1d(globalSize, workgroupSize);
 
-    cl->finish();
-
     StatefulTimer::instance()->timeCheck("BackpropWeightsScratchLarge end");
 }
 BackpropWeightsScratchLarge::BackpropWeightsScratchLarge(EasyCL *cl, LayerDimensions dim) :
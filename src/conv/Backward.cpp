@@ -14,6 +14,10 @@
 #include "BackwardGpuNaive.h"
 #include "BackwardGpuCached.h"
 #include "BackwardIm2Col.h"
+#include "BackwardWinograd.h"
+#include "Winograd.h"
+#include "BackwardFft.h"
+#include "Fft.h"
 
 #include "Backward.h"
 
@@ -40,6 +44,9 @@ STATIC Backward *Backward::instanceSpecific(int idx, EasyCL *cl, LayerDimensions
     if(idx == -1) {
         return new BackwardAuto(cl, layerDimensions);
     }
+    if(layerDimensions.skip > 0 && !supportsSkip(idx)) {
+        throw std::runtime_error("Backward::instanceSpecific: implementation " + toString(idx) + " doesnt support skip > 0");
+    }
     if(idx == 0) {
         return new BackwardCpu(cl, layerDimensions);
     }
@@ -52,6 +59,12 @@ STATIC Backward *Backward::instanceSpecific(int idx, EasyCL *cl, LayerDimensions
     if(idx == 3) {
         return new BackwardIm2Col(cl, layerDimensions);
     }
+    if(idx == 4) {
+        return new BackwardWinograd(cl, layerDimensions);
+    }
+    if(idx == 5) {
+        return new BackwardFft(cl, layerDimensions);
+    }
     throw std::runtime_error("backproperrorsv2::isntancespecifc, index not known: " + toString(idx));
 }
 Backward::Backward(EasyCL *cl, LayerDimensions layerDimensions) :
@@ -59,17 +72,30 @@ Backward::Backward(EasyCL *cl, LayerDimensions layerDimensions) :
         dim(layerDimensions) {
 }
 STATIC int Backward::getNumImplementations() {
-    return 4;
+    return 6;
 }
 STATIC bool Backward::plausiblyOptimal(int index, int batchSize, LayerDimensions dim) {
     if(index == 0) { 
         return false;
     }
-    if(index >= 4) {
+    if(index >= 6) {
+        return false;
+    }
+    if(index == 4 && !Winograd::supports(dim)) {
+        return false;
+    }
+    if(index == 5 && (!Fft::supports(dim) || dim.filterSize < 7)) {
+        return false;
+    }
+    if(dim.skip > 0 && !supportsSkip(index)) {
         return false;
     }
     return true;
 }
+// which implementations can handle skip > 0, ie a stride other than 1
+STATIC bool Backward::supportsSkip(int index) {
+    return index == 0 || index == 3;
+}
 VIRTUAL float * Backward::backward(int batchSize, float *input, float *gradOutput, float *filters) {
     StatefulTimer::timeCheck("Backward::backprop begin");
 
@@ -25,6 +25,8 @@ public:
 //    ActivationFunction const *upstreamFn;
 
     virtual ~Backward() {}
+    // true while backward calls, at this batchSize, are still timing kernels
+    virtual bool isTuning(int batchSize) { return false; }
     virtual void backward(int batchSize, 
         CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *weightsWrapper,
         CLWrapper *gradInput) = 0;
@@ -40,6 +42,7 @@ public:
     Backward(EasyCL *cl, LayerDimensions layerDimensions);
     STATIC int getNumImplementations();
     STATIC bool plausiblyOptimal(int index, int batchSize, LayerDimensions dim);
+    STATIC bool supportsSkip(int index);
     VIRTUAL float * backward(int batchSize, float *input, float *gradOutput, float *filters);
 
     // [[[end]]]
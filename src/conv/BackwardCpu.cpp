@@ -32,6 +32,7 @@ VIRTUAL float *BackwardCpu::backward(int batchSize, float *inputs,
     StatefulTimer::instance()->timeCheck("BackwardCpu start");
     const int halfFilterSize = dim.filterSize >> 1;
     const int margin = dim.padZeros ? halfFilterSize : 0;
+    const int stride = dim.skip + 1;
     // handle lower layer...
     // errors for upstream look like [n][inPlane][inRow][inCol]
     // need to aggregate over: [outPlane][outRow][outCol] (?)
@@ -46,18 +47,27 @@ VIRTUAL float *BackwardCpu::backward(int batchSize, float *inputs,
     for(int n = 0; n < batchSize; n++) {
         for(int upstreamPlane = 0; upstreamPlane < dim.inputPlanes; upstreamPlane++) {
             for(int upstreamRow = 0; upstreamRow < dim.inputSize; upstreamRow++) {
-                int minFilterRow = std::max(0, upstreamRow + margin - (dim.outputSize - 1));
+                int minFilterRow = std::max(0, upstreamRow + margin - (dim.outputSize - 1) * stride);
                 int maxFilterRow = std::min(dim.filterSize - 1, upstreamRow + margin);
                 for(int upstreamCol = 0; upstreamCol < dim.inputSize; upstreamCol++) {
                     float sumWeightTimesGradOutput = 0;
                     // aggregate over [outPlane][outRow][outCol]
-                    int minFilterCol = std::max(0, upstreamCol + margin - (dim.outputSize -1));
+                    int minFilterCol = std::max(0, upstreamCol + margin - (dim.outputSize - 1) * stride);
                     int maxFilterCol = std::min(dim.filterSize - 1, upstreamCol + margin);
                     for(int outPlane = 0; outPlane < dim.numFilters; outPlane++) {
                         for(int filterRow = minFilterRow; filterRow <= maxFilterRow; filterRow++) {
-                            int outRow = upstreamRow + margin - filterRow;
+                            // with a stride, only some filter rows land on an output row
+                            int outRowTimesStride = upstreamRow + margin - filterRow;
+                            if(outRowTimesStride % stride != 0) {
+                                continue;
+                            }
+                            int outRow = outRowTimesStride / stride;
                             for(int filterCol = minFilterCol; filterCol <= maxFilterCol; filterCol++) {
-                                int outCol = upstreamCol + margin - filterCol;
+                                int outColTimesStride = upstreamCol + margin - filterCol;
+                                if(outColTimesStride % stride != 0) {
+                                    continue;
+                                }
+                                int outCol = outColTimesStride / stride;
                                 int resultIndex = (( n 
                                     * dim.numFilters + outPlane)
                                     * dim.outputSize + outRow)
@@ -0,0 +1,76 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "util/stringhelper.h"
+#include "util/StatefulTimer.h"
+#include "conv/Fft.h"
+#include "conv/FftFilterCache.h"
+#include "conv/Im2ColWorkspace.h"
+#include "conv/BackwardFft.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC BackwardFft::BackwardFft(EasyCL *cl, LayerDimensions dim) :
+            Backward(cl, dim),
+            fft(0),
+            filterCache(0),
+            gradOutputWorkspace(0),
+            gradInputWorkspace(0) {
+    if(!Fft::supports(dim)) {
+        throw runtime_error("BackwardFft needs skip 0, and padded inputs of at most 256, not skip " +
+            toString(dim.skip) + " fft size " + toString(Fft::fftSizeFor(dim)));
+    }
+    fft = new Fft(cl, Fft::fftSizeFor(dim));
+    gradOutputWorkspace = new Im2ColWorkspace(cl);
+    gradInputWorkspace = new Im2ColWorkspace(cl);
+}
+PUBLIC VIRTUAL BackwardFft::~BackwardFft() {
+    FftFilterCache::release(filterCache);
+    delete fft;
+    delete gradOutputWorkspace;
+    delete gradInputWorkspace;
+}
+// the full convolution of gradOutput with the filters covers the padded
+// input, so gradInput is read out from the padding onwards
+PUBLIC VIRTUAL void BackwardFft::backward(int batchSize,
+        CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
+        CLWrapper *gradInputWrapper) {
+    StatefulTimer::timeCheck("BackwardFft::backward START");
+    const int fftSize = fft->getFftSize();
+    const long planeFloats = 2l * fftSize * fftSize;
+    const int padding = dim.padZeros ? dim.halfFilterSize : 0;
+
+    filterCache = FftFilterCache::reacquire(filterCache, cl, dim, weightsWrapper);
+    CLWrapper *filtersWrapper = filterCache->getTransformed(fft);
+    StatefulTimer::timeCheck("BackwardFft::backward after filters");
+
+    int chunkSize = Im2ColWorkspace::imagesPerChunk(batchSize, planeFloats * (dim.inputPlanes + dim.numFilters));
+    CLWrapper *gradOutputFreqWrapper = gradOutputWorkspace->get((int)(chunkSize * dim.numFilters * planeFloats));
+    CLWrapper *gradInputFreqWrapper = gradInputWorkspace->get((int)(chunkSize * dim.inputPlanes * planeFloats));
+    for(int b = 0; b < batchSize; b += chunkSize) {
+        int numImages = std::min(chunkSize, batchSize - b);
+        fft->forwardPlanes(gradOutputWrapper, b * dim.outputCubeSize, numImages * dim.numFilters,
+            dim.outputSize, 0, gradOutputFreqWrapper);
+        // [image][inputplane] = sum over filter of [image][filter] * [filter][inputplane]
+        fft->multiplyAccumulate(
+            numImages, dim.inputPlanes, dim.numFilters,
+            gradOutputFreqWrapper, dim.numFilters, 0, 1,
+            filtersWrapper, 0, 1, dim.inputPlanes,
+            false, false, gradInputFreqWrapper);
+        fft->inversePlanes(gradInputFreqWrapper, numImages * dim.inputPlanes, padding, dim.inputSize,
+            gradInputWrapper, b * dim.inputCubeSize);
+    }
+    StatefulTimer::timeCheck("BackwardFft::backward END");
+}
+
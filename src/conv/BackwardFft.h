@@ -0,0 +1,45 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "Backward.h"
+
+class Fft;
+class FftFilterCache;
+class Im2ColWorkspace;
+
+#include "DeepCLDllExport.h"
+
+#define STATIC static
+#define VIRTUAL virtual
+
+// gradInput is gradOutput convolved, rather than correlated, with the
+// filters, so it's the product with the transformed filters themselves,
+// which are shared with ForwardFft through FftFilterCache.  no skip
+class DeepCL_EXPORT BackwardFft : public Backward {
+    private:
+    Fft *fft;
+    FftFilterCache *filterCache;
+    Im2ColWorkspace *gradOutputWorkspace;
+    Im2ColWorkspace *gradInputWorkspace;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    BackwardFft(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~BackwardFft();
+    VIRTUAL void backward(int batchSize,
+        CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
+    CLWrapper *gradInputWrapper);
+
+    // [[[end]]]
+};
+
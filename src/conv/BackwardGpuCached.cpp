@@ -46,7 +46,6 @@ VIRTUAL void BackwardGpuCached::backward(int batchSize,
     
 //    float const*gradInput = (float *)gradInputWrapper->getHostArray();
     kernel->run_1d(globalSize, workgroupSize);
-    cl->finish();
 //    gradInputWrapper->copyToHost();
     StatefulTimer::instance()->timeCheck("BackwardGpuCached after first kernel");
 //    for(int i = 0; i < min(40, batchSize * dim.inputCubeSize); i++) {
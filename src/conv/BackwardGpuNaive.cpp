@@ -31,7 +31,6 @@ VIRTUAL void BackwardGpuNaive::backward(int batchSize,
     globalSize = (( globalSize + workgroupsize - 1) / workgroupsize) * workgroupsize;
     kernel->run_1d(globalSize, workgroupsize);
 
-    cl->finish();
     StatefulTimer::instance()->timeCheck("BackwardGpuNaive after first kernel");
 
 //    applyActivationDeriv->in(batchSize * dim.inputCubeSize)->in(gradInputWrapper)->in(inputDataWrapper);
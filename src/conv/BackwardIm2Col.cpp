@@ -1,6 +1,7 @@
 #include "util/stringhelper.h"
 #include "util/StatefulTimer.h"
 
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <string>
@@ -8,6 +9,7 @@
 //#include "clblas/ClBlasInstance.h"
 #include "clblas/ClBlasHelper.h"
 #include "conv/Im2Col.h"
+#include "conv/Im2ColWorkspace.h"
 #include "BackwardIm2Col.h"
 
 using namespace std;
@@ -25,50 +27,58 @@ PUBLIC BackwardIm2Col::BackwardIm2Col(EasyCL *cl, LayerDimensions dim) :
         {
 //    ClBlasInstance::initializeIfNecessary();
     im2Col = new Im2Col(cl, dim);
+    gradOutputWorkspace = new Im2ColWorkspace(cl);
+    gradColumnsWorkspace = new Im2ColWorkspace(cl);
 }
 PUBLIC VIRTUAL BackwardIm2Col::~BackwardIm2Col() {
     delete im2Col;
+    delete gradOutputWorkspace;
+    delete gradColumnsWorkspace;
 }
+// as ForwardIm2Col, several images per gemm: gradOutput is swapped into
+// [filter][image][pixel] order, one gemm makes the columns for the whole
+// chunk, and col2ImBatched folds them back into gradInput
 PUBLIC VIRTUAL void BackwardIm2Col::backward(int batchSize, 
         CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
         CLWrapper *gradInputWrapper) {
     StatefulTimer::timeCheck("BackwardIm2Col::backward START");
 
-    int gradColumnsSize = dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared;
-    float *gradColumns = new float[gradColumnsSize];
-    CLWrapper *gradColumnsWrapper = cl->wrap(gradColumnsSize, gradColumns);
-    gradColumnsWrapper->createOnDevice();
-//    cout << "gradColumnsSize: " << gradColumnsSize << endl;
-//    cout << "weightsize: " << weightsWrapper->size() << endl;
+    long m = dim.outputSizeSquared;
+    long n = dim.inputPlanes * dim.filterSizeSquared;
+    long k = dim.numFilters;
+    int chunkSize = Im2ColWorkspace::imagesPerChunk(batchSize, k * m + n * m);
+    CLWrapper *gradColumnsWrapper = gradColumnsWorkspace->get(chunkSize * n * m);
+    CLWrapper *gradOutputSwappedWrapper = chunkSize > 1 ? gradOutputWorkspace->get(chunkSize * k * m) : 0;
+//    cout << "m=" << m << " k=" << k << " n=" << n << " chunkSize=" << chunkSize << endl;
 
     StatefulTimer::timeCheck("BackwardIm2Col::backward after alloc");
 
     if(!gradInputWrapper->isOnDevice()) {
         gradInputWrapper->createOnDevice();
     }
-    for (int b = 0; b < batchSize; b ++) {
-//        cout << "b=" << b << " numkernels=" << numKernels << endl;
-        long m = dim.outputSizeSquared;
-        long n = dim.inputPlanes * dim.filterSizeSquared;
-        long k = dim.numFilters;
-//        cout << "m=" << m << " k=" << k << " n=" << n << endl;
+    for (int b = 0; b < batchSize; b += chunkSize) {
+        int numImages = std::min(chunkSize, batchSize - b);
+        CLWrapper *gemmInputWrapper = gradOutputWrapper;
+        int gemmInputOffset = b * dim.outputCubeSize;
+        if(numImages > 1) {
+            im2Col->swapOuterDims(gradOutputWrapper, b * dim.outputCubeSize, numImages, k, m, gradOutputSwappedWrapper, 0);
+            gemmInputWrapper = gradOutputSwappedWrapper;
+            gemmInputOffset = 0;
+        }
 
         ClBlasHelper::Gemm(
             cl, clblasColumnMajor, clblasNoTrans, clblasTrans,
-            m, k, n,
+            numImages * m, k, n,
             1,
-            gradOutputWrapper, b * dim.outputCubeSize,
+            gemmInputWrapper, gemmInputOffset,
             weightsWrapper, 0,
             0,
             gradColumnsWrapper, 0
         );
 
-        im2Col->col2Im(gradColumnsWrapper, gradInputWrapper, b * dim.inputCubeSize);
+        im2Col->col2ImBatched(gradColumnsWrapper, numImages, gradInputWrapper, b * dim.inputCubeSize);
     }
 
-    delete gradColumnsWrapper;
-    delete[] gradColumns;
-
     StatefulTimer::timeCheck("BackwardIm2Col::backward after call backward");
 
     StatefulTimer::timeCheck("BackwardIm2Col::backward END");
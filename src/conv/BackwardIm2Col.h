@@ -6,6 +6,7 @@
 #include "DeepCLDllExport.h"
 
 class Im2Col;
+class Im2ColWorkspace;
 
 #define STATIC static
 #define VIRTUAL virtual
@@ -16,9 +17,8 @@ class DeepCL_EXPORT BackwardIm2Col : public Backward {
 //    CLKernel *kernelCol2Im;
 //    AddBias *addBias;
 
-    float *columns;
-    CLWrapper *columnsWrapper;
-    int numKernels;
+    Im2ColWorkspace *gradOutputWorkspace;
+    Im2ColWorkspace *gradColumnsWorkspace;
 
     // [[[cog
     // import cog_addheaders
@@ -0,0 +1,43 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "util/stringhelper.h"
+#include "util/StatefulTimer.h"
+#include "conv/Winograd.h"
+#include "conv/BackwardWinograd.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// without padZeros, every gradOutput pixel reaches 2 pixels beyond the
+// edge of gradInput, hence a padding of 2
+PUBLIC BackwardWinograd::BackwardWinograd(EasyCL *cl, LayerDimensions dim) :
+            Backward(cl, dim),
+            winograd(0) {
+    if(!Winograd::supports(dim)) {
+        throw runtime_error("BackwardWinograd only handles filterSize 3, and skip 0, not filterSize " +
+            toString(dim.filterSize) + " skip " + toString(dim.skip));
+    }
+    winograd = new Winograd(cl, dim.numFilters, dim.outputSize, dim.inputPlanes, dim.inputSize,
+        dim.padZeros ? 1 : 2, true);
+}
+PUBLIC VIRTUAL BackwardWinograd::~BackwardWinograd() {
+    delete winograd;
+}
+PUBLIC VIRTUAL void BackwardWinograd::backward(int batchSize,
+        CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
+        CLWrapper *gradInputWrapper) {
+    StatefulTimer::timeCheck("BackwardWinograd::backward START");
+    winograd->convolve(batchSize, gradOutputWrapper, weightsWrapper, gradInputWrapper);
+    StatefulTimer::timeCheck("BackwardWinograd::backward END");
+}
+
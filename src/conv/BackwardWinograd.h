@@ -0,0 +1,39 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "Backward.h"
+
+class Winograd;
+
+#include "DeepCLDllExport.h"
+
+#define STATIC static
+#define VIRTUAL virtual
+
+// gradInput is gradOutput convolved with the rotated filters, so this is
+// ForwardWinograd run the other way round.  3x3 filters, no skip, only
+class DeepCL_EXPORT BackwardWinograd : public Backward {
+    private:
+    Winograd *winograd;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    BackwardWinograd(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~BackwardWinograd();
+    VIRTUAL void backward(int batchSize,
+        CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
+    CLWrapper *gradInputWrapper);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,218 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+#include "util/StatefulTimer.h"
+#include "activate/ActivationFunction.h"
+#include "conv/ConvEpilogue.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC ConvEpilogue::ConvEpilogue(EasyCL *cl, LayerDimensions dim, ActivationFunction const *fn) :
+        cl(cl),
+        forwardKernel(0),
+        backwardKernel(0),
+        dim(dim) {
+    string kernelName = string("ConvEpilogue.") + fn->getDefineName() + (dim.biased ? ".biased" : "");
+    if(cl->kernelExists(kernelName + ".forward")) {
+        forwardKernel = cl->getKernel(kernelName + ".forward");
+        backwardKernel = cl->getKernel(kernelName + ".backward");
+        return;
+    }
+    string options = string("-D ") + fn->getDefineName();
+    if(dim.biased) {
+        options += " -DBIASED";
+    }
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("forwardKernel", "cl/conv_epilogue.cl", "biasAndActivate", 'options')
+    // stringify.write_kernel2("backwardKernel", "cl/conv_epilogue.cl", "activationDeriv", 'options')
+    // ]]]
+    // generated using cog, from cl/conv_epilogue.cl:
+    const char * forwardKernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// the activation that follows a convolution, folded into the convolution's\n"
+    "// own passes over its output, see ConvEpilogue\n"
+    "\n"
+    "// expected defines:\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ]\n"
+    "// BIASED, if there is a bias to add before the activation\n"
+    "// same functions as activate.cl and applyActivationDeriv.cl\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+    "#endif\n"
+    "\n"
+    "#ifdef ACTIVATION_FUNCTION // protect against not defined\n"
+    "// output = activation(output + bias[filter]), in place, in one pass\n"
+    "kernel void biasAndActivate(\n"
+    "        const int N,\n"
+    "        const int numFilters,\n"
+    "        const int outputSizeSquared,\n"
+    "        global float *output,\n"
+    "        global const float *bias) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    float value = output[globalId];\n"
+    "    #ifdef BIASED\n"
+    "    value += bias[(globalId / outputSizeSquared) % numFilters];\n"
+    "    #endif\n"
+    "    output[globalId] = ACTIVATION_FUNCTION(value);\n"
+    "}\n"
+    "\n"
+    "// gradient wrt the pre-activation values, from the activated output, and\n"
+    "// the gradient wrt the activated output\n"
+    "kernel void activationDeriv(\n"
+    "        const int N,\n"
+    "        global const float *output,\n"
+    "        global const float *gradOutput,\n"
+    "        global float *gradPreActivation) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    gradPreActivation[globalId] = ACTIVATION_DERIV(output[globalId]) * gradOutput[globalId];\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "";
+    forwardKernel = cl->buildKernelFromString(forwardKernelSource, "biasAndActivate", options, "cl/conv_epilogue.cl");
+    // generated using cog, from cl/conv_epilogue.cl:
+    const char * backwardKernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// the activation that follows a convolution, folded into the convolution's\n"
+    "// own passes over its output, see ConvEpilogue\n"
+    "\n"
+    "// expected defines:\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ]\n"
+    "// BIASED, if there is a bias to add before the activation\n"
+    "// same functions as activate.cl and applyActivationDeriv.cl\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+    "#endif\n"
+    "\n"
+    "#ifdef ACTIVATION_FUNCTION // protect against not defined\n"
+    "// output = activation(output + bias[filter]), in place, in one pass\n"
+    "kernel void biasAndActivate(\n"
+    "        const int N,\n"
+    "        const int numFilters,\n"
+    "        const int outputSizeSquared,\n"
+    "        global float *output,\n"
+    "        global const float *bias) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    float value = output[globalId];\n"
+    "    #ifdef BIASED\n"
+    "    value += bias[(globalId / outputSizeSquared) % numFilters];\n"
+    "    #endif\n"
+    "    output[globalId] = ACTIVATION_FUNCTION(value);\n"
+    "}\n"
+    "\n"
+    "// gradient wrt the pre-activation values, from the activated output, and\n"
+    "// the gradient wrt the activated output\n"
+    "kernel void activationDeriv(\n"
+    "        const int N,\n"
+    "        global const float *output,\n"
+    "        global const float *gradOutput,\n"
+    "        global float *gradPreActivation) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    gradPreActivation[globalId] = ACTIVATION_DERIV(output[globalId]) * gradOutput[globalId];\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "";
+    backwardKernel = cl->buildKernelFromString(backwardKernelSource, "activationDeriv", options, "cl/conv_epilogue.cl");
+    // [[[end]]]
+    cl->storeKernel(kernelName + ".forward", forwardKernel, true);
+    cl->storeKernel(kernelName + ".backward", backwardKernel, true);
+}
+PUBLIC VIRTUAL ConvEpilogue::~ConvEpilogue() {
+}
+// outputWrapper holds the convolution, without the bias, and gets the
+// activated output.  biasWrapper is ignored if not dim.biased
+PUBLIC VIRTUAL void ConvEpilogue::forward(int batchSize, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
+    StatefulTimer::timeCheck("ConvEpilogue::forward start");
+    int N = batchSize * dim.outputCubeSize;
+    forwardKernel->in(N)
+                 ->in(dim.numFilters)
+                 ->in(dim.outputSizeSquared)
+                 ->inout(outputWrapper)
+                 ->in(dim.biased ? biasWrapper : outputWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    forwardKernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    StatefulTimer::timeCheck("ConvEpilogue::forward end");
+}
+// outputWrapper is the activated output, from forward
+PUBLIC VIRTUAL void ConvEpilogue::backward(int batchSize, CLWrapper *outputWrapper, CLWrapper *gradOutputWrapper,
+        CLWrapper *gradPreActivationWrapper) {
+    StatefulTimer::timeCheck("ConvEpilogue::backward start");
+    int N = batchSize * dim.outputCubeSize;
+    backwardKernel->in(N)
+                  ->in(outputWrapper)
+                  ->in(gradOutputWrapper)
+                  ->out(gradPreActivationWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    backwardKernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    StatefulTimer::timeCheck("ConvEpilogue::backward end");
+}
+
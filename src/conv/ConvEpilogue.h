@@ -0,0 +1,49 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "conv/LayerDimensions.h"
+
+class EasyCL;
+class CLKernel;
+class CLWrapper;
+class ActivationFunction;
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// an activation folded into the convolutional layer before it, see
+// NeuralNet::fuseLayers
+// forward adds the bias and applies the activation in one pass, in place,
+// replacing AddBias, and the activation layer's own pass into its own
+// buffer.  backward turns the gradient wrt the activated output into the
+// gradient wrt the convolution's output, before the convolution's backward
+class DeepCL_EXPORT ConvEpilogue {
+    private:
+    EasyCL *cl; // NOT owned by us
+    CLKernel *forwardKernel; // NOT owned by us
+    CLKernel *backwardKernel; // NOT owned by us
+    LayerDimensions dim;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ConvEpilogue(EasyCL *cl, LayerDimensions dim, ActivationFunction const *fn);
+    VIRTUAL ~ConvEpilogue();
+    VIRTUAL void forward(int batchSize, CLWrapper *biasWrapper, CLWrapper *outputWrapper);
+    VIRTUAL void backward(int batchSize, CLWrapper *outputWrapper, CLWrapper *gradOutputWrapper,
+    CLWrapper *gradPreActivationWrapper);
+
+    // [[[end]]]
+};
+
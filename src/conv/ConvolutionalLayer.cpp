@@ -17,6 +17,10 @@
 #include "trainers/SGDState.h"
 #include "clmath/GpuAdd.h"
 #include "clmath/CopyBuffer.h"
+#include "clmath/CLWrapperCache.h"
+#include "clmath/CLDeviceWrapper.h"
+#include "net/ParameterArena.h"
+#include "conv/ConvEpilogue.h"
 #include "layer/Layer.h"
 
 using namespace std;
@@ -34,11 +38,12 @@ ConvolutionalLayer::ConvolutionalLayer(EasyCL *cl, Layer *previousLayer, Convolu
         biasTrainerState(0),
         forwardImpl(0),
         backwardImpl(0),
+        fusedActivation(0),
+        epilogue(0),
+        gradPreActivationWrapper(0),
 
         weights(0),
         bias(0),
-        output(0),
-        gradInput(0),
         gradWeights(0),
         gradBias(0),
 
@@ -50,14 +55,18 @@ ConvolutionalLayer::ConvolutionalLayer(EasyCL *cl, Layer *previousLayer, Convolu
         gradBiasWrapper(0),
 
         batchSize(0),
-        allocatedSpaceNumExamples(0)
+        allocatedSpaceNumExamples(0),
+        upstreamWrapperCache(0),
+        gradOutputWrapperCache(0),
+        parameterArena(0)
             {
     dim.setInputPlanes(previousLayer->getOutputPlanes())
         .setInputSize(previousLayer->getOutputSize())
         .setNumFilters(maker->_numFilters)
         .setFilterSize(maker->_filterSize)
         .setBiased(maker->_biased)
-        .setPadZeros(maker->_padZeros);
+        .setPadZeros(maker->_padZeros)
+        .setSkip(maker->_skip);
     if(dim.padZeros && dim.filterSize % 2 == 0) {
         throw std::runtime_error("filter size must be an odd number, if padZeros is true, so either turn off padZeros, or choose a different filtersize :-)");
     }
@@ -90,40 +99,42 @@ ConvolutionalLayer::ConvolutionalLayer(EasyCL *cl, Layer *previousLayer, Convolu
         biasWrapper->copyToDevice();
     }
 
-    gradWeights = new float[ getWeightsSize() ];
-    gradWeightsWrapper = cl->wrap(getWeightsSize(), gradWeights);
-    gradWeightsWrapper->createOnDevice();
-
+    gradWeightsWrapper = new CLDeviceWrapper(cl, getWeightsSize());
     if(dim.biased) {
-        gradBias = new float[ getBiasSize() ];
-        gradBiasWrapper = cl->wrap(getBiasSize(), gradBias);
-        gradBiasWrapper->createOnDevice();
+        gradBiasWrapper = new CLDeviceWrapper(cl, getBiasSize());
     }
 
     gpuAdd = new GpuAdd(cl);
     copyBuffer = new CopyBuffer(cl);
+    upstreamWrapperCache = new CLWrapperCache(cl);
+    gradOutputWrapperCache = new CLWrapperCache(cl);
 }
 VIRTUAL ConvolutionalLayer::~ConvolutionalLayer() {
     delete gpuAdd;
     delete copyBuffer;
+    delete upstreamWrapperCache;
+    delete gradOutputWrapperCache;
 
     delete weightsWrapper;
     delete biasWrapper;
-    delete outputWrapper;
     delete gradInputWrapper;
     delete gradWeightsWrapper;
     delete gradBiasWrapper;
+    // in inference, our output is a view, owned by the net's OutputArenas
+    if(!inference) {
+        delete outputWrapper;
+    }
 
-    delete[] output;
-    delete[] weights;
-    delete[] bias;
-    delete[] gradInput;
-    delete[] gradWeights;
-    delete[] gradBias;
+    if(parameterArena == 0) {
+        delete[] weights;
+        delete[] bias;
+    }
 
     delete forwardImpl;
     delete backpropWeightsImpl;
     delete backwardImpl;
+    delete epilogue;
+    delete gradPreActivationWrapper;
     delete trainerState;
     delete biasTrainerState;
 }
@@ -134,13 +145,12 @@ VIRTUAL std::string ConvolutionalLayer::getClassName() const {
 //    return activationFunction;
 //}
 VIRTUAL float *ConvolutionalLayer::getGradInput() {
-    if(gradInputWrapper->isDeviceDirty()) {
-//        std::cout << "copying gradInput to host, from GPU" << std::endl;
-        gradInputWrapper->copyToHost();
-    }
-    return gradInput;
+    return gradInputWrapper->copyToStaging();
 }
 VIRTUAL float *ConvolutionalLayer::getGradWeights() {
+    if(parameterArena == 0) {
+        return static_cast< CLDeviceWrapper * >(gradWeightsWrapper)->copyToStaging();
+    }
     if(gradWeightsWrapper->isDeviceDirty()) {
 //        std::cout << "copying gradWeights to host, from GPU" << std::endl;
         gradWeightsWrapper->copyToHost();
@@ -148,6 +158,9 @@ VIRTUAL float *ConvolutionalLayer::getGradWeights() {
     return gradWeights;
 }
 VIRTUAL float *ConvolutionalLayer::getGradBias() {
+    if(parameterArena == 0) {
+        return static_cast< CLDeviceWrapper * >(gradBiasWrapper)->copyToStaging();
+    }
     if(gradBiasWrapper->isDeviceDirty()) {
 //        std::cout << "copying gradBias to host, from GPU" << std::endl;
         gradBiasWrapper->copyToHost();
@@ -206,7 +219,7 @@ void ConvolutionalLayer::randomizeWeights(WeightsInitializer *weightsInitializer
 VIRTUAL void ConvolutionalLayer::print() {
     std::cout << "ConvolutionalLayer " << dim << std::endl;
     printWeights();
-    if(output != 0) {
+    if(outputWrapper != 0) {
         printOutput();
     }
 }
@@ -240,7 +253,7 @@ VIRTUAL void ConvolutionalLayer::printWeights() {
     if(dim.numFilters > 5) std::cout << " ... other filters ... " << std::endl;
  }
 VIRTUAL void ConvolutionalLayer::printOutput() { 
-    if(output == 0) {
+    if(outputWrapper == 0) {
         return;
     }
     //    getOutput();
@@ -276,20 +289,67 @@ VIRTUAL void ConvolutionalLayer::setBatchSize(int batchSize) {
 
     this->batchSize = batchSize;
     this->allocatedSpaceNumExamples = batchSize;
+    if(inference) {
+        // output comes from setOutputView, and there's no backward, so
+        // neither gradInput nor gradPreActivation
+        return;
+    }
 
     delete outputWrapper;
-    delete[] output;
-
     delete gradInputWrapper;
-    delete[] gradInput;
+    gradInputWrapper = 0;
 
-    output = new float[getOutputNumElements()];
-    outputWrapper = cl->wrap(getOutputNumElements(), output);
+    outputWrapper = new CLDeviceWrapper(cl, getOutputNumElements());
 
     if(layerIndex > 1) {
-        gradInput = new float[ previousLayer->getOutputNumElements() ];
-        gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
+        gradInputWrapper = new CLDeviceWrapper(cl, previousLayer->getOutputNumElements());
     }
+
+    if(fusedActivation != 0) {
+        delete gradPreActivationWrapper;
+        gradPreActivationWrapper = new CLDeviceWrapper(cl, getOutputNumElements());
+    }
+}
+/// \brief take over the activation layer that follows us
+///
+/// forwardImpl is rebuilt without the bias, which ConvEpilogue then adds
+/// along with the activation, in one pass over the output, and backward
+/// applies the activation derivative before our own backward
+/// the activation layer stays in the net, for persistence, as a pass-through
+/// call before setBatchSize
+VIRTUAL bool ConvolutionalLayer::fuseActivation(ActivationFunction const *fn) {
+    if(fusedActivation != 0 || allocatedSpaceNumExamples != 0) {
+        return false;
+    }
+    LayerDimensions unbiasedDim = dim;
+    unbiasedDim.setBiased(false);
+    delete forwardImpl;
+    forwardImpl = Forward::instance(cl, unbiasedDim);
+    epilogue = new ConvEpilogue(cl, dim, fn);
+    fusedActivation = fn;
+    return true;
+}
+VIRTUAL bool ConvolutionalLayer::takesOutputView() const {
+    return true;
+}
+VIRTUAL void ConvolutionalLayer::setOutputView(CLDeviceWrapper *outputView) {
+    outputWrapper = outputView;
+}
+VIRTUAL ActivationFunction const *ConvolutionalLayer::getFusedActivation() const {
+    return fusedActivation;
+}
+VIRTUAL bool ConvolutionalLayer::isTuning() {
+    if(batchSize == 0) {
+        return false;
+    }
+    if(forwardImpl->isTuning(batchSize)) {
+        return true;
+    }
+    if(!training) {
+        return false;
+    }
+    return (backwardImpl != 0 && backwardImpl->isTuning(batchSize)) ||
+        backpropWeightsImpl->isTuning(batchSize);
 }
 VIRTUAL void ConvolutionalLayer::setWeights(float *weights, float *bias) {
 //    cout << "setweights" << endl;
@@ -346,38 +406,38 @@ VIRTUAL int ConvolutionalLayer::getBiasSize() const {
     }
 }
 VIRTUAL float const *ConvolutionalLayer::getWeights() const {
-    if(weightsWrapper->isDeviceDirty()) {
+    if(weightsWrapper->isDeviceDirty() || (parameterArena != 0 && parameterArena->isParamsDeviceDirty())) {
         throw std::runtime_error("weights not copied to host, and htis is const object, so cannot copy");
     }
     return weights;
 }
 VIRTUAL float *ConvolutionalLayer::getWeights() {
+    if(parameterArena != 0) {
+        parameterArena->copyParamsToHost();
+    }
     if(weightsWrapper->isDeviceDirty()) {
 //        cout << "copying weights to host" << endl;
-        cl->finish();
         weightsWrapper->copyToHost();
     }
     return weights;
 }
 VIRTUAL float *ConvolutionalLayer::getBias() {
+    if(parameterArena != 0) {
+        parameterArena->copyParamsToHost();
+    }
     if(biasWrapper->isDeviceDirty()) {
-        cl->finish();
         biasWrapper->copyToHost();
     }
     return bias;
 }
 VIRTUAL float const*ConvolutionalLayer::getBias() const {
-    if(biasWrapper->isDeviceDirty()) {
+    if(biasWrapper->isDeviceDirty() || (parameterArena != 0 && parameterArena->isParamsDeviceDirty())) {
         throw std::runtime_error("bias not copied to host, and htis is const object, so cannot copy");
     }
     return bias;
 }
 VIRTUAL float * ConvolutionalLayer::getOutput() {
-    if(outputWrapper->isDeviceDirty()) {
-        outputWrapper->copyToHost();
-//        outputCopiedToHost = true;
-    }
-    return output;
+    return outputWrapper->copyToStaging();
 };
 VIRTUAL void ConvolutionalLayer::forward() {
     if(batchSize == 0) {
@@ -391,16 +451,16 @@ VIRTUAL void ConvolutionalLayer::forward() {
         upstreamWrapper = previousLayer->getOutputWrapper();
     } else {
 //            std::cout << "layer " << previousLayer->layerIndex << " has no outputWrapper" << std::endl;
-        upstreamWrapper = cl->wrap(previousLayer->getOutputNumElements(), (float *)previousLayer->getOutput());
+        upstreamWrapper = upstreamWrapperCache->wrap(previousLayer->getOutputNumElements(), (float *)previousLayer->getOutput());
         upstreamWrapper->copyToDevice();
     }
     StatefulTimer::instance()->timeCheck("    forward layer " + toString(layerIndex) + ", copied to device");
+    outputWrapper->releaseStaging();
     forwardImpl->forward(batchSize, upstreamWrapper, weightsWrapper, biasWrapper, outputWrapper);
-    StatefulTimer::instance()->timeCheck("    forward layer " + toString(layerIndex) + ",  after clFinish");
-
-    if(!previousLayer->hasOutputWrapper()) {
-        delete upstreamWrapper;
+    if(fusedActivation != 0) {
+        epilogue->forward(batchSize, biasWrapper, outputWrapper);
     }
+    StatefulTimer::instance()->timeCheck("    forward layer " + toString(layerIndex) + ", enqueued");
 //    outputCopiedToHost = false;
 }
 VIRTUAL void ConvolutionalLayer::backward() {
@@ -410,37 +470,42 @@ VIRTUAL void ConvolutionalLayer::backward() {
     if(previousLayer->hasOutputWrapper()) {
         inputWrapper = previousLayer->getOutputWrapper();
     } else {
-        inputWrapper = cl->wrap(previousLayer->getOutputNumElements(), previousLayer->getOutput());
+        inputWrapper = upstreamWrapperCache->wrap(previousLayer->getOutputNumElements(), previousLayer->getOutput());
         inputWrapper->copyToDevice();
     }
 
+    // if fused, the gradient comes from the layer after the activation, and
+    // is wrt the activated output, so that's undone first
+    Layer *gradOutputLayer = fusedActivation != 0 ? nextLayer->nextLayer : nextLayer;
     CLWrapper *gradOutputWrapper = 0;
-    bool weOwnGradOutputWrapper = false;
-    if(nextLayer->providesGradInputWrapper()) {
-        gradOutputWrapper = nextLayer->getGradInputWrapper();
+    if(gradOutputLayer->providesGradInputWrapper()) {
+        gradOutputWrapper = gradOutputLayer->getGradInputWrapper();
     } else {
-        gradOutputWrapper = cl->wrap(getOutputNumElements(), nextLayer->getGradInput());
+        gradOutputWrapper = gradOutputWrapperCache->wrap(getOutputNumElements(), gradOutputLayer->getGradInput());
         gradOutputWrapper->copyToDevice();
-        weOwnGradOutputWrapper = true;
+    }
+    if(fusedActivation != 0) {
+        epilogue->backward(batchSize, outputWrapper, gradOutputWrapper, gradPreActivationWrapper);
+        gradOutputWrapper = gradPreActivationWrapper;
     }
 
     if(previousLayer->needsBackProp()) {
+        gradInputWrapper->releaseStaging();
         backwardImpl->backward(batchSize, inputWrapper, gradOutputWrapper, weightsWrapper, gradInputWrapper);
         StatefulTimer::instance()->timeCheck("backproperrors(): calced gradInput, layer " + ::toString(layerIndex) );
     }
 
+    if(parameterArena == 0) {
+        static_cast< CLDeviceWrapper * >(gradWeightsWrapper)->releaseStaging();
+        if(dim.biased) {
+            static_cast< CLDeviceWrapper * >(gradBiasWrapper)->releaseStaging();
+        }
+    }
     backpropWeightsImpl->calcGradWeights(batchSize, gradOutputWrapper, inputWrapper,  gradWeightsWrapper, gradBiasWrapper);
     StatefulTimer::instance()->timeCheck("backproperrors(): done calc gradWeights, layer " + ::toString(layerIndex) );
 
 //    gradWeightsCopiedToHost = false;
 //    gradBiasCopiedToHost = false;
-
-    if(!previousLayer->hasOutputWrapper()) {
-        delete inputWrapper;
-    }
-    if(weOwnGradOutputWrapper) {
-        delete gradOutputWrapper;
-    }
 }
 //VIRTUAL void ConvolutionalLayer::setWeights(CLWrapper *weightWrapper, CLWrapper *biasWrapper) {
 //    copyBuffer->copy(getWeightsSize(), weightWrapper, this->weightsWrapper);
@@ -461,6 +526,9 @@ VIRTUAL void ConvolutionalLayer::backward() {
 //    StatefulTimer::instance()->timeCheck("ConvolutionalLayer::updateWeights(): updated weights, layer " + ::toString(layerIndex) );
 //}
 VIRTUAL std::string ConvolutionalLayer::asString() const {
+    if(fusedActivation != 0) {
+        return "ConvolutionalLayer{ " + toString(dim) + " fused " + fusedActivation->getDefineName() + " }";
+    }
     return "ConvolutionalLayer{ " + toString(dim) + " }";
 }
 VIRTUAL bool ConvolutionalLayer::needsTrainerState() const {
@@ -475,6 +543,36 @@ VIRTUAL TrainerState *ConvolutionalLayer::getTrainerState() {
 VIRTUAL TrainerState *ConvolutionalLayer::getBiasTrainerState() {
     return biasTrainerState;
 }
+VIRTUAL void ConvolutionalLayer::setParameterArena(ParameterArena *arena, int weightsOffset, int biasOffset) {
+    if(parameterArena != 0) {
+        throw runtime_error("ConvolutionalLayer::setParameterArena: layer " + toString(layerIndex) + " already uses an arena");
+    }
+    memcpy(arena->getParams() + weightsOffset, getWeights(), sizeof(float) * getWeightsSize());
+    if(dim.biased) {
+        memcpy(arena->getParams() + biasOffset, getBias(), sizeof(float) * getBiasSize());
+    }
+
+    delete weightsWrapper;
+    delete gradWeightsWrapper;
+    delete[] weights;
+    weights = arena->getParams() + weightsOffset;
+    gradWeights = arena->getGradParams() + weightsOffset;
+    weightsWrapper = arena->createParamsView(weightsOffset, getWeightsSize());
+    gradWeightsWrapper = arena->createGradParamsView(weightsOffset, getWeightsSize());
+    weightsWrapper->copyToDevice();
+
+    if(dim.biased) {
+        delete biasWrapper;
+        delete gradBiasWrapper;
+        delete[] bias;
+        bias = arena->getParams() + biasOffset;
+        gradBias = arena->getGradParams() + biasOffset;
+        biasWrapper = arena->createParamsView(biasOffset, getBiasSize());
+        gradBiasWrapper = arena->createGradParamsView(biasOffset, getBiasSize());
+        biasWrapper->copyToDevice();
+    }
+    parameterArena = arena;
+}
 VIRTUAL void ConvolutionalLayer::setTrainerState(TrainerStateMaker *trainerStateMaker) {
     delete trainerState;
     delete biasTrainerState;
@@ -26,6 +26,10 @@ class BackpropWeights;
 class ConvolutionalMaker;
 class GpuAdd;
 class CopyBuffer;
+class CLWrapperCache;
+class CLDeviceWrapper;
+class ParameterArena;
+class ConvEpilogue;
 class WeightsInitializer;
 
 class ConvolutionalLayer : public Layer {
@@ -41,10 +45,18 @@ public:
     LayerDimensions dim;
 //    ActivationFunction const *const activationFunction;
 
+    // set by fuseActivation: the following activation layer is then done by
+    // us, so our output is already activated, and the bias is added along
+    // with the activation, rather than by forwardImpl
+    ActivationFunction const *fusedActivation; // NOT owned by us
+    ConvEpilogue *epilogue;
+    CLDeviceWrapper *gradPreActivationWrapper;
+
+    // weights and bias are the model, so they keep their host arrays
     float *weights;
     float *bias;
-    float *output;
-    float *gradInput;
+    // only set with a ParameterArena, whose host arrays these point into;
+    // otherwise the grads are device only, like the output and gradInput
     float *gradWeights;
     float *gradBias;
 
@@ -54,9 +66,9 @@ public:
 
     CLWrapper *weightsWrapper;
     CLWrapper *biasWrapper;
-    CLWrapper *outputWrapper;
-    CLWrapper *gradInputWrapper;
-    CLWrapper *gradWeightsWrapper;
+    CLDeviceWrapper *outputWrapper; // device only, see CLDeviceWrapper
+    CLDeviceWrapper *gradInputWrapper;
+    CLWrapper *gradWeightsWrapper; // a CLDeviceWrapper, unless in a ParameterArena
     CLWrapper *gradBiasWrapper;
 
     int batchSize;
@@ -72,6 +84,14 @@ public:
     GpuAdd *gpuAdd;
     CopyBuffer *copyBuffer;
 
+    // only used if our neighbours dont have their own wrappers
+    CLWrapperCache *upstreamWrapperCache;
+    CLWrapperCache *gradOutputWrapperCache;
+
+    // if non-zero, weights, bias, and their gradients, point into this, and
+    // are not ours to delete[]
+    ParameterArena *parameterArena; // NOT owned by us
+
     inline int getWeightIndex(int filterId, int inputPlane, int filterRow, int filterCol) const {
         return (( filterId 
             * dim.inputPlanes + inputPlane)
@@ -88,8 +108,8 @@ public:
             * dim.outputSize + outRow)
             * dim.outputSize + outCol;
     }
-    inline float getOutput(int n, int outPlane, int outRow, int outCol) const {
-        return output[ getOutputIndex(n,outPlane, outRow, outCol) ];
+    inline float getOutput(int n, int outPlane, int outRow, int outCol) {
+        return getOutput()[ getOutputIndex(n,outPlane, outRow, outCol) ];
     }
 
 //    ConvolutionalLayer(Layer *previousLayer, ConvolutionalMaker const*maker);
@@ -134,6 +154,11 @@ public:
     VIRTUAL void printWeights();
     VIRTUAL void printOutput();
     VIRTUAL void setBatchSize(int batchSize);
+    VIRTUAL bool fuseActivation(ActivationFunction const *fn);
+    VIRTUAL bool takesOutputView() const;
+    VIRTUAL void setOutputView(CLDeviceWrapper *outputView);
+    VIRTUAL ActivationFunction const *getFusedActivation() const;
+    VIRTUAL bool isTuning();
     VIRTUAL void setWeights(float *weights, float *bias);
     VIRTUAL int getOutputCubeSize() const;
     VIRTUAL int getPersistSize(int version) const;
@@ -155,6 +180,7 @@ public:
     VIRTUAL bool biased();
     VIRTUAL TrainerState *getTrainerState();
     VIRTUAL TrainerState *getBiasTrainerState();
+    VIRTUAL void setParameterArena(ParameterArena *arena, int weightsOffset, int biasOffset);
     VIRTUAL void setTrainerState(TrainerStateMaker *trainerStateMaker);
 
     // [[[end]]]
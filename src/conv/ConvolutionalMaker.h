@@ -22,6 +22,7 @@ public:
     int _filterSize;
     bool _padZeros;
     bool _biased;
+    int _skip;
     WeightsInitializer *_weightsInitializer;
 
     PUBLICAPI ConvolutionalMaker() :
@@ -29,6 +30,7 @@ public:
             _filterSize(0),
             _padZeros(false),
             _biased(true),
+            _skip(0),
             _weightsInitializer(new OriginalInitializer()) { // will leak slightly, but hopefully not much
     }
     PUBLICAPI static ConvolutionalMaker *instance() {
@@ -62,6 +64,11 @@ public:
         this->_biased = _biased;
         return this;
     }    
+    /// skip 1 means a stride of 2, and so on; default 0
+    PUBLICAPI ConvolutionalMaker *skip(int skip) {
+        this->_skip = skip;
+        return this;
+    }    
     virtual ConvolutionalMaker *clone() const {
         return new ConvolutionalMaker(*this); // this will copy the activationfunction pointer too
     }
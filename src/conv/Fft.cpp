@@ -0,0 +1,399 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "templates/TemplatedKernel.h"
+#include "util/stringhelper.h"
+#include "conv/Fft.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// each work item holds a whole row, or column, in private memory
+static const int maxFftSize = 256;
+
+PUBLIC Fft::Fft(EasyCL *cl, int fftSize) :
+        cl(cl),
+        fftSize(fftSize),
+        kernelRowsFromReal(0),
+        kernelColumns(0),
+        kernelRowsToReal(0),
+        kernelMultiplyAccumulate(0),
+        kernelAddDc(0),
+        kernelSnapshotChanged(0),
+        changedWrapper(0) {
+    if(fftSize < 1 || fftSize > maxFftSize || (fftSize & (fftSize - 1)) != 0) {
+        throw runtime_error("Fft size must be a power of 2, up to " + toString(maxFftSize) + ", not " + toString(fftSize));
+    }
+    changed[0] = 0;
+}
+PUBLIC Fft::~Fft() {
+    delete kernelRowsFromReal;
+    delete kernelColumns;
+    delete kernelRowsToReal;
+    delete kernelMultiplyAccumulate;
+    delete kernelAddDc;
+    delete kernelSnapshotChanged;
+    delete changedWrapper;
+}
+// the input plus padding on both sides: the products of the forward pass,
+// and of backward, which pads gradOutput out to the padded input, then fit
+// without wrapping round
+PUBLIC STATIC int Fft::fftSizeFor(LayerDimensions const &dim) {
+    int padded = dim.inputSize + (dim.padZeros ? (dim.filterSize >> 1) * 2 : 0);
+    int fftSize = 1;
+    while(fftSize < padded) {
+        fftSize <<= 1;
+    }
+    return fftSize;
+}
+PUBLIC STATIC bool Fft::supports(LayerDimensions const &dim) {
+    return dim.skip == 0 && fftSizeFor(dim) <= maxFftSize;
+}
+PUBLIC int Fft::getFftSize() const {
+    return fftSize;
+}
+// real planes, [plane][row][col], of planeSize x planeSize, put at
+// (shift, shift) in zeroed fftSize x fftSize planes, and transformed
+PUBLIC void Fft::forwardPlanes(CLWrapper *realWrapper, int realOffset, int numPlanes, int planeSize, int shift, CLWrapper *freqWrapper) {
+    if(kernelRowsFromReal == 0) {
+        kernelRowsFromReal = buildKernelNamed("fft_rows_from_real");
+    }
+    int numKernels = numPlanes * fftSize;
+    kernelRowsFromReal->in(numKernels);
+    kernelRowsFromReal->in(realWrapper);
+    kernelRowsFromReal->in(realOffset);
+    kernelRowsFromReal->in(planeSize);
+    kernelRowsFromReal->in(shift);
+    kernelRowsFromReal->out(freqWrapper);
+    runKernel(kernelRowsFromReal, numKernels);
+    columns(freqWrapper, numPlanes, -1.0f);
+}
+// inverse transforms freqWrapper, in place, and writes out the
+// outSize x outSize block of each plane starting at (start, start)
+PUBLIC void Fft::inversePlanes(CLWrapper *freqWrapper, int numPlanes, int start, int outSize, CLWrapper *realWrapper, int realOffset) {
+    columns(freqWrapper, numPlanes, 1.0f);
+    if(kernelRowsToReal == 0) {
+        kernelRowsToReal = buildKernelNamed("fft_rows_to_real");
+    }
+    if(!realWrapper->isOnDevice()) {
+        realWrapper->createOnDevice();
+    }
+    int numKernels = numPlanes * outSize;
+    kernelRowsToReal->in(numKernels);
+    kernelRowsToReal->in(freqWrapper);
+    kernelRowsToReal->in(start);
+    kernelRowsToReal->in(outSize);
+    kernelRowsToReal->out(realWrapper);
+    kernelRowsToReal->in(realOffset);
+    runKernel(kernelRowsToReal, numKernels);
+}
+// out[i][j] = sum over s of a[i][j][s] * b[i][j][s], where the strides, in
+// planes, say where each of a's and b's planes are for i, j and s
+PUBLIC void Fft::multiplyAccumulate(
+        int numI, int numJ, int numS,
+        CLWrapper *aWrapper, int aStrideI, int aStrideJ, int aStrideS,
+        CLWrapper *bWrapper, int bStrideI, int bStrideJ, int bStrideS,
+        bool conjugateB, bool accumulate, CLWrapper *outWrapper) {
+    if(kernelMultiplyAccumulate == 0) {
+        kernelMultiplyAccumulate = buildKernelNamed("fft_multiply_accumulate");
+    }
+    int numKernels = numI * numJ * fftSize * fftSize;
+    kernelMultiplyAccumulate->in(numKernels);
+    kernelMultiplyAccumulate->in(numJ);
+    kernelMultiplyAccumulate->in(numS);
+    kernelMultiplyAccumulate->in(aStrideI);
+    kernelMultiplyAccumulate->in(aStrideJ);
+    kernelMultiplyAccumulate->in(aStrideS);
+    kernelMultiplyAccumulate->in(bStrideI);
+    kernelMultiplyAccumulate->in(bStrideJ);
+    kernelMultiplyAccumulate->in(bStrideS);
+    kernelMultiplyAccumulate->in(conjugateB ? 1 : 0);
+    kernelMultiplyAccumulate->in(accumulate ? 1 : 0);
+    kernelMultiplyAccumulate->in(aWrapper);
+    kernelMultiplyAccumulate->in(bWrapper);
+    kernelMultiplyAccumulate->inout(outWrapper);
+    runKernel(kernelMultiplyAccumulate, numKernels);
+}
+// sums[plane] += the sum, over the images, of each transformed plane's
+// dc term, ie of the original plane
+PUBLIC void Fft::addDcTerms(CLWrapper *freqWrapper, int numImages, int numPlanes, CLWrapper *sumsWrapper) {
+    if(kernelAddDc == 0) {
+        kernelAddDc = buildKernelNamed("fft_add_dc");
+    }
+    kernelAddDc->in(numPlanes);
+    kernelAddDc->in(numImages);
+    kernelAddDc->in(freqWrapper);
+    kernelAddDc->inout(sumsWrapper);
+    runKernel(kernelAddDc, numPlanes);
+}
+// copies the n weights into snapshotWrapper, returning whether they
+// differed from what was there.  reading back the flag waits for the queue
+PUBLIC bool Fft::snapshotChanged(CLWrapper *weightsWrapper, CLWrapper *snapshotWrapper, int n) {
+    if(kernelSnapshotChanged == 0) {
+        kernelSnapshotChanged = buildKernelNamed("fft_snapshot_changed");
+        changedWrapper = cl->wrap(1, changed);
+    }
+    changed[0] = 0;
+    changedWrapper->copyToDevice();
+    kernelSnapshotChanged->in(n);
+    kernelSnapshotChanged->in(weightsWrapper);
+    kernelSnapshotChanged->inout(snapshotWrapper);
+    kernelSnapshotChanged->inout(changedWrapper);
+    runKernel(kernelSnapshotChanged, n);
+    changedWrapper->copyToHost();
+    return changed[0] != 0;
+}
+PRIVATE void Fft::columns(CLWrapper *freqWrapper, int numPlanes, float sign) {
+    if(kernelColumns == 0) {
+        kernelColumns = buildKernelNamed("fft_columns");
+    }
+    int numKernels = numPlanes * fftSize;
+    kernelColumns->in(numKernels);
+    kernelColumns->in(sign);
+    kernelColumns->inout(freqWrapper);
+    runKernel(kernelColumns, numKernels);
+}
+PRIVATE void Fft::setupBuilder(TemplatedKernel *builder) {
+    int log2FftSize = 0;
+    while((1 << log2FftSize) < fftSize) {
+        log2FftSize++;
+    }
+    builder->set("fftSize", fftSize);
+    builder->set("log2FftSize", log2FftSize);
+}
+PRIVATE CLKernel *Fft::buildKernelNamed(std::string kernelName) {
+    TemplatedKernel builder(cl);
+    setupBuilder(&builder);
+    return builder.buildKernel(
+        kernelName,
+        "fft.cl",
+        getKernelTemplate(),
+        kernelName,
+        false
+    );
+}
+PRIVATE void Fft::runKernel(CLKernel *kernel, int numKernels) {
+    int workgroupSize = cl->getMaxWorkgroupSize();
+    int numWorkgroups = (numKernels + workgroupSize - 1) / workgroupSize;
+    kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
+STATIC std::string Fft::getKernelTemplate() {
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel("kernel", "cl/fft.cl")
+    // ]]]
+    // generated using cog, from cl/fft.cl:
+    const char * kernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// FFT convolution: planes are zero-padded into {{fftSize}} x {{fftSize}}\n"
+    "// complex planes, transformed, multiplied pointwise, summed, and transformed\n"
+    "// back.  {{fftSize}} is a power of 2, large enough that the circular\n"
+    "// convolutions never wrap round onto the part of the result that is kept\n"
+    "//\n"
+    "// complex planes are [plane][row][col] float2s, {{fftSize}} x {{fftSize}} each\n"
+    "// each work item transforms one whole row, or column, in private memory,\n"
+    "// using an iterative radix-2 fft\n"
+    "\n"
+    "#define N {{fftSize}}\n"
+    "#define LOG2_N {{log2FftSize}}\n"
+    "\n"
+    "// CL: grid stride looping\n"
+    "#define CL_KERNEL_LOOP(i, n)                        \\\n"
+    "  for (int i = get_group_id(0) * get_local_size(0) + get_local_id(0); \\\n"
+    "      i < (n);                                       \\\n"
+    "      i += get_local_size(0) * get_num_groups(0))\n"
+    "\n"
+    "// in place; sign is -1 for the forward transform, +1 for the inverse, which\n"
+    "// is left unscaled\n"
+    "void fft_private(float2 *buf, const float sign) {\n"
+    "  for (int i = 0; i < N; i++) {\n"
+    "    int j = 0;\n"
+    "    int v = i;\n"
+    "    for (int b = 0; b < LOG2_N; b++) {\n"
+    "      j = (j << 1) | (v & 1);\n"
+    "      v >>= 1;\n"
+    "    }\n"
+    "    if (i < j) {\n"
+    "      float2 t = buf[i];\n"
+    "      buf[i] = buf[j];\n"
+    "      buf[j] = t;\n"
+    "    }\n"
+    "  }\n"
+    "  for (int len = 2; len <= N; len <<= 1) {\n"
+    "    int half = len >> 1;\n"
+    "    float angleStep = sign * 2.0f * M_PI_F / len;\n"
+    "    for (int k = 0; k < half; k++) {\n"
+    "      float c;\n"
+    "      float s = sincos(angleStep * k, &c);\n"
+    "      for (int start = 0; start < N; start += len) {\n"
+    "        float2 u = buf[start + k];\n"
+    "        float2 v = buf[start + k + half];\n"
+    "        float2 t = (float2)(v.x * c - v.y * s, v.x * s + v.y * c);\n"
+    "        buf[start + k] = u + t;\n"
+    "        buf[start + k + half] = u - t;\n"
+    "      }\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// real planeSize x planeSize planes, placed at (shift, shift) in the padded\n"
+    "// planes, and transformed along the rows\n"
+    "// n = numPlanes * N\n"
+    "kernel void fft_rows_from_real(\n"
+    "    const int n,\n"
+    "    global const float *real, int realOffset,\n"
+    "    const int planeSize, const int shift,\n"
+    "    global float2 *freq) {\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    int row = index % N;\n"
+    "    int plane = index / N;\n"
+    "    global float2 *dst = freq + (plane * N + row) * N;\n"
+    "    int srcRow = row - shift;\n"
+    "    if (srcRow < 0 || srcRow >= planeSize) {\n"
+    "      for (int x = 0; x < N; x++) {\n"
+    "        dst[x] = (float2)(0.0f, 0.0f);\n"
+    "      }\n"
+    "      continue;\n"
+    "    }\n"
+    "    global const float *src = real + realOffset + (plane * planeSize + srcRow) * planeSize;\n"
+    "    float2 buf[N];\n"
+    "    for (int x = 0; x < N; x++) {\n"
+    "      int srcCol = x - shift;\n"
+    "      buf[x] = (float2)((srcCol >= 0 && srcCol < planeSize) ? src[srcCol] : 0.0f, 0.0f);\n"
+    "    }\n"
+    "    fft_private(buf, -1.0f);\n"
+    "    for (int x = 0; x < N; x++) {\n"
+    "      dst[x] = buf[x];\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// n = numPlanes * N\n"
+    "kernel void fft_columns(\n"
+    "    const int n, const float sign,\n"
+    "    global float2 *freq) {\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    int col = index % N;\n"
+    "    int plane = index / N;\n"
+    "    global float2 *p = freq + plane * N * N + col;\n"
+    "    float2 buf[N];\n"
+    "    for (int y = 0; y < N; y++) {\n"
+    "      buf[y] = p[y * N];\n"
+    "    }\n"
+    "    fft_private(buf, sign);\n"
+    "    for (int y = 0; y < N; y++) {\n"
+    "      p[y * N] = buf[y];\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// inverse transforms rows start to start + outSize - 1, of planes whose\n"
+    "// columns have already been inverse transformed, and writes out the\n"
+    "// outSize x outSize real block starting at (start, start), scaled by 1 / N^2\n"
+    "// n = numPlanes * outSize\n"
+    "kernel void fft_rows_to_real(\n"
+    "    const int n,\n"
+    "    global const float2 *freq,\n"
+    "    const int start, const int outSize,\n"
+    "    global float *real, int realOffset) {\n"
+    "  const float scale = 1.0f / (N * N);\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    int row = index % outSize;\n"
+    "    int plane = index / outSize;\n"
+    "    global const float2 *src = freq + (plane * N + row + start) * N;\n"
+    "    float2 buf[N];\n"
+    "    for (int x = 0; x < N; x++) {\n"
+    "      buf[x] = src[x];\n"
+    "    }\n"
+    "    fft_private(buf, 1.0f);\n"
+    "    global float *dst = real + realOffset + (plane * outSize + row) * outSize;\n"
+    "    for (int x = 0; x < outSize; x++) {\n"
+    "      dst[x] = buf[x + start].x * scale;\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// out[i][j] = sum over s of a[i * aStrideI + j * aStrideJ + s * aStrideS] *\n"
+    "//     b[i * bStrideI + j * bStrideJ + s * bStrideS], pointwise, where each\n"
+    "// index picks out a whole complex plane\n"
+    "// conjugateB turns the convolution into a correlation; accumulate adds onto\n"
+    "// what is already in out\n"
+    "// n = numI * numJ * N * N\n"
+    "kernel void fft_multiply_accumulate(\n"
+    "    const int n, const int numJ, const int numS,\n"
+    "    const int aStrideI, const int aStrideJ, const int aStrideS,\n"
+    "    const int bStrideI, const int bStrideJ, const int bStrideS,\n"
+    "    const int conjugateB, const int accumulate,\n"
+    "    global const float2 *a, global const float2 *b,\n"
+    "    global float2 *out) {\n"
+    "  const int planeArea = N * N;\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    int k = index % planeArea;\n"
+    "    int rest = index / planeArea;\n"
+    "    int j = rest % numJ;\n"
+    "    int i = rest / numJ;\n"
+    "    global const float2 *aPlane = a + (i * aStrideI + j * aStrideJ) * planeArea + k;\n"
+    "    global const float2 *bPlane = b + (i * bStrideI + j * bStrideJ) * planeArea + k;\n"
+    "    float2 sum = accumulate ? out[index] : (float2)(0.0f, 0.0f);\n"
+    "    for (int s = 0; s < numS; s++) {\n"
+    "      float2 x = aPlane[s * aStrideS * planeArea];\n"
+    "      float2 y = bPlane[s * bStrideS * planeArea];\n"
+    "      if (conjugateB) {\n"
+    "        y.y = -y.y;\n"
+    "      }\n"
+    "      sum += (float2)(x.x * y.x - x.y * y.y, x.x * y.y + x.y * y.x);\n"
+    "    }\n"
+    "    out[index] = sum;\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// the dc term of a transformed plane is the sum of the original plane\n"
+    "// sums[plane] += sum over images of that, for freq laid out [image][plane]\n"
+    "kernel void fft_add_dc(\n"
+    "    const int numPlanes, const int numImages,\n"
+    "    global const float2 *freq,\n"
+    "    global float *sums) {\n"
+    "  CL_KERNEL_LOOP(plane, numPlanes) {\n"
+    "    float sum = 0.0f;\n"
+    "    for (int image = 0; image < numImages; image++) {\n"
+    "      sum += freq[(image * numPlanes + plane) * N * N].x;\n"
+    "    }\n"
+    "    sums[plane] += sum;\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// copies weights into snapshot, and sets changed[0] to 1 if they differed\n"
+    "kernel void fft_snapshot_changed(\n"
+    "    const int n,\n"
+    "    global const float *weights,\n"
+    "    global float *snapshot,\n"
+    "    global int *changed) {\n"
+    "  CL_KERNEL_LOOP(i, n) {\n"
+    "    float w = weights[i];\n"
+    "    if (w != snapshot[i]) {\n"
+    "      snapshot[i] = w;\n"
+    "      changed[0] = 1;\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "";
+    // [[[end]]]
+    return kernelSource;
+}
+
@@ -0,0 +1,76 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+
+#include "conv/LayerDimensions.h"
+
+class EasyCL;
+class CLWrapper;
+class CLKernel;
+class TemplatedKernel;
+
+#include "DeepCLDllExport.h"
+
+#define STATIC static
+#define VIRTUAL virtual
+
+// 2d ffts, and the pointwise products between them, for the fft
+// convolutions, ForwardFft, BackwardFft and BackpropWeightsFft
+// every plane is zero padded to fftSize x fftSize, the next power of 2 that
+// holds an input plane plus its padding, so that the circular convolutions
+// equal the linear ones over the part that is kept
+// complex planes are float2s, so a workspace of n complex values needs
+// 2 * n floats.  see cl/fft.cl
+class DeepCL_EXPORT Fft {
+    private:
+    EasyCL *cl; // NOT owned by us
+    int fftSize;
+
+    CLKernel *kernelRowsFromReal;
+    CLKernel *kernelColumns;
+    CLKernel *kernelRowsToReal;
+    CLKernel *kernelMultiplyAccumulate;
+    CLKernel *kernelAddDc;
+    CLKernel *kernelSnapshotChanged;
+
+    int changed[1];
+    CLWrapper *changedWrapper;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    Fft(EasyCL *cl, int fftSize);
+    ~Fft();
+    STATIC int fftSizeFor(LayerDimensions const &dim);
+    STATIC bool supports(LayerDimensions const &dim);
+    int getFftSize() const;
+    void forwardPlanes(CLWrapper *realWrapper, int realOffset, int numPlanes, int planeSize, int shift, CLWrapper *freqWrapper);
+    void inversePlanes(CLWrapper *freqWrapper, int numPlanes, int start, int outSize, CLWrapper *realWrapper, int realOffset);
+    void multiplyAccumulate(
+        int numI, int numJ, int numS,
+        CLWrapper *aWrapper, int aStrideI, int aStrideJ, int aStrideS,
+        CLWrapper *bWrapper, int bStrideI, int bStrideJ, int bStrideS,
+    bool conjugateB, bool accumulate, CLWrapper *outWrapper);
+    void addDcTerms(CLWrapper *freqWrapper, int numImages, int numPlanes, CLWrapper *sumsWrapper);
+    bool snapshotChanged(CLWrapper *weightsWrapper, CLWrapper *snapshotWrapper, int n);
+
+    private:
+    void columns(CLWrapper *freqWrapper, int numPlanes, float sign);
+    void setupBuilder(TemplatedKernel *builder);
+    CLKernel *buildKernelNamed(std::string kernelName);
+    void runKernel(CLKernel *kernel, int numKernels);
+    STATIC std::string getKernelTemplate();
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,99 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <sstream>
+
+#include "EasyCL.h"
+#include "conv/Fft.h"
+#include "conv/Im2ColWorkspace.h"
+#include "conv/FftFilterCache.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+#ifndef NOTHREADS
+#define FFTFILTERCACHE_LOCK lock_guard<std::mutex> lock(mutex)
+#else
+#define FFTFILTERCACHE_LOCK
+#endif
+
+std::map<FftFilterCache::Key, FftFilterCache *> FftFilterCache::entries;
+#ifndef NOTHREADS
+std::mutex FftFilterCache::mutex;
+#endif
+
+PRIVATE FftFilterCache::FftFilterCache(EasyCL *cl, LayerDimensions const &dim, CLWrapper *weightsWrapper, Key key) :
+        cl(cl),
+        dim(dim),
+        weightsWrapper(weightsWrapper),
+        key(key),
+        refCount(0),
+        valid(false) {
+    snapshotWorkspace = new Im2ColWorkspace(cl);
+    transformedWorkspace = new Im2ColWorkspace(cl);
+}
+PRIVATE FftFilterCache::~FftFilterCache() {
+    delete snapshotWorkspace;
+    delete transformedWorkspace;
+}
+// keyed on the dimensions too, in case a wrapper is freed, and another,
+// for a different layer, is then allocated at the same address
+PUBLIC STATIC FftFilterCache *FftFilterCache::acquire(EasyCL *cl, LayerDimensions const &dim, CLWrapper *weightsWrapper) {
+    FFTFILTERCACHE_LOCK;
+    ostringstream dimString;
+    dimString << dim;
+    Key key(weightsWrapper, dimString.str());
+    FftFilterCache *cache = 0;
+    if(entries.find(key) == entries.end()) {
+        cache = new FftFilterCache(cl, dim, weightsWrapper, key);
+        entries[key] = cache;
+    } else {
+        cache = entries[key];
+    }
+    cache->refCount++;
+    return cache;
+}
+PUBLIC STATIC void FftFilterCache::release(FftFilterCache *cache) {
+    if(cache == 0) {
+        return;
+    }
+    FFTFILTERCACHE_LOCK;
+    cache->refCount--;
+    if(cache->refCount == 0) {
+        entries.erase(cache->key);
+        delete cache;
+    }
+}
+// for callers that hold on to an entry: current, if it's already for
+// weightsWrapper, otherwise current is released, and weightsWrapper's
+// entry acquired.  a new wrapper at the same address is caught by the
+// snapshot of the weights anyway
+PUBLIC STATIC FftFilterCache *FftFilterCache::reacquire(FftFilterCache *current, EasyCL *cl, LayerDimensions const &dim, CLWrapper *weightsWrapper) {
+    if(current != 0 && current->weightsWrapper == weightsWrapper) {
+        return current;
+    }
+    release(current);
+    return acquire(cl, dim, weightsWrapper);
+}
+// [filter][inputplane] complex planes, of fft->getFftSize() squared each
+PUBLIC CLWrapper *FftFilterCache::getTransformed(Fft *fft) {
+    int numWeights = dim.filtersSize;
+    int fftSize = fft->getFftSize();
+    int numPlanes = dim.numFilters * dim.inputPlanes;
+    CLWrapper *snapshotWrapper = snapshotWorkspace->get(numWeights);
+    CLWrapper *transformedWrapper = transformedWorkspace->get(numPlanes * fftSize * fftSize * 2);
+    bool changed = fft->snapshotChanged(weightsWrapper, snapshotWrapper, numWeights);
+    if(changed || !valid) {
+        fft->forwardPlanes(weightsWrapper, 0, numPlanes, dim.filterSize, 0, transformedWrapper);
+        valid = true;
+    }
+    return transformedWrapper;
+}
+
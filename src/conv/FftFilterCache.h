@@ -0,0 +1,77 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#ifndef NOTHREADS
+#include <mutex>
+#endif
+
+#include "conv/LayerDimensions.h"
+
+class EasyCL;
+class CLWrapper;
+class Fft;
+class Im2ColWorkspace;
+
+#include "DeepCLDllExport.h"
+
+#define STATIC static
+#define VIRTUAL virtual
+
+// the transformed filters of one layer, shared between its ForwardFft and
+// BackwardFft, which find it through the layer's weights wrapper
+// the filters are only transformed again when the weights differ from the
+// copy taken the last time they were transformed, so, eg, backward reuses
+// forward's transform, and, without training, the transform is done once
+// entries are reference counted: get one with acquire, and give it back
+// with release
+class DeepCL_EXPORT FftFilterCache {
+    private:
+    typedef std::pair<CLWrapper *, std::string> Key;
+
+    EasyCL *cl; // NOT owned by us
+    LayerDimensions dim;
+    CLWrapper *weightsWrapper; // NOT owned by us
+    Key key;
+    int refCount;
+    bool valid;
+    Im2ColWorkspace *snapshotWorkspace;
+    Im2ColWorkspace *transformedWorkspace;
+
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    STATIC std::map<Key, FftFilterCache *> entries;
+    #ifndef NOTHREADS
+    STATIC std::mutex mutex;
+    #endif
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC FftFilterCache *acquire(EasyCL *cl, LayerDimensions const &dim, CLWrapper *weightsWrapper);
+    STATIC void release(FftFilterCache *cache);
+    STATIC FftFilterCache *reacquire(FftFilterCache *current, EasyCL *cl, LayerDimensions const &dim, CLWrapper *weightsWrapper);
+    CLWrapper *getTransformed(Fft *fft);
+
+    private:
+    FftFilterCache(EasyCL *cl, LayerDimensions const &dim, CLWrapper *weightsWrapper, Key key);
+    ~FftFilterCache();
+
+    // [[[end]]]
+};
+
@@ -17,6 +17,11 @@
 #include "conv/ForwardFc.h"
 #include "conv/ForwardByInputPlane.h"
 #include "conv/ForwardIm2Col.h"
+#include "conv/ForwardCpuIm2Col.h"
+#include "conv/ForwardWinograd.h"
+#include "conv/Winograd.h"
+#include "conv/ForwardFft.h"
+#include "conv/Fft.h"
 #include "conv/ForwardAuto.h"
 #include "util/StatefulTimer.h"
 
@@ -54,18 +59,46 @@ STATIC Forward *Forward::instanceTest(EasyCL *cl, LayerDimensions layerDimension
     return new Forward2(cl, layerDimensions);
 }
 STATIC int Forward::getNumImplementations() {
-    return 8;
+    return 11;
 }
-STATIC bool Forward::plausiblyOptimal(int index, int batchSize, LayerDimensions dim) {
+// cpuim2col runs on the host, so it's only a candidate when cl isnt a gpu;
+// on a gpu it would just leave the gpu idle.  asking for it by name, or by
+// index, still works on any device
+STATIC bool Forward::plausiblyOptimal(int index, int batchSize, EasyCL *cl, LayerDimensions dim) {
     if(index == 0) { 
         return false;
     }
-    if(index > 7) {
+    if(index > 10) {
+        return false;
+    }
+    if(index == 8) {
+        cl_device_type deviceType = 0;
+        clGetDeviceInfo(cl->device, CL_DEVICE_TYPE, sizeof(deviceType), &deviceType, 0);
+        if((deviceType & CL_DEVICE_TYPE_GPU) != 0) {
+            return false;
+        }
+    }
+    if(index == 9 && !Winograd::supports(dim)) {
+        return false;
+    }
+    // fft costs about the same whatever the filter size, so only large
+    // filters make it worth trying
+    if(index == 10 && (!Fft::supports(dim) || dim.filterSize < 7)) {
+        return false;
+    }
+    if(dim.skip > 0 && !supportsSkip(index)) {
         return false;
     }
     return true;
 }
+// which implementations can handle skip > 0, ie a stride other than 1
+STATIC bool Forward::supportsSkip(int index) {
+    return index == 0 || index == 1 || index == 7 || index == 8;
+}
 STATIC Forward *Forward::instanceSpecific(int idx, EasyCL *cl, LayerDimensions layerDimensions) {
+    if(layerDimensions.skip > 0 && idx >= 0 && !supportsSkip(idx)) {
+        throw runtime_error("Forward::instanceSpecific: implementation " + toString(idx) + " doesnt support skip > 0");
+    }
     if(idx == 0) {
         return new ForwardCpu(cl, layerDimensions);
     } else if(idx == -1) {
@@ -87,11 +120,20 @@ STATIC Forward *Forward::instanceSpecific(int idx, EasyCL *cl, LayerDimensions l
         return new ForwardByInputPlane(cl, layerDimensions);
     } else if(idx == 7) {
         return new ForwardIm2Col(cl, layerDimensions);
+    } else if(idx == 8) {
+        return new ForwardCpuIm2Col(cl, layerDimensions);
+    } else if(idx == 9) {
+        return new ForwardWinograd(cl, layerDimensions);
+    } else if(idx == 10) {
+        return new ForwardFft(cl, layerDimensions);
     } else {
         throw runtime_error(string("") + __FILE__ + ":" + toString(__LINE__) + " Forward::instanceSpecific: no instance defined for index " + toString(idx));
     }
 }
 STATIC Forward *Forward::instanceSpecific(std::string name, EasyCL *cl, LayerDimensions layerDimensions) {
+    if(layerDimensions.skip > 0 && name != "cpu" && name != "prop1" && name != "cpuim2col") {
+        throw runtime_error("Forward::instanceSpecific: " + name + " doesnt support skip > 0");
+    }
     if(name == "cpu") {
         return new ForwardCpu(cl, layerDimensions);
     } else if(name == "prop1") {
@@ -104,6 +146,12 @@ STATIC Forward *Forward::instanceSpecific(std::string name, EasyCL *cl, LayerDim
         return new ForwardFc(cl, layerDimensions);
     } else if(name == "byinplane") {
         return new ForwardByInputPlane(cl, layerDimensions);
+    } else if(name == "cpuim2col") {
+        return new ForwardCpuIm2Col(cl, layerDimensions);
+    } else if(name == "winograd") {
+        return new ForwardWinograd(cl, layerDimensions);
+    } else if(name == "fft") {
+        return new ForwardFft(cl, layerDimensions);
     } else {
         throw runtime_error(string("") + __FILE__ + ":" + toString(__LINE__) + " Forward::instanceSpecific: no instance defined for name " + name);
     }
@@ -142,13 +190,11 @@ VIRTUAL void Forward::forward(int batchSize, float *inputData, float *filters, f
 //    float *output = new float[allocatedOutputNumElements];
     CLWrapper *outputWrapper = cl->wrap(batchSize * dim.outputCubeSize, output);
     outputWrapper->createOnDevice();
-    cl->finish();
 
     StatefulTimer::timeCheck("Forward::forward after copied to device");
     forward(batchSize, dataWrapper, weightsWrapper, biasWrapper,
             outputWrapper);
     StatefulTimer::timeCheck("Forward::forward after call forward");
-    cl->finish();
     outputWrapper->copyToHost();
     StatefulTimer::timeCheck("Forward::forward after copytohost");
 //    for(int i = 0; i < 20; i++) {
@@ -33,6 +33,8 @@ public:
     virtual void forward(int batchSize, 
         CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper,
         CLWrapper *outputWrapper) = 0;
+    // true while forward calls, at this batchSize, are still timing kernels
+    virtual bool isTuning(int batchSize) { return false; }
 
     // [[[cog
     // import cog_addheaders
@@ -43,7 +45,8 @@ public:
     STATIC Forward *instance(EasyCL *cl, LayerDimensions dim);
     STATIC Forward *instanceTest(EasyCL *cl, LayerDimensions layerDimensions);
     STATIC int getNumImplementations();
-    STATIC bool plausiblyOptimal(int index, int batchSize, LayerDimensions dim);
+    STATIC bool plausiblyOptimal(int index, int batchSize, EasyCL *cl, LayerDimensions dim);
+    STATIC bool supportsSkip(int index);
     STATIC Forward *instanceSpecific(int idx, EasyCL *cl, LayerDimensions layerDimensions);
     STATIC Forward *instanceSpecific(std::string name, EasyCL *cl, LayerDimensions layerDimensions);
     VIRTUAL int getOutputTotalSize(int batchSize);
@@ -35,7 +35,6 @@ VIRTUAL void Forward1::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
 //    cout << "forward1 globalsize " << globalSize << " workgroupsize " << workgroupsize << endl;
 
     kernel->run_1d(globalSize, workgroupsize);
-    cl->finish();
     StatefulTimer::timeCheck("Forward1::forward after call forward");
 
     if(dim.biased) {
@@ -121,6 +120,10 @@ Forward1::Forward1(EasyCL *cl, LayerDimensions dim) :
     "//     - loads a whole upstream cube\n"
     "//     - loads a whole filter cube\n"
     "//     - writes one output...\n"
+    "// with gSkip > 0, output (row, col) reads from input (row, col) * (gSkip + 1)\n"
+    "\n"
+    "#define gStride (gSkip + 1)\n"
+    "\n"
     "void kernel convolve_imagecubes_float2(\n"
     "    const int numExamples,\n"
     "      global const float *inputs, global const float *filters,\n"
@@ -147,9 +150,9 @@ Forward1::Forward1(EasyCL *cl, LayerDimensions dim) :
     "            for (int u = -gHalfFilterSize; u <= gHalfFilterSize - gEven; u++) {\n"
     "                // trying to reduce register pressure...\n"
     "                #if gPadZeros == 1\n"
-    "                    #define inputRowIdx (outputRow + u)\n"
+    "                    #define inputRowIdx (outputRow * gStride + u)\n"
     "                #else\n"
-    "                    #define inputRowIdx (outputRow + u + gHalfFilterSize)\n"
+    "                    #define inputRowIdx (outputRow * gStride + u + gHalfFilterSize)\n"
     "                #endif\n"
     "                global float const *inputRow = inputPlane + inputRowIdx * gInputSize;\n"
     "                global float const *filterRow = filterPlane + (u+gHalfFilterSize) * gFilterSize + gHalfFilterSize;\n"
@@ -157,9 +160,9 @@ Forward1::Forward1(EasyCL *cl, LayerDimensions dim) :
     "                #pragma unroll\n"
     "                for (int v = -gHalfFilterSize; v <= gHalfFilterSize - gEven; v++) {\n"
     "                    #if gPadZeros == 1\n"
-    "                        #define inputColIdx (outputCol + v)\n"
+    "                        #define inputColIdx (outputCol * gStride + v)\n"
     "                    #else\n"
-    "                        #define inputColIdx (outputCol + v + gHalfFilterSize)\n"
+    "                        #define inputColIdx (outputCol * gStride + v + gHalfFilterSize)\n"
     "                    #endif\n"
     "                    bool process = rowOk && inputColIdx >= 0 && inputColIdx < gInputSize;\n"
     "                    if (process) {\n"
@@ -36,7 +36,6 @@ VIRTUAL void Forward2::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
     kernel->localFloats(square(dim.filterSize) * dim.inputPlanes);
 //    cout << "forward2 globalsize " << globalSize << " workgroupsize " << workgroupsize << endl;
     kernel->run_1d(globalSize, workgroupSize);
-    cl->finish();
     StatefulTimer::timeCheck("Forward2::forward after call forward");
 
     if(dim.biased) {
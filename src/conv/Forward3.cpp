@@ -39,7 +39,6 @@ VIRTUAL void Forward3::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
     int numWorkgroups = dim.numFilters * batchSize;
     int globalSize = workgroupsize * numWorkgroups;
     kernel->run_1d(globalSize, workgroupsize);
-    cl->finish();
 
     StatefulTimer::timeCheck("Forward3::forward after kernel1");
 
@@ -35,7 +35,6 @@ VIRTUAL void Forward4::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
     kernel->localFloats(square(dim.filterSize) );
 
     kernel->run_1d(globalSize, workgroupSize);
-    cl->finish();
     StatefulTimer::timeCheck("Forward4::forward after call forward");
 
     if(dim.biased) {
@@ -16,6 +16,8 @@
 #include "conv/LayerDimensions.h"
 #include "DeepCLDllExport.h"
 
+class AutoTuner;
+
 using namespace std;
 
 //inline float square(float value) {
@@ -32,11 +34,8 @@ public:
 //    ActivationFunction const*fn;
 
     int num;
-    int *milliseconds;
-    bool *valid;
-    int chosenIndex;
     Forward **instances;
-    int nextIndex;
+    AutoTuner *tuner;
 
     // [[[cog
     // import cog_addheaders
@@ -45,6 +44,7 @@ public:
     // generated, using cog:
     ForwardAuto(EasyCL *cl, LayerDimensions dim);
     VIRTUAL ~ForwardAuto();
+    VIRTUAL bool isTuning(int batchSize);
     VIRTUAL void forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper,
     CLWrapper *biasWrapper, CLWrapper *outputWrapper);
 
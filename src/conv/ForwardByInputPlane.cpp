@@ -57,7 +57,6 @@ VIRTUAL void ForwardByInputPlane::forward(int batchSize, CLWrapper *dataWrapper,
     int globalSize = workgroupsize * numWorkgroups;
 //    cout << "forwardbyinputplane numworkgroups " << numWorkgroups << " globalsize " << globalSize << " workgroupsize " << workgroupsize << " numinputplanes=" << dim.numInputPlanes << endl;
     kernel->run_1d(globalSize, workgroupsize);
-    cl->finish();
     StatefulTimer::timeCheck("ForwardByInputPlane::forward after kernel1");
 
 //    {
@@ -71,7 +70,6 @@ VIRTUAL void ForwardByInputPlane::forward(int batchSize, CLWrapper *dataWrapper,
     maxglobalId = batchSize * dim.numFilters * dim.outputSize * dim.outputSize;
     numWorkgroups = (maxglobalId + maxWorkgroupSize - 1) / maxWorkgroupSize;
     reduceSegments->run_1d(numWorkgroups * maxWorkgroupSize, maxWorkgroupSize);
-    cl->finish();
     StatefulTimer::timeCheck("ForwardByInputPlane::forward after reduce over inputplanes");
 
     if(dim.biased) {
@@ -82,7 +80,6 @@ VIRTUAL void ForwardByInputPlane::forward(int batchSize, CLWrapper *dataWrapper,
         maxglobalId = batchSize * dim.numFilters * dim.outputSize * dim.outputSize;
         numWorkgroups = (maxglobalId + maxWorkgroupSize - 1) / maxWorkgroupSize;
         repeatedAdd->run_1d(numWorkgroups * maxWorkgroupSize, maxWorkgroupSize);
-        cl->finish();
         StatefulTimer::timeCheck("ForwardByInputPlane::forward after repeatedAdd");
     }
 
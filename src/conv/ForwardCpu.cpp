@@ -42,23 +42,21 @@ VIRTUAL void ForwardCpu::forward(int batchSize, CLWrapper *inputDataWrapper, CLW
 VIRTUAL float *ForwardCpu::forward(int batchSize, float *inputData, float *weights, float *bias) {
 //    cout << "ForwardCpu::forward outputcubesize=" << dim.outputCubeSize << " batchSize=" << batchSize << endl;
     float *output = new float[ dim.outputCubeSize * batchSize ];
+    const int stride = dim.skip + 1;
+    const int margin = dim.padZeros ? dim.halfFilterSize : 0;
     for(int n = 0; n < batchSize; n++) {
         for(int filter = 0; filter < dim.numFilters; filter++) {
-            for(int outRow = 0; outRow < dim.outputSize; outRow += 1 + dim.skip) {
-                for(int outCol = 0; outCol < dim.outputSize; outCol += 1 + dim.skip) {
+            for(int outRow = 0; outRow < dim.outputSize; outRow++) {
+                for(int outCol = 0; outCol < dim.outputSize; outCol++) {
                     float sum = 0;
                     for(int inPlane = 0; inPlane < dim.inputPlanes; inPlane++) {
-//                        cout << "inplane=" << inPlane << endl;
-                        for(int u = -dim.halfFilterSize; u <= dim.halfFilterSize; u++) {
-                            int inRow = outRow * (dim.skip + 1) + u + (dim.padZeros ? 0 : dim.halfFilterSize);
-//                                cout << "candidate inRow " << inRow << endl;
+                        for(int filterRow = 0; filterRow < dim.filterSize; filterRow++) {
+                            int inRow = outRow * stride + filterRow - margin;
                             if(inRow < 0 || inRow > dim.inputSize - 1) {
                                 continue;
                             }
-                            int filterRow = u + dim.halfFilterSize;
-                            for(int v = -dim.halfFilterSize; v <= dim.halfFilterSize; v++) {
-                                int inCol = outCol * (dim.skip + 1) + v + (dim.padZeros ? 0 : dim.halfFilterSize);
-                                int filterCol = v + dim.halfFilterSize;
+                            for(int filterCol = 0; filterCol < dim.filterSize; filterCol++) {
+                                int inCol = outCol * stride + filterCol - margin;
                                 if(inCol < 0 || inCol > dim.inputSize - 1) {
                                     continue;
                                 }
@@ -70,15 +68,7 @@ VIRTUAL float *ForwardCpu::forward(int batchSize, float *inputData, float *weigh
                                     * dim.inputPlanes + inPlane) 
                                     * dim.filterSize  + filterRow)
                                     * dim.filterSize  + filterCol;
-//                                    cout << "inpos " << inRow << "," << inCol << " outpos " << outRow << "," << outCol
-//                                        << " filterpos " << filterRow << "," << filterCol << endl;
-                                float sumchange = inputData[ inputIndex] * weights[ weightIndex ];
-                                if(sumchange != 0) {
-//                                        cout << inputData[inputIndex] << " * " << weights[weightIndex] << " = " << sumchange << endl;
-                                }
-                                sum += sumchange;
-//                                cout << "inputIndex=" << inputIndex << " weightIndex=" << weightIndex << 
-//                                    "  inputData[inputIndex]=" << inputData[inputIndex] << " weights[weightIndex]=" << weights[weightIndex] << " sumchange " << sumchange << " sum=" << sum << endl;
+                                sum += inputData[ inputIndex] * weights[ weightIndex ];
                             }
                         }
                     }
@@ -0,0 +1,225 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cstring>
+#include <algorithm>
+
+#include "EasyCL.h"
+#include "clmath/CLDeviceWrapper.h"
+#include "conv/ForwardCpuIm2Col.h"
+#include "util/ThreadPool.h"
+#include "util/StatefulTimer.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CPUIM2COL_AVX
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CPUIM2COL_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CPUIM2COL_NEON
+#endif
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+
+// the gemm walks the output in tiles of this many pixels, and the
+// columns in tiles of this many rows, so one tile of columns stays in
+// l2 while we run every filter over it, and one output row tile stays in l1
+#define OUTPUT_TILE 256
+#define K_TILE 128
+
+// y[i] += a * x[i], for i in [0, n)
+static inline void axpy(int n, float a, float const *x, float *y) {
+    int i = 0;
+    #if defined(CPUIM2COL_AVX)
+    __m256 a8 = _mm256_set1_ps(a);
+    for(; i + 8 <= n; i += 8) {
+        #ifdef __FMA__
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a8, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        #else
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(a8, _mm256_loadu_ps(x + i))));
+        #endif
+    }
+    #elif defined(CPUIM2COL_SSE)
+    __m128 a4 = _mm_set1_ps(a);
+    for(; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(a4, _mm_loadu_ps(x + i))));
+    }
+    #elif defined(CPUIM2COL_NEON)
+    float32x4_t a4 = vdupq_n_f32(a);
+    for(; i + 4 <= n; i += 4) {
+        vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), vld1q_f32(x + i), a4));
+    }
+    #endif
+    for(; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+// unrolls one image per task
+class ForwardCpuIm2ColUnrollTask : public ThreadPoolTask {
+public:
+    LayerDimensions dim;
+    float const *inputData;
+    float *columns;
+    ForwardCpuIm2ColUnrollTask(LayerDimensions dim, float const *inputData, float *columns) :
+        dim(dim),
+        inputData(inputData),
+        columns(columns) {
+    }
+    virtual void run(int n) {
+        int columnsSize = dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared;
+        ForwardCpuIm2Col::im2Col(dim, inputData + n * dim.inputCubeSize, columns + n * columnsSize);
+    }
+};
+
+// one task per [image][block of filters]
+class ForwardCpuIm2ColGemmTask : public ThreadPoolTask {
+public:
+    LayerDimensions dim;
+    int numFilterBlocks;
+    int filtersPerBlock;
+    float const *weights;
+    float const *bias;
+    float const *columns;
+    float *output;
+    ForwardCpuIm2ColGemmTask(LayerDimensions dim, int numFilterBlocks, int filtersPerBlock, float const *weights,
+            float const *bias, float const *columns, float *output) :
+        dim(dim),
+        numFilterBlocks(numFilterBlocks),
+        filtersPerBlock(filtersPerBlock),
+        weights(weights),
+        bias(bias),
+        columns(columns),
+        output(output) {
+    }
+    virtual void run(int index) {
+        int n = index / numFilterBlocks;
+        int filterBlock = index % numFilterBlocks;
+        int filterStart = filterBlock * filtersPerBlock;
+        int filterEnd = std::min(dim.numFilters, filterStart + filtersPerBlock);
+        int columnsSize = dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared;
+        float const *imageColumns = columns + n * columnsSize;
+        ForwardCpuIm2Col::gemm(dim, filterStart, filterEnd, weights, bias, imageColumns, output + n * dim.outputCubeSize);
+    }
+};
+
+PUBLIC ForwardCpuIm2Col::ForwardCpuIm2Col(EasyCL *cl, LayerDimensions dim) :
+        Forward(cl, dim),
+        threadPool(ThreadPool::instance()),
+        columns(0),
+        columnsAllocated(0) {
+}
+PUBLIC VIRTUAL ForwardCpuIm2Col::~ForwardCpuIm2Col() {
+    delete[] columns;
+}
+PUBLIC VIRTUAL void ForwardCpuIm2Col::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
+    StatefulTimer::timeCheck("ForwardCpuIm2Col::forward START");
+    // the layers' data and output are device only, see CLDeviceWrapper
+    float *inputData = CLDeviceWrapper::copyToHostArray(dataWrapper);
+    weightsWrapper->copyToHost();
+    float *bias = 0;
+    if(dim.biased) {
+        biasWrapper->copyToHost();
+        bias = (float *)biasWrapper->getHostArray();
+    }
+    float *output = CLDeviceWrapper::copyToHostArray(outputWrapper);
+    StatefulTimer::timeCheck("ForwardCpuIm2Col::forward after copy to host");
+    forward(batchSize, inputData, (float *)weightsWrapper->getHostArray(), bias, output);
+    CLDeviceWrapper::copyHostArrayToDevice(outputWrapper);
+    StatefulTimer::timeCheck("ForwardCpuIm2Col::forward END");
+}
+// host-side version: no opencl involved at all
+PUBLIC VIRTUAL void ForwardCpuIm2Col::forward(int batchSize, float *inputData, float *weights, float *bias, float *output) {
+    int columnsSize = dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared;
+    int numThreads = threadPool->getNumThreads();
+    // unroll up to one image per thread at a time, so the columns buffer
+    // doesnt grow with the batch size
+    int imagesPerChunk = std::min(batchSize, numThreads);
+    if(columnsAllocated < imagesPerChunk * columnsSize) {
+        delete[] columns;
+        columnsAllocated = imagesPerChunk * columnsSize;
+        columns = new float[columnsAllocated];
+    }
+    for(int chunkStart = 0; chunkStart < batchSize; chunkStart += imagesPerChunk) {
+        int thisChunkSize = std::min(imagesPerChunk, batchSize - chunkStart);
+
+        ForwardCpuIm2ColUnrollTask unrollTask(dim, inputData + chunkStart * dim.inputCubeSize, columns);
+        threadPool->run(thisChunkSize, &unrollTask);
+
+        // if there are fewer images than threads, split the filters too
+        int numFilterBlocks = std::min((numThreads + thisChunkSize - 1) / thisChunkSize, (dim.numFilters + 3) / 4);
+        numFilterBlocks = std::max(1, numFilterBlocks);
+        int filtersPerBlock = (dim.numFilters + numFilterBlocks - 1) / numFilterBlocks;
+        ForwardCpuIm2ColGemmTask gemmTask(dim, numFilterBlocks, filtersPerBlock, weights, bias, columns,
+            output + chunkStart * dim.outputCubeSize);
+        threadPool->run(thisChunkSize * numFilterBlocks, &gemmTask);
+    }
+}
+// columns are organized like [inputplane][filterrow][filtercol][outrow][outcol]
+// ie, one row per filter weight, one column per output pixel
+// all the bounds checking happens here, so the gemm doesnt need any
+PUBLIC STATIC void ForwardCpuIm2Col::im2Col(LayerDimensions const &dim, float const *image, float *columns) {
+    const int margin = dim.padZeros ? dim.halfFilterSize : 0;
+    const int stride = dim.skip + 1;
+    const int inputSize = dim.inputSize;
+    const int outputSize = dim.outputSize;
+    for(int plane = 0; plane < dim.inputPlanes; plane++) {
+        float const *inputPlane = image + plane * dim.inputSizeSquared;
+        for(int filterRow = 0; filterRow < dim.filterSize; filterRow++) {
+            for(int filterCol = 0; filterCol < dim.filterSize; filterCol++) {
+                float *columnsRow = columns +
+                    ((plane * dim.filterSize + filterRow) * dim.filterSize + filterCol) * dim.outputSizeSquared;
+                for(int outRow = 0; outRow < outputSize; outRow++) {
+                    float *dst = columnsRow + outRow * outputSize;
+                    int inRow = outRow * stride + filterRow - margin;
+                    if(inRow < 0 || inRow >= inputSize) {
+                        memset(dst, 0, sizeof(float) * outputSize);
+                        continue;
+                    }
+                    float const *src = inputPlane + inRow * inputSize;
+                    for(int outCol = 0; outCol < outputSize; outCol++) {
+                        int inCol = outCol * stride + filterCol - margin;
+                        dst[outCol] = (inCol >= 0 && inCol < inputSize) ? src[inCol] : 0.0f;
+                    }
+                }
+            }
+        }
+    }
+}
+// output[filter][pixel] = bias[filter] + sum_k weights[filter][k] * columns[k][pixel]
+// for filters in [filterStart, filterEnd), for one image
+PUBLIC STATIC void ForwardCpuIm2Col::gemm(LayerDimensions const &dim, int filterStart, int filterEnd, float const *weights, float const *bias, float const *columns, float *output) {
+    const int K = dim.inputPlanes * dim.filterSizeSquared;
+    const int P = dim.outputSizeSquared;
+    for(int filter = filterStart; filter < filterEnd; filter++) {
+        float *outputPlane = output + filter * P;
+        float initialValue = dim.biased ? bias[filter] : 0.0f;
+        for(int p = 0; p < P; p++) {
+            outputPlane[p] = initialValue;
+        }
+    }
+    for(int p0 = 0; p0 < P; p0 += OUTPUT_TILE) {
+        int thisTileSize = std::min(OUTPUT_TILE, P - p0);
+        for(int k0 = 0; k0 < K; k0 += K_TILE) {
+            int kEnd = std::min(K, k0 + K_TILE);
+            for(int filter = filterStart; filter < filterEnd; filter++) {
+                float *outputTile = output + filter * P + p0;
+                float const *filterWeights = weights + filter * K;
+                for(int k = k0; k < kEnd; k++) {
+                    axpy(thisTileSize, filterWeights[k], columns + k * P + p0, outputTile);
+                }
+            }
+        }
+    }
+}
+
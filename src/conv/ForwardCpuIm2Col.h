@@ -0,0 +1,46 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "Forward.h"
+
+#include "DeepCLDllExport.h"
+
+class ThreadPool;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// cpu forward, for when there's no decent opencl device around:
+// unrolls each image into columns, like ForwardIm2Col, then does a tiled,
+// simd gemm against the filters, spread over the cores with a ThreadPool
+// works on host arrays directly, and writes straight into the output
+// wrapper's host array
+class DeepCL_EXPORT ForwardCpuIm2Col : public Forward {
+    private:
+    ThreadPool *threadPool; // NOT owned by us
+
+    float *columns;
+    int columnsAllocated;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ForwardCpuIm2Col(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~ForwardCpuIm2Col();
+    VIRTUAL void forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper);
+    VIRTUAL void forward(int batchSize, float *inputData, float *weights, float *bias, float *output);
+    STATIC void im2Col(LayerDimensions const &dim, float const *image, float *columns);
+    STATIC void gemm(LayerDimensions const &dim, int filterStart, int filterEnd, float const *weights, float const *bias, float const *columns, float *output);
+
+    // [[[end]]]
+};
+
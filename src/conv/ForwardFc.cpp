@@ -57,7 +57,6 @@ VIRTUAL void ForwardFc::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
     int numWorkgroups = dim.filterSize * dim.numInputPlanes;
 
     kernel1->run_1d(workgroupSize * numWorkgroups, workgroupSize);
-    cl->finish();
     StatefulTimer::timeCheck("ForwardFc::forward after first kernel");
 
     reduceSegments->reduce(output1Size, dim.filterSize, output1Wrapper, output2Wrapper);
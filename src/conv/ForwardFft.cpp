@@ -0,0 +1,83 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "conv/ForwardFft.h"
+#include "util/stringhelper.h"
+#include "util/StatefulTimer.h"
+#include "conv/AddBias.h"
+#include "conv/Fft.h"
+#include "conv/FftFilterCache.h"
+#include "conv/Im2ColWorkspace.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+
+PUBLIC ForwardFft::ForwardFft(EasyCL *cl, LayerDimensions dim) :
+            Forward(cl, dim),
+            addBias(0),
+            fft(0),
+            filterCache(0),
+            inputWorkspace(0),
+            outputWorkspace(0) {
+    if(!Fft::supports(dim)) {
+        throw runtime_error("ForwardFft needs skip 0, and padded inputs of at most 256, not skip " +
+            toString(dim.skip) + " fft size " + toString(Fft::fftSizeFor(dim)));
+    }
+    addBias = new AddBias(cl);
+    fft = new Fft(cl, Fft::fftSizeFor(dim));
+    inputWorkspace = new Im2ColWorkspace(cl);
+    outputWorkspace = new Im2ColWorkspace(cl);
+}
+PUBLIC VIRTUAL ForwardFft::~ForwardFft() {
+    FftFilterCache::release(filterCache);
+    delete addBias;
+    delete fft;
+    delete inputWorkspace;
+    delete outputWorkspace;
+}
+// the images are shifted by the padding, so output (0, 0) lands at (0, 0)
+PUBLIC VIRTUAL void ForwardFft::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
+    StatefulTimer::timeCheck("ForwardFft::forward START");
+    const int fftSize = fft->getFftSize();
+    const long planeFloats = 2l * fftSize * fftSize;
+    const int padding = dim.padZeros ? dim.halfFilterSize : 0;
+
+    filterCache = FftFilterCache::reacquire(filterCache, cl, dim, weightsWrapper);
+    CLWrapper *filtersWrapper = filterCache->getTransformed(fft);
+    StatefulTimer::timeCheck("ForwardFft::forward after filters");
+
+    int chunkSize = Im2ColWorkspace::imagesPerChunk(batchSize, planeFloats * (dim.inputPlanes + dim.numFilters));
+    CLWrapper *inputWrapper = inputWorkspace->get((int)(chunkSize * dim.inputPlanes * planeFloats));
+    CLWrapper *productsWrapper = outputWorkspace->get((int)(chunkSize * dim.numFilters * planeFloats));
+    for(int b = 0; b < batchSize; b += chunkSize) {
+        int numImages = std::min(chunkSize, batchSize - b);
+        fft->forwardPlanes(dataWrapper, b * dim.inputCubeSize, numImages * dim.inputPlanes,
+            dim.inputSize, padding, inputWrapper);
+        // [image][filter] = sum over inputplane of [image][inputplane] * conj([filter][inputplane])
+        fft->multiplyAccumulate(
+            numImages, dim.numFilters, dim.inputPlanes,
+            inputWrapper, dim.inputPlanes, 0, 1,
+            filtersWrapper, 0, dim.inputPlanes, 1,
+            true, false, productsWrapper);
+        fft->inversePlanes(productsWrapper, numImages * dim.numFilters, 0, dim.outputSize,
+            outputWrapper, b * dim.outputCubeSize);
+    }
+    StatefulTimer::timeCheck("ForwardFft::forward after convolve");
+    if(dim.biased) {
+        addBias->forward(
+            batchSize, dim.numFilters, dim.outputSize,
+            outputWrapper, biasWrapper);
+    }
+    StatefulTimer::timeCheck("ForwardFft::forward END");
+}
+
@@ -0,0 +1,46 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "Forward.h"
+
+class AddBias;
+class Fft;
+class FftFilterCache;
+class Im2ColWorkspace;
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// convolution by fft: each output plane is the inverse transform of the
+// sum, over input planes, of the transformed input times the conjugate of
+// the transformed filter.  the cost hardly depends on the filter size, so
+// this pays off for large filters.  no skip
+class DeepCL_EXPORT ForwardFft : public Forward {
+    private:
+    AddBias *addBias;
+    Fft *fft;
+    FftFilterCache *filterCache;
+    Im2ColWorkspace *inputWorkspace;
+    Im2ColWorkspace *outputWorkspace;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ForwardFft(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~ForwardFft();
+    VIRTUAL void forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper);
+
+    // [[[end]]]
+};
+
@@ -11,7 +11,9 @@
 //#include "clblas/ClBlasInstance.h"
 #include "clblas/ClBlasHelper.h"
 #include "conv/Im2Col.h"
+#include "conv/Im2ColWorkspace.h"
 
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <string>
@@ -31,45 +33,61 @@ PUBLIC ForwardIm2Col::ForwardIm2Col(EasyCL *cl, LayerDimensions dim) :
 
     addBias = new AddBias(cl);
     im2Col = new Im2Col(cl, dim);
+    columnsWorkspace = new Im2ColWorkspace(cl);
+    resultsWorkspace = new Im2ColWorkspace(cl);
 }
 PUBLIC VIRTUAL ForwardIm2Col::~ForwardIm2Col() {
     delete addBias;
     delete im2Col;
+    delete columnsWorkspace;
+    delete resultsWorkspace;
 }
+// unrolls as many images as fit in the workspace, then does one gemm for
+// all of them, into [filter][image][pixel] order, which is then swapped
+// into the output.  chunks of one image gemm straight into the output
 PUBLIC VIRTUAL void ForwardIm2Col::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
     StatefulTimer::timeCheck("ForwardIm2Col::forward START");
 
-    int columnsSize= dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared;
-    float *columns = new float[columnsSize];
-    CLWrapper *columnsWrapper = cl->wrap(columnsSize, columns);
-    columnsWrapper->createOnDevice();
-//    cout << "columnsSize: " << columnsSize << endl;
-//    cout << "weightsize: " << weightsWrapper->size() << endl;
+    long m = dim.outputSizeSquared;
+    long n = dim.numFilters;
+    long k = dim.inputPlanes * dim.filterSizeSquared;
+    int chunkSize = Im2ColWorkspace::imagesPerChunk(batchSize, k * m + n * m);
+    CLWrapper *columnsWrapper = columnsWorkspace->get(chunkSize * k * m);
+    CLWrapper *resultsWrapper = chunkSize > 1 ? resultsWorkspace->get(chunkSize * n * m) : 0;
+    if(!outputWrapper->isOnDevice()) {
+        outputWrapper->createOnDevice();
+    }
+//    cout << "m=" << m << " n=" << n << " k=" << k << " chunkSize=" << chunkSize << endl;
 
     StatefulTimer::timeCheck("ForwardIm2Col::forward after alloc");
 
-    for (int b = 0; b < batchSize; b ++) {
-        im2Col->im2Col(dataWrapper, b * dim.inputCubeSize, columnsWrapper);
-
-        long m = dim.outputSizeSquared;
-        long n = dim.numFilters;
-        long k = dim.inputPlanes * dim.filterSizeSquared;
-//        cout << "m=" << m << " n=" << n << " k=" << k << endl;
-
-        ClBlasHelper::Gemm(
-            cl, clblasColumnMajor, clblasNoTrans, clblasNoTrans,
-            m, k, n,
-            1,
-            columnsWrapper, 0,
-            weightsWrapper, 0,
-            0,
-            outputWrapper, b * dim.outputCubeSize
-        );
+    for (int b = 0; b < batchSize; b += chunkSize) {
+        int numImages = std::min(chunkSize, batchSize - b);
+        im2Col->im2ColBatched(dataWrapper, b * dim.inputCubeSize, numImages, columnsWrapper);
+        if(numImages == 1) {
+            ClBlasHelper::Gemm(
+                cl, clblasColumnMajor, clblasNoTrans, clblasNoTrans,
+                m, k, n,
+                1,
+                columnsWrapper, 0,
+                weightsWrapper, 0,
+                0,
+                outputWrapper, b * dim.outputCubeSize
+            );
+        } else {
+            ClBlasHelper::Gemm(
+                cl, clblasColumnMajor, clblasNoTrans, clblasNoTrans,
+                numImages * m, k, n,
+                1,
+                columnsWrapper, 0,
+                weightsWrapper, 0,
+                0,
+                resultsWrapper, 0
+            );
+            im2Col->swapOuterDims(resultsWrapper, 0, n, numImages, m, outputWrapper, b * dim.outputCubeSize);
+        }
     }
 
-    delete columnsWrapper;
-    delete[] columns;
-
     StatefulTimer::timeCheck("ForwardIm2Col::forward after call forward");
 
     if(dim.biased) {
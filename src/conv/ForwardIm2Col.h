@@ -10,6 +10,7 @@
 
 class AddBias;
 class Im2Col;
+class Im2ColWorkspace;
 
 #include "DeepCLDllExport.h"
 
@@ -23,9 +24,8 @@ class DeepCL_EXPORT ForwardIm2Col : public Forward {
     AddBias *addBias;
     Im2Col *im2Col;
 
-    float *columns;
-    CLWrapper *columnsWrapper;
-    int numKernels;
+    Im2ColWorkspace *columnsWorkspace;
+    Im2ColWorkspace *resultsWorkspace;
 
     // [[[cog
     // import cog_addheaders
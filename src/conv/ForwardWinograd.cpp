@@ -0,0 +1,49 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "conv/ForwardWinograd.h"
+#include "util/stringhelper.h"
+#include "util/StatefulTimer.h"
+#include "conv/AddBias.h"
+#include "conv/Winograd.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+
+PUBLIC ForwardWinograd::ForwardWinograd(EasyCL *cl, LayerDimensions dim) :
+            Forward(cl, dim),
+            addBias(0),
+            winograd(0) {
+    if(!Winograd::supports(dim)) {
+        throw runtime_error("ForwardWinograd only handles filterSize 3, and skip 0, not filterSize " +
+            toString(dim.filterSize) + " skip " + toString(dim.skip));
+    }
+    addBias = new AddBias(cl);
+    winograd = new Winograd(cl, dim.inputPlanes, dim.inputSize, dim.numFilters, dim.outputSize,
+        dim.padZeros ? 1 : 0, false);
+}
+PUBLIC VIRTUAL ForwardWinograd::~ForwardWinograd() {
+    delete addBias;
+    delete winograd;
+}
+PUBLIC VIRTUAL void ForwardWinograd::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
+    StatefulTimer::timeCheck("ForwardWinograd::forward START");
+    winograd->convolve(batchSize, dataWrapper, weightsWrapper, outputWrapper);
+    StatefulTimer::timeCheck("ForwardWinograd::forward after convolve");
+    if(dim.biased) {
+        addBias->forward(
+            batchSize, dim.numFilters, dim.outputSize,
+            outputWrapper, biasWrapper);
+    }
+    StatefulTimer::timeCheck("ForwardWinograd::forward END");
+}
+
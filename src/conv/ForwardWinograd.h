@@ -0,0 +1,38 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "Forward.h"
+
+class AddBias;
+class Winograd;
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// 3x3 filters, no skip, only
+class DeepCL_EXPORT ForwardWinograd : public Forward {
+    private:
+    AddBias *addBias;
+    Winograd *winograd;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ForwardWinograd(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~ForwardWinograd();
+    VIRTUAL void forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper);
+
+    // [[[end]]]
+};
+
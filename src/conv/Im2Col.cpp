@@ -21,23 +21,31 @@ PUBLIC Im2Col::Im2Col(EasyCL *cl, LayerDimensions dim) :
 //    ClBlasInstance::initializeIfNecessary();
     this->kernelIm2Col = 0;
     this->kernelCol2Im = 0;
+    this->kernelIm2ColBatched = 0;
+    this->kernelCol2ImBatched = 0;
+    this->kernelSwapOuterDims = 0;
 }
 PUBLIC VIRTUAL Im2Col::~Im2Col() {
     delete kernelIm2Col;
     delete kernelCol2Im;
+    delete kernelIm2ColBatched;
+    delete kernelCol2ImBatched;
+    delete kernelSwapOuterDims;
 }
+// the column size comes from LayerDimensions, rather than from the usual
+// (size + 2 * padding - filterSize) / stride + 1, since they differ for
+// padZeros with a stride that doesnt divide the input size
 void Im2Col::setupBuilder(TemplatedKernel *builder) {
-    int size = dim.inputSize;
     int padding = dim.padZeros ? dim.halfFilterSize : 0;
-    int stride = 1;
+    int stride = dim.skip + 1;
     int channels = dim.inputPlanes;
-    int size_col = (size + 2 * padding - dim.filterSize) / stride + 1;
+    int size_col = dim.outputSize;
 
     this->numKernelsIm2Col = channels * size_col * size_col;
     this->numKernelsCol2Im = channels * dim.inputSizeSquared;
 
-    builder->set("padding", dim.padZeros ? dim.halfFilterSize : 0);
-    builder->set("stride", 1);
+    builder->set("padding", padding);
+    builder->set("stride", stride);
     builder->set("colSize", size_col);
     builder->set("channels", dim.inputPlanes);
     builder->set("filterSize", dim.filterSize);
@@ -65,6 +73,17 @@ void Im2Col::buildKernelCol2Im() {
         false
     );
 }
+CLKernel *Im2Col::buildKernelNamed(std::string kernelName) {
+    TemplatedKernel builder(cl);
+    setupBuilder(&builder);
+    return builder.buildKernel(
+        kernelName,
+        "ForwardIm2Col.cl",
+        getKernelTemplate(),
+        kernelName,
+        false
+    );
+}
 PUBLIC void Im2Col::im2Col(CLWrapper *imagesWrapper, int imagesOffset, CLWrapper *columnsWrapper) {
     if(kernelIm2Col == 0) {
         buildKernelIm2Col();
@@ -94,6 +113,62 @@ PUBLIC void Im2Col::col2Im(CLWrapper *columnsWrapper, CLWrapper *imagesWrapper,
 //        cout << "numworkgroups=" << numWorkgroups << " workgorupSize=" << workgroupSize << endl;
     kernelCol2Im->run_1d(numWorkgroups * workgroupSize, workgroupSize);
 }
+// unrolls numImages images, starting at imagesOffset, into one column matrix,
+// of numImages * outputSizeSquared rows, by inputPlanes * filterSizeSquared
+// columns, column-major, for a single gemm
+PUBLIC void Im2Col::im2ColBatched(CLWrapper *imagesWrapper, int imagesOffset, int numImages, CLWrapper *columnsWrapper) {
+    if(kernelIm2ColBatched == 0) {
+        kernelIm2ColBatched = buildKernelNamed("im2col_batched");
+    }
+    int numKernels = numImages * numKernelsIm2Col;
+    kernelIm2ColBatched->in(numKernels);
+    kernelIm2ColBatched->in(numImages);
+    kernelIm2ColBatched->in(imagesWrapper);
+    kernelIm2ColBatched->in(imagesOffset);
+    kernelIm2ColBatched->out(columnsWrapper);
+
+    int workgroupSize = cl->getMaxWorkgroupSize();
+    int numWorkgroups = (numKernels + workgroupSize - 1) / workgroupSize;
+    kernelIm2ColBatched->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
+// sums a column matrix from im2ColBatched layout back into numImages images
+PUBLIC void Im2Col::col2ImBatched(CLWrapper *columnsWrapper, int numImages, CLWrapper *imagesWrapper, int imagesOffset) {
+    if(kernelCol2ImBatched == 0) {
+        kernelCol2ImBatched = buildKernelNamed("col2im_batched");
+    }
+    int numKernels = numImages * numKernelsCol2Im;
+    kernelCol2ImBatched->in(numKernels);
+    kernelCol2ImBatched->in(numImages);
+    kernelCol2ImBatched->in(columnsWrapper);
+    kernelCol2ImBatched->out(imagesWrapper);
+    kernelCol2ImBatched->in(imagesOffset);
+
+    int workgroupSize = cl->getMaxWorkgroupSize();
+    int numWorkgroups = (numKernels + workgroupSize - 1) / workgroupSize;
+    kernelCol2ImBatched->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
+// out[j][i][k] = in[i][j][k], for i < dim0, j < dim1, k < inner
+// eg dim0 = numImages, dim1 = numFilters, inner = outputSizeSquared turns
+// layer outputs into the [filter][image][pixel] layout used by the batched
+// gemms, and swapping dim0 and dim1 turns them back
+PUBLIC void Im2Col::swapOuterDims(CLWrapper *inWrapper, int inOffset, int dim0, int dim1, int inner, CLWrapper *outWrapper, int outOffset) {
+    if(kernelSwapOuterDims == 0) {
+        kernelSwapOuterDims = buildKernelNamed("swap_outer_dims");
+    }
+    int numKernels = dim0 * dim1 * inner;
+    kernelSwapOuterDims->in(numKernels);
+    kernelSwapOuterDims->in(dim0);
+    kernelSwapOuterDims->in(dim1);
+    kernelSwapOuterDims->in(inner);
+    kernelSwapOuterDims->in(inWrapper);
+    kernelSwapOuterDims->in(inOffset);
+    kernelSwapOuterDims->out(outWrapper);
+    kernelSwapOuterDims->in(outOffset);
+
+    int workgroupSize = cl->getMaxWorkgroupSize();
+    int numWorkgroups = (numKernels + workgroupSize - 1) / workgroupSize;
+    kernelSwapOuterDims->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
 STATIC std::string Im2Col::getKernelTemplate() {
     // [[[cog
     // import stringify
@@ -174,6 +249,83 @@ STATIC std::string Im2Col::getKernelTemplate() {
     "  }\n"
     "}\n"
     "\n"
+    "// several images at once, so a single gemm can cover them all: the column\n"
+    "// matrix has numImages * {{colSize}} * {{colSize}} values per row, and image b's\n"
+    "// columns start at b * {{colSize}} * {{colSize}} in each row\n"
+    "kernel void im2col_batched(\n"
+    "    const int n, const int numImages,\n"
+    "    global float const * im_data, int im_offset,\n"
+    "    global float* data_col) {\n"
+    "  const int imageColSize = {{colSize}} * {{colSize}};\n"
+    "  const int rowStride = numImages * imageColSize;\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    int w_out = index % {{colSize}};\n"
+    "    int rest = index / {{colSize}};\n"
+    "    int h_out = rest % {{colSize}};\n"
+    "    rest /= {{colSize}};\n"
+    "    int channel_in = rest % {{channels}};\n"
+    "    int image = rest / {{channels}};\n"
+    "    int channel_out = channel_in * {{filterSize}} * {{filterSize}};\n"
+    "    int h_in = h_out * {{stride}} - {{padding}};\n"
+    "    int w_in = w_out * {{stride}} - {{padding}};\n"
+    "    global float *col = data_col + channel_out * rowStride + image * imageColSize + h_out * {{colSize}} + w_out;\n"
+    "    global const float *im = im_data + im_offset + ((image * {{channels}} + channel_in) * {{size}} + h_in) * {{size}} + w_in;\n"
+    "    for (int i = 0; i < {{filterSize}}; ++i) {\n"
+    "      for (int j = 0; j < {{filterSize}}; ++j) {\n"
+    "        int h = h_in + i;\n"
+    "        int w = w_in + j;\n"
+    "        *col = (h >= 0 && w >= 0 && h < {{size}} && w < {{size}}) ?\n"
+    "          im[i * {{size}} + j] : 0;\n"
+    "        col += rowStride;\n"
+    "      }\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// inverse of im2col_batched: sums each image's columns back into numImages images\n"
+    "kernel void col2im_batched(\n"
+    "    const int n, const int numImages,\n"
+    "    global float const *data_col,\n"
+    "    global float* im_data, int im_offset) {\n"
+    "  const int imageColSize = {{colSize}} * {{colSize}};\n"
+    "  const int rowStride = numImages * imageColSize;\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    float val = 0;\n"
+    "    int w = index % {{size}} + {{padding}};\n"
+    "    int h = (index / {{size}}) % {{size}} + {{padding}};\n"
+    "    int c = (index / ({{size}} * {{size}})) % {{channels}};\n"
+    "    int image = index / ({{size}} * {{size}} * {{channels}});\n"
+    "    int w_col_start = (w < {{filterSize}}) ? 0 : (w - {{filterSize}}) / {{stride}} + 1;\n"
+    "    int w_col_end = min(w / {{stride}} + 1, {{colSize}});\n"
+    "    int h_col_start = (h < {{filterSize}}) ? 0 : (h - {{filterSize}}) / {{stride}} + 1;\n"
+    "    int h_col_end = min(h / {{stride}} + 1, {{colSize}});\n"
+    "    global float const *col = data_col + image * imageColSize;\n"
+    "    for (int h_col = h_col_start; h_col < h_col_end; ++h_col) {\n"
+    "      for (int w_col = w_col_start; w_col < w_col_end; ++w_col) {\n"
+    "        int row = (c * {{filterSize}} + h - h_col * {{stride}}) * {{filterSize}} + w - w_col * {{stride}};\n"
+    "        val += col[row * rowStride + h_col * {{colSize}} + w_col];\n"
+    "      }\n"
+    "    }\n"
+    "    im_data[im_offset + index] = val;\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// out[j][i][k] = in[i][j][k], for i < dim0, j < dim1, k < inner\n"
+    "// moves between the [image][filter][pixel] layout of the layer outputs, and\n"
+    "// the [filter][image][pixel] layout that a batched gemm reads and writes\n"
+    "kernel void swap_outer_dims(\n"
+    "    const int n, const int dim0, const int dim1, const int inner,\n"
+    "    global float const *in_data, int in_offset,\n"
+    "    global float *out_data, int out_offset) {\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    int k = index % inner;\n"
+    "    int rest = index / inner;\n"
+    "    int j = rest % dim1;\n"
+    "    int i = rest / dim1;\n"
+    "    out_data[out_offset + (j * dim0 + i) * inner + k] = in_data[in_offset + index];\n"
+    "  }\n"
+    "}\n"
+    "\n"
     "";
     // [[[end]]]
     return kernelSource;
@@ -18,6 +18,9 @@ class Im2Col {
 
     CLKernel *kernelIm2Col;
     CLKernel *kernelCol2Im;
+    CLKernel *kernelIm2ColBatched;
+    CLKernel *kernelCol2ImBatched;
+    CLKernel *kernelSwapOuterDims;
 
     int numKernelsIm2Col;
     int numKernelsCol2Im;
@@ -33,11 +36,15 @@ class Im2Col {
     VIRTUAL ~Im2Col();
     void im2Col(CLWrapper *imagesWrapper, int imagesOffset, CLWrapper *columnsWrapper);
     void col2Im(CLWrapper *columnsWrapper, CLWrapper *imagesWrapper, int imagesOffset);
+    void im2ColBatched(CLWrapper *imagesWrapper, int imagesOffset, int numImages, CLWrapper *columnsWrapper);
+    void col2ImBatched(CLWrapper *columnsWrapper, int numImages, CLWrapper *imagesWrapper, int imagesOffset);
+    void swapOuterDims(CLWrapper *inWrapper, int inOffset, int dim0, int dim1, int inner, CLWrapper *outWrapper, int outOffset);
 
     private:
     void setupBuilder(TemplatedKernel *builder);
     void buildKernelIm2Col();
     void buildKernelCol2Im();
+    CLKernel *buildKernelNamed(std::string kernelName);
     STATIC std::string getKernelTemplate();
 
     // [[[end]]]
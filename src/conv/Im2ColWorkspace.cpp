@@ -0,0 +1,66 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "util/stringhelper.h"
+#include "clmath/CLDeviceWrapper.h"
+#include "conv/Im2ColWorkspace.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+long Im2ColWorkspace::maxBytes = 64l * 1024l * 1024l;
+
+PUBLIC Im2ColWorkspace::Im2ColWorkspace(EasyCL *cl) :
+        cl(cl),
+        wrapper(0),
+        allocated(0) {
+}
+PUBLIC Im2ColWorkspace::~Im2ColWorkspace() {
+    delete wrapper;
+}
+// applies to the workspaces of every layer, from their next batch on
+PUBLIC STATIC void Im2ColWorkspace::setMaxBytes(long maxBytes) {
+    if(maxBytes <= 0) {
+        throw runtime_error("Im2ColWorkspace::setMaxBytes: maxBytes should be positive, not " + toString(maxBytes));
+    }
+    Im2ColWorkspace::maxBytes = maxBytes;
+}
+PUBLIC STATIC long Im2ColWorkspace::getMaxBytes() {
+    return maxBytes;
+}
+// how many images to unroll at once, given the workspace floats each one
+// needs; always at least one, even if that one is over the limit
+PUBLIC STATIC int Im2ColWorkspace::imagesPerChunk(int batchSize, long floatsPerImage) {
+    long numImages = maxBytes / (floatsPerImage * 4l);
+    if(numImages < 1) {
+        numImages = 1;
+    }
+    if(numImages > batchSize) {
+        numImages = batchSize;
+    }
+    return (int)numImages;
+}
+// returns a wrapper of at least size floats, already on the device
+// contents are undefined, except that they're kept until the next resize
+PUBLIC CLWrapper *Im2ColWorkspace::get(int size) {
+    if(size > allocated) {
+        delete wrapper;
+        wrapper = new CLDeviceWrapper(cl, size);
+        allocated = size;
+    }
+    return wrapper;
+}
+PUBLIC int Im2ColWorkspace::getAllocated() const {
+    return allocated;
+}
+
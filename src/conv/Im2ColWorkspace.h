@@ -0,0 +1,49 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class CLWrapper;
+class CLDeviceWrapper;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// device scratch buffer for the im2col convolutions: grows to the largest
+// size asked for, and is kept between calls, instead of being allocated
+// for every batch
+// the im2col classes unroll as many images at a time as fit in
+// getMaxBytes(), so they can do one big gemm per chunk of the batch, rather
+// than one small gemm per image
+class DeepCL_EXPORT Im2ColWorkspace {
+    private:
+    EasyCL *cl; // NOT owned by us
+    CLDeviceWrapper *wrapper; // device only, there's nothing to see on the host
+    int allocated;
+
+    STATIC long maxBytes;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    Im2ColWorkspace(EasyCL *cl);
+    ~Im2ColWorkspace();
+    STATIC void setMaxBytes(long maxBytes);
+    STATIC long getMaxBytes();
+    STATIC int imagesPerChunk(int batchSize, long floatsPerImage);
+    CLWrapper *get(int size);
+    int getAllocated() const;
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,72 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "clmath/ProfilingQueue.h"
+#include "conv/KernelTimer.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC KernelTimer::KernelTimer(EasyCL *cl) :
+        cl(cl),
+        useEvents(false),
+        startEvent(0) {
+    useEvents = ProfilingQueue::enable(cl);
+}
+PUBLIC KernelTimer::~KernelTimer() {
+    releaseStartEvent();
+}
+PUBLIC bool KernelTimer::usesDeviceEvents() const {
+    return useEvents;
+}
+// anything already queued isnt counted: the start marker only completes
+// once that has, or, on the host clock, we wait for it
+// the host clock runs either way, in case the device's timestamps cant be
+// read back in stop()
+PUBLIC void KernelTimer::start() {
+    releaseStartEvent();
+    if(useEvents && clEnqueueMarker(*cl->queue, &startEvent) != CL_SUCCESS) {
+        startEvent = 0;
+        useEvents = false;
+    }
+    if(!useEvents) {
+        cl->finish();
+    }
+    timer.lap();
+}
+// if the device timestamps arent available after all, we drop back to the
+// host clock, for this and later timings
+PUBLIC float KernelTimer::stop() {
+    if(useEvents) {
+        cl_event endEvent = 0;
+        if(clEnqueueMarker(*cl->queue, &endEvent) == CL_SUCCESS) {
+            clWaitForEvents(1, &endEvent);
+            cl_ulong startNanoseconds = 0;
+            cl_ulong endNanoseconds = 0;
+            cl_int startError = clGetEventProfilingInfo(startEvent, CL_PROFILING_COMMAND_END, sizeof(startNanoseconds), &startNanoseconds, 0);
+            cl_int endError = clGetEventProfilingInfo(endEvent, CL_PROFILING_COMMAND_END, sizeof(endNanoseconds), &endNanoseconds, 0);
+            clReleaseEvent(endEvent);
+            releaseStartEvent();
+            if(startError == CL_SUCCESS && endError == CL_SUCCESS && endNanoseconds >= startNanoseconds) {
+                return (float)(endNanoseconds - startNanoseconds) / 1000.0f;
+            }
+        }
+        useEvents = false;
+    }
+    cl->finish();
+    return (float)timer.lapMicroseconds();
+}
+PRIVATE void KernelTimer::releaseStartEvent() {
+    if(startEvent != 0) {
+        clReleaseEvent(startEvent);
+        startEvent = 0;
+    }
+}
+
@@ -0,0 +1,48 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "EasyCL.h"
+#include "util/Timer.h"
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// times whatever gets queued on cl between start() and stop(), in
+// microseconds
+// turns profiling on for cl's queue, via ProfilingQueue, then puts a marker
+// on the queue at each end, and uses the device's own timestamps for those,
+// so host jitter doesnt count.  only if the queue cant profile does it wait
+// for the queue to empty at each end, and use the host clock
+class DeepCL_EXPORT KernelTimer {
+    private:
+    EasyCL *cl; // NOT owned by us
+    bool useEvents;
+    cl_event startEvent;
+    Timer timer;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    KernelTimer(EasyCL *cl);
+    ~KernelTimer();
+    bool usesDeviceEvents() const;
+    void start();
+    float stop();
+
+    private:
+    void releaseStartEvent();
+
+    // [[[end]]]
+};
+
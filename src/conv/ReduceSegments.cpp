@@ -37,7 +37,6 @@ VIRTUAL void ReduceSegments::reduce(
         ->out(outputWrapper);
     int numWorkgroups = (numSegments + 64 - 1) / 64;
     kernel->run_1d(numWorkgroups * 64, 64);
-    cl->finish();
 
     StatefulTimer::timeCheck("ReduceSegments::reduce end");
 }
@@ -0,0 +1,315 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "clblas/ClBlasHelper.h"
+#include "EasyCL.h"
+#include "templates/TemplatedKernel.h"
+#include "util/stringhelper.h"
+#include "conv/Im2ColWorkspace.h"
+#include "conv/Winograd.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC Winograd::Winograd(EasyCL *cl, int inputPlanes, int inputSize, int numFilters, int outputSize, int padding, bool flip) :
+        cl(cl),
+        inputPlanes(inputPlanes),
+        inputSize(inputSize),
+        numFilters(numFilters),
+        outputSize(outputSize),
+        padding(padding),
+        flip(flip),
+        tiles(numTiles(outputSize)),
+        kernelFilterTransform(0),
+        kernelInputTransform(0),
+        kernelOutputTransform(0) {
+    filtersWorkspace = new Im2ColWorkspace(cl);
+    inputWorkspace = new Im2ColWorkspace(cl);
+    productsWorkspace = new Im2ColWorkspace(cl);
+}
+PUBLIC Winograd::~Winograd() {
+    delete kernelFilterTransform;
+    delete kernelInputTransform;
+    delete kernelOutputTransform;
+    delete filtersWorkspace;
+    delete inputWorkspace;
+    delete productsWorkspace;
+}
+PUBLIC STATIC bool Winograd::supports(LayerDimensions const &dim) {
+    return dim.filterSize == 3 && dim.skip == 0;
+}
+// tiles along each side of the output; the last one overhangs if
+// outputSize is odd
+PUBLIC STATIC int Winograd::numTiles(int outputSize) {
+    return (outputSize + 1) / 2;
+}
+// the filters are transformed on every call, since they change every batch
+// the images are then transformed, multiplied and transformed back in
+// chunks, as many images at a time as fit in the workspace
+PUBLIC void Winograd::convolve(int batchSize, CLWrapper *imagesWrapper, CLWrapper *weightsWrapper, CLWrapper *outputWrapper) {
+    const int tilesSquared = tiles * tiles;
+    CLWrapper *filtersWrapper = filtersWorkspace->get(16 * numFilters * inputPlanes);
+    transformFilters(weightsWrapper, filtersWrapper);
+
+    int chunkSize = Im2ColWorkspace::imagesPerChunk(batchSize, 16l * (inputPlanes + numFilters) * tilesSquared);
+    CLWrapper *inputWrapper = inputWorkspace->get(chunkSize * 16 * inputPlanes * tilesSquared);
+    CLWrapper *productsWrapper = productsWorkspace->get(chunkSize * 16 * numFilters * tilesSquared);
+    if(!outputWrapper->isOnDevice()) {
+        outputWrapper->createOnDevice();
+    }
+    const int inputCubeSize = inputPlanes * inputSize * inputSize;
+    const int outputCubeSize = numFilters * outputSize * outputSize;
+    for(int b = 0; b < batchSize; b += chunkSize) {
+        int numImages = std::min(chunkSize, batchSize - b);
+        int numChunkTiles = numImages * tilesSquared;
+        transformInput(imagesWrapper, b * inputCubeSize, numImages, inputWrapper);
+        // M[xi] = V[xi] U[xi]^T, ie [tile][inputplane] by [inputplane][filter],
+        // column-major
+        for(int xi = 0; xi < 16; xi++) {
+            ClBlasHelper::Gemm(
+                cl, clblasColumnMajor, clblasNoTrans, clblasNoTrans,
+                numChunkTiles, inputPlanes, numFilters,
+                1,
+                inputWrapper, (int64)xi * inputPlanes * numChunkTiles,
+                filtersWrapper, (int64)xi * numFilters * inputPlanes,
+                0,
+                productsWrapper, (int64)xi * numFilters * numChunkTiles
+            );
+        }
+        transformOutput(productsWrapper, numImages, outputWrapper, b * outputCubeSize);
+    }
+}
+PRIVATE void Winograd::transformFilters(CLWrapper *weightsWrapper, CLWrapper *filtersWrapper) {
+    if(kernelFilterTransform == 0) {
+        kernelFilterTransform = buildKernelNamed("winograd_filter_transform");
+    }
+    int numKernels = numFilters * inputPlanes;
+    kernelFilterTransform->in(numKernels);
+    kernelFilterTransform->in(weightsWrapper);
+    kernelFilterTransform->out(filtersWrapper);
+    runKernel(kernelFilterTransform, numKernels);
+}
+PRIVATE void Winograd::transformInput(CLWrapper *imagesWrapper, int imagesOffset, int numImages, CLWrapper *inputWrapper) {
+    if(kernelInputTransform == 0) {
+        kernelInputTransform = buildKernelNamed("winograd_input_transform");
+    }
+    int numKernels = numImages * inputPlanes * tiles * tiles;
+    kernelInputTransform->in(numKernels);
+    kernelInputTransform->in(numImages);
+    kernelInputTransform->in(imagesWrapper);
+    kernelInputTransform->in(imagesOffset);
+    kernelInputTransform->out(inputWrapper);
+    runKernel(kernelInputTransform, numKernels);
+}
+PRIVATE void Winograd::transformOutput(CLWrapper *productsWrapper, int numImages, CLWrapper *outputWrapper, int outputOffset) {
+    if(kernelOutputTransform == 0) {
+        kernelOutputTransform = buildKernelNamed("winograd_output_transform");
+    }
+    int numKernels = numImages * numFilters * tiles * tiles;
+    kernelOutputTransform->in(numKernels);
+    kernelOutputTransform->in(numImages);
+    kernelOutputTransform->in(productsWrapper);
+    kernelOutputTransform->out(outputWrapper);
+    kernelOutputTransform->in(outputOffset);
+    runKernel(kernelOutputTransform, numKernels);
+}
+PRIVATE void Winograd::setupBuilder(TemplatedKernel *builder) {
+    builder->set("inputPlanes", inputPlanes);
+    builder->set("inputSize", inputSize);
+    builder->set("numFilters", numFilters);
+    builder->set("outputSize", outputSize);
+    builder->set("padding", padding);
+    builder->set("tiles", tiles);
+    builder->set("flip", flip ? 1 : 0);
+}
+PRIVATE CLKernel *Winograd::buildKernelNamed(std::string kernelName) {
+    TemplatedKernel builder(cl);
+    setupBuilder(&builder);
+    return builder.buildKernel(
+        kernelName,
+        "winograd.cl",
+        getKernelTemplate(),
+        kernelName,
+        false
+    );
+}
+PRIVATE void Winograd::runKernel(CLKernel *kernel, int numKernels) {
+    int workgroupSize = cl->getMaxWorkgroupSize();
+    int numWorkgroups = (numKernels + workgroupSize - 1) / workgroupSize;
+    kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
+STATIC std::string Winograd::getKernelTemplate() {
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel("kernel", "cl/winograd.cl")
+    // ]]]
+    // generated using cog, from cl/winograd.cl:
+    const char * kernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// Winograd F(2x2,3x3) convolution, as in Lavin and Gray, \"Fast Algorithms for\n"
+    "// Convolutional Neural Networks\":\n"
+    "//     Y = A^T [ (G g G^T) .* (B^T d B) ] A\n"
+    "// for each 2x2 output tile Y, its 4x4 input patch d, and 3x3 filter g\n"
+    "// the elementwise product, summed over the input planes, becomes 16 gemms,\n"
+    "// one per element xi of the 4x4 transformed tiles, which are done in between\n"
+    "// these kernels, using clblas\n"
+    "//\n"
+    "// layouts:\n"
+    "//   U: [xi][filter][inputplane]     transformed filters\n"
+    "//   V: [xi][inputplane][tile]       transformed input patches\n"
+    "//   M: [xi][filter][tile]           gemm results\n"
+    "// tile runs over all the images in the chunk: image * {{tiles}}^2 + tilerow * {{tiles}} + tilecol\n"
+    "//\n"
+    "// {{flip}} == 1 transforms the filters for the backward pass, ie rotated by\n"
+    "// 180 degrees, with the filter and input plane axes swapped\n"
+    "\n"
+    "// CL: grid stride looping\n"
+    "#define CL_KERNEL_LOOP(i, n)                        \\\n"
+    "  for (int i = get_group_id(0) * get_local_size(0) + get_local_id(0); \\\n"
+    "      i < (n);                                       \\\n"
+    "      i += get_local_size(0) * get_num_groups(0))\n"
+    "\n"
+    "kernel void winograd_filter_transform(\n"
+    "    const int n,\n"
+    "    global const float *weights,\n"
+    "    global float *U) {\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    int inPlane = index % {{inputPlanes}};\n"
+    "    int filter = index / {{inputPlanes}};\n"
+    "    float g[3][3];\n"
+    "    for (int r = 0; r < 3; r++) {\n"
+    "      for (int s = 0; s < 3; s++) {\n"
+    "#if {{flip}} == 1\n"
+    "        g[r][s] = weights[(inPlane * {{numFilters}} + filter) * 9 + (2 - r) * 3 + (2 - s)];\n"
+    "#else\n"
+    "        g[r][s] = weights[(filter * {{inputPlanes}} + inPlane) * 9 + r * 3 + s];\n"
+    "#endif\n"
+    "      }\n"
+    "    }\n"
+    "    // G g\n"
+    "    float Gg[4][3];\n"
+    "    for (int s = 0; s < 3; s++) {\n"
+    "      Gg[0][s] = g[0][s];\n"
+    "      Gg[1][s] = 0.5f * (g[0][s] + g[1][s] + g[2][s]);\n"
+    "      Gg[2][s] = 0.5f * (g[0][s] - g[1][s] + g[2][s]);\n"
+    "      Gg[3][s] = g[2][s];\n"
+    "    }\n"
+    "    // (G g) G^T\n"
+    "    const int xiStride = {{numFilters}} * {{inputPlanes}};\n"
+    "    global float *dst = U + filter * {{inputPlanes}} + inPlane;\n"
+    "    for (int r = 0; r < 4; r++) {\n"
+    "      dst[(r * 4 + 0) * xiStride] = Gg[r][0];\n"
+    "      dst[(r * 4 + 1) * xiStride] = 0.5f * (Gg[r][0] + Gg[r][1] + Gg[r][2]);\n"
+    "      dst[(r * 4 + 2) * xiStride] = 0.5f * (Gg[r][0] - Gg[r][1] + Gg[r][2]);\n"
+    "      dst[(r * 4 + 3) * xiStride] = Gg[r][2];\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "kernel void winograd_input_transform(\n"
+    "    const int n, const int numImages,\n"
+    "    global const float *images, int imagesOffset,\n"
+    "    global float *V) {\n"
+    "  const int tilesSquared = {{tiles}} * {{tiles}};\n"
+    "  const int numTiles = numImages * tilesSquared;\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    int tile = index % tilesSquared;\n"
+    "    int rest = index / tilesSquared;\n"
+    "    int plane = rest % {{inputPlanes}};\n"
+    "    int image = rest / {{inputPlanes}};\n"
+    "    int row0 = (tile / {{tiles}}) * 2 - {{padding}};\n"
+    "    int col0 = (tile % {{tiles}}) * 2 - {{padding}};\n"
+    "    global const float *src = images + imagesOffset + (image * {{inputPlanes}} + plane) * {{inputSize}} * {{inputSize}};\n"
+    "    float d[4][4];\n"
+    "    for (int r = 0; r < 4; r++) {\n"
+    "      int row = row0 + r;\n"
+    "      for (int c = 0; c < 4; c++) {\n"
+    "        int col = col0 + c;\n"
+    "        d[r][c] = (row >= 0 && col >= 0 && row < {{inputSize}} && col < {{inputSize}}) ?\n"
+    "          src[row * {{inputSize}} + col] : 0;\n"
+    "      }\n"
+    "    }\n"
+    "    // B^T d\n"
+    "    float t[4][4];\n"
+    "    for (int c = 0; c < 4; c++) {\n"
+    "      t[0][c] = d[0][c] - d[2][c];\n"
+    "      t[1][c] = d[1][c] + d[2][c];\n"
+    "      t[2][c] = d[2][c] - d[1][c];\n"
+    "      t[3][c] = d[1][c] - d[3][c];\n"
+    "    }\n"
+    "    // (B^T d) B\n"
+    "    const int xiStride = {{inputPlanes}} * numTiles;\n"
+    "    global float *dst = V + plane * numTiles + image * tilesSquared + tile;\n"
+    "    for (int r = 0; r < 4; r++) {\n"
+    "      dst[(r * 4 + 0) * xiStride] = t[r][0] - t[r][2];\n"
+    "      dst[(r * 4 + 1) * xiStride] = t[r][1] + t[r][2];\n"
+    "      dst[(r * 4 + 2) * xiStride] = t[r][2] - t[r][1];\n"
+    "      dst[(r * 4 + 3) * xiStride] = t[r][1] - t[r][3];\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "kernel void winograd_output_transform(\n"
+    "    const int n, const int numImages,\n"
+    "    global const float *M,\n"
+    "    global float *output, int outputOffset) {\n"
+    "  const int tilesSquared = {{tiles}} * {{tiles}};\n"
+    "  const int numTiles = numImages * tilesSquared;\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    int tile = index % tilesSquared;\n"
+    "    int rest = index / tilesSquared;\n"
+    "    int filter = rest % {{numFilters}};\n"
+    "    int image = rest / {{numFilters}};\n"
+    "    const int xiStride = {{numFilters}} * numTiles;\n"
+    "    global const float *src = M + filter * numTiles + image * tilesSquared + tile;\n"
+    "    float m[4][4];\n"
+    "    for (int r = 0; r < 4; r++) {\n"
+    "      for (int c = 0; c < 4; c++) {\n"
+    "        m[r][c] = src[(r * 4 + c) * xiStride];\n"
+    "      }\n"
+    "    }\n"
+    "    // A^T m\n"
+    "    float t[2][4];\n"
+    "    for (int c = 0; c < 4; c++) {\n"
+    "      t[0][c] = m[0][c] + m[1][c] + m[2][c];\n"
+    "      t[1][c] = m[1][c] - m[2][c] - m[3][c];\n"
+    "    }\n"
+    "    // (A^T m) A, written out, except where the tile overhangs the output\n"
+    "    int row0 = (tile / {{tiles}}) * 2;\n"
+    "    int col0 = (tile % {{tiles}}) * 2;\n"
+    "    global float *dst = output + outputOffset + (image * {{numFilters}} + filter) * {{outputSize}} * {{outputSize}};\n"
+    "    for (int r = 0; r < 2; r++) {\n"
+    "      int row = row0 + r;\n"
+    "      if (row >= {{outputSize}}) {\n"
+    "        continue;\n"
+    "      }\n"
+    "      float y0 = t[r][0] + t[r][1] + t[r][2];\n"
+    "      float y1 = t[r][1] - t[r][2] - t[r][3];\n"
+    "      dst[row * {{outputSize}} + col0] = y0;\n"
+    "      if (col0 + 1 < {{outputSize}}) {\n"
+    "        dst[row * {{outputSize}} + col0 + 1] = y1;\n"
+    "      }\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "";
+    // [[[end]]]
+    return kernelSource;
+}
+
@@ -0,0 +1,75 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+
+#include "conv/LayerDimensions.h"
+
+class EasyCL;
+class CLWrapper;
+class CLKernel;
+class TemplatedKernel;
+class Im2ColWorkspace;
+
+#include "DeepCLDllExport.h"
+
+#define STATIC static
+#define VIRTUAL virtual
+
+// stride 1, 3x3 convolutions, by Winograd F(2x2,3x3): each 2x2 output tile
+// costs 16 multiplies per filter and input plane, instead of 36
+// the sizes are given explicitly, rather than as LayerDimensions, since
+// BackwardWinograd runs it with the planes swapped, and, for layers without
+// padZeros, with a padding of 2
+// flip means the weights are for the layer the other way round, and are
+// rotated, which is what backward needs
+// see cl/winograd.cl for the layouts
+class DeepCL_EXPORT Winograd {
+    private:
+    EasyCL *cl; // NOT owned by us
+    int inputPlanes;
+    int inputSize;
+    int numFilters;
+    int outputSize;
+    int padding;
+    bool flip;
+    int tiles;
+
+    CLKernel *kernelFilterTransform;
+    CLKernel *kernelInputTransform;
+    CLKernel *kernelOutputTransform;
+
+    Im2ColWorkspace *filtersWorkspace;
+    Im2ColWorkspace *inputWorkspace;
+    Im2ColWorkspace *productsWorkspace;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    Winograd(EasyCL *cl, int inputPlanes, int inputSize, int numFilters, int outputSize, int padding, bool flip);
+    ~Winograd();
+    STATIC bool supports(LayerDimensions const &dim);
+    STATIC int numTiles(int outputSize);
+    void convolve(int batchSize, CLWrapper *imagesWrapper, CLWrapper *weightsWrapper, CLWrapper *outputWrapper);
+
+    private:
+    void transformFilters(CLWrapper *weightsWrapper, CLWrapper *filtersWrapper);
+    void transformInput(CLWrapper *imagesWrapper, int imagesOffset, int numImages, CLWrapper *inputWrapper);
+    void transformOutput(CLWrapper *productsWrapper, int numImages, CLWrapper *outputWrapper, int outputOffset);
+    void setupBuilder(TemplatedKernel *builder);
+    CLKernel *buildKernelNamed(std::string kernelName);
+    void runKernel(CLKernel *kernel, int numKernels);
+    STATIC std::string getKernelTemplate();
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,124 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cstring>
+
+#include "conv/Winograd.h"
+#include "conv/WinogradCpu.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// U = G g G^T, g is [3][3], U is [4][4]
+PUBLIC STATIC void WinogradCpu::transformFilter(float const *g, float *U) {
+    float Gg[4][3];
+    for(int s = 0; s < 3; s++) {
+        Gg[0][s] = g[s];
+        Gg[1][s] = 0.5f * (g[s] + g[3 + s] + g[6 + s]);
+        Gg[2][s] = 0.5f * (g[s] - g[3 + s] + g[6 + s]);
+        Gg[3][s] = g[6 + s];
+    }
+    for(int r = 0; r < 4; r++) {
+        U[r * 4 + 0] = Gg[r][0];
+        U[r * 4 + 1] = 0.5f * (Gg[r][0] + Gg[r][1] + Gg[r][2]);
+        U[r * 4 + 2] = 0.5f * (Gg[r][0] - Gg[r][1] + Gg[r][2]);
+        U[r * 4 + 3] = Gg[r][2];
+    }
+}
+// V = B^T d B, d and V are [4][4]
+PUBLIC STATIC void WinogradCpu::transformInput(float const *d, float *V) {
+    float t[4][4];
+    for(int c = 0; c < 4; c++) {
+        t[0][c] = d[c] - d[8 + c];
+        t[1][c] = d[4 + c] + d[8 + c];
+        t[2][c] = d[8 + c] - d[4 + c];
+        t[3][c] = d[4 + c] - d[12 + c];
+    }
+    for(int r = 0; r < 4; r++) {
+        V[r * 4 + 0] = t[r][0] - t[r][2];
+        V[r * 4 + 1] = t[r][1] + t[r][2];
+        V[r * 4 + 2] = t[r][2] - t[r][1];
+        V[r * 4 + 3] = t[r][1] - t[r][3];
+    }
+}
+// Y = A^T M A, M is [4][4], Y is [2][2]
+PUBLIC STATIC void WinogradCpu::transformOutput(float const *M, float *Y) {
+    float t[2][4];
+    for(int c = 0; c < 4; c++) {
+        t[0][c] = M[c] + M[4 + c] + M[8 + c];
+        t[1][c] = M[4 + c] - M[8 + c] - M[12 + c];
+    }
+    for(int r = 0; r < 2; r++) {
+        Y[r * 2 + 0] = t[r][0] + t[r][1] + t[r][2];
+        Y[r * 2 + 1] = t[r][1] - t[r][2] - t[r][3];
+    }
+}
+// output is [batchSize][numFilters][outputSize][outputSize], no bias
+PUBLIC STATIC void WinogradCpu::convolve(int batchSize, int inputPlanes, int inputSize, int numFilters, int outputSize, int padding, bool flip,
+        float const *images, float const *weights, float *output) {
+    const int tiles = Winograd::numTiles(outputSize);
+    float *U = new float[numFilters * inputPlanes * 16];
+    for(int filter = 0; filter < numFilters; filter++) {
+        for(int inPlane = 0; inPlane < inputPlanes; inPlane++) {
+            float g[9];
+            for(int i = 0; i < 9; i++) {
+                g[i] = flip ? weights[(inPlane * numFilters + filter) * 9 + 8 - i] :
+                    weights[(filter * inputPlanes + inPlane) * 9 + i];
+            }
+            transformFilter(g, U + (filter * inputPlanes + inPlane) * 16);
+        }
+    }
+    float *V = new float[inputPlanes * 16];
+    for(int n = 0; n < batchSize; n++) {
+        for(int tileRow = 0; tileRow < tiles; tileRow++) {
+            for(int tileCol = 0; tileCol < tiles; tileCol++) {
+                for(int inPlane = 0; inPlane < inputPlanes; inPlane++) {
+                    float const *inputPlane = images + (n * inputPlanes + inPlane) * inputSize * inputSize;
+                    float d[16];
+                    for(int r = 0; r < 4; r++) {
+                        int row = tileRow * 2 - padding + r;
+                        for(int c = 0; c < 4; c++) {
+                            int col = tileCol * 2 - padding + c;
+                            d[r * 4 + c] = (row >= 0 && col >= 0 && row < inputSize && col < inputSize) ?
+                                inputPlane[row * inputSize + col] : 0.0f;
+                        }
+                    }
+                    transformInput(d, V + inPlane * 16);
+                }
+                for(int filter = 0; filter < numFilters; filter++) {
+                    float M[16];
+                    memset(M, 0, sizeof(M));
+                    for(int inPlane = 0; inPlane < inputPlanes; inPlane++) {
+                        float const *thisU = U + (filter * inputPlanes + inPlane) * 16;
+                        float const *thisV = V + inPlane * 16;
+                        for(int xi = 0; xi < 16; xi++) {
+                            M[xi] += thisU[xi] * thisV[xi];
+                        }
+                    }
+                    float Y[4];
+                    transformOutput(M, Y);
+                    float *outputPlane = output + (n * numFilters + filter) * outputSize * outputSize;
+                    for(int r = 0; r < 2; r++) {
+                        int row = tileRow * 2 + r;
+                        for(int c = 0; c < 2; c++) {
+                            int col = tileCol * 2 + c;
+                            if(row < outputSize && col < outputSize) {
+                                outputPlane[row * outputSize + col] = Y[r * 2 + c];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    delete[] V;
+    delete[] U;
+}
+
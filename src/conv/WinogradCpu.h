@@ -0,0 +1,35 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+#define STATIC static
+#define VIRTUAL virtual
+
+// plain c++ version of the Winograd F(2x2,3x3) transforms in cl/winograd.cl,
+// one tile at a time, as a reference for the tests
+// arguments mean the same as for Winograd
+class DeepCL_EXPORT WinogradCpu {
+    public:
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC void transformFilter(float const *g, float *U);
+    STATIC void transformInput(float const *d, float *V);
+    STATIC void transformOutput(float const *M, float *Y);
+    STATIC void convolve(int batchSize, int inputPlanes, int inputSize, int numFilters, int outputSize, int padding, bool flip,
+    float const *images, float const *weights, float *output);
+
+    // [[[end]]]
+};
+
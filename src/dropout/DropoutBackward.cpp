@@ -13,6 +13,7 @@
 
 #include "DropoutBackwardCpu.h"
 #include "DropoutBackwardGpuNaive.h"
+#include "DropoutMasks.h"
 
 #include "DropoutBackward.h"
 
@@ -55,10 +56,14 @@ VIRTUAL int DropoutBackward::getInputNumElements(int batchSize) {
 VIRTUAL int DropoutBackward::getOutputNumElements(int batchSize) {
     return batchSize * numPlanes * outputSize * outputSize;
 }
+// mask here is one byte per element, 1 to keep, 0 to drop
 VIRTUAL void DropoutBackward::backward(int batchSize, uchar *mask, float *gradOutput, float *gradInput) {
 //    cout << "DropoutBackward::backward(float *)" << endl;
     StatefulTimer::instance()->timeCheck("DropoutBackward::backward float->wrapper start");
-    CLWrapper *maskWrapper = cl->wrap(getOutputNumElements(batchSize), mask);
+    int numWords = DropoutMasks::numWords(getOutputNumElements(batchSize));
+    int *maskWords = new int[numWords];
+    DropoutMasks::pack(getOutputNumElements(batchSize), mask, maskWords);
+    CLWrapper *maskWrapper = cl->wrap(numWords, maskWords);
     CLWrapper *gradOutputWrapper = cl->wrap(getOutputNumElements(batchSize), gradOutput);
     CLWrapper *gradInputWrapper = cl->wrap(getInputNumElements(batchSize), gradInput);
 
@@ -73,8 +78,10 @@ VIRTUAL void DropoutBackward::backward(int batchSize, uchar *mask, float *gradOu
     delete maskWrapper;
     delete gradOutputWrapper;
     delete gradInputWrapper;
+    delete[] maskWords;
     StatefulTimer::instance()->timeCheck("DropoutBackward::backward float->wrapper end");
 }
+// maskWrapper is a bitmask, see DropoutMasks
 VIRTUAL void DropoutBackward::backward(int batchSize, CLWrapper *maskWrapper, CLWrapper *gradOutputWrapper, CLWrapper *gradInputWrapper) {
     throw runtime_error("DropoutBackward::backward wrappers not implemented");
 }
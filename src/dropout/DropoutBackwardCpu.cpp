@@ -13,6 +13,7 @@
 #include "util/StatefulTimer.h"
 
 #include "DropoutBackwardCpu.h"
+#include "DropoutMasks.h"
 
 using namespace std;
 
@@ -24,12 +25,6 @@ using namespace std;
 DropoutBackwardCpu::DropoutBackwardCpu(EasyCL *cl, int numPlanes, int inputSize, float dropRatio) :
         DropoutBackward(cl, numPlanes, inputSize, dropRatio) {
 }
-VIRTUAL void DropoutBackwardCpu::backward(int batchSize, uchar *mask,  float *gradOutput, float *gradInput) {
-    int totalLinearSize = batchSize * numPlanes * inputSize * inputSize;
-    for(int i = 0; i < totalLinearSize; i++) {
-        gradInput[i] = mask[i] == 1 ? gradOutput[i] : 0.0f;
-    }
-}
 VIRTUAL void DropoutBackwardCpu::backward(int batchSize, CLWrapper *maskWrapper, CLWrapper *gradOutputWrapper, 
         CLWrapper *gradInputWrapper) {
     StatefulTimer::instance()->timeCheck("DropoutBackwardCpu::backward start");
@@ -37,17 +32,16 @@ VIRTUAL void DropoutBackwardCpu::backward(int batchSize, CLWrapper *maskWrapper,
     maskWrapper->copyToHost();
     gradOutputWrapper->copyToHost();
 
-    uchar *mask = reinterpret_cast<uchar *>(maskWrapper->getHostArray());
+    int const *maskWords = reinterpret_cast<int *>(maskWrapper->getHostArray());
     float *gradOutput = reinterpret_cast<float *>(gradOutputWrapper->getHostArray());
-    float *gradInput = new float[ getInputNumElements(batchSize) ];
+    float *gradInput = reinterpret_cast<float *>(gradInputWrapper->getHostArray());
 
-    backward(batchSize, mask, gradOutput, gradInput);
-
-    float *gradInputHostArray = reinterpret_cast<float *>(gradInputWrapper->getHostArray());
-    memcpy(gradInputHostArray, gradInput, sizeof(float) * getInputNumElements(batchSize) );
+    int totalLinearSize = batchSize * numPlanes * inputSize * inputSize;
+    for(int i = 0; i < totalLinearSize; i++) {
+        gradInput[i] = DropoutMasks::isKept(maskWords, i) ? gradOutput[i] : 0.0f;
+    }
     gradInputWrapper->copyToDevice();
 
-    delete[] gradInput;
     
     StatefulTimer::instance()->timeCheck("DropoutBackwardCpu::backward end");
 }
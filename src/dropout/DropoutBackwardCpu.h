@@ -20,7 +20,6 @@ public:
     // ]]]
     // generated, using cog:
     DropoutBackwardCpu(EasyCL *cl, int numPlanes, int inputSize, float dropRatio);
-    VIRTUAL void backward(int batchSize, uchar *mask,  float *gradOutput, float *gradInput);
     VIRTUAL void backward(int batchSize, CLWrapper *maskWrapper, CLWrapper *gradOutputWrapper,
     CLWrapper *gradInputWrapper);
 
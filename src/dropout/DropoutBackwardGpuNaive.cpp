@@ -53,7 +53,6 @@ VIRTUAL void DropoutBackwardGpuNaive::backward(
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("DropoutBackwardGpuNaive::backward end");
 }
@@ -89,28 +88,81 @@ DropoutBackwardGpuNaive::DropoutBackwardGpuNaive(EasyCL *cl, int numPlanes, int
     "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
     "// obtain one at http://mozilla.org/MPL/2.0/.\n"
     "\n"
+    "// masks are bitmasks: bit (i % 32) of mask[i / 32] is 1 if element i is kept\n"
+    "// see src/dropout/DropoutMasks.h, which does the same as forwardGenerate,\n"
+    "// on the host\n"
+    "\n"
+    "// Philox4x32-10, Salmon et al., \"Parallel Random Numbers: As Easy as 1, 2, 3\"\n"
+    "uint4 philox4x32(uint4 counter, uint2 key) {\n"
+    "    for (int round = 0; round < 10; round++) {\n"
+    "        uint hi0 = mul_hi(0xD2511F53u, counter.x);\n"
+    "        uint lo0 = 0xD2511F53u * counter.x;\n"
+    "        uint hi1 = mul_hi(0xCD9E8D57u, counter.z);\n"
+    "        uint lo1 = 0xCD9E8D57u * counter.z;\n"
+    "        counter = (uint4)(hi1 ^ counter.y ^ key.x, lo1, hi0 ^ counter.w ^ key.y, lo0);\n"
+    "        key += (uint2)(0x9E3779B9u, 0xBB67AE85u);\n"
+    "    }\n"
+    "    return counter;\n"
+    "}\n"
+    "\n"
+    "// one work item per mask word, ie per 32 elements: makes the mask word, from\n"
+    "// 8 philox calls, writes it, for backward, and applies it\n"
+    "// an element is dropped if the top 24 bits of its random number are below\n"
+    "// dropThreshold\n"
+    "kernel void forwardGenerate(\n"
+    "        const int N,\n"
+    "        const int seed,\n"
+    "        const int batchCounter,\n"
+    "        const int dropThreshold,\n"
+    "        global int *mask,\n"
+    "        global const float *input,\n"
+    "        global float *output) {\n"
+    "    const int word = get_global_id(0);\n"
+    "    if (word * 32 >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const uint2 key = (uint2)((uint)seed, 0);\n"
+    "    uint bits = 0;\n"
+    "    for (int q = 0; q < 8; q++) {\n"
+    "        uint4 random = philox4x32((uint4)((uint)(word * 8 + q), (uint)batchCounter, 0, 0), key);\n"
+    "        bits |= ((random.x >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4);\n"
+    "        bits |= ((random.y >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 1);\n"
+    "        bits |= ((random.z >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 2);\n"
+    "        bits |= ((random.w >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 3);\n"
+    "    }\n"
+    "    const int first = word * 32;\n"
+    "    const int count = min(32, N - first);\n"
+    "    if (count < 32) {\n"
+    "        bits &= (1u << count) - 1;\n"
+    "    }\n"
+    "    mask[word] = (int)bits;\n"
+    "    for (int b = 0; b < count; b++) {\n"
+    "        output[first + b] = ((bits >> b) & 1) ? input[first + b] : 0.0f;\n"
+    "    }\n"
+    "}\n"
+    "\n"
     "kernel void forwardNaive(\n"
     "        const int N,\n"
-    "        global const unsigned char *mask,\n"
+    "        global const int *mask,\n"
     "        global const float *input,\n"
     "        global float *output) {\n"
     "    const int globalId = get_global_id(0);\n"
     "    if (globalId >= N) {\n"
     "        return;\n"
     "    }\n"
-    "    output[globalId] = mask[globalId] == 1 ? input[globalId] : 0.0f;\n"
+    "    output[globalId] = (((uint)mask[globalId >> 5] >> (globalId & 31)) & 1) ? input[globalId] : 0.0f;\n"
     "}\n"
     "\n"
     "kernel void backpropNaive(\n"
     "        const int N,\n"
-    "        global const unsigned char *mask,\n"
+    "        global const int *mask,\n"
     "        global const float *gradOutput,\n"
     "        global float *output) {\n"
     "    const int globalId = get_global_id(0);\n"
     "    if (globalId >= N) {\n"
     "        return;\n"
     "    }\n"
-    "    output[globalId] = mask[globalId] == 1 ? gradOutput[globalId] : 0.0f;\n"
+    "    output[globalId] = (((uint)mask[globalId >> 5] >> (globalId & 31)) & 1) ? gradOutput[globalId] : 0.0f;\n"
     "}\n"
     "\n"
     "";
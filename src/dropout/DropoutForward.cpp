@@ -10,6 +10,7 @@
 #include "util/stringhelper.h"
 #include "DropoutForwardCpu.h"
 #include "DropoutForwardGpuNaive.h"
+#include "DropoutMasks.h"
 
 #include "DropoutForward.h"
 
@@ -47,13 +48,24 @@ STATIC DropoutForward *DropoutForward::instanceSpecific(int idx, EasyCL *cl, int
     cout << "idx " << idx << " not known" << endl;
     throw runtime_error("DropoutForward::instanceSpecific idx not known: " + toString(idx) );
 }
+// masksWrapper is a bitmask, see DropoutMasks
 VIRTUAL void DropoutForward::forward(int batchSize, CLWrapper *masksWrapper, CLWrapper *inputData, CLWrapper *outputData) {
     throw runtime_error("forward not implemented for this child type");
 }
+// makes new masks, from seed and batchCounter, into masksWrapper, for
+// backward to use, and applies them.  the same seed and batchCounter give the
+// same masks, whichever the implementation
+VIRTUAL void DropoutForward::generateAndForward(int batchSize, int seed, int batchCounter, CLWrapper *masksWrapper, CLWrapper *inputWrapper, CLWrapper *outputWrapper) {
+    throw runtime_error("generateAndForward not implemented for this child type");
+}
+// masks here are one byte per element, 1 to keep, 0 to drop
 VIRTUAL void DropoutForward::forward(int batchSize, unsigned char *masks, float *input, float *output) {
 //    cout << "DropoutForward::forward(float *)" << endl;
     int inputLinearSize = getInputNumElements(batchSize);
-    CLWrapper *masksWrapper = cl->wrap(inputLinearSize, masks);
+    int numWords = DropoutMasks::numWords(inputLinearSize);
+    int *maskWords = new int[numWords];
+    DropoutMasks::pack(inputLinearSize, masks, maskWords);
+    CLWrapper *masksWrapper = cl->wrap(numWords, maskWords);
     CLWrapper *inputWrapper = cl->wrap(inputLinearSize, input);
     CLWrapper *outputWrapper = cl->wrap(getOutputNumElements(batchSize), output);
 
@@ -65,6 +77,7 @@ VIRTUAL void DropoutForward::forward(int batchSize, unsigned char *masks, float
     delete outputWrapper;
     delete inputWrapper;
     delete masksWrapper;
+    delete[] maskWords;
 }
 VIRTUAL int DropoutForward::getInputNumElements(int batchSize) {
     return batchSize * numPlanes * inputSize * inputSize;
@@ -48,6 +48,7 @@ public:
     STATIC DropoutForward *instanceForTest(EasyCL *cl, int numPlanes, int inputSize, float dropRatio);
     STATIC DropoutForward *instanceSpecific(int idx, EasyCL *cl, int numPlanes, int inputSize, float dropRatio);
     VIRTUAL void forward(int batchSize, CLWrapper *masksWrapper, CLWrapper *inputData, CLWrapper *outputData);
+    VIRTUAL void generateAndForward(int batchSize, int seed, int batchCounter, CLWrapper *masksWrapper, CLWrapper *inputWrapper, CLWrapper *outputWrapper);
     VIRTUAL void forward(int batchSize, unsigned char *masks, float *input, float *output);
     VIRTUAL int getInputNumElements(int batchSize);
     VIRTUAL int getOutputNumElements(int batchSize);
@@ -12,6 +12,7 @@
 #include "util/StatefulTimer.h"
 
 #include "DropoutForwardCpu.h"
+#include "DropoutMasks.h"
 
 using namespace std;
 
@@ -26,31 +27,26 @@ DropoutForwardCpu::DropoutForwardCpu(EasyCL *cl, int numPlanes, int inputSize, f
 VIRTUAL void DropoutForwardCpu::forward(int batchSize, CLWrapper *masksWrapper, CLWrapper *inputWrapper, CLWrapper *outputWrapper) {
 //    cout << "DropoutForwardCpu::forward(CLWrapper *)" << endl;
 
+    StatefulTimer::instance()->timeCheck("DropoutForwardCpu::forward start");
+    masksWrapper->copyToHost();
     inputWrapper->copyToHost();
 
-    unsigned char *masks = reinterpret_cast<unsigned char *>(masksWrapper->getHostArray());
+    int const *maskWords = reinterpret_cast<int *>(masksWrapper->getHostArray());
     float *input = reinterpret_cast<float *>(inputWrapper->getHostArray());
-    float *output = new float[ getOutputNumElements(batchSize) ];
-
-    forward(batchSize, masks, input, output);
-
-    float *outputHostArray = reinterpret_cast<float *>(outputWrapper->getHostArray());
-    memcpy(outputHostArray, output, sizeof(float) * getOutputNumElements(batchSize) );
-
-    outputWrapper->copyToDevice();
+    float *output = reinterpret_cast<float *>(outputWrapper->getHostArray());
 
-    delete[] output;
-}
-VIRTUAL void DropoutForwardCpu::forward(int batchSize, unsigned char *masks, float *input, float *output) {
-//    float *output = new float[ getOutputNumElements(batchSize) ];
-//    cout << "DropoutForwardCpu::forward(float *)" << endl;
-    StatefulTimer::instance()->timeCheck("DropoutForwardCpu::forward start");
     int totalLinearSize = batchSize * numPlanes * inputSize * inputSize;
-//    float inverseDropRatio = 1.0f / dropRatio; // since multiply faster than divide, just divide once
     for(int i = 0; i < totalLinearSize; i++) {
-        output[i] = masks[i] == 1 ? input[i] : 0;
+        output[i] = DropoutMasks::isKept(maskWords, i) ? input[i] : 0;
     }
+
+    outputWrapper->copyToDevice();
     StatefulTimer::instance()->timeCheck("DropoutForwardCpu::forward end");
-//    return output;
+}
+VIRTUAL void DropoutForwardCpu::generateAndForward(int batchSize, int seed, int batchCounter, CLWrapper *masksWrapper, CLWrapper *inputWrapper, CLWrapper *outputWrapper) {
+    int *maskWords = reinterpret_cast<int *>(masksWrapper->getHostArray());
+    DropoutMasks::generate(getInputNumElements(batchSize), seed, batchCounter, dropRatio, maskWords);
+    masksWrapper->copyToDevice();
+    forward(batchSize, masksWrapper, inputWrapper, outputWrapper);
 }
 
@@ -21,7 +21,7 @@ public:
     // generated, using cog:
     DropoutForwardCpu(EasyCL *cl, int numPlanes, int inputSize, float dropRatio);
     VIRTUAL void forward(int batchSize, CLWrapper *masksWrapper, CLWrapper *inputWrapper, CLWrapper *outputWrapper);
-    VIRTUAL void forward(int batchSize, unsigned char *masks, float *input, float *output);
+    VIRTUAL void generateAndForward(int batchSize, int seed, int batchCounter, CLWrapper *masksWrapper, CLWrapper *inputWrapper, CLWrapper *outputWrapper);
 
     // [[[end]]]
 };
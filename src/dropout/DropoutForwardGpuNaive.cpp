@@ -13,6 +13,7 @@
 #include "util/stringhelper.h"
 
 #include "DropoutForwardGpuNaive.h"
+#include "DropoutMasks.h"
 
 //#include "test/PrintBuffer.h"
 
@@ -25,6 +26,7 @@ using namespace std;
 
 VIRTUAL DropoutForwardGpuNaive::~DropoutForwardGpuNaive() {
     delete kernel;
+    delete kernelGenerate;
 }
 VIRTUAL void DropoutForwardGpuNaive::forward(int batchSize, CLWrapper *masksWrapper, CLWrapper *inputWrapper, CLWrapper *outputWrapper) {
 //    cout << StatefulTimer::instance()->prefix << "DropoutForwardGpuNaive::forward(CLWrapper *)" << endl;
@@ -39,13 +41,34 @@ VIRTUAL void DropoutForwardGpuNaive::forward(int batchSize, CLWrapper *masksWrap
     globalSize = (( globalSize + workgroupsize - 1) / workgroupsize) * workgroupsize;
 //    cout << "DropoutForwardGpuNaive::forward batchsize=" << batchSize << " g=" << globalSize << " w=" << workgroupsize << endl;
     kernel->run_1d(globalSize, workgroupsize);
-    cl->finish();
 
 //    cout << "DropoutForwardGpuNaive::forward selectorswrapper:" << endl;
 //    PrintBuffer::printInts(cl, selectorsWrapper, outputSize, outputSize);
 
     StatefulTimer::instance()->timeCheck("DropoutForwardGpuNaive::forward end");
 }
+// one work item per 32 elements, each making one word of the mask
+VIRTUAL void DropoutForwardGpuNaive::generateAndForward(int batchSize, int seed, int batchCounter, CLWrapper *masksWrapper, CLWrapper *inputWrapper, CLWrapper *outputWrapper) {
+    StatefulTimer::instance()->timeCheck("DropoutForwardGpuNaive::generateAndForward start");
+
+    int numElements = batchSize * numPlanes * outputSize * outputSize;
+    if(!masksWrapper->isOnDevice()) {
+        masksWrapper->createOnDevice();
+    }
+    kernelGenerate->input(numElements)
+                  ->input(seed)
+                  ->input(batchCounter)
+                  ->input((int)DropoutMasks::threshold(dropRatio))
+                  ->output(masksWrapper)
+                  ->input(inputWrapper)
+                  ->output(outputWrapper);
+    int globalSize = DropoutMasks::numWords(numElements);
+    int workgroupsize = cl->getMaxWorkgroupSize();
+    globalSize = (( globalSize + workgroupsize - 1) / workgroupsize) * workgroupsize;
+    kernelGenerate->run_1d(globalSize, workgroupsize);
+
+    StatefulTimer::instance()->timeCheck("DropoutForwardGpuNaive::generateAndForward end");
+}
 DropoutForwardGpuNaive::DropoutForwardGpuNaive(EasyCL *cl, int numPlanes, int inputSize, float dropRatio) :
         DropoutForward(cl, numPlanes, inputSize, dropRatio) {
     string options = "";
@@ -67,6 +90,7 @@ DropoutForwardGpuNaive::DropoutForwardGpuNaive(EasyCL *cl, int numPlanes, int in
     // [[[cog
     // import stringify
     // stringify.write_kernel2("kernel", "cl/dropout.cl", "forwardNaive", 'options')
+    // stringify.write_kernel2("kernelGenerate", "cl/dropout.cl", "forwardGenerate", 'options')
     // ]]]
     // generated using cog, from cl/dropout.cl:
     const char * kernelSource =  
@@ -76,32 +100,172 @@ DropoutForwardGpuNaive::DropoutForwardGpuNaive(EasyCL *cl, int numPlanes, int in
     "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
     "// obtain one at http://mozilla.org/MPL/2.0/.\n"
     "\n"
+    "// masks are bitmasks: bit (i % 32) of mask[i / 32] is 1 if element i is kept\n"
+    "// see src/dropout/DropoutMasks.h, which does the same as forwardGenerate,\n"
+    "// on the host\n"
+    "\n"
+    "// Philox4x32-10, Salmon et al., \"Parallel Random Numbers: As Easy as 1, 2, 3\"\n"
+    "uint4 philox4x32(uint4 counter, uint2 key) {\n"
+    "    for (int round = 0; round < 10; round++) {\n"
+    "        uint hi0 = mul_hi(0xD2511F53u, counter.x);\n"
+    "        uint lo0 = 0xD2511F53u * counter.x;\n"
+    "        uint hi1 = mul_hi(0xCD9E8D57u, counter.z);\n"
+    "        uint lo1 = 0xCD9E8D57u * counter.z;\n"
+    "        counter = (uint4)(hi1 ^ counter.y ^ key.x, lo1, hi0 ^ counter.w ^ key.y, lo0);\n"
+    "        key += (uint2)(0x9E3779B9u, 0xBB67AE85u);\n"
+    "    }\n"
+    "    return counter;\n"
+    "}\n"
+    "\n"
+    "// one work item per mask word, ie per 32 elements: makes the mask word, from\n"
+    "// 8 philox calls, writes it, for backward, and applies it\n"
+    "// an element is dropped if the top 24 bits of its random number are below\n"
+    "// dropThreshold\n"
+    "kernel void forwardGenerate(\n"
+    "        const int N,\n"
+    "        const int seed,\n"
+    "        const int batchCounter,\n"
+    "        const int dropThreshold,\n"
+    "        global int *mask,\n"
+    "        global const float *input,\n"
+    "        global float *output) {\n"
+    "    const int word = get_global_id(0);\n"
+    "    if (word * 32 >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const uint2 key = (uint2)((uint)seed, 0);\n"
+    "    uint bits = 0;\n"
+    "    for (int q = 0; q < 8; q++) {\n"
+    "        uint4 random = philox4x32((uint4)((uint)(word * 8 + q), (uint)batchCounter, 0, 0), key);\n"
+    "        bits |= ((random.x >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4);\n"
+    "        bits |= ((random.y >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 1);\n"
+    "        bits |= ((random.z >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 2);\n"
+    "        bits |= ((random.w >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 3);\n"
+    "    }\n"
+    "    const int first = word * 32;\n"
+    "    const int count = min(32, N - first);\n"
+    "    if (count < 32) {\n"
+    "        bits &= (1u << count) - 1;\n"
+    "    }\n"
+    "    mask[word] = (int)bits;\n"
+    "    for (int b = 0; b < count; b++) {\n"
+    "        output[first + b] = ((bits >> b) & 1) ? input[first + b] : 0.0f;\n"
+    "    }\n"
+    "}\n"
+    "\n"
     "kernel void forwardNaive(\n"
     "        const int N,\n"
-    "        global const unsigned char *mask,\n"
+    "        global const int *mask,\n"
     "        global const float *input,\n"
     "        global float *output) {\n"
     "    const int globalId = get_global_id(0);\n"
     "    if (globalId >= N) {\n"
     "        return;\n"
     "    }\n"
-    "    output[globalId] = mask[globalId] == 1 ? input[globalId] : 0.0f;\n"
+    "    output[globalId] = (((uint)mask[globalId >> 5] >> (globalId & 31)) & 1) ? input[globalId] : 0.0f;\n"
     "}\n"
     "\n"
     "kernel void backpropNaive(\n"
     "        const int N,\n"
-    "        global const unsigned char *mask,\n"
+    "        global const int *mask,\n"
     "        global const float *gradOutput,\n"
     "        global float *output) {\n"
     "    const int globalId = get_global_id(0);\n"
     "    if (globalId >= N) {\n"
     "        return;\n"
     "    }\n"
-    "    output[globalId] = mask[globalId] == 1 ? gradOutput[globalId] : 0.0f;\n"
+    "    output[globalId] = (((uint)mask[globalId >> 5] >> (globalId & 31)) & 1) ? gradOutput[globalId] : 0.0f;\n"
     "}\n"
     "\n"
     "";
     kernel = cl->buildKernelFromString(kernelSource, "forwardNaive", options, "cl/dropout.cl");
+    // generated using cog, from cl/dropout.cl:
+    const char * kernelGenerateSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// masks are bitmasks: bit (i % 32) of mask[i / 32] is 1 if element i is kept\n"
+    "// see src/dropout/DropoutMasks.h, which does the same as forwardGenerate,\n"
+    "// on the host\n"
+    "\n"
+    "// Philox4x32-10, Salmon et al., \"Parallel Random Numbers: As Easy as 1, 2, 3\"\n"
+    "uint4 philox4x32(uint4 counter, uint2 key) {\n"
+    "    for (int round = 0; round < 10; round++) {\n"
+    "        uint hi0 = mul_hi(0xD2511F53u, counter.x);\n"
+    "        uint lo0 = 0xD2511F53u * counter.x;\n"
+    "        uint hi1 = mul_hi(0xCD9E8D57u, counter.z);\n"
+    "        uint lo1 = 0xCD9E8D57u * counter.z;\n"
+    "        counter = (uint4)(hi1 ^ counter.y ^ key.x, lo1, hi0 ^ counter.w ^ key.y, lo0);\n"
+    "        key += (uint2)(0x9E3779B9u, 0xBB67AE85u);\n"
+    "    }\n"
+    "    return counter;\n"
+    "}\n"
+    "\n"
+    "// one work item per mask word, ie per 32 elements: makes the mask word, from\n"
+    "// 8 philox calls, writes it, for backward, and applies it\n"
+    "// an element is dropped if the top 24 bits of its random number are below\n"
+    "// dropThreshold\n"
+    "kernel void forwardGenerate(\n"
+    "        const int N,\n"
+    "        const int seed,\n"
+    "        const int batchCounter,\n"
+    "        const int dropThreshold,\n"
+    "        global int *mask,\n"
+    "        global const float *input,\n"
+    "        global float *output) {\n"
+    "    const int word = get_global_id(0);\n"
+    "    if (word * 32 >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const uint2 key = (uint2)((uint)seed, 0);\n"
+    "    uint bits = 0;\n"
+    "    for (int q = 0; q < 8; q++) {\n"
+    "        uint4 random = philox4x32((uint4)((uint)(word * 8 + q), (uint)batchCounter, 0, 0), key);\n"
+    "        bits |= ((random.x >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4);\n"
+    "        bits |= ((random.y >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 1);\n"
+    "        bits |= ((random.z >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 2);\n"
+    "        bits |= ((random.w >> 8) >= (uint)dropThreshold ? 1u : 0u) << (q * 4 + 3);\n"
+    "    }\n"
+    "    const int first = word * 32;\n"
+    "    const int count = min(32, N - first);\n"
+    "    if (count < 32) {\n"
+    "        bits &= (1u << count) - 1;\n"
+    "    }\n"
+    "    mask[word] = (int)bits;\n"
+    "    for (int b = 0; b < count; b++) {\n"
+    "        output[first + b] = ((bits >> b) & 1) ? input[first + b] : 0.0f;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "kernel void forwardNaive(\n"
+    "        const int N,\n"
+    "        global const int *mask,\n"
+    "        global const float *input,\n"
+    "        global float *output) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    output[globalId] = (((uint)mask[globalId >> 5] >> (globalId & 31)) & 1) ? input[globalId] : 0.0f;\n"
+    "}\n"
+    "\n"
+    "kernel void backpropNaive(\n"
+    "        const int N,\n"
+    "        global const int *mask,\n"
+    "        global const float *gradOutput,\n"
+    "        global float *output) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    output[globalId] = (((uint)mask[globalId >> 5] >> (globalId & 31)) & 1) ? gradOutput[globalId] : 0.0f;\n"
+    "}\n"
+    "\n"
+    "";
+    kernelGenerate = cl->buildKernelFromString(kernelGenerateSource, "forwardGenerate", options, "cl/dropout.cl");
     // [[[end]]]
 //    kernel = cl->buildKernel("dropout.cl", "forwardNaive", options);
 }
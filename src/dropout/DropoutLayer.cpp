@@ -9,9 +9,12 @@
 #include "net/NeuralNet.h"
 #include "layer/Layer.h"
 #include "dropout/DropoutLayer.h"
+#include "clmath/CLWrapperCache.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "dropout/DropoutMaker.h"
 #include "dropout/DropoutForward.h"
 #include "dropout/DropoutBackward.h"
+#include "dropout/DropoutMasks.h"
 #include "util/RandomSingleton.h"
 #include "clmath/MultiplyBuffer.h"
 
@@ -32,12 +35,13 @@ DropoutLayer::DropoutLayer(EasyCL *cl, Layer *previousLayer, DropoutMaker *maker
         outputSize(previousLayer->getOutputSize()),
         random(RandomSingleton::instance()),
         cl(cl),
-        masks(0),
-        output(0),
-        gradInput(0),
+        seed(0),
+        batchCounter(0),
         maskWrapper(0),
         outputWrapper(0),
         gradInputWrapper(0),
+        upstreamWrapperCache(0),
+        gradOutputWrapperCache(0),
 //        outputCopiedToHost(false),
 //        gradInputCopiedToHost(false),
         batchSize(0),
@@ -53,35 +57,36 @@ DropoutLayer::DropoutLayer(EasyCL *cl, Layer *previousLayer, DropoutMaker *maker
     dropoutForwardImpl = DropoutForward::instance(cl, numPlanes, inputSize, dropRatio);
     dropoutBackwardImpl = DropoutBackward::instance(cl, numPlanes, inputSize, dropRatio);
     multiplyBuffer = new MultiplyBuffer(cl);
+    upstreamWrapperCache = new CLWrapperCache(cl);
+    gradOutputWrapperCache = new CLWrapperCache(cl);
+    seed = (int)(random->_uniform() * 16777216.0f);
 }
 VIRTUAL DropoutLayer::~DropoutLayer() {
     delete multiplyBuffer;
     delete dropoutForwardImpl;
     delete dropoutBackwardImpl;
-    if(maskWrapper != 0) {
-        delete maskWrapper;
-    }
-    if(outputWrapper != 0) {
+    delete upstreamWrapperCache;
+    delete gradOutputWrapperCache;
+    delete maskWrapper;
+    // in inference, our output is a view, owned by the net's OutputArenas
+    if(!inference) {
         delete outputWrapper;
     }
-    if(masks != 0) {
-        delete[] masks;
-    }
-    if(output != 0) {
-        delete[] output;
-    }
-    if(gradInputWrapper != 0) {
-        delete gradInputWrapper;
-    }
-    if(gradInput != 0) {
-        delete[] gradInput;
-    }
+    delete gradInputWrapper;
 }
 VIRTUAL std::string DropoutLayer::getClassName() const {
     return "DropoutLayer";
 }
 VIRTUAL void DropoutLayer::fortesting_setRandomSingleton(RandomSingleton *random) {
     this->random = random;
+    setSeed((int)(random->_uniform() * 16777216.0f));
+}
+// the masks depend only on the seed, and on how many batches have been
+// through forward since it was set, so eg tests can reproduce them, with
+// DropoutMasks::generate
+VIRTUAL void DropoutLayer::setSeed(int seed) {
+    this->seed = seed;
+    this->batchCounter = 0;
 }
 VIRTUAL void DropoutLayer::setBatchSize(int batchSize) {
 //    cout << "DropoutLayer::setBatchSize" << endl;
@@ -89,43 +94,33 @@ VIRTUAL void DropoutLayer::setBatchSize(int batchSize) {
         this->batchSize = batchSize;
         return;
     }
-    if(maskWrapper != 0) {
-        delete maskWrapper;
-    }
-    if(outputWrapper != 0) {
-        delete outputWrapper;
-    }
-    if(masks != 0) {
-        delete[] masks;
-    }
-    if(output != 0) {
-        delete[] output;
-    }
-    if(gradInputWrapper != 0) {
-        delete gradInputWrapper;
-    }
-    if(gradInput != 0) {
-        delete[] gradInput;
+    if(inference) {
+        // output comes from setOutputView, and, never training, we need
+        // neither masks nor gradInput
+        this->batchSize = batchSize;
+        this->allocatedSize = batchSize;
+        return;
     }
+    delete maskWrapper;
+    delete outputWrapper;
+    delete gradInputWrapper;
     this->batchSize = batchSize;
     this->allocatedSize = batchSize;
-    masks = new unsigned char[ getOutputNumElements() ];
-    maskWrapper = cl->wrap(getOutputNumElements(), masks);
-    output = new float[ getOutputNumElements() ];
-    outputWrapper = cl->wrap(getOutputNumElements(), output);
-    gradInput = new float[ previousLayer->getOutputNumElements() ];
-    gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
-    gradInputWrapper->createOnDevice();
+    maskWrapper = new CLDeviceWrapper(cl, DropoutMasks::numWords(getOutputNumElements()));
+    outputWrapper = new CLDeviceWrapper(cl, getOutputNumElements());
+    gradInputWrapper = new CLDeviceWrapper(cl, previousLayer->getOutputNumElements());
+}
+VIRTUAL bool DropoutLayer::takesOutputView() const {
+    return true;
+}
+VIRTUAL void DropoutLayer::setOutputView(CLDeviceWrapper *outputView) {
+    outputWrapper = outputView;
 }
 VIRTUAL int DropoutLayer::getOutputNumElements() {
     return batchSize * numPlanes * outputSize * outputSize;
 }
 VIRTUAL float *DropoutLayer::getOutput() {
-    if(outputWrapper->isDeviceDirty()) {
-        outputWrapper->copyToHost();
-//        outputCopiedToHost = true;
-    }
-    return output;
+    return outputWrapper->copyToStaging();
 }
 VIRTUAL bool DropoutLayer::needsBackProp() {
     return previousLayer->needsBackProp(); // seems highly unlikely that we wouldnt have to backprop
@@ -158,81 +153,44 @@ VIRTUAL CLWrapper *DropoutLayer::getOutputWrapper() {
     return outputWrapper;
 }
 VIRTUAL float *DropoutLayer::getGradInput() {
-    return gradInput;
+    return gradInputWrapper->copyToStaging();
 }
 VIRTUAL ActivationFunction const *DropoutLayer::getActivationFunction() {
     return new LinearActivation();
 }
-//VIRTUAL void DropoutLayer::generateMasks() {
-//    int totalInputLinearSize = getOutputNumElements();
-////    int numBytes = (totalInputLinearSize+8-1)/8;
-////    unsigned char *bitsField = new unsigned char[numBytes];
-//    int idx = 0;
-//    unsigned char thisByte = 0;
-//    int bitsPacked = 0;
-//    for(int i = 0; i < totalInputLinearSize; i++) {
-//        //double value = ((int)random() % 10000) / 20000.0f + 0.5f;
-//        // 1 means we pass value through, 0 means we drop
-//        // dropRatio is probability that mask value is 0 therefore
-//        // so higher dropRatio => more likely to be 0
-//        unsigned char bit = random->_uniform() <= dropRatio ? 0 : 1;
-////        unsigned char bit = 0;
-//        thisByte <<= 1;
-//        thisByte |= bit;
-//        bitsPacked++;
-//        if(bitsPacked >= 8) {
-//            masks[idx] = thisByte;
-//            idx++;
-//            bitsPacked = 0;
-//        }
-//    }
-//}
-VIRTUAL void DropoutLayer::generateMasks() {
-    int totalInputLinearSize = getOutputNumElements();
-    for(int i = 0; i < totalInputLinearSize; i++) {
-        masks[i] = random->_uniform() <= dropRatio ? 0 : 1;
-    }
-}
 VIRTUAL void DropoutLayer::forward() {
     CLWrapper *upstreamOutputWrapper = 0;
     if(previousLayer->hasOutputWrapper()) {
         upstreamOutputWrapper = previousLayer->getOutputWrapper();
     } else {
         float *upstreamOutput = previousLayer->getOutput();
-        upstreamOutputWrapper = cl->wrap(previousLayer->getOutputNumElements(), upstreamOutput);
+        upstreamOutputWrapper = upstreamWrapperCache->wrap(previousLayer->getOutputNumElements(), upstreamOutput);
         upstreamOutputWrapper->copyToDevice();
     }
 
+    outputWrapper->releaseStaging();
 //    cout << "training: " << training << endl;
     if(training) {
-        // create new masks...
-        generateMasks();
-        maskWrapper->copyToDevice();
-        dropoutForwardImpl->forward(batchSize, maskWrapper, upstreamOutputWrapper, outputWrapper);
+        // new masks each batch, made on the device, as the dropout is applied
+        dropoutForwardImpl->generateAndForward(batchSize, seed, batchCounter, maskWrapper, upstreamOutputWrapper, outputWrapper);
+        batchCounter++;
     } else {
         // if not training, then simply skip the dropout bit, copy the buffers directly
         multiplyBuffer->multiply(getOutputNumElements(), dropRatio, upstreamOutputWrapper, outputWrapper);
     }
-    if(!previousLayer->hasOutputWrapper()) {
-        delete upstreamOutputWrapper;
-    }
 }
 VIRTUAL void DropoutLayer::backward() {
     // have no weights to backprop to, just need to backprop the errors
 
     CLWrapper *gradOutputWrapper = 0;
-    bool weOwnErrorsWrapper = false;
     if(nextLayer->providesGradInputWrapper()) {
         gradOutputWrapper = nextLayer->getGradInputWrapper();
     } else {
-        gradOutputWrapper = cl->wrap(getOutputNumElements(), nextLayer->getGradInput());
+        gradOutputWrapper = gradOutputWrapperCache->wrap(getOutputNumElements(), nextLayer->getGradInput());
         gradOutputWrapper->copyToDevice();
-        weOwnErrorsWrapper = true;
     }
+    gradInputWrapper->releaseStaging();
     dropoutBackwardImpl->backward(batchSize, maskWrapper, gradOutputWrapper, gradInputWrapper);
-    if(weOwnErrorsWrapper) {
-        delete gradOutputWrapper;
-    }
 }
 VIRTUAL std::string DropoutLayer::asString() const {
     return "DropoutLayer{ dropRatio=" + toString(dropRatio) + " }";
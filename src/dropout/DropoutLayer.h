@@ -17,6 +17,8 @@ class DropoutForward;
 class DropoutBackward;
 class RandomSingleton;
 class DropoutMaker;
+class CLWrapperCache;
+class CLDeviceWrapper;
 class MultiplyBuffer;
 
 class DropoutLayer : public Layer {
@@ -34,13 +36,19 @@ public:
     DropoutBackward *dropoutBackwardImpl;
     MultiplyBuffer *multiplyBuffer; // for skipping dropout...
 
-    unsigned char *masks;
-    float *output;
-    float *gradInput;
+    int seed;
+    int batchCounter;
 
-    CLWrapper *maskWrapper;
-    CLWrapper *outputWrapper;
-    CLWrapper *gradInputWrapper;
+    // device only, see CLDeviceWrapper
+    // the masks are bitmasks, see DropoutMasks, made by forward, from seed
+    // and batchCounter
+    CLDeviceWrapper *maskWrapper;
+    CLDeviceWrapper *outputWrapper;
+    CLDeviceWrapper *gradInputWrapper;
+
+    // only used if our neighbours dont have their own wrappers
+    CLWrapperCache *upstreamWrapperCache;
+    CLWrapperCache *gradOutputWrapperCache;
 
 //    bool outputCopiedToHost;
 //    bool gradInputCopiedToHost;
@@ -57,7 +65,10 @@ public:
     VIRTUAL ~DropoutLayer();
     VIRTUAL std::string getClassName() const;
     VIRTUAL void fortesting_setRandomSingleton(RandomSingleton *random);
+    VIRTUAL void setSeed(int seed);
     VIRTUAL void setBatchSize(int batchSize);
+    VIRTUAL bool takesOutputView() const;
+    VIRTUAL void setOutputView(CLDeviceWrapper *outputView);
     VIRTUAL int getOutputNumElements();
     VIRTUAL float *getOutput();
     VIRTUAL bool needsBackProp();
@@ -71,7 +82,6 @@ public:
     VIRTUAL CLWrapper *getOutputWrapper();
     VIRTUAL float *getGradInput();
     VIRTUAL ActivationFunction const *getActivationFunction();
-    VIRTUAL void generateMasks();
     VIRTUAL void forward();
     VIRTUAL void backward();
     VIRTUAL std::string asString() const;
@@ -0,0 +1,86 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "dropout/DropoutMasks.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#define VIRTUAL 
+#undef STATIC
+#define STATIC
+
+PUBLIC STATIC int DropoutMasks::numWords(int numElements) {
+    return (numElements + 31) / 32;
+}
+PUBLIC STATIC bool DropoutMasks::isKept(int const *maskWords, int i) {
+    return (((unsigned int)maskWords[i >> 5] >> (i & 31)) & 1) != 0;
+}
+// from one byte per element, 1 to keep, 0 to drop, as the masks used to be
+PUBLIC STATIC void DropoutMasks::pack(int numElements, unsigned char const *bytes, int *maskWords) {
+    int words = numWords(numElements);
+    for(int w = 0; w < words; w++) {
+        unsigned int word = 0;
+        for(int b = 0; b < 32 && w * 32 + b < numElements; b++) {
+            if(bytes[w * 32 + b] == 1) {
+                word |= 1u << b;
+            }
+        }
+        maskWords[w] = (int)word;
+    }
+}
+// compared against the top 24 bits of each random number, so the host and
+// the device agree exactly, without any float rounding
+PUBLIC STATIC unsigned int DropoutMasks::threshold(float dropRatio) {
+    if(dropRatio <= 0.0f) {
+        return 0;
+    }
+    if(dropRatio >= 1.0f) {
+        return 1u << 24;
+    }
+    return (unsigned int)(dropRatio * 16777216.0 + 0.5);
+}
+PUBLIC STATIC void DropoutMasks::philox(unsigned int const counter[4], unsigned int const key[2], unsigned int result[4]) {
+    unsigned int c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    unsigned int k0 = key[0], k1 = key[1];
+    for(int round = 0; round < 10; round++) {
+        unsigned long long p0 = (unsigned long long)0xD2511F53u * c0;
+        unsigned long long p1 = (unsigned long long)0xCD9E8D57u * c2;
+        unsigned int hi0 = (unsigned int)(p0 >> 32), lo0 = (unsigned int)p0;
+        unsigned int hi1 = (unsigned int)(p1 >> 32), lo1 = (unsigned int)p1;
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    result[0] = c0;
+    result[1] = c1;
+    result[2] = c2;
+    result[3] = c3;
+}
+PUBLIC STATIC void DropoutMasks::generate(int numElements, int seed, int batchCounter, float dropRatio, int *maskWords) {
+    unsigned int dropThreshold = threshold(dropRatio);
+    unsigned int key[2] = { (unsigned int)seed, 0 };
+    int words = numWords(numElements);
+    for(int w = 0; w < words; w++) {
+        unsigned int word = 0;
+        for(int q = 0; q < 8; q++) {
+            unsigned int counter[4] = { (unsigned int)(w * 8 + q), (unsigned int)batchCounter, 0, 0 };
+            unsigned int random[4];
+            philox(counter, key, random);
+            for(int lane = 0; lane < 4; lane++) {
+                int b = q * 4 + lane;
+                if(w * 32 + b < numElements && (random[lane] >> 8) >= dropThreshold) {
+                    word |= 1u << b;
+                }
+            }
+        }
+        maskWords[w] = (int)word;
+    }
+}
+
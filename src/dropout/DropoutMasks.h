@@ -0,0 +1,41 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// dropout masks are bitmasks: bit (i % 32) of word (i / 32) is 1 if element i
+// is passed through, and 0 if it is dropped.  words are stored as ints, so
+// they can be wrapped, but are treated as unsigned
+//
+// masks are generated from a stateless counter-based rng, Philox4x32-10
+// (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"): element i
+// of batch batchCounter gets lane i % 4 of philox({i / 4, batchCounter, 0, 0},
+// {seed, 0}), and is dropped if the top 24 bits of that are below
+// threshold(dropRatio).  this is the cpu version of what cl/dropout.cl does,
+// bit for bit, for DropoutForwardCpu, and for the tests
+class DeepCL_EXPORT DropoutMasks {
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC int numWords(int numElements);
+    STATIC bool isKept(int const *maskWords, int i);
+    STATIC void pack(int numElements, unsigned char const *bytes, int *maskWords);
+    STATIC unsigned int threshold(float dropRatio);
+    STATIC void philox(unsigned int const counter[4], unsigned int const key[2], unsigned int result[4]);
+    STATIC void generate(int numElements, int seed, int batchCounter, float dropRatio, int *maskWords);
+
+    // [[[end]]]
+};
+
@@ -85,6 +85,9 @@ VIRTUAL float *FullyConnectedLayer::getOutput() {
 VIRTUAL float *FullyConnectedLayer::getGradInput() {
     return convolutionalLayer->getGradInput();
 }
+VIRTUAL void FullyConnectedLayer::setParameterArena(ParameterArena *arena, int weightsOffset, int biasOffset) {
+    convolutionalLayer->setParameterArena(arena, weightsOffset, biasOffset);
+}
 VIRTUAL CLWrapper *FullyConnectedLayer::getGradWeightsWrapper() {
     return convolutionalLayer->getGradWeightsWrapper();
 }
@@ -115,6 +118,19 @@ VIRTUAL CLWrapper *FullyConnectedLayer::getOutputWrapper() {
 //VIRTUAL ActivationFunction const*FullyConnectedLayer::getActivationFunction() {
 //    return fn;
 //}
+VIRTUAL bool FullyConnectedLayer::fuseActivation(ActivationFunction const *fn) {
+    return convolutionalLayer->fuseActivation(fn);
+}
+VIRTUAL void FullyConnectedLayer::setInference(bool inference) {
+    Layer::setInference(inference);
+    convolutionalLayer->setInference(inference);
+}
+VIRTUAL bool FullyConnectedLayer::takesOutputView() const {
+    return convolutionalLayer->takesOutputView();
+}
+VIRTUAL void FullyConnectedLayer::setOutputView(CLDeviceWrapper *outputView) {
+    convolutionalLayer->setOutputView(outputView);
+}
 VIRTUAL bool FullyConnectedLayer::needsBackProp() {
     return true;;
 }
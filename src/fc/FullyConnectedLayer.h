@@ -46,6 +46,7 @@ public:
     VIRTUAL int getOutputNumElements() const;
     VIRTUAL float *getOutput();
     VIRTUAL float *getGradInput();
+    VIRTUAL void setParameterArena(ParameterArena *arena, int weightsOffset, int biasOffset);
     VIRTUAL CLWrapper *getGradWeightsWrapper();
     VIRTUAL CLWrapper *getGradBiasWrapper();
     VIRTUAL CLWrapper *getWeightsWrapper();
@@ -55,6 +56,10 @@ public:
     VIRTUAL CLWrapper *getGradInputWrapper();
     VIRTUAL bool hasOutputWrapper() const;
     VIRTUAL CLWrapper *getOutputWrapper();
+    VIRTUAL bool fuseActivation(ActivationFunction const *fn);
+    VIRTUAL void setInference(bool inference);
+    VIRTUAL bool takesOutputView() const;
+    VIRTUAL void setOutputView(CLDeviceWrapper *outputView);
     VIRTUAL bool needsBackProp();
     VIRTUAL void forward();
     VIRTUAL void backward();
@@ -12,6 +12,7 @@ PUBLICAPI Layer::Layer(Layer *previousLayer, LayerMaker2 *maker) :
     nextLayer(0),
     layerIndex(previousLayer == 0 ? 0 : previousLayer->layerIndex + 1),
     training(false),
+    inference(false),
     maker(maker)
      {
     if(previousLayer != 0) {
@@ -29,6 +30,14 @@ VIRTUAL Layer::~Layer() {
 PUBLICAPI VIRTUAL void Layer::setTraining(bool training) {
     this->training = training;
 }
+/// \brief no backward will ever be run, so setBatchSize can leave out the
+/// gradient buffers, and layers that takesOutputView() leave out their
+/// output too, and wait for setOutputView
+///
+/// call before setBatchSize, see NeuralNet::setInference
+PUBLICAPI VIRTUAL void Layer::setInference(bool inference) {
+    this->inference = inference;
+}
 /// used to set up internal buffers and stuff
 PUBLICAPI VIRTUAL void Layer::setBatchSize(int batchSize) {
     throw std::runtime_error("setBatchsize not implemetned for this layer type");
@@ -181,6 +190,11 @@ VIRTUAL bool Layer::needsTrainerState  () const {
 VIRTUAL void Layer::setTrainerState(TrainerStateMaker *trainerMaker) {
     throw std::runtime_error("setTrainer not implemented for " + getClassName());
 }
+// layer should copy its weights and bias into the arena, at these offsets,
+// and use views into the arena from now on, for weights, bias and their gradients
+VIRTUAL void Layer::setParameterArena(ParameterArena *arena, int weightsOffset, int biasOffset) {
+    throw std::runtime_error("setParameterArena not implemented for " + getClassName());
+}
 VIRTUAL TrainerState *Layer::getTrainerState() {
     throw std::runtime_error("getTrainerState not implemented for " + getClassName());
 }
@@ -190,4 +204,32 @@ VIRTUAL TrainerState *Layer::getBiasTrainerState() {
 VIRTUAL void Layer::updateWeights(CLWrapper *weightChangesWrapper, CLWrapper *biasChangesWrapper) {
     throw std::runtime_error("updateWeights not implemented for " + getClassName());
 }
+// offer the activation layer that follows us to be applied as part of our own
+// forward and backward, see NeuralNet::fuseLayers
+// returns false if we can't, and then nothing changes
+VIRTUAL bool Layer::fuseActivation(ActivationFunction const *fn) {
+    return false;
+}
+// true if our output is just our previous layer's output, handed on,
+// eg loss layers, so it lives in the same buffer
+VIRTUAL bool Layer::passesOutputThrough() const {
+    return false;
+}
+// true if, in inference, we write our output to a view that someone else
+// owns, see setOutputView and OutputArenas
+VIRTUAL bool Layer::takesOutputView() const {
+    return false;
+}
+// in inference, for layers that takesOutputView(): write our output to
+// outputView, from now on, rather than to a buffer of our own
+// outputView holds at least getOutputNumElements() floats, and is NOT
+// owned by us
+VIRTUAL void Layer::setOutputView(CLDeviceWrapper *outputView) {
+    throw std::runtime_error("setOutputView not implemented for " + getClassName());
+}
+// true while our forward, or, in training, backward, are still timing
+// kernels, for the current batchSize; see AutoTuner
+VIRTUAL bool Layer::isTuning() {
+    return false;
+}
 
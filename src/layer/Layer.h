@@ -22,6 +22,9 @@
 
 class TrainerState;
 class TrainerStateMaker;
+class ParameterArena;
+class CLWrapper;
+class CLDeviceWrapper;
 
 PUBLICAPI
 /// A single layer within the neural net
@@ -31,6 +34,7 @@ public:
     Layer *nextLayer;
     const int layerIndex;
     bool training;
+    bool inference; // no backward ever, so no gradient buffers, see NeuralNet::setInference
 
     LayerMaker2 *maker;
 
@@ -51,6 +55,7 @@ public:
     PUBLICAPI Layer(Layer *previousLayer, LayerMaker2 *maker);
     VIRTUAL ~Layer();
     PUBLICAPI VIRTUAL void setTraining(bool training);
+    PUBLICAPI VIRTUAL void setInference(bool inference);
     PUBLICAPI VIRTUAL void setBatchSize(int batchSize);
     VIRTUAL bool providesGradInputWrapper() const;
     VIRTUAL const char *getClassNameAsCharStar() const;
@@ -94,9 +99,15 @@ public:
     VIRTUAL const char *asNewCharStar() const;
     VIRTUAL bool needsTrainerState  () const;
     VIRTUAL void setTrainerState(TrainerStateMaker *trainerMaker);
+    VIRTUAL void setParameterArena(ParameterArena *arena, int weightsOffset, int biasOffset);
     VIRTUAL TrainerState *getTrainerState();
     VIRTUAL TrainerState *getBiasTrainerState();
     VIRTUAL void updateWeights(CLWrapper *weightChangesWrapper, CLWrapper *biasChangesWrapper);
+    VIRTUAL bool fuseActivation(ActivationFunction const *fn);
+    VIRTUAL bool passesOutputThrough() const;
+    VIRTUAL bool takesOutputView() const;
+    VIRTUAL void setOutputView(CLDeviceWrapper *outputView);
+    VIRTUAL bool isTuning();
 
     // [[[end]]]
 
@@ -29,6 +29,6 @@ Layer *CrossEntropyLossMaker::createLayer(Layer *previousLayer) {
     return new CrossEntropyLoss(previousLayer, this);
 }
 Layer *SoftMaxMaker::createLayer(Layer *previousLayer) {
-    return new SoftMaxLayer(previousLayer, this);
+    return new SoftMaxLayer(cl, previousLayer, this);
 }
 
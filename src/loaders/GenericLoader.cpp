@@ -11,6 +11,7 @@
 #include "Kgsv2Loader.h"
 #include "util/StatefulTimer.h"
 #include "loaders/MnistLoader.h"
+#include "loaders/MappedDatasetLoader.h"
 #include "DeepCLDllExport.h"
 #include "loaders/GenericLoader.h"
 
@@ -42,6 +43,11 @@ PUBLIC PUBLICAPI STATIC void GenericLoader::getDimensions(const char * trainFile
         NorbLoader::getDimensions(trainFilepath, p_numExamples, p_numPlanes, p_imageSize);
     } else if(headerInts[0] == 0x03080000) {
         MnistLoader::getDimensions(trainFilepath, p_numExamples, p_numPlanes, p_imageSize);
+    } else if(string(type) == "dcm1") {
+        MappedDatasetLoader loader(trainFilepath);
+        *p_numExamples = loader.getN();
+        *p_numPlanes = loader.getPlanes();
+        *p_imageSize = loader.getImageSize();
     } else {
         cout << "headstring" << type << endl;
         throw runtime_error(string("Filetype of ") + trainFilepath + " not recognised");
@@ -84,6 +90,9 @@ PUBLIC STATIC void GenericLoader::load(const char * trainFilepath, unsigned char
         NorbLoader::load(trainFilepath, images, labels, startN, numExamples);
     } else if(headerInts[0] == 0x03080000) {
         MnistLoader::load(trainFilepath, images, labels, startN, numExamples);
+    } else if(string(type) == "dcm1") {
+        MappedDatasetLoader loader(trainFilepath);
+        loader.load(images, labels, startN, numExamples);
     } else {
         cout << "headstring" << type << endl;
         throw runtime_error(string("Filetype of ") + trainFilepath + " not recognised");
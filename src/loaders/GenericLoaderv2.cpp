@@ -11,6 +11,8 @@
 #include "loaders/Loader.h"
 #include "loaders/GenericLoaderv1Wrapper.h"
 #include "loaders/GenericLoaderv2.h"
+#include "loaders/MappedDatasetLoader.h"
+#include "normalize/NormalizationHelper.h"
 
 #ifdef LIBJPEG_FOUND
 #include "loaders/ManifestLoaderv1.h"
@@ -27,10 +29,15 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
-PUBLIC GenericLoaderv2::GenericLoaderv2(std::string imagesFilepath) {
+PUBLIC GenericLoaderv2::GenericLoaderv2(std::string imagesFilepath) :
+        ucImages(0),
+        ucImagesAllocated(0) {
     loader = 0;
+    if(MappedDatasetLoader::isFormatFor(imagesFilepath)) {
+        loader = new MappedDatasetLoader(imagesFilepath);
+    }
     #ifdef LIBJPEG_FOUND
-    if(ManifestLoaderv1::isFormatFor(imagesFilepath) ) {
+    if(loader == 0 && ManifestLoaderv1::isFormatFor(imagesFilepath) ) {
         loader = new ManifestLoaderv1(imagesFilepath);
     }
     #endif
@@ -38,17 +45,53 @@ PUBLIC GenericLoaderv2::GenericLoaderv2(std::string imagesFilepath) {
         loader = new GenericLoaderv1Wrapper(imagesFilepath);
     }
 }
-
+// for a Loader that doesnt come from a file, eg a fake one, in tests; we
+// take ownership of loader
+PUBLIC GenericLoaderv2::GenericLoaderv2(Loader *loader) :
+        loader(loader),
+        ucImages(0),
+        ucImagesAllocated(0) {
+}
+PUBLIC GenericLoaderv2::~GenericLoaderv2() {
+    delete[] ucImages;
+    delete loader;
+}
 PUBLIC void GenericLoaderv2::load(float *images, int *labels, int startN, int numExamples) {
-    int linearSize =  numExamples * loader->getImageCubeSize();
-    unsigned char *ucImages = new unsigned char[ linearSize ];
+    load(images, labels, startN, numExamples, 0.0f, 1.0f);
+}
+// loads the images, and writes them out as (value + translate) * scale, in
+// one pass, eg so the NormalizationLayer doesnt need to do it again later
+// the byte buffer is kept between calls, so one loader shouldnt be used from
+// two threads at once
+PUBLIC void GenericLoaderv2::load(float *images, int *labels, int startN, int numExamples, float translate, float scale) {
+    int imageCubeSize = loader->getImageCubeSize();
+    int64 recordStride = 0;
+    unsigned char const *mappedImages = loader->mapRecords(startN, numExamples, labels, &recordStride);
+    if(mappedImages != 0) {
+        // convert straight out of the mapping, no byte buffer needed
+        StatefulTimer::timeCheck("GenericLoaderv2::load start");
+        if(recordStride == imageCubeSize) {
+            NormalizationHelper::translateAndScale(mappedImages, images, (int64)numExamples * imageCubeSize, translate, scale);
+        } else {
+            for(int n = 0; n < numExamples; n++) {
+                NormalizationHelper::translateAndScale(mappedImages + n * recordStride, images + (int64)n * imageCubeSize,
+                    imageCubeSize, translate, scale);
+            }
+        }
+        StatefulTimer::timeCheck("GenericLoaderv2::load end");
+        return;
+    }
+
+    int64 linearSize = (int64)numExamples * imageCubeSize;
+    if(linearSize > ucImagesAllocated) {
+        delete[] ucImages;
+        ucImages = new unsigned char[ linearSize ];
+        ucImagesAllocated = linearSize;
+    }
 
     load(ucImages, labels, startN, numExamples);
 
-    for(int i = 0; i < linearSize; i++) {
-        images[i] = ucImages[i];
-    }
-    delete[] ucImages;
+    NormalizationHelper::translateAndScale(ucImages, images, linearSize, translate, scale);
 }
 PUBLIC int GenericLoaderv2::getN() {
     return loader->getN();
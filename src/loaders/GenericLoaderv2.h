@@ -25,6 +25,9 @@ class DeepCL_EXPORT GenericLoaderv2 {
     private:
     Loader *loader;
 
+    unsigned char *ucImages;
+    int64 ucImagesAllocated;
+
     // [[[cog
     // import cog_addheaders
     // cog_addheaders.addv2()
@@ -33,7 +36,10 @@ class DeepCL_EXPORT GenericLoaderv2 {
 
     public:
     GenericLoaderv2(std::string imagesFilepath);
+    GenericLoaderv2(Loader *loader);
+    ~GenericLoaderv2();
     void load(float *images, int *labels, int startN, int numExamples);
+    void load(float *images, int *labels, int startN, int numExamples, float translate, float scale);
     int getN();
     int getPlanes();
     int getImageSize();
@@ -18,4 +18,13 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
+PUBLIC VIRTUAL Loader::~Loader() {
+}
+// loaders that keep the whole file mapped into memory can hand out a pointer
+// straight to the records, instead of copying them out with load()
+// records start *p_recordStride bytes apart.  labels are copied, as for load()
+// returns 0 if the loader cant do that, in which case use load()
+PUBLIC VIRTUAL unsigned char const *Loader::mapRecords(int startRecord, int numRecords, int *labels, int64 *p_recordStride) {
+    return 0;
+}
 
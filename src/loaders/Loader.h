@@ -11,6 +11,8 @@
 #include <iostream>
 #include <algorithm>
 
+#include "DeepCLDllExport.h"
+
 #define VIRTUAL virtual
 #define STATIC static
 
@@ -29,6 +31,10 @@ class Loader {
     // ]]]
     // generated, using cog:
 
+    public:
+    VIRTUAL ~Loader();
+    VIRTUAL unsigned char const *mapRecords(int startRecord, int numRecords, int *labels, int64 *p_recordStride);
+
     // [[[end]]]
 };
 
@@ -14,6 +14,7 @@
 #include "util/stringhelper.h"
 #include "ManifestLoaderv1.h"
 #include "util/JpegHelper.h"
+#include "util/ThreadPool.h"
 
 #include "DeepCLDllExport.h"
 
@@ -124,17 +125,34 @@ int ManifestLoaderv1::readIntValue(std::vector< std::string > splitLine, std::st
     }
     throw runtime_error("Key " + key + " not found in file header");
 }
+// decodes one jpeg per task, straight into its slot in the output
+class ManifestLoaderv1DecodeTask : public ThreadPoolTask {
+public:
+    std::string const *files;
+    int planes;
+    int size;
+    unsigned char *data;
+    ManifestLoaderv1DecodeTask(std::string const *files, int planes, int size, unsigned char *data) :
+        files(files),
+        planes(planes),
+        size(size),
+        data(data) {
+    }
+    virtual void run(int localN) {
+        JpegHelper::read(files[localN], planes, size, size, data + localN * planes * size * size);
+    }
+};
+
 PUBLIC VIRTUAL void ManifestLoaderv1::load(unsigned char *data, int *labels, int startRecord, int numRecords) {
-    int imageCubeSize = planes * size * size;
 //    cout << "ManifestLoaderv1, loading " << numRecords << " jpegs" << endl;
-    for(int localN = 0; localN < numRecords; localN++) {
-        int globalN = localN + startRecord;
-        JpegHelper::read(files[globalN], planes, size, size, data + localN * imageCubeSize);
-        if(labels != 0) {
-            if(!includeLabels) {
-                throw runtime_error("ManifestLoaderv1: labels reqested in load() method, but not activated in constructor");
-            }
-            labels[localN] = this->labels[globalN];
+    if(labels != 0 && !includeLabels) {
+        throw runtime_error("ManifestLoaderv1: labels reqested in load() method, but not activated in constructor");
+    }
+    ManifestLoaderv1DecodeTask task(files + startRecord, planes, size, data);
+    ThreadPool::instance()->run(numRecords, &task);
+    if(labels != 0) {
+        for(int localN = 0; localN < numRecords; localN++) {
+            labels[localN] = this->labels[localN + startRecord];
         }
     }
 }
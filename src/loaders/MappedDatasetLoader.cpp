@@ -0,0 +1,137 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+
+#include "util/FileHelper.h"
+#include "util/MappedFile.h"
+#include "util/stringhelper.h"
+#include "loaders/MappedDatasetLoader.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+PUBLIC STATIC bool MappedDatasetLoader::isFormatFor(std::string imagesFilepath) {
+    if(FileHelper::getFilesize(imagesFilepath) < (long)sizeof(MappedDatasetHeader)) {
+        return false;
+    }
+    char *headerBytes = FileHelper::readBinaryChunk(imagesFilepath, 0, 4);
+    bool matched = strncmp(headerBytes, "dcm1", 4) == 0;
+    delete[] headerBytes;
+    return matched;
+}
+// page-aligned, so the records start on a page boundary
+PUBLIC STATIC long long MappedDatasetLoader::getDataOffset() {
+    return 4096;
+}
+PUBLIC STATIC MappedDatasetHeader MappedDatasetLoader::makeHeader(int N, int planes, int imageSize, bool hasLabels) {
+    MappedDatasetHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "dcm1", 4);
+    header.version = 1;
+    header.N = N;
+    header.planes = planes;
+    header.imageSize = imageSize;
+    int imageCubeSize = planes * imageSize * imageSize;
+    header.recordStride = (imageCubeSize + 15) / 16 * 16;
+    header.hasLabels = hasLabels ? 1 : 0;
+    header.dataOffset = getDataOffset();
+    long long dataEnd = header.dataOffset + (long long)N * header.recordStride;
+    header.labelsOffset = hasLabels ? (dataEnd + 4095) / 4096 * 4096 : 0;
+    return header;
+}
+PUBLIC MappedDatasetLoader::MappedDatasetLoader(std::string imagesFilepath) :
+        file(0) {
+    if(!isFormatFor(imagesFilepath)) {
+        throw runtime_error("file " + imagesFilepath + " is not a deepcl mapped dataset file");
+    }
+    file = new MappedFile(imagesFilepath);
+    memcpy(&header, file->getData(), sizeof(header));
+    if(header.version != 1) {
+        delete file;
+        throw runtime_error("file " + imagesFilepath + " is deepcl mapped dataset version " +
+            toString(header.version) + ", only version 1 is handled");
+    }
+    imageCubeSize = header.planes * header.imageSize * header.imageSize;
+    long long expectedSize = header.hasLabels ? header.labelsOffset + (long long)header.N * sizeof(int) :
+        header.dataOffset + (long long)header.N * header.recordStride;
+    if((long long)file->getSize() < expectedSize) {
+        delete file;
+        throw runtime_error("file " + imagesFilepath + " is truncated: expected at least " +
+            toString(expectedSize) + " bytes");
+    }
+    cout << "mapped dataset " << imagesFilepath << " N=" << header.N << " planes=" << header.planes <<
+        " size=" << header.imageSize << endl;
+}
+PUBLIC VIRTUAL MappedDatasetLoader::~MappedDatasetLoader() {
+    delete file;
+}
+PUBLIC VIRTUAL std::string MappedDatasetLoader::getType() {
+    return "MappedDatasetLoader";
+}
+PUBLIC VIRTUAL int MappedDatasetLoader::getImageCubeSize() {
+    return imageCubeSize;
+}
+PUBLIC VIRTUAL int MappedDatasetLoader::getN() {
+    return header.N;
+}
+PUBLIC VIRTUAL int MappedDatasetLoader::getPlanes() {
+    return header.planes;
+}
+PUBLIC VIRTUAL int MappedDatasetLoader::getImageSize() {
+    return header.imageSize;
+}
+PUBLIC bool MappedDatasetLoader::hasLabels() const {
+    return header.hasLabels != 0;
+}
+// numRecords 0 means all of them, like the other loaders
+PUBLIC VIRTUAL void MappedDatasetLoader::load(unsigned char *data, int *labels, int startRecord, int numRecords) {
+    if(numRecords == 0) {
+        numRecords = header.N - startRecord;
+    }
+    int64 recordStride = 0;
+    unsigned char const *records = mapRecords(startRecord, numRecords, labels, &recordStride);
+    if(recordStride == imageCubeSize) {
+        memcpy(data, records, (size_t)((int64)numRecords * imageCubeSize));
+    } else {
+        for(int n = 0; n < numRecords; n++) {
+            memcpy(data + (int64)n * imageCubeSize, records + n * recordStride, imageCubeSize);
+        }
+    }
+}
+// also asks the os to start reading in the same number of records after these,
+// since callers usually work through the file in order
+PUBLIC VIRTUAL unsigned char const *MappedDatasetLoader::mapRecords(int startRecord, int numRecords, int *labels, int64 *p_recordStride) {
+    checkRange(startRecord, numRecords);
+    if(labels != 0) {
+        memcpy(labels, mapLabels(startRecord, numRecords), numRecords * sizeof(int));
+    }
+    long long offset = header.dataOffset + (long long)startRecord * header.recordStride;
+    long long length = (long long)numRecords * header.recordStride;
+    file->adviseWillNeed(offset + length, length);
+    *p_recordStride = header.recordStride;
+    return file->getData() + offset;
+}
+PUBLIC int const *MappedDatasetLoader::mapLabels(int startRecord, int numRecords) {
+    checkRange(startRecord, numRecords);
+    if(!header.hasLabels) {
+        throw runtime_error("MappedDatasetLoader: labels requested, but " + file->getFilepath() + " doesnt have any");
+    }
+    return reinterpret_cast< int const * >(file->getData() + header.labelsOffset) + startRecord;
+}
+PRIVATE void MappedDatasetLoader::checkRange(int startRecord, int numRecords) {
+    if(startRecord < 0 || numRecords < 0 || startRecord + numRecords > header.N) {
+        throw runtime_error("MappedDatasetLoader: records " + toString(startRecord) + " to " +
+            toString(startRecord + numRecords) + " out of range, N=" + toString(header.N));
+    }
+}
+
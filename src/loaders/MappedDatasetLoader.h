@@ -0,0 +1,79 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+
+#include "loaders/Loader.h"
+
+#include "DeepCLDllExport.h"
+
+class MappedFile;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// fixed 64-byte header, at the start of a deepcl mapped dataset file
+// layout on disk:
+//   header, padded out to dataOffset (page-aligned)
+//   N records, recordStride bytes apart, each one planes x imageSize x imageSize
+//     unsigned chars, padded out to a multiple of 16 bytes
+//   if hasLabels, N ints, at labelsOffset (page-aligned)
+// all little-endian
+class DeepCL_EXPORT MappedDatasetHeader {
+public:
+    char magic[4]; // "dcm1"
+    int version;
+    int N;
+    int planes;
+    int imageSize;
+    int recordStride;
+    int hasLabels;
+    int reserved;
+    long long dataOffset;
+    long long labelsOffset;
+    char padding[16];
+};
+
+// loads the deepcl mapped dataset format, by mapping the whole file into
+// memory, so reads need no buffers, and no copies beyond the one into the
+// caller's array; and mapRecords() avoids even that one
+// use MappedDatasetWriter, or the convert-to-mapped tool, to create them
+class DeepCL_EXPORT MappedDatasetLoader : public Loader {
+    private:
+    MappedFile *file;
+    MappedDatasetHeader header;
+    int imageCubeSize;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC bool isFormatFor(std::string imagesFilepath);
+    STATIC long long getDataOffset();
+    STATIC MappedDatasetHeader makeHeader(int N, int planes, int imageSize, bool hasLabels);
+    MappedDatasetLoader(std::string imagesFilepath);
+    VIRTUAL ~MappedDatasetLoader();
+    VIRTUAL std::string getType();
+    VIRTUAL int getImageCubeSize();
+    VIRTUAL int getN();
+    VIRTUAL int getPlanes();
+    VIRTUAL int getImageSize();
+    bool hasLabels() const;
+    VIRTUAL void load(unsigned char *data, int *labels, int startRecord, int numRecords);
+    VIRTUAL unsigned char const *mapRecords(int startRecord, int numRecords, int *labels, int64 *p_recordStride);
+    int const *mapLabels(int startRecord, int numRecords);
+
+    private:
+    void checkRange(int startRecord, int numRecords);
+
+    // [[[end]]]
+};
+
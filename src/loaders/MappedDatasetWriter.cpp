@@ -0,0 +1,105 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+
+#include "util/FileHelper.h"
+#include "util/stringhelper.h"
+#include "loaders/MappedDatasetWriter.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+// pass labels as false if there are no labels, and then pass 0 for labels
+// to append()
+PUBLIC MappedDatasetWriter::MappedDatasetWriter(std::string filepath, int N, int planes, int imageSize, bool hasLabels) :
+        filepath(filepath),
+        numWritten(0),
+        closed(false) {
+    header = MappedDatasetLoader::makeHeader(N, planes, imageSize, hasLabels);
+    imageCubeSize = planes * imageSize * imageSize;
+    string tempPath = FileHelper::localizePath(filepath + "~");
+    out.open(tempPath.c_str(), ios::out | ios::binary | ios::trunc);
+    if(!out) {
+        throw runtime_error("failed to open " + tempPath + " for writing");
+    }
+    out.write(reinterpret_cast< char const * >(&header), sizeof(header));
+    seekTo(header.dataOffset);
+}
+PUBLIC MappedDatasetWriter::~MappedDatasetWriter() {
+    if(!closed) {
+        out.close();
+        FileHelper::remove(filepath + "~");
+    }
+}
+PUBLIC void MappedDatasetWriter::append(unsigned char const *images, int const *labels, int numRecords) {
+    if(numWritten + numRecords > header.N) {
+        throw runtime_error("MappedDatasetWriter: writing more than the " + toString(header.N) + " records declared");
+    }
+    if(header.hasLabels && labels == 0) {
+        throw runtime_error("MappedDatasetWriter: labels needed for " + filepath);
+    }
+    char padding[16];
+    memset(padding, 0, sizeof(padding));
+    int paddingSize = header.recordStride - imageCubeSize;
+    seekTo(header.dataOffset + (long long)numWritten * header.recordStride);
+    for(int n = 0; n < numRecords; n++) {
+        out.write(reinterpret_cast< char const * >(images + (long)n * imageCubeSize), imageCubeSize);
+        out.write(padding, paddingSize);
+    }
+    if(header.hasLabels) {
+        seekTo(header.labelsOffset + (long long)numWritten * sizeof(int));
+        out.write(reinterpret_cast< char const * >(labels), numRecords * sizeof(int));
+    }
+    if(!out) {
+        throw runtime_error("MappedDatasetWriter: failed writing to " + filepath + "~");
+    }
+    numWritten += numRecords;
+}
+// checks all the records were written, then moves the file into place
+PUBLIC void MappedDatasetWriter::close() {
+    if(numWritten != header.N) {
+        throw runtime_error("MappedDatasetWriter: only " + toString(numWritten) + " of " +
+            toString(header.N) + " records written to " + filepath);
+    }
+    // make sure the file reaches the end of the last section, even if it's empty
+    if(header.hasLabels) {
+        seekTo(header.labelsOffset + (long long)header.N * sizeof(int));
+    } else {
+        seekTo(header.dataOffset + (long long)header.N * header.recordStride);
+    }
+    out.close();
+    if(!out) {
+        throw runtime_error("MappedDatasetWriter: failed writing to " + filepath + "~");
+    }
+    FileHelper::remove(filepath);
+    FileHelper::rename(filepath + "~", filepath);
+    closed = true;
+}
+// extends the file with zeros if needed, so everything between the
+// sections is zero padding
+PRIVATE void MappedDatasetWriter::seekTo(long long offset) {
+    out.seekp(0, ios::end);
+    long long end = (long long)out.tellp();
+    if(end < offset) {
+        char zeros[4096];
+        memset(zeros, 0, sizeof(zeros));
+        while(end < offset) {
+            long long toWrite = offset - end < (long long)sizeof(zeros) ? offset - end : (long long)sizeof(zeros);
+            out.write(zeros, (streamsize)toWrite);
+            end += toWrite;
+        }
+    } else {
+        out.seekp((streamoff)offset, ios::beg);
+    }
+}
+
@@ -0,0 +1,54 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <fstream>
+
+#include "loaders/MappedDatasetLoader.h"
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// writes a deepcl mapped dataset file (see MappedDatasetLoader), a few
+// records at a time, so the whole dataset never needs to be in memory
+// the file is written to filepath~, and renamed into place by close()
+class DeepCL_EXPORT MappedDatasetWriter {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::string filepath;
+    std::ofstream out;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    MappedDatasetHeader header;
+    int imageCubeSize;
+    int numWritten;
+    bool closed;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    MappedDatasetWriter(std::string filepath, int N, int planes, int imageSize, bool hasLabels);
+    ~MappedDatasetWriter();
+    void append(unsigned char const *images, int const *labels, int numRecords);
+    void close();
+
+    private:
+    void seekTo(long long offset);
+
+    // [[[end]]]
+};
+
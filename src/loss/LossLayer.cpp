@@ -26,6 +26,9 @@ VIRTUAL bool LossLayer::needsBackProp() {
 VIRTUAL float *LossLayer::getOutput() {
     return previousLayer->getOutput();
 }
+VIRTUAL bool LossLayer::passesOutputThrough() const {
+    return true;
+}
 VIRTUAL int LossLayer::getOutputNumElements() const {
     return previousLayer->getOutputNumElements();
 }
@@ -4,7 +4,13 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <cstring>
+
 #include "util/StatefulTimer.h"
+#include "util/AllocationCounter.h"
+#include "clmath/CLWrapperCache.h"
+#include "clmath/CLDeviceWrapper.h"
+#include "clmath/HostStagingPool.h"
 
 #include "layer/LayerMaker.h"
 #include "loss/SoftMaxLayer.h"
@@ -16,83 +22,425 @@ using namespace std;
 #undef STATIC
 #define STATIC
 
-SoftMaxLayer::SoftMaxLayer(Layer *previousLayer, SoftMaxMaker *maker) :
+SoftMaxLayer::SoftMaxLayer(EasyCL *cl, Layer *previousLayer, SoftMaxMaker *maker) :
     LossLayer(previousLayer, maker),
         perPlane(maker->_perPlane),
         imageSize(previousLayer->getOutputSize()),
         numPlanes(previousLayer->getOutputPlanes()),
         imageSizeSquared(previousLayer->getOutputSize() * previousLayer->getOutputSize()),
-        output(0),
-        gradInput(0),
+        cl(cl),
+        forwardKernel(0),
+        lossKernel(0),
+        upstreamWrapperCache(0),
+        labels(0),
+        outputWrapper(0),
+        gradInputWrapper(0),
+        labelsWrapper(0),
+        lossWrapper(0),
+        numRightWrapper(0),
+        inputWrapper(0),
+        outputStale(false),
+        labelResultsValid(false),
         allocatedSize(0),
         batchSize(0)
          {
+    upstreamWrapperCache = new CLWrapperCache(cl);
+    lossTotal[0] = 0;
+    numRightTotal[0] = 0;
+    lossWrapper = cl->wrap(1, lossTotal);
+    numRightWrapper = cl->wrap(1, numRightTotal);
+    lossWrapper->createOnDevice();
+    numRightWrapper->createOnDevice();
+
+    if(cl->kernelExists("softmaxForward")) {
+        forwardKernel = cl->getKernel("softmaxForward");
+        lossKernel = cl->getKernel("softmaxLossFromLabels");
+        return;
+    }
+    string options = "";
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("forwardKernel", "cl/softmax.cl", "softmaxForward", 'options')
+    // stringify.write_kernel2("lossKernel", "cl/softmax.cl", "softmaxLossFromLabels", 'options')
+    // ]]]
+    // generated using cog, from cl/softmax.cl:
+    const char * forwardKernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// the input is numVectors contiguous vectors, of vectorSize values each, and\n"
+    "// each vector gets its own softmax: one per plane, for perPlane, otherwise\n"
+    "// one per example, over the planes\n"
+    "\n"
+    "// one work item per vector\n"
+    "kernel void softmaxForward(\n"
+    "        const int numVectors,\n"
+    "        const int vectorSize,\n"
+    "        global const float *input,\n"
+    "        global float *output) {\n"
+    "    const int vectorId = get_global_id(0);\n"
+    "    if (vectorId >= numVectors) {\n"
+    "        return;\n"
+    "    }\n"
+    "    global const float *in = input + vectorId * vectorSize;\n"
+    "    global float *out = output + vectorId * vectorSize;\n"
+    "    float maxValue = in[0];\n"
+    "    for (int i = 1; i < vectorSize; i++) {\n"
+    "        maxValue = max(maxValue, in[i]);\n"
+    "    }\n"
+    "    float denominator = 0;\n"
+    "    for (int i = 0; i < vectorSize; i++) {\n"
+    "        denominator += exp(in[i] - maxValue);\n"
+    "    }\n"
+    "    for (int i = 0; i < vectorSize; i++) {\n"
+    "        out[i] = exp(in[i] - maxValue) / denominator;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// a single workgroup, whose size is a power of two, strides over the vectors,\n"
+    "// and, for each, does the softmax, as softmaxForward, then the gradient,\n"
+    "// output minus one-hot label, the cross-entropy loss, -log(output[label]),\n"
+    "// and whether the largest output is at the label\n"
+    "// the losses and the counts are summed across the workgroup, so only those\n"
+    "// two totals need to go back to the host\n"
+    "// if inputIsSoftmax, input already holds the probabilities, and is output\n"
+    "kernel void softmaxLossFromLabels(\n"
+    "        const int numVectors,\n"
+    "        const int vectorSize,\n"
+    "        const int inputIsSoftmax,\n"
+    "        global const int *labels,\n"
+    "        global const float *input,\n"
+    "        global float *output,\n"
+    "        global float *gradInput,\n"
+    "        global float *lossTotal,\n"
+    "        global int *numRightTotal,\n"
+    "        local float *losses,\n"
+    "        local int *numRights) {\n"
+    "    const int localId = get_local_id(0);\n"
+    "    const int workgroupSize = get_local_size(0);\n"
+    "    float loss = 0;\n"
+    "    int numRight = 0;\n"
+    "    for (int vectorId = localId; vectorId < numVectors; vectorId += workgroupSize) {\n"
+    "        global const float *in = input + vectorId * vectorSize;\n"
+    "        global float *out = output + vectorId * vectorSize;\n"
+    "        global float *grad = gradInput + vectorId * vectorSize;\n"
+    "        const int label = labels[vectorId];\n"
+    "        float maxValue = in[0];\n"
+    "        float denominator = 1;\n"
+    "        if (!inputIsSoftmax) {\n"
+    "            for (int i = 1; i < vectorSize; i++) {\n"
+    "                maxValue = max(maxValue, in[i]);\n"
+    "            }\n"
+    "            denominator = 0;\n"
+    "            for (int i = 0; i < vectorSize; i++) {\n"
+    "                denominator += exp(in[i] - maxValue);\n"
+    "            }\n"
+    "        }\n"
+    "        float bestValue = -1;\n"
+    "        int best = 0;\n"
+    "        for (int i = 0; i < vectorSize; i++) {\n"
+    "            float value = inputIsSoftmax ? in[i] : exp(in[i] - maxValue) / denominator;\n"
+    "            out[i] = value;\n"
+    "            grad[i] = i == label ? value - 1.0f : value;\n"
+    "            if (value > bestValue) {\n"
+    "                bestValue = value;\n"
+    "                best = i;\n"
+    "            }\n"
+    "        }\n"
+    "        loss -= log(out[label]);\n"
+    "        numRight += best == label ? 1 : 0;\n"
+    "    }\n"
+    "    losses[localId] = loss;\n"
+    "    numRights[localId] = numRight;\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "    for (int offset = workgroupSize >> 1; offset > 0; offset >>= 1) {\n"
+    "        if (localId < offset) {\n"
+    "            losses[localId] += losses[localId + offset];\n"
+    "            numRights[localId] += numRights[localId + offset];\n"
+    "        }\n"
+    "        barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "    }\n"
+    "    if (localId == 0) {\n"
+    "        lossTotal[0] = losses[0];\n"
+    "        numRightTotal[0] = numRights[0];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "";
+    forwardKernel = cl->buildKernelFromString(forwardKernelSource, "softmaxForward", options, "cl/softmax.cl");
+    // generated using cog, from cl/softmax.cl:
+    const char * lossKernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// the input is numVectors contiguous vectors, of vectorSize values each, and\n"
+    "// each vector gets its own softmax: one per plane, for perPlane, otherwise\n"
+    "// one per example, over the planes\n"
+    "\n"
+    "// one work item per vector\n"
+    "kernel void softmaxForward(\n"
+    "        const int numVectors,\n"
+    "        const int vectorSize,\n"
+    "        global const float *input,\n"
+    "        global float *output) {\n"
+    "    const int vectorId = get_global_id(0);\n"
+    "    if (vectorId >= numVectors) {\n"
+    "        return;\n"
+    "    }\n"
+    "    global const float *in = input + vectorId * vectorSize;\n"
+    "    global float *out = output + vectorId * vectorSize;\n"
+    "    float maxValue = in[0];\n"
+    "    for (int i = 1; i < vectorSize; i++) {\n"
+    "        maxValue = max(maxValue, in[i]);\n"
+    "    }\n"
+    "    float denominator = 0;\n"
+    "    for (int i = 0; i < vectorSize; i++) {\n"
+    "        denominator += exp(in[i] - maxValue);\n"
+    "    }\n"
+    "    for (int i = 0; i < vectorSize; i++) {\n"
+    "        out[i] = exp(in[i] - maxValue) / denominator;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// a single workgroup, whose size is a power of two, strides over the vectors,\n"
+    "// and, for each, does the softmax, as softmaxForward, then the gradient,\n"
+    "// output minus one-hot label, the cross-entropy loss, -log(output[label]),\n"
+    "// and whether the largest output is at the label\n"
+    "// the losses and the counts are summed across the workgroup, so only those\n"
+    "// two totals need to go back to the host\n"
+    "// if inputIsSoftmax, input already holds the probabilities, and is output\n"
+    "kernel void softmaxLossFromLabels(\n"
+    "        const int numVectors,\n"
+    "        const int vectorSize,\n"
+    "        const int inputIsSoftmax,\n"
+    "        global const int *labels,\n"
+    "        global const float *input,\n"
+    "        global float *output,\n"
+    "        global float *gradInput,\n"
+    "        global float *lossTotal,\n"
+    "        global int *numRightTotal,\n"
+    "        local float *losses,\n"
+    "        local int *numRights) {\n"
+    "    const int localId = get_local_id(0);\n"
+    "    const int workgroupSize = get_local_size(0);\n"
+    "    float loss = 0;\n"
+    "    int numRight = 0;\n"
+    "    for (int vectorId = localId; vectorId < numVectors; vectorId += workgroupSize) {\n"
+    "        global const float *in = input + vectorId * vectorSize;\n"
+    "        global float *out = output + vectorId * vectorSize;\n"
+    "        global float *grad = gradInput + vectorId * vectorSize;\n"
+    "        const int label = labels[vectorId];\n"
+    "        float maxValue = in[0];\n"
+    "        float denominator = 1;\n"
+    "        if (!inputIsSoftmax) {\n"
+    "            for (int i = 1; i < vectorSize; i++) {\n"
+    "                maxValue = max(maxValue, in[i]);\n"
+    "            }\n"
+    "            denominator = 0;\n"
+    "            for (int i = 0; i < vectorSize; i++) {\n"
+    "                denominator += exp(in[i] - maxValue);\n"
+    "            }\n"
+    "        }\n"
+    "        float bestValue = -1;\n"
+    "        int best = 0;\n"
+    "        for (int i = 0; i < vectorSize; i++) {\n"
+    "            float value = inputIsSoftmax ? in[i] : exp(in[i] - maxValue) / denominator;\n"
+    "            out[i] = value;\n"
+    "            grad[i] = i == label ? value - 1.0f : value;\n"
+    "            if (value > bestValue) {\n"
+    "                bestValue = value;\n"
+    "                best = i;\n"
+    "            }\n"
+    "        }\n"
+    "        loss -= log(out[label]);\n"
+    "        numRight += best == label ? 1 : 0;\n"
+    "    }\n"
+    "    losses[localId] = loss;\n"
+    "    numRights[localId] = numRight;\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "    for (int offset = workgroupSize >> 1; offset > 0; offset >>= 1) {\n"
+    "        if (localId < offset) {\n"
+    "            losses[localId] += losses[localId + offset];\n"
+    "            numRights[localId] += numRights[localId + offset];\n"
+    "        }\n"
+    "        barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "    }\n"
+    "    if (localId == 0) {\n"
+    "        lossTotal[0] = losses[0];\n"
+    "        numRightTotal[0] = numRights[0];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "";
+    lossKernel = cl->buildKernelFromString(lossKernelSource, "softmaxLossFromLabels", options, "cl/softmax.cl");
+    // [[[end]]]
+    cl->storeKernel("softmaxForward", forwardKernel, true);
+    cl->storeKernel("softmaxLossFromLabels", lossKernel, true);
 }
 VIRTUAL SoftMaxLayer::~SoftMaxLayer() {
-    if(gradInput != 0) {
-        delete[] gradInput;
+    delete upstreamWrapperCache;
+    delete lossWrapper;
+    delete numRightWrapper;
+    if(outputWrapper != 0) {
+        delete outputWrapper;
+        delete gradInputWrapper;
+        delete labelsWrapper;
     }
-    if(output != 0) {
-        delete[] output;
+    if(labels != 0) {
+        delete[] labels;
     }
 }
 VIRTUAL std::string SoftMaxLayer::getClassName() const {
     return "SoftMaxLayer";
 }
 VIRTUAL float *SoftMaxLayer::getOutput() {
-    return output;
+    updateOutput();
+    return outputWrapper->copyToStaging();
+}
+// unlike the other loss layers, we have an output of our own
+VIRTUAL bool SoftMaxLayer::passesOutputThrough() const {
+    return false;
+}
+VIRTUAL bool SoftMaxLayer::hasOutputWrapper() const {
+    return true;
+}
+VIRTUAL CLWrapper *SoftMaxLayer::getOutputWrapper() {
+    updateOutput();
+    return outputWrapper;
 }
 VIRTUAL float *SoftMaxLayer::getGradInput() {
-    return gradInput;
+    return gradInputWrapper->copyToStaging();
+}
+VIRTUAL bool SoftMaxLayer::providesGradInputWrapper() const {
+    return true;
+}
+VIRTUAL CLWrapper *SoftMaxLayer::getGradInputWrapper() {
+    return gradInputWrapper;
+}
+/// \brief for when the probabilities come from elsewhere, eg MultiNet
+/// averaging its children, rather than from forward
+VIRTUAL void SoftMaxLayer::setOutput(float const *probabilities) {
+    outputWrapper->copyFromHost(probabilities);
+    setOutputWritten();
+}
+/// \brief as setOutput, for when the probabilities were written straight
+/// into outputWrapper, on the device
+VIRTUAL void SoftMaxLayer::setOutputWritten() {
+    outputStale = false;
+    inputWrapper = 0;
+    labelResultsValid = false;
 }
 VIRTUAL void SoftMaxLayer::setBatchSize(int batchSize) {
     this->batchSize = batchSize;
     if(batchSize <= this->allocatedSize) {
         return;
     }
-    if(output != 0) {
-        delete[] output;
+    if(outputWrapper != 0) {
+        delete outputWrapper;
+        delete gradInputWrapper;
+        delete labelsWrapper;
     }
-    if(gradInput != 0) {
-        delete[] gradInput;
+    if(labels != 0) {
+        delete[] labels;
     }
-    output = new float[ getOutputNumElements() ];
-    gradInput = new float[ previousLayer-> getOutputNumElements() ];
+    labels = new int[ getNumVectors() ];
+    outputWrapper = new CLDeviceWrapper(cl, getOutputNumElements());
+    gradInputWrapper = new CLDeviceWrapper(cl, previousLayer->getOutputNumElements());
+    labelsWrapper = cl->wrap(getNumVectors(), labels);
+    labelsWrapper->createOnDevice();
+    AllocationCounter::countAllocation();
     allocatedSize = batchSize;
+    outputStale = false;
+    labelResultsValid = false;
 }
 VIRTUAL int SoftMaxLayer::getBatchSize() {
     return this->batchSize;
 }
-// need to calculate multinomial logistic /cross-entropy loss
-VIRTUAL float SoftMaxLayer::calcLossFromLabels(int const *labels) {
-//    cout << "softmaxlayer::calcloss" << endl;
-    StatefulTimer::timeCheck("start SoftMaxLayer calcLossfromlabels");
-    float loss = 0;
-    if(perPlane) {
-        for(int n = 0; n < batchSize; n++) {
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int label = labels[n * numPlanes + plane];
-                int imageOffset = (n * numPlanes + plane) * imageSizeSquared;
-                loss += - log(output[ imageOffset + label ]);
-            }
-        }
-    } else {
-        // force imagesize of 1 for now
-        if(imageSize != 1) {
-            throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-        }
-        for(int n = 0; n < batchSize; n++) {
-            int imageOffset = n * numPlanes * imageSizeSquared;
-            int label = labels[n];
-            loss += - log(output[imageOffset + label]);
+// each softmax is over one contiguous vector: a plane, if perPlane, otherwise
+// the planes of one example, since imageSize is 1
+VIRTUAL int SoftMaxLayer::getNumVectors() const {
+    return perPlane ? batchSize * numPlanes : batchSize;
+}
+VIRTUAL int SoftMaxLayer::getVectorSize() const {
+    return perPlane ? imageSizeSquared : numPlanes;
+}
+// does the softmax, if forward was called since the output was last made
+VIRTUAL void SoftMaxLayer::updateOutput() {
+    if(!outputStale) {
+        return;
+    }
+    StatefulTimer::timeCheck("start SoftMaxLayer updateOutput");
+    int numVectors = getNumVectors();
+    forwardKernel->in(numVectors)
+                 ->in(getVectorSize())
+                 ->in(inputWrapper)
+                 ->out(outputWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (numVectors + workgroupSize - 1) / workgroupSize;
+    forwardKernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    outputStale = false;
+    StatefulTimer::timeCheck("end SoftMaxLayer updateOutput");
+}
+// runs the fused kernel: softmax, gradInput, loss and numRight, for these
+// labels, unless it already ran for the same labels since the last forward
+// only the labels go up, and only loss and numRight come back
+VIRTUAL void SoftMaxLayer::calcFromLabels(int const *labels) {
+    int numVectors = getNumVectors();
+    int vectorSize = getVectorSize();
+    if(labelResultsValid && memcmp(this->labels, labels, sizeof(int) * numVectors) == 0) {
+        return;
+    }
+    StatefulTimer::timeCheck("start SoftMaxLayer calcFromLabels");
+    for(int i = 0; i < numVectors; i++) {
+        int label = labels[i];
+        if(label >= vectorSize) {
+            throw runtime_error("Label " + toString(label) + " exceeds number of softmax planes " + toString(vectorSize) );
+        } else if(label < 0) {
+            throw runtime_error("Label " + toString(label) + " negative");
         }
     }
-    StatefulTimer::timeCheck("end SoftMaxLayer calcLossfromlabels");
-    return loss;
+    memcpy(this->labels, labels, sizeof(int) * numVectors);
+    labelsWrapper->copyToDevice();
+
+    int workgroupSize = 1;
+    while(workgroupSize * 2 <= std::min(256, cl->getMaxWorkgroupSize())) {
+        workgroupSize *= 2;
+    }
+    // after setOutput, there's no input, just the probabilities
+    bool inputIsSoftmax = inputWrapper == 0;
+    lossKernel->in(numVectors)
+              ->in(vectorSize)
+              ->in(inputIsSoftmax ? 1 : 0)
+              ->in(labelsWrapper)
+              ->in(inputIsSoftmax ? outputWrapper : inputWrapper)
+              ->out(outputWrapper)
+              ->out(gradInputWrapper)
+              ->out(lossWrapper)
+              ->out(numRightWrapper)
+              ->localFloats(workgroupSize)
+              ->localInts(workgroupSize);
+    lossKernel->run_1d(workgroupSize, workgroupSize);
+    lossWrapper->copyToHost();
+    numRightWrapper->copyToHost();
+    outputStale = false;
+    labelResultsValid = true;
+    StatefulTimer::timeCheck("end SoftMaxLayer calcFromLabels");
+}
+// need to calculate multinomial logistic /cross-entropy loss
+VIRTUAL float SoftMaxLayer::calcLossFromLabels(int const *labels) {
+    calcFromLabels(labels);
+    return lossTotal[0];
 }
 // need to calculate multinomial logistic /cross-entropy loss
 VIRTUAL float SoftMaxLayer::calcLoss(float const *expectedValues) {
     StatefulTimer::timeCheck("start SoftMaxLayer calcLoss");
+    float const *output = getOutput();
     float loss = 0;
     if(perPlane) {
         for(int n = 0; n < batchSize; n++) {
@@ -126,39 +474,7 @@ VIRTUAL float SoftMaxLayer::calcLoss(float const *expectedValues) {
 // (multinomial cross-entropy) loss derivative wrt our output, and
 // derivative of softmax wrt our inputs
 VIRTUAL void SoftMaxLayer::calcGradInputFromLabels(int const *labels) {
-//    cout << "softmaxlayer::calcerrors" << endl;
-    StatefulTimer::timeCheck("start SoftMaxLayer calcGradInputfromlabels");
-    if(perPlane) {
-        for(int n = 0; n < batchSize; n++) {
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int imageOffset = (n * numPlanes + plane) * imageSizeSquared;
-                int label = labels[n * numPlanes + plane];
-                for(int i = 0; i < imageSizeSquared; i++) {
-                    gradInput[imageOffset + i] = output[imageOffset + i];
-                }
-                gradInput[imageOffset + label] -= 1;
-            }
-        }
-    } else {
-        // force imagesize of 1 for now
-        if(imageSize != 1) {
-            throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-        }
-        for(int n = 0; n < batchSize; n++) {
-            int imageOffset = n * numPlanes * imageSizeSquared;
-            int label = labels[n];
-            for(int plane = 0; plane < numPlanes; plane++) {
-                gradInput[imageOffset + plane] = output[imageOffset + plane];
-            }
-            if(label >= numPlanes) {
-                throw runtime_error("Label " + toString(label) + " exceeds number of softmax planes " + toString(numPlanes) );
-            } else if(label < 0) {
-                throw runtime_error("Label " + toString(label) + " negative");
-            }
-            gradInput[imageOffset + label] -= 1;
-        }
-    }
-    StatefulTimer::timeCheck("end SoftMaxLayer calcGradInputfromlabels");
+    calcFromLabels(labels);
 }
 // calculate partial deriv loss wrt our inputs, in other words, product of
 // (multinomial cross-entropy) loss derivative wrt our output, and
@@ -166,6 +482,10 @@ VIRTUAL void SoftMaxLayer::calcGradInputFromLabels(int const *labels) {
 VIRTUAL void SoftMaxLayer::calcGradInput(float const *expectedValues) {
 //    cout << "softmaxlayer::calcerrors" << endl;
     StatefulTimer::timeCheck("start SoftMaxLayer calcGradInput");
+    float const *output = getOutput();
+    // worked out on the host, then uploaded, so there's nothing to read back first
+    int gradInputCapacity = 0;
+    float *gradInput = HostStagingPool::acquire(previousLayer->getOutputNumElements(), &gradInputCapacity);
     if(perPlane) {
         for(int n = 0; n < batchSize; n++) {
             for(int plane = 0; plane < numPlanes; plane++) {
@@ -189,6 +509,9 @@ VIRTUAL void SoftMaxLayer::calcGradInput(float const *expectedValues) {
             }
         }
     }
+    gradInputWrapper->copyFromHost(gradInput);
+    HostStagingPool::release(gradInput, gradInputCapacity);
+    labelResultsValid = false;
     StatefulTimer::timeCheck("end SoftMaxLayer calcGradInput");
 }
 VIRTUAL int SoftMaxLayer::getNumLabelsPerExample() {
@@ -202,99 +525,26 @@ VIRTUAL int SoftMaxLayer::getPersistSize(int version) const {
     return 0;
 }
 VIRTUAL int SoftMaxLayer::calcNumRightFromLabels(int const*labels) {
-    StatefulTimer::timeCheck("start SoftMaxLayer calcNumRight");
-//    float *input = previousLayer->getOutput(); // just retrieve as host-side array for now
-    int numRight = 0;
-    if(perPlane) {
-        for(int n = 0; n < batchSize; n++) {
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int imageOffset = (n * numPlanes + plane) * imageSizeSquared;
-                int label = labels[n * numPlanes + plane];
-                float thisMax = output[imageOffset + 0];
-                int iMax = 0;
-                for(int i = 1; i < imageSizeSquared; i++) {
-                    if(output[imageOffset + i] > thisMax) {
-                        thisMax = output[imageOffset + i];
-                        iMax = i;
-                    }
-                }
-                if(label == iMax) {
-//                    cout << "n " << n << " plane " << plane << " label " << label << endl;
-                    numRight++;
-                }
-            }
-        }
-    } else {
-        // force imagesize of 1 for now
-        if(imageSize != 1) {
-            throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-        }
-        for(int n = 0; n < batchSize; n++) {
-            int imageOffset = n * numPlanes * imageSizeSquared;
-            int label = labels[n];
-            float thisMax = output[imageOffset + 0];
-            int iMax = 0;
-            for(int i = 1; i < numPlanes; i++) {
-                if(output[imageOffset + i] > thisMax) {
-                    thisMax = output[imageOffset + i];
-                    iMax = i;
-                }
-            }
-            if(label == iMax) {
-                numRight++;
-            }
-        }
-    }
-
-    StatefulTimer::timeCheck("start SoftMaxLayer calcNumRight");
-    return numRight;
+    calcFromLabels(labels);
+    return numRightTotal[0];
 }
 // for forward, we just need to apply the softmax activation. "just" :-P
+// which is left until the labels, or the output, are wanted, see updateOutput
+// and calcFromLabels
 VIRTUAL void SoftMaxLayer::forward() {
-//    cout << "softmaxlayer::forward" << endl;
-    StatefulTimer::timeCheck("start SoftMaxLayer forward");
-    float *input = previousLayer->getOutput(); // just retrieve as host-side array for now
-    if(perPlane) {
-        for(int n = 0; n < batchSize; n++) {
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int imageOffset = (n * numPlanes + plane) * imageSizeSquared;
-                float maxValue = input[imageOffset + 0];
-                for(int i = 1; i < imageSizeSquared; i++) {
-                    maxValue = std::max(maxValue, input[imageOffset + i]);
-                }
-                float denominator = 0;
-                for(int i = 0; i < imageSizeSquared; i++) {
-                    denominator += exp(input[imageOffset + i] - maxValue);
-                }
-                for(int i = 0; i < imageSizeSquared; i++) {
-                    output[imageOffset + i] = exp(input[imageOffset + i] - maxValue) / denominator;
-                }
-            }
-        }
+    if(!perPlane && imageSize != 1) {
+        throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
+    }
+    if(previousLayer->hasOutputWrapper()) {
+        inputWrapper = previousLayer->getOutputWrapper();
     } else {
-        // force imagesize of 1 for now
-        if(imageSize != 1) {
-            throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-        }
-        for(int n = 0; n < batchSize; n++) {
-            int imageOffset = n * numPlanes * imageSizeSquared;
-            // first get the max
-            float maxValue = input[imageOffset + 0]; // since we assume imagesize 1, this is correct
-            for(int plane = 1; plane < numPlanes; plane++) {
-                maxValue = std::max(maxValue, input[imageOffset + plane]);
-            }
-            // calculate sum, under this max
-            float denominator = 0;
-            for(int plane = 0; plane < numPlanes; plane++) {
-                denominator += exp(input[imageOffset + plane] - maxValue);
-            }
-            // now calc the softmaxes:
-            for(int plane = 0; plane < numPlanes; plane++) {
-                output[imageOffset + plane] = exp(input[imageOffset + plane] - maxValue) / denominator;
-            }
-        }
+        inputWrapper = upstreamWrapperCache->wrap(previousLayer->getOutputNumElements(), previousLayer->getOutput());
+        inputWrapper->copyToDevice();
     }
-    StatefulTimer::timeCheck("end SoftMaxLayer forward");
+    outputWrapper->releaseStaging();
+    gradInputWrapper->releaseStaging();
+    outputStale = true;
+    labelResultsValid = false;
 }
 VIRTUAL void SoftMaxLayer::getLabels(int *labels) { // need to allocate labels array first, and have called 'forward' first
     if(perPlane) {
@@ -303,8 +553,9 @@ VIRTUAL void SoftMaxLayer::getLabels(int *labels) { // need to allocate labels a
     if(imageSize != 1) {
         throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
     }
+    float const *output = getOutput();
     for(int n = 0; n < batchSize; n++) {
-        float *outputStack = output + n * numPlanes;
+        float const *outputStack = output + n * numPlanes;
         float highestProb = outputStack[0];
         int bestPlane = 0;
         for(int plane = 1; plane < numPlanes; plane++) {
@@ -11,6 +11,8 @@
 #include "IAcceptsLabels.h"
 
 class SoftMaxMaker;
+class CLWrapperCache;
+class CLDeviceWrapper;
 
 #define VIRTUAL virtual
 #define STATIC static
@@ -19,6 +21,10 @@ class SoftMaxMaker;
 // it will have the same shape as the previous layer, ie same imagesize, same number of planes
 // the softmax will be per-plane, or maybe that is configurable?
 // this will ALWAYS use multinomial logistic loss (ie cross-entropy loss), at least for now
+// runs on the device: forward only notes the input, and the softmax is done
+// either by the fused loss kernel, the first time one of the ...FromLabels
+// methods is called, which also makes the gradient, the loss and numRight
+// in one go, or else when the output is asked for
 class SoftMaxLayer : public LossLayer, public IAcceptsLabels {
 public:
     const bool perPlane;
@@ -26,8 +32,22 @@ public:
     const int numPlanes;
     const int imageSizeSquared;
 
-    float *output;
-    float *gradInput;
+    EasyCL *cl; // NOT owned by us
+    CLKernel *forwardKernel;
+    CLKernel *lossKernel;
+    CLWrapperCache *upstreamWrapperCache;
+
+    int *labels; // copy of the labels that loss and numRight are for
+    float lossTotal[1];
+    int numRightTotal[1];
+    CLDeviceWrapper *outputWrapper; // device only, see CLDeviceWrapper
+    CLDeviceWrapper *gradInputWrapper;
+    CLWrapper *labelsWrapper;
+    CLWrapper *lossWrapper;
+    CLWrapper *numRightWrapper;
+    CLWrapper *inputWrapper; // from the last forward, NOT owned by us
+    bool outputStale; // forward was called, but the softmax not done yet
+    bool labelResultsValid; // loss, numRight and gradInput are for labels
     int allocatedSize;
     int batchSize;
 
@@ -36,13 +56,24 @@ public:
     // cog_addheaders.add()
     // ]]]
     // generated, using cog:
-    SoftMaxLayer(Layer *previousLayer, SoftMaxMaker *maker);
+    SoftMaxLayer(EasyCL *cl, Layer *previousLayer, SoftMaxMaker *maker);
     VIRTUAL ~SoftMaxLayer();
     VIRTUAL std::string getClassName() const;
     VIRTUAL float *getOutput();
+    VIRTUAL bool passesOutputThrough() const;
+    VIRTUAL bool hasOutputWrapper() const;
+    VIRTUAL CLWrapper *getOutputWrapper();
     VIRTUAL float *getGradInput();
+    VIRTUAL bool providesGradInputWrapper() const;
+    VIRTUAL CLWrapper *getGradInputWrapper();
+    VIRTUAL void setOutput(float const *probabilities);
+    VIRTUAL void setOutputWritten();
     VIRTUAL void setBatchSize(int batchSize);
     VIRTUAL int getBatchSize();
+    VIRTUAL int getNumVectors() const;
+    VIRTUAL int getVectorSize() const;
+    VIRTUAL void updateOutput();
+    VIRTUAL void calcFromLabels(int const *labels);
     VIRTUAL float calcLossFromLabels(int const *labels);
     VIRTUAL float calcLoss(float const *expectedValues);
     VIRTUAL void calcGradInputFromLabels(int const *labels);
@@ -167,6 +167,9 @@ void go(Config config) {
     if(verbose) {
         net->print();
     }
+    // forward only, so no gradients, and the layers' outputs can share memory
+    // the last layer forwarded always has its output intact
+    net->setInference(true);
     net->setBatchSize(config.batchSize);
     if(verbose) cout << "batchSize: " << config.batchSize << endl;
 
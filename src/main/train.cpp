@@ -11,6 +11,9 @@
 #include "DeepCL.h"
 //#include "test/Sampler.h"  // TODO: REMOVE THIS
 #include "clblas/ClBlasInstance.h"
+#include "normalize/NormalizationLayer.h"
+#include "conv/Im2ColWorkspace.h"
+#include "clmath/ProfilingQueue.h"
 
 using namespace std;
 
@@ -36,8 +39,11 @@ using namespace std;
         ('normalizationNumStds', 'float', 'with stddev normalization, how many stddevs from mean is 1?', 2.0, True),
         ('dumpTimings', 'int', 'dump detailed timings each epoch? [1|0]', 0, True),
         ('multiNet', 'int', 'number of Mcdnn columns to train', 1, True),
+        ('concurrentMultiNet', 'int', 'train the multinet columns at the same time, each on its own queue, or gpu if several [1|0]', 0, True),
         ('loadOnDemand', 'int', 'load data on demand [1|0]', 0, True),
         ('fileReadBatches', 'int', 'how many batches to read from file each time? (for loadondemand=1)', 50, True),
+        ('prefetchDepth', 'int', 'how many file reads to run ahead, in a background thread, 0 for none (for loadondemand=1)', 0, True),
+        ('im2colWorkspaceMB', 'int', 'max MB each im2col convolution unrolls into, so it can do several images per gemm (default: 64)', 64, False),
         ('normalizationExamples', 'int', 'number of examples to read to determine normalization parameters', 10000, True),
         ('weightsInitializer', 'string', 'initializer for weights, choices: original, uniform (default: original)', 'original', True),
         ('initialWeights', 'float', 'for uniform initializer, weights will be initialized randomly within range -initialweights to +initialweights, divided by fanin, (default: 1.0f)', 1.0, False),
@@ -76,8 +82,11 @@ public:
     float normalizationNumStds;
     int dumpTimings;
     int multiNet;
+    int concurrentMultiNet;
     int loadOnDemand;
     int fileReadBatches;
+    int prefetchDepth;
+    int im2colWorkspaceMB;
     int normalizationExamples;
     string weightsInitializer;
     float initialWeights;
@@ -123,8 +132,11 @@ public:
         normalizationNumStds = 2.0f;
         dumpTimings = 0;
         multiNet = 1;
+        concurrentMultiNet = 0;
         loadOnDemand = 0;
         fileReadBatches = 50;
+        prefetchDepth = 0;
+        im2colWorkspaceMB = 64;
         normalizationExamples = 10000;
         weightsInitializer = "original";
         initialWeights = 1.0f;
@@ -170,6 +182,7 @@ void go(Config config) {
 
     if(config.dumpTimings) {
         StatefulTimer::setEnabled(true);
+        LayerTimer::setEnabled(true);
     }
     cout << "Statefultimer enabled: " << StatefulTimer::enabled << endl;
 
@@ -263,6 +276,13 @@ void go(Config config) {
         cl = EasyCL::createForFirstGpuOtherwiseCpu();
     }
     ClBlasInstance blasInstance;
+    Im2ColWorkspace::setMaxBytes(config.im2colWorkspaceMB * 1024l * 1024l);
+    if(config.dumpTimings) {
+        // so LayerTimer can use the device's timestamps, rather than wait
+        // for each layer; the first LayerTimer::start would do it anyway
+        bool profiling = ProfilingQueue::enable(cl);
+        cout << "layer timings from " << (profiling ? "device events" : "host clock") << endl;
+    }
 
     NeuralNet *net;
     net = new NeuralNet(cl);
@@ -348,25 +368,49 @@ void go(Config config) {
         cout << "reloaded epoch=" << restartEpoch << " batch=" << restartBatch << " numRight=" << restartNumRight << " loss=" << restartLoss << endl;
     }
 
+    // normalize the data as it's loaded, in one pass, rather than having the
+    // NormalizationLayer go over every batch again.  uses the layer's values,
+    // since they might have just come from the weights file
+    // (MultiNet copies the net, and the copies wouldnt know to skip it, so
+    // only for a single net)
+    NormalizationLayer *normalizationLayer = dynamic_cast< NormalizationLayer * >(net->getLayer(1));
+    bool preNormalize = config.multiNet <= 1 && normalizationLayer != 0;
+    if(preNormalize) {
+        normalizationLayer->setInputPreNormalized(true);
+        if(!config.loadOnDemand) {
+            NormalizationHelper::translateAndScale(trainData, trainData, (int64)Ntrain * inputCubeSize,
+                normalizationLayer->translate, normalizationLayer->scale);
+            NormalizationHelper::translateAndScale(testData, testData, (int64)Ntest * inputCubeSize,
+                normalizationLayer->translate, normalizationLayer->scale);
+        }
+    }
+
     timer.timeCheck("before learning start");
     if(config.dumpTimings) {
         StatefulTimer::dump(true);
+        AllocationCounter::dump();
+        LayerTimer::dump();
     }
     StatefulTimer::timeCheck("START");
 
     Trainable *trainable = net;
     MultiNet *multiNet = 0;
     if(config.multiNet > 1) {
-        multiNet = new MultiNet(config.multiNet, net);
+        multiNet = new MultiNet(config.multiNet, net, config.concurrentMultiNet);
         trainable = multiNet;
     }
     NetLearnerBase *netLearner = 0;
     if(config.loadOnDemand) {
-        netLearner = new NetLearnerOnDemandv2(trainer, trainable,
+        NetLearnerOnDemandv2 *netLearnerOnDemand = new NetLearnerOnDemandv2(trainer, trainable,
             &trainLoader, Ntrain,
             &testLoader, Ntest,
             config.fileReadBatches, config.batchSize
         );
+        netLearnerOnDemand->setPrefetchDepth(config.prefetchDepth);
+        if(preNormalize) {
+            netLearnerOnDemand->setLoadNormalization(normalizationLayer->translate, normalizationLayer->scale);
+        }
+        netLearner = netLearnerOnDemand;
     } else {
         netLearner = new NetLearner(trainer, trainable,
             Ntrain, trainData, trainLabels,
@@ -399,6 +443,8 @@ void go(Config config) {
 //            Sampler::sampleFloatWrapper("fc bias", net->getLayer(11)->getBiasWrapper());
             if(config.dumpTimings) {
                 StatefulTimer::dump(true);
+                AllocationCounter::dump();
+                LayerTimer::dump();
             }
         } else {
             if(config.writeWeightsInterval > 0) {
@@ -479,8 +525,10 @@ void printUsage(char *argv[], Config config) {
     cout << "    normalizationnumstds=[with stddev normalization, how many stddevs from mean is 1?] (" << config.normalizationNumStds << ")" << endl;
     cout << "    dumptimings=[dump detailed timings each epoch? [1|0]] (" << config.dumpTimings << ")" << endl;
     cout << "    multinet=[number of Mcdnn columns to train] (" << config.multiNet << ")" << endl;
+    cout << "    concurrentmultinet=[train the multinet columns at the same time, each on its own queue, or gpu if several [1|0]] (" << config.concurrentMultiNet << ")" << endl;
     cout << "    loadondemand=[load data on demand [1|0]] (" << config.loadOnDemand << ")" << endl;
     cout << "    filereadbatches=[how many batches to read from file each time? (for loadondemand=1)] (" << config.fileReadBatches << ")" << endl;
+    cout << "    prefetchdepth=[how many file reads to run ahead, in a background thread, 0 for none (for loadondemand=1)] (" << config.prefetchDepth << ")" << endl;
     cout << "    normalizationexamples=[number of examples to read to determine normalization parameters] (" << config.normalizationExamples << ")" << endl;
     cout << "    weightsinitializer=[initializer for weights, choices: original, uniform (default: original)] (" << config.weightsInitializer << ")" << endl;
     cout << "    trainer=[which trainer, sgd, anneal, nesterov, adagrad, rmsprop, or adadelta (default: sgd)] (" << config.trainer << ")" << endl;
@@ -489,6 +537,7 @@ void printUsage(char *argv[], Config config) {
     cout << "    weightdecay=[weight decay, 0 means no decay; 1 means full decay, used by sgd trainer] (" << config.weightDecay << ")" << endl;
     cout << "" << endl; 
     cout << "unstable, might change within major version:" << endl; 
+    cout << "    im2colworkspacemb=[max MB each im2col convolution unrolls into, so it can do several images per gemm (default: 64)] (" << config.im2colWorkspaceMB << ")" << endl;
     cout << "    initialweights=[for uniform initializer, weights will be initialized randomly within range -initialweights to +initialweights, divided by fanin, (default: 1.0f)] (" << config.initialWeights << ")" << endl;
     cout << "    rho=[rho decay, in adadelta trainer. 1 is no decay. 0 is full decay (default 0.9)] (" << config.rho << ")" << endl;
     cout << "    anneal=[multiply learningrate by this amount each epoch, used by anneal trainer, default 1.0] (" << config.anneal << ")" << endl;
@@ -557,10 +606,16 @@ int main(int argc, char *argv[]) {
                 config.dumpTimings = atoi(value);
             } else if(key == "multinet") {
                 config.multiNet = atoi(value);
+            } else if(key == "concurrentmultinet") {
+                config.concurrentMultiNet = atoi(value);
             } else if(key == "loadondemand") {
                 config.loadOnDemand = atoi(value);
             } else if(key == "filereadbatches") {
                 config.fileReadBatches = atoi(value);
+            } else if(key == "prefetchdepth") {
+                config.prefetchDepth = atoi(value);
+            } else if(key == "im2colworkspacemb") {
+                config.im2colWorkspaceMB = atoi(value);
             } else if(key == "normalizationexamples") {
                 config.normalizationExamples = atoi(value);
             } else if(key == "weightsinitializer") {
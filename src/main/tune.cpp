@@ -0,0 +1,278 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// runs a few forward and backward batches through a network, on random
+// data, so ForwardAuto, BackwardAuto and BackpropWeightsAuto pick their
+// kernels, and save the choices in the tuning cache, for later train and
+// predict runs on the same device, with the same batchsize
+
+#include "DeepCL.h"
+#include "conv/Forward.h"
+#include "conv/Backward.h"
+#include "conv/BackpropWeights.h"
+#include "conv/AutoTuneCache.h"
+#include "conv/AutoTuner.h"
+#include "clblas/ClBlasInstance.h"
+#include "clmath/ProfilingQueue.h"
+
+using namespace std;
+
+/* [[[cog
+    # These are used in the later cog sections in this file:
+    options = [
+        {'name': 'gpuIndex', 'type': 'int', 'description': 'gpu device index; default value is gpu if present, cpu otw.', 'default': -1, 'ispublicapi': True},
+        {'name': 'netDef', 'type': 'string', 'description': 'network definition', 'default': 'rt2-8c5z-relu-mp2-16c5z-relu-mp3-150n-tanh-10n', 'ispublicapi': True},
+        {'name': 'weightsFile', 'type': 'string', 'description': 'if not empty, read the network definition from this weights file, instead of netdef', 'default': '', 'ispublicapi': True},
+        {'name': 'numPlanes', 'type': 'int', 'description': 'number of input planes', 'default': 1, 'ispublicapi': True},
+        {'name': 'imageSize', 'type': 'int', 'description': 'input image size', 'default': 28, 'ispublicapi': True},
+        {'name': 'batchSize', 'type': 'string', 'description': 'batch size, comma-separated list to tune several', 'default': '128', 'ispublicapi': True},
+        {'name': 'forwardOnly', 'type': 'int', 'description': 'only tune forward kernels, eg for predict [0|1]', 'default': 0, 'ispublicapi': True},
+        {'name': 'timedRuns', 'type': 'int', 'description': 'timed runs of each candidate kernel, the median is used', 'default': 9, 'ispublicapi': True},
+        {'name': 'tuneCache', 'type': 'string', 'description': 'tuning cache file, if empty, use DEEPCL_TUNE_CACHE, or ~/.deepcl_tunecache.txt', 'default': ''}
+    ]
+*///]]]
+// [[[end]]]
+
+class Config {
+public:
+    /* [[[cog
+        cog.outl('// generated using cog:')
+        for option in options:
+            cog.outl(option['type'] + ' ' + option['name'] + ';')
+    */// ]]]
+    // generated using cog:
+    int gpuIndex;
+    string netDef;
+    string weightsFile;
+    int numPlanes;
+    int imageSize;
+    string batchSize;
+    int forwardOnly;
+    int timedRuns;
+    string tuneCache;
+    // [[[end]]]
+
+    Config() {
+        /* [[[cog
+            cog.outl('// generated using cog:')
+            for option in options:
+                defaultString = ''
+                default = option['default']
+                type = option['type']
+                if type == 'string':
+                    defaultString = '"' + default + '"'
+                elif type == 'int':
+                    defaultString = str(default)
+                elif type == 'float':
+                    defaultString = str(default)
+                    if '.' not in defaultString:
+                        defaultString += '.0'
+                    defaultString += 'f'
+                cog.outl(option['name'] + ' = ' + defaultString + ';')
+        */// ]]]
+        // generated using cog:
+        gpuIndex = -1;
+        netDef = "rt2-8c5z-relu-mp2-16c5z-relu-mp3-150n-tanh-10n";
+        weightsFile = "";
+        numPlanes = 1;
+        imageSize = 28;
+        batchSize = "128";
+        forwardOnly = 0;
+        timedRuns = 9;
+        tuneCache = "";
+        // [[[end]]]
+    }
+};
+
+void tuneBatchSize(EasyCL *cl, Config const &config, string netDef, int batchSize) {
+    NeuralNet *net = new NeuralNet(cl);
+    WeightsInitializer *weightsInitializer = new OriginalInitializer();
+    net->addLayer(InputLayerMaker::instance()->numPlanes(config.numPlanes)->imageSize(config.imageSize));
+    net->addLayer(NormalizationLayerMaker::instance()->translate(0.0f)->scale(1.0f));
+    if(!NetdefToNet::createNetFromNetdef(net, netDef, weightsInitializer)) {
+        delete weightsInitializer;
+        delete net;
+        throw runtime_error("Failed to create network from netdef " + netDef);
+    }
+    net->setBatchSize(batchSize);
+
+    const int inputCubeSize = config.numPlanes * config.imageSize * config.imageSize;
+    float *inputData = new float[inputCubeSize * batchSize];
+    for(int i = 0; i < inputCubeSize * batchSize; i++) {
+        inputData[i] = (float)((i * 37) % 255) / 255.0f - 0.5f;
+    }
+    float *expectedOutput = new float[net->getOutputNumElements()];
+    for(int i = 0; i < net->getOutputNumElements(); i++) {
+        expectedOutput[i] = 0.0f;
+    }
+
+    // each Auto times one candidate per batch, and chooses after it's
+    // seen them all, so one more batch than there are candidates is enough
+    int numBatches = Forward::getNumImplementations();
+    if(!config.forwardOnly) {
+        numBatches = std::max(numBatches, Backward::getNumImplementations());
+        numBatches = std::max(numBatches, BackpropWeights::getNumImplementations());
+    }
+    numBatches++;
+    cout << "batchsize " << batchSize << ": running " << numBatches << " batches" << endl;
+    for(int i = 0; i < numBatches; i++) {
+        net->forward(inputData);
+        if(!config.forwardOnly) {
+            net->backward(expectedOutput);
+        }
+    }
+
+    delete[] expectedOutput;
+    delete[] inputData;
+    delete weightsInitializer;
+    delete net;
+}
+
+void go(Config config) {
+    if(config.tuneCache != "") {
+        AutoTuneCache::instance()->setFilepath(config.tuneCache);
+    }
+    if(AutoTuneCache::instance()->getFilepath() == "") {
+        throw runtime_error("tuning cache is turned off, nowhere to save to; set tunecache=[file]");
+    }
+    cout << "tuning cache: " << AutoTuneCache::instance()->getFilepath() << endl;
+    AutoTuner::setRuns(1, config.timedRuns);
+
+    string netDef = config.netDef;
+    if(config.weightsFile != "") {
+        if(!WeightsPersister::loadConfigString(config.weightsFile, netDef)) {
+            throw runtime_error("Cannot load network definition from weightsFile " + config.weightsFile);
+        }
+    }
+    cout << "netdef: " << netDef << endl;
+
+    EasyCL *cl = 0;
+    if(config.gpuIndex >= 0) {
+        cl = EasyCL::createForIndexedGpu(config.gpuIndex);
+    } else {
+        cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    }
+    ClBlasInstance blasInstance;
+    // KernelTimer would turn this on anyway, the first time it's used
+    cout << "kernels timed by " << (ProfilingQueue::enable(cl) ? "device events" : "host clock") << endl;
+
+    vector<string> batchSizes = split(config.batchSize, ",");
+    for(int i = 0; i < (int)batchSizes.size(); i++) {
+        int batchSize = atoi(trim(batchSizes[i]));
+        if(batchSize <= 0) {
+            delete cl;
+            throw runtime_error("batchsize should be a comma-separated list of positive integers, not: " + config.batchSize);
+        }
+        tuneBatchSize(cl, config, netDef, batchSize);
+    }
+    cout << "tuning cache now has " << AutoTuneCache::instance()->size() << " entries" << endl;
+    delete cl;
+}
+
+void printUsage(char *argv[], Config config) {
+    cout << "Usage: " << argv[0] << " [key]=[value] [[key]=[value]] ..." << endl;
+    cout << endl;
+    cout << "Possible key=value pairs:" << endl;
+    /* [[[cog
+        cog.outl('// generated using cog:')
+        cog.outl('cout << "public api, shouldnt change within major version:" << endl;')
+        for option in options:
+            name = option['name']
+            description = option['description']
+            if 'ispublicapi' in option and option['ispublicapi']:
+                cog.outl('cout << "    ' + name.lower() + '=[' + description + '] (" << config.' + name + ' << ")" << endl;')
+        cog.outl('cout << "" << endl; ')
+        cog.outl('cout << "unstable, might change within major version:" << endl; ')
+        for option in options:
+            if 'ispublicapi' not in option or not option['ispublicapi']:
+                name = option['name']
+                description = option['description']
+                cog.outl('cout << "    ' + name.lower() + '=[' + description + '] (" << config.' + name + ' << ")" << endl;')
+    *///]]]
+    // generated using cog:
+    cout << "public api, shouldnt change within major version:" << endl;
+    cout << "    gpuindex=[gpu device index; default value is gpu if present, cpu otw.] (" << config.gpuIndex << ")" << endl;
+    cout << "    netdef=[network definition] (" << config.netDef << ")" << endl;
+    cout << "    weightsfile=[if not empty, read the network definition from this weights file, instead of netdef] (" << config.weightsFile << ")" << endl;
+    cout << "    numplanes=[number of input planes] (" << config.numPlanes << ")" << endl;
+    cout << "    imagesize=[input image size] (" << config.imageSize << ")" << endl;
+    cout << "    batchsize=[batch size, comma-separated list to tune several] (" << config.batchSize << ")" << endl;
+    cout << "    forwardonly=[only tune forward kernels, eg for predict [0|1]] (" << config.forwardOnly << ")" << endl;
+    cout << "    timedruns=[timed runs of each candidate kernel, the median is used] (" << config.timedRuns << ")" << endl;
+    cout << "" << endl; 
+    cout << "unstable, might change within major version:" << endl; 
+    cout << "    tunecache=[tuning cache file, if empty, use DEEPCL_TUNE_CACHE, or ~/.deepcl_tunecache.txt] (" << config.tuneCache << ")" << endl;
+    // [[[end]]]
+}
+
+int main(int argc, char *argv[]) {
+    Config config;
+    if(argc == 2 && (string(argv[1]) == "--help" || string(argv[1]) == "--?" || string(argv[1]) == "-?" || string(argv[1]) == "-h") ) {
+        printUsage(argv, config);
+        return 0;
+    }
+    for(int i = 1; i < argc; i++) {
+        vector<string> splitkeyval = split(argv[i], "=");
+        if(splitkeyval.size() != 2) {
+          cout << "Usage: " << argv[0] << " [key]=[value] [[key]=[value]] ..." << endl;
+          exit(1);
+        } else {
+            string key = splitkeyval[0];
+            string value = splitkeyval[1];
+            /* [[[cog
+                cog.outl('// generated using cog:')
+                cog.outl('if(false) {')
+                for option in options:
+                    name = option['name']
+                    type = option['type']
+                    cog.outl('} else if(key == "' + name.lower() + '") {')
+                    converter = '';
+                    if type == 'int':
+                        converter = 'atoi';
+                    elif type == 'float':
+                        converter = 'atof';
+                    cog.outl('    config.' + name + ' = ' + converter + '(value);')
+            */// ]]]
+            // generated using cog:
+            if(false) {
+            } else if(key == "gpuindex") {
+                config.gpuIndex = atoi(value);
+            } else if(key == "netdef") {
+                config.netDef = (value);
+            } else if(key == "weightsfile") {
+                config.weightsFile = (value);
+            } else if(key == "numplanes") {
+                config.numPlanes = atoi(value);
+            } else if(key == "imagesize") {
+                config.imageSize = atoi(value);
+            } else if(key == "batchsize") {
+                config.batchSize = (value);
+            } else if(key == "forwardonly") {
+                config.forwardOnly = atoi(value);
+            } else if(key == "timedruns") {
+                config.timedRuns = atoi(value);
+            } else if(key == "tunecache") {
+                config.tuneCache = (value);
+            // [[[end]]]
+            } else {
+                cout << endl;
+                cout << "Error: key '" << key << "' not recognised" << endl;
+                cout << endl;
+                printUsage(argv, config);
+                cout << endl;
+                return -1;
+            }
+        }
+    }
+    try {
+        go(config);
+    } catch(runtime_error &e) {
+        cout << "Something went wrong: " << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
+
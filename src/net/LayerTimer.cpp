@@ -0,0 +1,141 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "clmath/ProfilingQueue.h"
+#include "net/LayerTimer.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// events read back, at the latest, every this many layers, so a run that
+// never dumps doesnt hold on to events without limit
+static const int maxPending = 512;
+
+bool LayerTimer::enabled = false;
+std::string LayerTimer::currentName = "";
+cl_event LayerTimer::currentStartEvent = 0;
+Timer LayerTimer::hostTimer;
+std::vector<LayerTimer::Pending> LayerTimer::pending;
+std::map<std::string, double> LayerTimer::totalMicroseconds;
+std::map<std::string, int> LayerTimer::counts;
+int LayerTimer::numDeviceTimings = 0;
+
+PUBLIC STATIC void LayerTimer::setEnabled(bool enabled) {
+    LayerTimer::enabled = enabled;
+}
+PUBLIC STATIC bool LayerTimer::isEnabled() {
+    return enabled;
+}
+// times what's queued on cl from here until stop(), under name, eg
+// "layer3 forward"; no-op unless enabled
+// the first time for each cl, this turns on profiling for its queue
+PUBLIC STATIC void LayerTimer::start(EasyCL *cl, std::string const &name) {
+    if(!enabled) {
+        return;
+    }
+    currentName = name;
+    currentStartEvent = 0;
+    if(ProfilingQueue::enable(cl) && clEnqueueMarker(*cl->queue, &currentStartEvent) == CL_SUCCESS) {
+        return;
+    }
+    currentStartEvent = 0;
+    cl->finish();
+    hostTimer.lap();
+}
+PUBLIC STATIC void LayerTimer::stop(EasyCL *cl) {
+    if(!enabled) {
+        return;
+    }
+    if(currentStartEvent != 0) {
+        Pending entry;
+        entry.name = currentName;
+        entry.startEvent = currentStartEvent;
+        entry.endEvent = 0;
+        currentStartEvent = 0;
+        if(clEnqueueMarker(*cl->queue, &entry.endEvent) != CL_SUCCESS) {
+            clReleaseEvent(entry.startEvent);
+            return;
+        }
+        pending.push_back(entry);
+        if((int)pending.size() >= maxPending) {
+            collect();
+        }
+        return;
+    }
+    cl->finish();
+    totalMicroseconds[currentName] += hostTimer.lapMicroseconds();
+    counts[currentName]++;
+}
+// totals since the last dump() or reset()
+PUBLIC STATIC double LayerTimer::getTotalMicroseconds(std::string const &name) {
+    collect();
+    return totalMicroseconds.count(name) > 0 ? totalMicroseconds[name] : 0;
+}
+PUBLIC STATIC int LayerTimer::getCount(std::string const &name) {
+    collect();
+    return counts.count(name) > 0 ? counts[name] : 0;
+}
+// how many of those came from the device's timestamps, rather than the host
+// clock
+PUBLIC STATIC int LayerTimer::getNumDeviceTimings() {
+    collect();
+    return numDeviceTimings;
+}
+// printed alongside StatefulTimer::dump(), and resets the totals, like
+// AllocationCounter::dump(); prints nothing if nothing was timed
+PUBLIC STATIC void LayerTimer::dump() {
+    collect();
+    if(counts.size() > 0) {
+        cout << "layer timings:" << endl;
+        for(map<string, double>::iterator it = totalMicroseconds.begin(); it != totalMicroseconds.end(); it++) {
+            int count = counts[it->first];
+            cout << "    " << it->first << " " << (it->second / 1000.0) << "ms (" << count << " runs, " <<
+                (it->second / 1000.0 / count) << "ms each)" << endl;
+        }
+    }
+    reset();
+}
+PUBLIC STATIC void LayerTimer::reset() {
+    for(int i = 0; i < (int)pending.size(); i++) {
+        clReleaseEvent(pending[i].startEvent);
+        clReleaseEvent(pending[i].endEvent);
+    }
+    pending.clear();
+    totalMicroseconds.clear();
+    counts.clear();
+    numDeviceTimings = 0;
+}
+// waits for the last marker, and so, the queue being in order, for all of
+// them, then adds up the device's timestamps
+PRIVATE STATIC void LayerTimer::collect() {
+    if(pending.size() == 0) {
+        return;
+    }
+    clWaitForEvents(1, &pending[pending.size() - 1].endEvent);
+    for(int i = 0; i < (int)pending.size(); i++) {
+        cl_ulong startNanoseconds = 0;
+        cl_ulong endNanoseconds = 0;
+        cl_int startError = clGetEventProfilingInfo(pending[i].startEvent, CL_PROFILING_COMMAND_END,
+            sizeof(startNanoseconds), &startNanoseconds, 0);
+        cl_int endError = clGetEventProfilingInfo(pending[i].endEvent, CL_PROFILING_COMMAND_END,
+            sizeof(endNanoseconds), &endNanoseconds, 0);
+        if(startError == CL_SUCCESS && endError == CL_SUCCESS && endNanoseconds >= startNanoseconds) {
+            totalMicroseconds[pending[i].name] += (endNanoseconds - startNanoseconds) / 1000.0;
+            counts[pending[i].name]++;
+            numDeviceTimings++;
+        }
+        clReleaseEvent(pending[i].startEvent);
+        clReleaseEvent(pending[i].endEvent);
+    }
+    pending.clear();
+}
+
@@ -0,0 +1,76 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "EasyCL.h"
+#include "util/Timer.h"
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// per-layer times, for dumpTimings
+// kernels are queued without waiting for them to finish, so StatefulTimer's
+// host times only show how long the queueing took.  instead NeuralNet puts
+// each layer's forward and backward between two markers on the queue, and
+// the device's timestamps for those are only read back in dump(), so timing
+// adds no waits of its own
+// the first start() on an EasyCL turns profiling on for its queue, via
+// ProfilingQueue.  only if that fails does each layer wait for the queue at
+// both ends, and get timed on the host
+// off by default; not thread-safe, like StatefulTimer
+class DeepCL_EXPORT LayerTimer {
+    private:
+    struct Pending {
+        std::string name;
+        cl_event startEvent;
+        cl_event endEvent;
+    };
+
+    STATIC bool enabled;
+    STATIC std::string currentName;
+    STATIC cl_event currentStartEvent;
+    STATIC Timer hostTimer;
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    STATIC std::vector<Pending> pending;
+    STATIC std::map<std::string, double> totalMicroseconds;
+    STATIC std::map<std::string, int> counts;
+    STATIC int numDeviceTimings;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC void setEnabled(bool enabled);
+    STATIC bool isEnabled();
+    STATIC void start(EasyCL *cl, std::string const &name);
+    STATIC void stop(EasyCL *cl);
+    STATIC double getTotalMicroseconds(std::string const &name);
+    STATIC int getCount(std::string const &name);
+    STATIC int getNumDeviceTimings();
+    STATIC void dump();
+    STATIC void reset();
+
+    private:
+    STATIC void collect();
+
+    // [[[end]]]
+};
+
@@ -4,32 +4,118 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include "EasyCL.h"
+#include "DevicesInfo.h"
+#include "util/StatefulTimer.h"
+#include "util/ThreadPool.h"
+#include "util/stringhelper.h"
 #include "normalize/NormalizationHelper.h"
 #include "net/NeuralNet.h"
+#include "net/LayerTimer.h"
 #include "loss/LossLayer.h"
 #include "loss/SoftMaxLayer.h"
 #include "input/InputLayer.h"
 #include "layer/LayerMaker.h"
 #include "input/InputLayerMaker.h"
+#include "clmath/CLDeviceWrapper.h"
+#include "clmath/CLMathWrapper.h"
+#include "clmath/CLMathExpression.h"
+#include "clmath/FusedGpuOp.h"
 
 #include "net/MultiNet.h"
 
 using namespace std;
+using namespace easycl;
 
 #undef STATIC
 #undef VIRTUAL
 #define STATIC
 #define VIRTUAL
 
+// one column's forward, then, if concurrent, on the column's own thread,
+// either reads its output back, or, if the columns share a context, waits
+// for its queue, so the average on column 0's queue sees the output
+class MultiNetForwardTask : public ThreadPoolTask {
+public:
+    MultiNet *multiNet;
+    float const *images;
+    bool readOutput;
+    bool finishQueue;
+    MultiNetForwardTask(MultiNet *multiNet, float const *images, bool readOutput, bool finishQueue) :
+        multiNet(multiNet),
+        images(images),
+        readOutput(readOutput),
+        finishQueue(finishQueue) {
+    }
+    virtual void run(int column) {
+        multiNet->getNet(column)->forward(images);
+        if(readOutput) {
+            multiNet->getNet(column)->getOutput();
+        }
+        if(finishQueue) {
+            dynamic_cast< NeuralNet * >(multiNet->getNet(column))->getCl()->finish();
+        }
+    }
+};
+
+// one column's backward, from labels, or from expectedOutput
+class MultiNetBackwardTask : public ThreadPoolTask {
+public:
+    MultiNet *multiNet;
+    int const *labels;
+    float const *expectedOutput;
+    MultiNetBackwardTask(MultiNet *multiNet, int const *labels, float const *expectedOutput) :
+        multiNet(multiNet),
+        labels(labels),
+        expectedOutput(expectedOutput) {
+    }
+    virtual void run(int column) {
+        if(labels != 0) {
+            multiNet->getNet(column)->backwardFromLabels(labels);
+        } else {
+            multiNet->getNet(column)->backward(expectedOutput);
+        }
+    }
+};
+
 MultiNet::MultiNet(int numNets, NeuralNet *model) :
+        threadPool(0),
+        sharedContext(false),
+        output(0),
+        batchSize(0),
+        allocatedSize(0),
+        proxyInputLayer(0),
+        lossLayer(0) {
+    createColumns(numNets, model, false);
+}
+MultiNet::MultiNet(int numNets, NeuralNet *model, bool concurrent) :
+        threadPool(0),
+        sharedContext(false),
         output(0),
         batchSize(0),
         allocatedSize(0),
         proxyInputLayer(0),
         lossLayer(0) {
+    createColumns(numNets, model, concurrent);
+}
+void MultiNet::createColumns(int numNets, NeuralNet *model, bool concurrent) {
 //    trainables.push_back(model);
     for(int i = 0; i < numNets; i++) {
-        trainables.push_back(model->clone());
+        if(concurrent) {
+            columnCls.push_back(createColumnCl(model->getCl(), i));
+            trainables.push_back(model->cloneOnto(columnCls[i]));
+        } else {
+            trainables.push_back(model->clone());
+        }
+    }
+    if(concurrent) {
+        threadPool = new ThreadPool(numNets);
+        sharedContext = true;
+        for(int i = 0; i < numNets; i++) {
+            if(*columnCls[i]->context != *model->getCl()->context) {
+                sharedContext = false;
+            }
+        }
     }
     InputLayerMaker *inputLayerMaker = InputLayerMaker::instance();
     inputLayerMaker->numPlanes(trainables[0]->getOutputPlanes());
@@ -50,6 +136,66 @@ VIRTUAL MultiNet::~MultiNet() {
     for(vector< Trainable * >::iterator it = trainables.begin(); it != trainables.end(); it++) {
         delete (*it);
     }    
+    for(int i = 0; i < (int)columnCls.size(); i++) {
+        delete columnCls[i];
+    }
+    if(threadPool != 0) {
+        delete threadPool;
+    }
+}
+// if there are several gpus, its own context and queue, on gpu
+// (column % numGpus).  otherwise its own queue, in the model's context, so
+// the columns' kernels can overlap on the one device, and their outputs can
+// still be averaged there
+STATIC EasyCL *MultiNet::createColumnCl(EasyCL *modelCl, int column) {
+    cl_platform_id platformId;
+    cl_device_id deviceId;
+    int numGpus = DevicesInfo::getNumGpus();
+    if(numGpus > 1) {
+        DevicesInfo::getIdForIndexedGpu(column % numGpus, &platformId, &deviceId);
+        return new EasyCL(platformId, deviceId);
+    } else {
+        deviceId = modelCl->device;
+        cl_int error = clGetDeviceInfo(deviceId, CL_DEVICE_PLATFORM, sizeof(platformId), &platformId, 0);
+        if(error != CL_SUCCESS) {
+            throw runtime_error("MultiNet: couldnt get the platform of the model's device, error " +
+                toString(error));
+        }
+    }
+    EasyCL *cl = new EasyCL(platformId, deviceId);
+    cl_int error = CL_SUCCESS;
+    cl_command_queue queue = clCreateCommandQueue(*modelCl->context, deviceId, 0, &error);
+    if(error != CL_SUCCESS) {
+        delete cl;
+        throw runtime_error("MultiNet: couldnt create a command queue for column " + toString(column) +
+            ", error " + toString(error));
+    }
+    // swap in the model's context, before anything is built or allocated in
+    // the one EasyCL made; the EasyCL releases them both, when it's deleted
+    clReleaseCommandQueue(*cl->queue);
+    clReleaseContext(*cl->context);
+    clRetainContext(*modelCl->context);
+    *cl->context = *modelCl->context;
+    *cl->queue = queue;
+    return cl;
+}
+VIRTUAL bool MultiNet::isConcurrent() const {
+    return threadPool != 0;
+}
+// calls task->run(column) for each column; on a thread each, if concurrent
+// and nothing that isnt thread-safe is turned on
+// while any column is autotuning, they run one at a time, so that each
+// kernel is timed with the device to itself, and a fair winner goes in the
+// AutoTuneCache
+void MultiNet::runColumns(ThreadPoolTask *task) {
+    int numColumns = (int)trainables.size();
+    if(threadPool != 0 && !StatefulTimer::enabled && !LayerTimer::isEnabled() && !isTuning()) {
+        threadPool->run(numColumns, task);
+        return;
+    }
+    for(int column = 0; column < numColumns; column++) {
+        task->run(column);
+    }
 }
 VIRTUAL int MultiNet::getInputCubeSize() const {
     return trainables[0]->getInputCubeSize();
@@ -70,6 +216,14 @@ VIRTUAL LossLayerMaker *MultiNet::cloneLossLayerMaker() const {
     throw runtime_error("need to implement MultiNet::cloneLossLayerMaker :-)");
 //    return dynamic_cast< LossLayerMaker *>(lossLayer->maker->clone(clonePreviousLayer) );
 }
+VIRTUAL bool MultiNet::isTuning() {
+    for(int i = 0; i < (int)trainables.size(); i++) {
+        if(trainables[i]->isTuning()) {
+            return true;
+        }
+    }
+    return false;
+}
 VIRTUAL float MultiNet::calcLoss(float const *expectedValues) {
     float loss = lossLayer->calcLoss(expectedValues);
     return loss;
@@ -143,8 +297,52 @@ VIRTUAL int MultiNet::calcNumRight(int const *labels) {
     }
     return softMaxLayer->calcNumRightFromLabels(labels);
 }
+// the columns' output wrappers, if they can be averaged on the device,
+// straight into the loss layer's output, ie they're all in one context,
+// otherwise empty
+std::vector<CLWrapper *> MultiNet::getColumnOutputWrappers() {
+    vector<CLWrapper *> wrappers;
+    SoftMaxLayer *softMaxLayer = dynamic_cast< SoftMaxLayer * >(lossLayer);
+    if((columnCls.size() > 0 && !sharedContext) || softMaxLayer == 0) {
+        return wrappers;
+    }
+    for(vector< Trainable * >::iterator it = trainables.begin(); it != trainables.end(); it++) {
+        NeuralNet *net = dynamic_cast< NeuralNet * >(*it);
+        if(net == 0 || !net->getLastLayer()->hasOutputWrapper()) {
+            return vector<CLWrapper *>();
+        }
+        CLWrapper *wrapper = net->getLastLayer()->getOutputWrapper();
+        if(wrapper->size() != softMaxLayer->outputWrapper->size()) {
+            return vector<CLWrapper *>();
+        }
+        wrappers.push_back(wrapper);
+    }
+    return wrappers;
+}
 void MultiNet::forwardToOurselves() {
     // now forward to ourselves :-)
+    const int numChildren = (int)trainables.size();
+    vector<CLWrapper *> columnOutputs = getColumnOutputWrappers();
+    if(columnOutputs.size() > 0) {
+        // all on one device, so average them there, in one kernel, via FusedGpuOp
+        SoftMaxLayer *softMaxLayer = dynamic_cast< SoftMaxLayer * >(lossLayer);
+        CLMathWrapper average(softMaxLayer->outputWrapper);
+        CLMathExpression sum = CLMathWrapper(columnOutputs[0]);
+        for(int i = 1; i < numChildren; i++) {
+            sum = sum + CLMathWrapper(columnOutputs[i]);
+        }
+        FusedGpuOp fusedOp(softMaxLayer->cl);
+        fusedOp.assign(average, sum * (1.0f / numChildren));
+        fusedOp.run();
+        if(columnCls.size() > 0) {
+            // the other columns' queues dont wait for column 0's, so make
+            // sure the average has read their outputs, before they write
+            // the next ones
+            softMaxLayer->cl->finish();
+        }
+        softMaxLayer->setOutputWritten();
+        return;
+    }
     // I suppose this could be done in GPU, but what if we want to split across mpi?
     const int outputNumElements = trainables[0]->getOutputNumElements();
     memset(output, 0, sizeof(float) * outputNumElements);
@@ -154,32 +352,29 @@ void MultiNet::forwardToOurselves() {
             output[i] += childOutput[i];
         }
     }    
-    const int numChildren = (int)trainables.size();
     for(int i = 0; i < outputNumElements; i++) {
         output[i] /= numChildren;
     }
-    memcpy(dynamic_cast< SoftMaxLayer * >(lossLayer)->output, output, sizeof(float) * lossLayer->getOutputNumElements());
+    dynamic_cast< SoftMaxLayer * >(lossLayer)->setOutput(output);
 //    proxyInputLayer->in(output);
 }
 VIRTUAL void MultiNet::forward(float const*images) {
-    for(vector< Trainable * >::iterator it = trainables.begin(); it != trainables.end(); it++) {
-        (*it)->forward(images);
-    }
+    bool concurrent = columnCls.size() > 0;
+    MultiNetForwardTask task(this, images, concurrent && !sharedContext, concurrent && sharedContext);
+    runColumns(&task);
     forwardToOurselves();
 }
 VIRTUAL void MultiNet::backwardFromLabels(int const *labels) {
     // dont think we need to backprop onto ourselves?  Just direclty onto children, right?
-    for(vector< Trainable * >::iterator it = trainables.begin(); it != trainables.end(); it++) {
-        (*it)->backwardFromLabels(labels);
-    }
+    MultiNetBackwardTask task(this, labels, 0);
+    runColumns(&task);
 }
 VIRTUAL void MultiNet::backward(float const *expectedOutput) {
-    for(vector< Trainable * >::iterator it = trainables.begin(); it != trainables.end(); it++) {
-        (*it)->backward(expectedOutput);
-    }
+    MultiNetBackwardTask task(this, 0, expectedOutput);
+    runColumns(&task);
 }
 VIRTUAL float const *MultiNet::getOutput() const {
-    return output;
+    return lossLayer->getOutput();
 }
 VIRTUAL int MultiNet::getNumNets() const {
     return trainables.size();
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 
 #include "net/Trainable.h"
 
@@ -18,13 +19,29 @@
 #include "DeepCLDllExport.h"
 
 class LossLayer;
+class EasyCL;
+class CLWrapper;
+class ThreadPool;
+class ThreadPoolTask;
 
 class NeuralNet;
 
 // This handles grouping several NeuralNets into one single MultiNet
+// concurrent: each column gets its own EasyCL, so its own command queue,
+// and forward, backward, and the trainers, run the columns on a thread each.
+// on one gpu, the columns' queues share the model's context, and their
+// outputs are averaged on the device, as when not concurrent, where the
+// columns share the model's EasyCL.  if there are several gpus, the columns
+// are spread over them, each in its own context, and averaged on the host
+// the columns still run one after another while StatefulTimer or LayerTimer
+// are enabled, since those are not thread-safe, and while any column is
+// still autotuning its kernels
 class DeepCL_EXPORT MultiNet : public Trainable {
     std::vector<Trainable * > trainables;
-    float *output;
+    std::vector<EasyCL *> columnCls; // one per column, if concurrent
+    ThreadPool *threadPool; // if concurrent
+    bool sharedContext; // if concurrent, and columnCls are all in the model's context
+    float *output; // averaged on the host, if concurrent
     int batchSize;
     int allocatedSize;
     InputLayer *proxyInputLayer; // used to feed in output from children, to give to lossLayer
@@ -37,18 +54,25 @@ public:
     // ]]]
     // generated, using cog:
     MultiNet(int numNets, NeuralNet *model);
+    MultiNet(int numNets, NeuralNet *model, bool concurrent);
+    void createColumns(int numNets, NeuralNet *model, bool concurrent);
     VIRTUAL ~MultiNet();
+    STATIC EasyCL *createColumnCl(EasyCL *modelCl, int column);
+    VIRTUAL bool isConcurrent() const;
+    void runColumns(ThreadPoolTask *task);
     VIRTUAL int getInputCubeSize() const;
     VIRTUAL int getOutputCubeSize() const;
     VIRTUAL int getOutputNumElements() const;
     VIRTUAL int getOutputPlanes() const;
     VIRTUAL int getOutputSize() const;
     VIRTUAL LossLayerMaker *cloneLossLayerMaker() const;
+    VIRTUAL bool isTuning();
     VIRTUAL float calcLoss(float const *expectedValues);
     VIRTUAL float calcLossFromLabels(int const *labels);
     VIRTUAL void setBatchSize(int batchSize);
     VIRTUAL void setTraining(bool training);
     VIRTUAL int calcNumRight(int const *labels);
+    std::vector<CLWrapper *> getColumnOutputWrappers();
     void forwardToOurselves();
     VIRTUAL void forward(float const*images);
     VIRTUAL void backwardFromLabels(int const *labels);
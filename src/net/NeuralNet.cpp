@@ -17,6 +17,7 @@
 #include "layer/Layer.h"
 #include "input/InputLayer.h"
 #include "fc/FullyConnectedLayer.h"
+#include "activate/ActivationLayer.h"
 #include "batch/EpochMaker.h"
 #include "loss/LossLayer.h"
 #include "loss/IAcceptsLabels.h"
@@ -25,6 +26,9 @@
 #include "trainers/Trainer.h"
 #include "trainers/TrainerMaker.h"
 #include "weights/WeightsPersister.h"
+#include "net/ParameterArena.h"
+#include "net/OutputArenas.h"
+#include "net/LayerTimer.h"
 #include "CppRuntimeBoundary.h"
 
 #include "net/NeuralNet.h"
@@ -38,8 +42,22 @@ using namespace std;
 #undef STATIC
 #define STATIC
 
+// the prefix lives in the one StatefulTimer shared by the whole process, and
+// only matters while it's timing, so leave it alone otherwise: concurrent
+// MultiNet columns run forward and backward on several threads at once, and
+// only run one at a time while the timer is enabled
+static void setTimerPrefix(std::string const &prefix) {
+    if(StatefulTimer::enabled) {
+        StatefulTimer::setPrefix(prefix);
+    }
+}
+
 NeuralNet::NeuralNet(EasyCL *cl) :
-        cl(cl) {
+        cl(cl),
+        parameterArena(0),
+        inference(false),
+        outputArenas(0),
+        allocatedBatchSize(0) {
     trainer = 0;
     isTraining = true;
 }
@@ -57,7 +75,11 @@ void NeuralNet::deleteMe() {
 }
 /// Constructor
 NeuralNet::NeuralNet(EasyCL *cl, int numPlanes, int imageSize) :
-        cl(cl) {
+        cl(cl),
+        parameterArena(0),
+        inference(false),
+        outputArenas(0),
+        allocatedBatchSize(0) {
     addLayer(InputLayerMaker::instance()->numPlanes(numPlanes)->imageSize(imageSize) );
     trainer = 0;
 }
@@ -65,17 +87,33 @@ NeuralNet::~NeuralNet() {
     for(int i = 0; i < (int)layers.size(); i++) {
         delete layers[i];
     }
+    // after the layers, since they hold views into them
+    delete parameterArena;
+    delete outputArenas;
 }
 STATIC NeuralNetMould *NeuralNet::maker(EasyCL *cl) {
     return new NeuralNetMould(cl);
 }
 NeuralNet *NeuralNet::clone() {
+    return cloneOnto(cl);
+}
+// same layers, with fresh weights, on another EasyCL, eg for each column of
+// a concurrent MultiNet; fused too, if fuseLayers was called on us
+NeuralNet *NeuralNet::cloneOnto(EasyCL *cl) {
     NeuralNet *copy = new NeuralNet(cl);
+    bool fused = false;
     for(vector<Layer *>::iterator it = layers.begin(); it != layers.end(); it++) {
         LayerMaker2 *maker = (*it)->maker;
 
         LayerMaker2 *makerCopy = maker->clone();
         copy->addLayer(makerCopy);
+        ActivationLayer *activationLayer = dynamic_cast< ActivationLayer * >(*it);
+        if(activationLayer != 0 && activationLayer->isFused()) {
+            fused = true;
+        }
+    }
+    if(fused) {
+        copy->fuseLayers();
     }
     copy->print();
     cout << "outputimagesize: " << copy->getOutputSize() << endl;
@@ -87,10 +125,56 @@ EasyCL *NeuralNet::getCl() {
 /// Add a network layer, using a LayerMaker2 object
 PUBLICAPI void NeuralNet::addLayer(LayerMaker2 *maker) {
 //    cout << "neuralnet::insert numplanes " << inputLayerMaker._numPlanes << " imageSize " << inputLayerMaker._imageSize << endl;
+    if(parameterArena != 0) {
+        throw runtime_error("NeuralNet::addLayer: cannot add layers after calling useParameterArena()");
+    }
+    if(inference) {
+        throw runtime_error("NeuralNet::addLayer: cannot add layers after calling setInference(true)");
+    }
     maker->setCl(cl);
     Layer *layer = maker->createLayer(getLastLayer());
     layers.push_back(layer);
 }
+/// \brief Move all trainable weights and biases into one contiguous buffer
+///
+/// \publicapi
+///
+/// Opt-in.  Call once, after adding all the layers, and before training.
+/// The trainers then update the whole net in a single kernel, and
+/// persisting the weights needs a single transfer from the device.
+/// Layers cannot be added afterwards.
+PUBLICAPI void NeuralNet::useParameterArena() {
+    if(parameterArena != 0) {
+        return;
+    }
+    parameterArena = new ParameterArena(cl, this);
+}
+/// \brief Fold each activation layer into the convolutional or fully
+/// connected layer before it
+///
+/// \publicapi
+///
+/// That layer then adds its bias and applies the activation in one pass
+/// over its output, and applies the activation derivative before its own
+/// backward.  The activation layers stay in the net, as pass-throughs, so
+/// the layer structure, and persisted weights, are unchanged.  The output
+/// of a layer that took over an activation is the activated output.
+/// Call after adding the layers, and before setBatchSize.
+PUBLICAPI void NeuralNet::fuseLayers() {
+    for(int i = 1; i < (int)layers.size(); i++) {
+        ActivationLayer *activationLayer = dynamic_cast< ActivationLayer * >(layers[i]);
+        if(activationLayer == 0 || activationLayer->isFused()) {
+            continue;
+        }
+        if(layers[i - 1]->fuseActivation(activationLayer->fn)) {
+            activationLayer->setFused(true);
+        }
+    }
+}
+/// returns 0 unless useParameterArena() was called
+PUBLICAPI ParameterArena *NeuralNet::getParameterArena() {
+    return parameterArena;
+}
 PUBLICAPI void NeuralNet::initWeights(int layerIndex, float *weights, float *bias) {
     initWeights(layerIndex, weights);
     initBias(layerIndex, bias);
@@ -133,6 +217,16 @@ VIRTUAL LossLayerMaker *NeuralNet::cloneLossLayerMaker() const {
 //    LossLayer const*lossLayer = dynamic_cast< LossLayer const*>(getLastLayer());
 //    return dynamic_cast< LossLayerMaker *>(lossLayer->maker->clone(clonePreviousLayer) ) ;
 }
+/// true while any layer is still autotuning its kernels, for the current
+/// batchSize, see AutoTuner
+VIRTUAL bool NeuralNet::isTuning() {
+    for(int i = 0; i < (int)layers.size(); i++) {
+        if(layers[i]->isTuning()) {
+            return true;
+        }
+    }
+    return false;
+}
 PUBLICAPI InputLayer *NeuralNet::getFirstLayer() {
     return dynamic_cast<InputLayer *>(layers[0]);
 }
@@ -170,8 +264,48 @@ PUBLICAPI void NeuralNet::setBatchSize(int batchSize) {
     for(std::vector<Layer*>::iterator it = layers.begin(); it != layers.end(); it++) {
         (*it)->setBatchSize(batchSize);
     }
+    if(inference && (outputArenas == 0 || batchSize > outputArenas->getBatchSize())) {
+        // the layers swap over to the new views, before the old ones go
+        OutputArenas *oldOutputArenas = outputArenas;
+        outputArenas = new OutputArenas(cl, this, batchSize);
+        delete oldOutputArenas;
+    }
+    allocatedBatchSize = std::max(allocatedBatchSize, batchSize);
+}
+/// \brief Only ever run forward, never backward, so as to fit larger
+/// batches in the same device memory
+///
+/// \publicapi
+///
+/// No gradient buffers are allocated, and the layers' outputs share two
+/// arenas, ping-ponging between them, see OutputArenas.  So, after
+/// forward, only the net's output, and the output of the layer before it,
+/// can be read: the other layers' outputs have been written over.  Turns
+/// training off, for good.
+/// Call after adding the layers, and before setBatchSize.
+PUBLICAPI void NeuralNet::setInference(bool inference) {
+    if(allocatedBatchSize != 0) {
+        throw runtime_error("NeuralNet::setInference: call before setBatchSize");
+    }
+    this->inference = inference;
+    for(std::vector<Layer*>::iterator it = layers.begin(); it != layers.end(); it++) {
+        (*it)->setInference(inference);
+    }
+    if(inference) {
+        setTraining(false);
+    }
+}
+PUBLICAPI bool NeuralNet::getInference() const {
+    return inference;
+}
+/// returns 0 unless setInference(true) and setBatchSize were called
+PUBLICAPI OutputArenas *NeuralNet::getOutputArenas() {
+    return outputArenas;
 }
 PUBLICAPI void NeuralNet::setTraining(bool training) {
+    if(inference && training) {
+        throw runtime_error("NeuralNet::setTraining: cannot train a net in inference mode");
+    }
     for(std::vector<Layer*>::iterator it = layers.begin(); it != layers.end(); it++) {
         (*it)->setTraining(training);
     }
@@ -187,9 +321,11 @@ PUBLICAPI void NeuralNet::forward(float const*images) {
     // forward...
     dynamic_cast<InputLayer *>(layers[0])->in(images);
     for(int layerId = 0; layerId < (int)layers.size(); layerId++) {
-        StatefulTimer::setPrefix("layer" + toString(layerId) + " ");
+        setTimerPrefix("layer" + toString(layerId) + " ");
+        LayerTimer::start(cl, "layer" + toString(layerId) + " forward");
         layers[layerId]->forward();
-        StatefulTimer::setPrefix("");
+        LayerTimer::stop(cl);
+        setTimerPrefix("");
     }
 }
 /// \brief note: this does no learning, just calculates the gradients
@@ -200,12 +336,14 @@ PUBLICAPI void NeuralNet::backwardFromLabels(int const *labels) {
     }
     acceptsLabels->calcGradInputFromLabels(labels);
     for(int layerIdx = (int)layers.size() - 2; layerIdx >= 1; layerIdx--) { // no point in propagating to input layer :-P
-        StatefulTimer::setPrefix("layer" + toString(layerIdx) + " ");
+        setTimerPrefix("layer" + toString(layerIdx) + " ");
         Layer *layer = layers[layerIdx];
         if(layer->needsBackProp()) {
+            LayerTimer::start(cl, "layer" + toString(layerIdx) + " backward");
             layer->backward();
+            LayerTimer::stop(cl);
         }
-        StatefulTimer::setPrefix("");
+        setTimerPrefix("");
     }
 }
 /// \brief note: this does no learning, just calculates the gradients
@@ -216,9 +354,11 @@ PUBLICAPI void NeuralNet::backward(float const *expectedOutput) {
     }
     lossLayer->calcGradInput(expectedOutput);
     for(int layerIdx = (int)layers.size() - 2; layerIdx >= 1; layerIdx--) { // no point in propagating to input layer
-        StatefulTimer::setPrefix("layer" + toString(layerIdx) + " ");
+        setTimerPrefix("layer" + toString(layerIdx) + " ");
+        LayerTimer::start(cl, "layer" + toString(layerIdx) + " backward");
         layers[layerIdx]->backward();
-        StatefulTimer::setPrefix("");
+        LayerTimer::stop(cl);
+        setTimerPrefix("");
     }
 }
 void NeuralNet::backward(OutputData *outputData) {
@@ -229,9 +369,11 @@ void NeuralNet::backward(OutputData *outputData) {
         if(!layer->needsBackProp()) {
             break;
         }
-        StatefulTimer::setPrefix("layer" + toString(layerIdx) + " ");
+        setTimerPrefix("layer" + toString(layerIdx) + " ");
+        LayerTimer::start(cl, "layer" + toString(layerIdx) + " backward");
         layer->backward();
-        StatefulTimer::setPrefix("");
+        LayerTimer::stop(cl);
+        setTimerPrefix("");
     }
 }
 PUBLICAPI int NeuralNet::getNumLayers() {
@@ -26,6 +26,8 @@ class EpochMaker;
 class InputMaker;
 class InputLayer;
 class OutputData;
+class ParameterArena;
+class OutputArenas;
 
 #define VIRTUAL virtual
 #define STATIC static
@@ -43,6 +45,10 @@ protected:
 #endif
     EasyCL *cl; // NOT owned by us, dont delete
     Trainer *trainer; // NOT owned by us, dont delete
+    ParameterArena *parameterArena; // owned by us, 0 unless useParameterArena() was called
+    bool inference;
+    OutputArenas *outputArenas; // owned by us, 0 unless setInference(true) was called
+    int allocatedBatchSize; // largest batch size passed to setBatchSize so far
 
 public:
     int isTraining; // = true;
@@ -61,8 +67,12 @@ public:
     ~NeuralNet();
     STATIC NeuralNetMould *maker(EasyCL *cl);
     NeuralNet *clone();
+    NeuralNet *cloneOnto(EasyCL *cl);
     EasyCL *getCl();
     PUBLICAPI void addLayer(LayerMaker2 *maker);
+    PUBLICAPI void useParameterArena();
+    PUBLICAPI void fuseLayers();
+    PUBLICAPI ParameterArena *getParameterArena();
     PUBLICAPI void initWeights(int layerIndex, float *weights, float *bias);
     PUBLICAPI void initWeights(int layerIndex, float *weights);
     PUBLICAPI void initBias(int layerIndex, float *weights);
@@ -72,6 +82,7 @@ public:
     int calcNumRight(OutputData *outputData);
     EpochMaker *epochMaker(Trainer *trainer);
     VIRTUAL LossLayerMaker *cloneLossLayerMaker() const;
+    VIRTUAL bool isTuning();
     PUBLICAPI InputLayer *getFirstLayer();
     PUBLICAPI Layer *getLastLayer();
     PUBLICAPI int getNumLayers() const;
@@ -80,6 +91,9 @@ public:
     PUBLICAPI VIRTUAL int getOutputPlanes() const;
     PUBLICAPI VIRTUAL int getOutputSize() const;
     PUBLICAPI void setBatchSize(int batchSize);
+    PUBLICAPI void setInference(bool inference);
+    PUBLICAPI bool getInference() const;
+    PUBLICAPI OutputArenas *getOutputArenas();
     PUBLICAPI void setTraining(bool training);
     PUBLICAPI int calcNumRight(int const *labels);
     PUBLICAPI void forward(float const*images);
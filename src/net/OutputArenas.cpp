@@ -0,0 +1,124 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "layer/Layer.h"
+#include "clmath/CLDeviceWrapper.h"
+#include "net/OutputArenas.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+// plans the arenas for the layers' current output sizes, then hands each
+// layer that takesOutputView() its view
+// call after the layers' setBatchSize(batchSize)
+PUBLIC OutputArenas::OutputArenas(EasyCL *cl, NeuralNet *net, int batchSize) :
+        cl(cl),
+        batchSize(batchSize) {
+    int numLayers = net->getNumLayers();
+    vector<bool> passesThrough;
+    vector<int> viewSizes;
+    for(int i = 0; i < numLayers; i++) {
+        Layer *layer = net->getLayer(i);
+        passesThrough.push_back(layer->passesOutputThrough());
+        viewSizes.push_back(layer->takesOutputView() ? layer->getOutputNumElements() : 0);
+    }
+    plan(passesThrough, viewSizes, &arenaOfLayer, &arenaSizes);
+
+    for(int arena = 0; arena < (int)arenaSizes.size(); arena++) {
+        arenaWrappers.push_back(new CLDeviceWrapper(cl, arenaSizes[arena]));
+    }
+    for(int i = 0; i < numLayers; i++) {
+        CLDeviceWrapper *view = 0;
+        if(arenaOfLayer[i] >= 0) {
+            view = new CLDeviceWrapper(arenaWrappers[arenaOfLayer[i]], 0, viewSizes[i]);
+            net->getLayer(i)->setOutputView(view);
+        }
+        views.push_back(view);
+    }
+}
+PUBLIC VIRTUAL OutputArenas::~OutputArenas() {
+    for(int i = 0; i < (int)views.size(); i++) {
+        delete views[i];
+    }
+    for(int arena = 0; arena < (int)arenaWrappers.size(); arena++) {
+        delete arenaWrappers[arena];
+    }
+}
+// the liveness analysis, on its own, so it can be checked without a device
+// passesThrough[i]: layer i's output is its previous layer's, see
+// Layer::passesOutputThrough
+// viewSizes[i]: floats in layer i's output, or 0 if it keeps its own buffer
+// arenaOfLayer gets, for each layer, the arena its output goes in, or -1,
+// and arenaSizes the size, in floats, of each arena
+PUBLIC STATIC void OutputArenas::plan(std::vector<bool> const &passesThrough, std::vector<int> const &viewSizes,
+        std::vector<int> *arenaOfLayer, std::vector<int> *arenaSizes) {
+    int numLayers = (int)passesThrough.size();
+    // owner[i] is the layer whose buffer holds layer i's output
+    vector<int> owner(numLayers);
+    for(int i = 0; i < numLayers; i++) {
+        owner[i] = (i > 0 && passesThrough[i]) ? owner[i - 1] : i;
+    }
+    // lastRead[j] is the last layer whose forward reads layer j's buffer
+    // nothing is written after the last layer, so its output, and the one it
+    // reads, maybe only later, eg SoftMaxLayer, both outlast forward
+    vector<int> lastRead(numLayers, -1);
+    for(int i = 1; i < numLayers; i++) {
+        lastRead[owner[i - 1]] = i;
+    }
+
+    // in forward order, each output goes in the first arena whose current
+    // occupant has already been read for the last time; strictly before,
+    // since a layer cant write over what it's reading
+    arenaOfLayer->assign(numLayers, -1);
+    arenaSizes->clear();
+    vector<int> occupantLastRead;
+    for(int i = 0; i < numLayers; i++) {
+        if(owner[i] != i || viewSizes[i] == 0) {
+            continue;
+        }
+        int arena = 0;
+        while(arena < (int)occupantLastRead.size() && occupantLastRead[arena] >= i) {
+            arena++;
+        }
+        if(arena == (int)occupantLastRead.size()) {
+            occupantLastRead.push_back(0);
+            arenaSizes->push_back(0);
+        }
+        (*arenaOfLayer)[i] = arena;
+        (*arenaSizes)[arena] = std::max((*arenaSizes)[arena], viewSizes[i]);
+        occupantLastRead[arena] = lastRead[i];
+    }
+}
+// the batch size the arenas were sized for
+PUBLIC int OutputArenas::getBatchSize() const {
+    return batchSize;
+}
+PUBLIC int OutputArenas::getNumArenas() const {
+    return (int)arenaSizes.size();
+}
+PUBLIC int OutputArenas::getArenaSize(int arena) const {
+    return arenaSizes[arena];
+}
+// -1 if the layer's output isnt in any arena
+PUBLIC int OutputArenas::getArenaOfLayer(int layerIndex) const {
+    return arenaOfLayer[layerIndex];
+}
+// across all the arenas
+PUBLIC int OutputArenas::getNumFloats() const {
+    int numFloats = 0;
+    for(int arena = 0; arena < (int)arenaSizes.size(); arena++) {
+        numFloats += arenaSizes[arena];
+    }
+    return numFloats;
+}
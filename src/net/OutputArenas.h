@@ -0,0 +1,64 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class CLDeviceWrapper;
+class NeuralNet;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// opt-in, via NeuralNet::setInference(): the outputs of the layers live in
+// a few shared arenas, rather than each in a buffer of its own, with the
+// layers holding CLDeviceWrapper sub-buffer views into them
+// which outputs can share an arena comes from a liveness analysis over the
+// layer chain: an output is live from the forward that writes it, to the
+// last forward that reads it.  in a chain, that's the next layer with an
+// output of its own, so it comes down to ping-ponging between two arenas,
+// each the size of the largest output it holds
+// so, after forward, only the outputs still live can be read: the last
+// layer's, and the one it reads from
+class DeepCL_EXPORT OutputArenas {
+    private:
+    EasyCL *cl; // NOT owned by us
+    int batchSize;
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<int> arenaOfLayer; // -1 if the layer has no view into an arena
+    std::vector<int> arenaSizes;
+    std::vector<CLDeviceWrapper *> arenaWrappers;
+    std::vector<CLDeviceWrapper *> views; // one per layer, 0 if no view
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    OutputArenas(EasyCL *cl, NeuralNet *net, int batchSize);
+    VIRTUAL ~OutputArenas();
+    STATIC void plan(std::vector<bool> const &passesThrough, std::vector<int> const &viewSizes,
+    std::vector<int> *arenaOfLayer, std::vector<int> *arenaSizes);
+    int getBatchSize() const;
+    int getNumArenas() const;
+    int getArenaSize(int arena) const;
+    int getArenaOfLayer(int layerIndex) const;
+    int getNumFloats() const;
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,123 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <vector>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "layer/Layer.h"
+#include "clmath/CLFloatWrapperView.h"
+#include "trainers/TrainerState.h"
+#include "trainers/TrainerStateMaker.h"
+#include "net/ParameterArena.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+// lays out the layers' weights and biases, then hands each layer its offsets,
+// so it can copy its current values in, and switch over to views
+PUBLIC ParameterArena::ParameterArena(EasyCL *cl, NeuralNet *net) :
+        cl(cl),
+        numParams(0),
+        params(0),
+        gradParams(0),
+        paramsWrapper(0),
+        gradParamsWrapper(0),
+        trainerState(0) {
+    int alignFloats = CLFloatWrapperView::getAlignFloats(cl);
+    vector<Layer *> layers;
+    vector<int> weightsOffsets;
+    vector<int> biasOffsets;
+    int pos = 0;
+    for(int layerIdx = net->getNumLayers() - 2; layerIdx > 0; layerIdx--) {
+        Layer *layer = net->getLayer(layerIdx);
+        if(!layer->needsBackProp()) {
+            break;
+        }
+        if(!layer->needsTrainerState()) {
+            continue;
+        }
+        layers.push_back(layer);
+        weightsOffsets.push_back(pos);
+        pos += (layer->getWeightsSize() + alignFloats - 1) / alignFloats * alignFloats;
+        biasOffsets.push_back(pos);
+        pos += (layer->getBiasSize() + alignFloats - 1) / alignFloats * alignFloats;
+    }
+    numParams = pos > 0 ? pos : alignFloats;
+
+    params = new float[numParams];
+    gradParams = new float[numParams];
+    // zeroes the padding, as well as everything the layers then copy over
+    for(int i = 0; i < numParams; i++) {
+        params[i] = 0;
+        gradParams[i] = 0;
+    }
+    paramsWrapper = cl->wrap(numParams, params);
+    paramsWrapper->copyToDevice();
+    gradParamsWrapper = cl->wrap(numParams, gradParams);
+    gradParamsWrapper->copyToDevice();
+
+    for(int i = 0; i < (int)layers.size(); i++) {
+        layers[i]->setParameterArena(this, weightsOffsets[i], biasOffsets[i]);
+    }
+}
+PUBLIC VIRTUAL ParameterArena::~ParameterArena() {
+    delete trainerState;
+    delete paramsWrapper;
+    delete gradParamsWrapper;
+    delete[] params;
+    delete[] gradParams;
+}
+PUBLIC int ParameterArena::getNumParams() const {
+    return numParams;
+}
+PUBLIC float *ParameterArena::getParams() {
+    return params;
+}
+PUBLIC float *ParameterArena::getGradParams() {
+    return gradParams;
+}
+PUBLIC CLWrapper *ParameterArena::getParamsWrapper() {
+    return paramsWrapper;
+}
+PUBLIC CLWrapper *ParameterArena::getGradParamsWrapper() {
+    return gradParamsWrapper;
+}
+// caller owns the returned view, and should delete it before we are deleted
+PUBLIC CLWrapper *ParameterArena::createParamsView(int offset, int N) {
+    return new CLFloatWrapperView(paramsWrapper, offset, N);
+}
+PUBLIC CLWrapper *ParameterArena::createGradParamsView(int offset, int N) {
+    return new CLFloatWrapperView(gradParamsWrapper, offset, N);
+}
+// true if a trainer has updated the params on the device, since they
+// were last copied to the host
+PUBLIC bool ParameterArena::isParamsDeviceDirty() {
+    return paramsWrapper->isDeviceDirty();
+}
+// one transfer for all the weights and biases; no-op if already up to date
+PUBLIC void ParameterArena::copyParamsToHost() {
+    if(paramsWrapper->isDeviceDirty()) {
+        paramsWrapper->copyToHost();
+    }
+}
+PUBLIC TrainerState *ParameterArena::getTrainerState() {
+    return trainerState;
+}
+// one trainer state, covering the whole arena
+PUBLIC void ParameterArena::setTrainerState(TrainerStateMaker *trainerStateMaker) {
+    delete trainerState;
+    trainerState = 0;
+    // passing 0 just strips the state, eg for trainers that dont have any
+    if(trainerStateMaker != 0) {
+        trainerState = trainerStateMaker->instance(cl, numParams);
+    }
+}
+
@@ -0,0 +1,66 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class CLWrapper;
+class NeuralNet;
+class TrainerState;
+class TrainerStateMaker;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// opt-in, via NeuralNet::useParameterArena(): all the trainable weights and
+// biases of a net live in one contiguous buffer, and all their gradients in
+// another, with the layers holding CLFloatWrapperView views into them
+// so the trainers can update the whole model with one kernel, using one
+// TrainerState, and checkpointing needs one transfer
+// each tensor starts on a CL_DEVICE_MEM_BASE_ADDR_ALIGN boundary; the
+// padding in between starts at zero, in both the weights and the gradients,
+// and no layer writes to it, so its gradient stays zero.  it gets updated
+// along with everything else, and the update kernels leave weights with a
+// zero gradient alone, even against optimizer state that has decayed to
+// zero, so the padding stays at zero too
+// covers the same layers the trainers would update one at a time: from the
+// top down, stopping at the first layer that doesnt need backprop
+class DeepCL_EXPORT ParameterArena {
+    private:
+    EasyCL *cl; // NOT owned by us
+    int numParams;
+    float *params;
+    float *gradParams;
+    CLWrapper *paramsWrapper;
+    CLWrapper *gradParamsWrapper;
+    TrainerState *trainerState;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ParameterArena(EasyCL *cl, NeuralNet *net);
+    VIRTUAL ~ParameterArena();
+    int getNumParams() const;
+    float *getParams();
+    float *getGradParams();
+    CLWrapper *getParamsWrapper();
+    CLWrapper *getGradParamsWrapper();
+    CLWrapper *createParamsView(int offset, int N);
+    CLWrapper *createGradParamsView(int offset, int N);
+    bool isParamsDeviceDirty();
+    void copyParamsToHost();
+    TrainerState *getTrainerState();
+    void setTrainerState(TrainerStateMaker *trainerStateMaker);
+
+    // [[[end]]]
+};
+
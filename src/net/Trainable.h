@@ -35,6 +35,7 @@ public:
     virtual int getOutputSize() const = 0;
     virtual int getInputCubeSize() const = 0;
     virtual int getOutputCubeSize() const = 0;
+    virtual bool isTuning() = 0;
 //    virtual void setTrainer(TrainerMaker *trainer) = 0;
 
     // [[[cog
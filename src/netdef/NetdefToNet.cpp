@@ -163,7 +163,7 @@ STATIC bool NetdefToNet::parseSubstring(WeightsInitializer *weightsInitializer,
                 return false;
             }
         }
-        net->addLayer(ConvolutionalMaker::instance()->numFilters(numFilters)->filterSize(filterSize)->padZeros(padZeros)->biased()->weightsInitializer(weightsInitializer) );
+        net->addLayer(ConvolutionalMaker::instance()->numFilters(numFilters)->filterSize(filterSize)->padZeros(padZeros)->skip(skip)->biased()->weightsInitializer(weightsInitializer) );
         if(fn != 0) {
             net->addLayer(ActivationMaker::instance()->fn(fn) );
         }
@@ -270,5 +270,6 @@ STATIC bool NetdefToNet::createNetFromNetdef(NeuralNet *net, std::string netdef,
         }
     }
     net->addLayer(SoftMaxMaker::instance());
+    net->fuseLayers();
     return true;
 }
@@ -11,6 +11,11 @@
 #include <cmath>
 #include <iostream>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NORMALIZATIONHELPER_SSE2
+#endif
+
 #include "DeepCLDllExport.h"
 
 class DeepCL_EXPORT Statistics {
@@ -120,6 +125,39 @@ public:
             data[i] = (data[i] - mean) / scaling;
         }
     }
+
+    // dest[i] = (source[i] + translate) * scale, same as NormalizationLayer,
+    // so the results match exactly; widens 16 bytes at a time, where we can
+    static void translateAndScale(unsigned char const *source, float *dest, int64 length, float translate, float scale) {
+        int64 i = 0;
+        #ifdef NORMALIZATIONHELPER_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 translate4 = _mm_set1_ps(translate);
+        const __m128 scale4 = _mm_set1_ps(scale);
+        for(; i + 16 <= length; i += 16) {
+            __m128i bytes = _mm_loadu_si128((__m128i const *)(source + i));
+            __m128i shorts[2];
+            shorts[0] = _mm_unpacklo_epi8(bytes, zero);
+            shorts[1] = _mm_unpackhi_epi8(bytes, zero);
+            for(int half = 0; half < 2; half++) {
+                __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(shorts[half], zero));
+                __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(shorts[half], zero));
+                _mm_storeu_ps(dest + i + half * 8, _mm_mul_ps(_mm_add_ps(lo, translate4), scale4));
+                _mm_storeu_ps(dest + i + half * 8 + 4, _mm_mul_ps(_mm_add_ps(hi, translate4), scale4));
+            }
+        }
+        #endif
+        for(; i < length; i++) {
+            dest[i] = (source[i] + translate) * scale;
+        }
+    }
+
+    // in place is ok
+    static void translateAndScale(float const *source, float *dest, int64 length, float translate, float scale) {
+        for(int64 i = 0; i < length; i++) {
+            dest[i] = (source[i] + translate) * scale;
+        }
+    }
 };
 
 
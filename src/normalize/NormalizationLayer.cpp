@@ -7,32 +7,94 @@
 #include "normalize/NormalizationLayerMaker.h"
 
 #include "normalize/NormalizationLayer.h"
+#include "clmath/CLWrapperCache.h"
+#include "clmath/CLDeviceWrapper.h"
+#include "util/StatefulTimer.h"
 
 using namespace std;
 
 #undef VIRTUAL
 #define VIRTUAL 
 
-NormalizationLayer::NormalizationLayer(Layer *previousLayer, NormalizationLayerMaker *maker) :
+NormalizationLayer::NormalizationLayer(EasyCL *cl, Layer *previousLayer, NormalizationLayerMaker *maker) :
        Layer(previousLayer, maker),
     translate(maker->_translate),
     scale(maker->_scale),
     outputPlanes(previousLayer->getOutputPlanes()),
     outputSize(previousLayer->getOutputSize()),
+    cl(cl),
+    kernel(0),
+    upstreamWrapperCache(0),
     batchSize(0),
     allocatedSize(0),
-    output(0) {
+    outputWrapper(0),
+    inputPreNormalized(false) {
+    upstreamWrapperCache = new CLWrapperCache(cl);
+
+    std::string kernelName = "translateAndScale";
+    if(cl->kernelExists(kernelName)) {
+        this->kernel = cl->getKernel(kernelName);
+        return;
+    }
+    string options = "";
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("kernel", "cl/normalize.cl", "translateAndScale", 'options')
+    // ]]]
+    // generated using cog, from cl/normalize.cl:
+    const char * kernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// same sums, in the same order, as NormalizationHelper::translateAndScale\n"
+    "kernel void translateAndScale(\n"
+    "        const int N,\n"
+    "        const float translate,\n"
+    "        const float scale,\n"
+    "        global const float *in,\n"
+    "        global float *out) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    out[globalId] = (in[globalId] + translate) * scale;\n"
+    "}\n"
+    "\n"
+    "";
+    kernel = cl->buildKernelFromString(kernelSource, "translateAndScale", options, "cl/normalize.cl");
+    // [[[end]]]
+    cl->storeKernel(kernelName, kernel, true);
 }
 VIRTUAL NormalizationLayer::~NormalizationLayer() {
-    if(output != 0) {
-        delete[] output;
+    delete upstreamWrapperCache;
+    // in inference, our output is a view, owned by the net's OutputArenas
+    if(!inference) {
+        delete outputWrapper;
     }
 }
 VIRTUAL std::string NormalizationLayer::getClassName() const {
     return "NormalizationLayer";
 }
 VIRTUAL float *NormalizationLayer::getOutput() {
-    return output;
+    if(inputPreNormalized) {
+        return previousLayer->getOutput();
+    }
+    return outputWrapper->copyToStaging();
+}
+VIRTUAL bool NormalizationLayer::hasOutputWrapper() const {
+    if(inputPreNormalized) {
+        return previousLayer->hasOutputWrapper();
+    }
+    return true;
+}
+VIRTUAL CLWrapper *NormalizationLayer::getOutputWrapper() {
+    if(inputPreNormalized) {
+        return previousLayer->getOutputWrapper();
+    }
+    return outputWrapper;
 }
 VIRTUAL ActivationFunction const *NormalizationLayer::getActivationFunction() {
     return new LinearActivation();
@@ -62,9 +124,11 @@ VIRTUAL bool NormalizationLayer::needsBackProp() {
     return previousLayer->needsBackProp();
 }
 VIRTUAL void NormalizationLayer::printOutput() const {
-    if(output == 0) {
+    if(outputWrapper == 0) {
          return;
     }
+    bool hadStaging = outputWrapper->hasStaging();
+    float const *output = outputWrapper->copyToStaging();
     for(int n = 0; n < std::min(5,batchSize); n++) {
         std::cout << "NormalizationLayer n " << n << ":" << std::endl;
         for(int plane = 0; plane < std::min(5, outputPlanes); plane++) {
@@ -72,7 +136,7 @@ VIRTUAL void NormalizationLayer::printOutput() const {
             for(int i = 0; i < std::min(5, outputSize); i++) {
                 std::cout << "      ";
                 for(int j = 0; j < std::min(5, outputSize); j++) {
-                    std::cout << getResult(n, plane, i, j) << " ";
+                    std::cout << output[getResultIndex(n, plane, i, j)] << " ";
 //output[
 //                            n * numPlanes * imageSize*imageSize +
 //                            plane*imageSize*imageSize +
@@ -87,6 +151,9 @@ VIRTUAL void NormalizationLayer::printOutput() const {
         if(outputPlanes > 5) std::cout << "   ... other planes ... " << std::endl;
     }
     if(batchSize > 5) std::cout << "   ... other n ... " << std::endl;
+    if(!hadStaging) {
+        outputWrapper->releaseStaging();
+    }
 }
 VIRTUAL void NormalizationLayer::print() const {
     printOutput();
@@ -99,19 +166,61 @@ VIRTUAL void NormalizationLayer::setBatchSize(int batchSize) {
         this->batchSize = batchSize;
         return;
     }
-    if(output != 0) {
-        delete[] output;
+    if(inference) {
+        // output comes from setOutputView, unless we just pass on our input
+        this->batchSize = batchSize;
+        this->allocatedSize = batchSize;
+        return;
     }
+    delete outputWrapper;
     this->batchSize = batchSize;
-    this->allocatedSize = allocatedSize;
-    output = new float[ getOutputNumElements() ];
+    this->allocatedSize = batchSize;
+    outputWrapper = new CLDeviceWrapper(cl, getOutputNumElements());
+}
+/// \brief the input data has already had translate and scale applied, eg by
+/// GenericLoaderv2, when it was loaded, so dont apply them again
+///
+/// forward() then does nothing, and getOutput() hands back the input
+/// translate and scale are still kept, and persisted, as before
+VIRTUAL void NormalizationLayer::setInputPreNormalized(bool inputPreNormalized) {
+    this->inputPreNormalized = inputPreNormalized;
+}
+VIRTUAL bool NormalizationLayer::getInputPreNormalized() const {
+    return inputPreNormalized;
+}
+VIRTUAL bool NormalizationLayer::passesOutputThrough() const {
+    return inputPreNormalized;
+}
+VIRTUAL bool NormalizationLayer::takesOutputView() const {
+    return !inputPreNormalized;
+}
+VIRTUAL void NormalizationLayer::setOutputView(CLDeviceWrapper *outputView) {
+    outputWrapper = outputView;
 }
 VIRTUAL void NormalizationLayer::forward() {
-    int totalLinearLength = getOutputNumElements();
-    float *upstreamOutput = previousLayer->getOutput();
-    for(int i = 0; i < totalLinearLength; i++) {
-        output[i] = (upstreamOutput[i] + translate) * scale;
+    if(inputPreNormalized) {
+        return;
+    }
+    StatefulTimer::timeCheck("NormalizationLayer::forward start");
+    // usually the input layer, so this is the upload of the input batch
+    CLWrapper *inputWrapper = 0;
+    if(previousLayer->hasOutputWrapper()) {
+        inputWrapper = previousLayer->getOutputWrapper();
+    } else {
+        inputWrapper = upstreamWrapperCache->wrap(previousLayer->getOutputNumElements(), previousLayer->getOutput());
+        inputWrapper->copyToDevice();
     }
+    outputWrapper->releaseStaging();
+    int N = getOutputNumElements();
+    kernel->in(N)
+          ->in(translate)
+          ->in(scale)
+          ->in(inputWrapper)
+          ->out(outputWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    StatefulTimer::timeCheck("NormalizationLayer::forward end");
 }
 VIRTUAL void NormalizationLayer::backward(float learningRate, float const *gradOutput) {
   // do nothing...
@@ -13,6 +13,8 @@
 #define VIRTUAL virtual
 
 class NormalizationLayerMaker;
+class CLWrapperCache;
+class CLDeviceWrapper;
 
 class NormalizationLayer : public Layer, IHasToString {
 public:
@@ -22,9 +24,14 @@ public:
     const int outputPlanes;
     const int outputSize;
 
+    EasyCL *cl; // NOT owned by us
+    CLKernel *kernel;
+    CLWrapperCache *upstreamWrapperCache;
+
     int batchSize;
     int allocatedSize;
-    float *output;
+    CLDeviceWrapper *outputWrapper; // device only, see CLDeviceWrapper
+    bool inputPreNormalized;
 
     inline int getResultIndex(int n, int outPlane, int outRow, int outCol) const {
         return (( n
@@ -32,19 +39,18 @@ public:
             * outputSize + outRow)
             * outputSize + outCol;
     }
-    inline float getResult(int n, int outPlane, int outRow, int outCol) const {
-        return output[ getResultIndex(n,outPlane, outRow, outCol) ];
-    }
 
     // [[[cog
     // import cog_addheaders
     // cog_addheaders.add()
     // ]]]
     // generated, using cog:
-    NormalizationLayer(Layer *previousLayer, NormalizationLayerMaker *maker);
+    NormalizationLayer(EasyCL *cl, Layer *previousLayer, NormalizationLayerMaker *maker);
     VIRTUAL ~NormalizationLayer();
     VIRTUAL std::string getClassName() const;
     VIRTUAL float *getOutput();
+    VIRTUAL bool hasOutputWrapper() const;
+    VIRTUAL CLWrapper *getOutputWrapper();
     VIRTUAL ActivationFunction const *getActivationFunction();
     VIRTUAL int getPersistSize(int version) const;
     VIRTUAL void persistToArray(int version, float *array);
@@ -54,6 +60,11 @@ public:
     VIRTUAL void print() const;
     VIRTUAL bool needErrorsBackprop();
     VIRTUAL void setBatchSize(int batchSize);
+    VIRTUAL void setInputPreNormalized(bool inputPreNormalized);
+    VIRTUAL bool getInputPreNormalized() const;
+    VIRTUAL bool passesOutputThrough() const;
+    VIRTUAL bool takesOutputView() const;
+    VIRTUAL void setOutputView(CLDeviceWrapper *outputView);
     VIRTUAL void forward();
     VIRTUAL void backward(float learningRate, float const *gradOutput);
     VIRTUAL int getOutputSize() const;
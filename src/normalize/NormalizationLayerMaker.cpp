@@ -11,7 +11,7 @@
 using namespace std;
 
 Layer *NormalizationLayerMaker::createLayer(Layer *previousLayer) {
-    return new NormalizationLayer(previousLayer, this);
+    return new NormalizationLayer(cl, previousLayer, this);
 }
 
 
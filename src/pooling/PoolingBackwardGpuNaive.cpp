@@ -37,14 +37,12 @@ VIRTUAL void PoolingBackwardGpuNaive::backward(int batchSize, CLWrapper *gradOut
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kMemset->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     kernel->in(batchSize)->inout(gradOutputWrapper)->in(selectorsWrapper)->in(gradInputWrapper);
     globalSize = batchSize * numPlanes * outputSize * outputSize;
     workgroupSize = 64;
     numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
-    cl->finish();
 
     StatefulTimer::instance()->timeCheck("PoolingBackwardGpuNaive::backward end");
 }
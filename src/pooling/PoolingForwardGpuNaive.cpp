@@ -36,7 +36,6 @@ VIRTUAL void PoolingForwardGpuNaive::forward(int batchSize, CLWrapper *inputWrap
     globalSize = (( globalSize + workgroupsize - 1) / workgroupsize) * workgroupsize;
 //    cout << "PoolingForwardGpuNaive::forward batchsize=" << batchSize << " g=" << globalSize << " w=" << workgroupsize << endl;
     kernel->run_1d(globalSize, workgroupsize);
-    cl->finish();
 
 //    cout << "PoolingForwardGpuNaive::forward selectorswrapper:" << endl;
 //    PrintBuffer::printInts(cl, selectorsWrapper, outputSize, outputSize);
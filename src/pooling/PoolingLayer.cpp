@@ -10,6 +10,8 @@
 #include "layer/Layer.h"
 #include "PoolingMaker.h"
 #include "PoolingLayer.h"
+#include "clmath/CLWrapperCache.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "PoolingForward.h"
 #include "PoolingBackward.h"
 
@@ -30,12 +32,11 @@ PoolingLayer::PoolingLayer(EasyCL *cl, Layer *previousLayer, PoolingMaker *maker
         poolingSize(maker->_poolingSize),
         outputSize(maker->_padZeros ? (previousLayer->getOutputSize() + maker->_poolingSize - 1) / maker->_poolingSize : previousLayer->getOutputSize() / maker->_poolingSize),
         cl(cl),
-        output(0),
-        selectors(0),
-        gradInput(0),
         outputWrapper(0),
         selectorsWrapper(0),
         gradInputWrapper(0),
+        upstreamWrapperCache(0),
+        gradOutputWrapperCache(0),
 //        outputCopiedToHost(false),
 //        gradInputCopiedToHost(false),
         batchSize(0),
@@ -50,28 +51,20 @@ PoolingLayer::PoolingLayer(EasyCL *cl, Layer *previousLayer, PoolingMaker *maker
     }
     poolingForwardImpl = PoolingForward::instance(cl, padZeros, numPlanes, inputSize, poolingSize);
     poolingBackpropImpl = PoolingBackward::instance(cl, padZeros, numPlanes, inputSize, poolingSize);
+    upstreamWrapperCache = new CLWrapperCache(cl);
+    gradOutputWrapperCache = new CLWrapperCache(cl);
 }
 VIRTUAL PoolingLayer::~PoolingLayer() {
     delete poolingForwardImpl;
     delete poolingBackpropImpl;
-    if(outputWrapper != 0) {
+    delete upstreamWrapperCache;
+    delete gradOutputWrapperCache;
+    // in inference, our output is a view, owned by the net's OutputArenas
+    if(!inference) {
         delete outputWrapper;
     }
-    if(output != 0) {
-        delete[] output;
-    }
-    if(selectorsWrapper != 0) {
-        delete selectorsWrapper;
-    }
-    if(selectors != 0) {
-        delete[] selectors;
-    }
-    if(gradInputWrapper != 0) {
-        delete gradInputWrapper;
-    }
-    if(gradInput != 0) {
-        delete[] gradInput;
-    }
+    delete selectorsWrapper;
+    delete gradInputWrapper;
 }
 VIRTUAL std::string PoolingLayer::getClassName() const {
     return "PoolingLayer";
@@ -82,43 +75,33 @@ VIRTUAL void PoolingLayer::setBatchSize(int batchSize) {
         this->batchSize = batchSize;
         return;
     }
-    if(outputWrapper != 0) {
+    if(!inference) {
         delete outputWrapper;
     }
-    if(output != 0) {
-        delete[] output;
-    }
-    if(selectorsWrapper != 0) {
-        delete selectorsWrapper;
-    }
-    if(selectors != 0) {
-        delete[] selectors;
-    }
-    if(gradInputWrapper != 0) {
-        delete gradInputWrapper;
-    }
-    if(gradInput != 0) {
-        delete[] gradInput;
-    }
+    delete selectorsWrapper;
+    delete gradInputWrapper;
     this->batchSize = batchSize;
     this->allocatedSize = batchSize;
-    output = new float[ getOutputNumElements() ];
-    outputWrapper = cl->wrap(getOutputNumElements(), output);
-    selectors = new int[ getOutputNumElements() ];
-    selectorsWrapper = cl->wrap(getOutputNumElements(), selectors);
-    gradInput = new float[ previousLayer->getOutputNumElements() ];
-    gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
-    gradInputWrapper->createOnDevice();
+    // forward writes the selectors, even if backward never reads them
+    selectorsWrapper = new CLDeviceWrapper(cl, getOutputNumElements());
+    if(inference) {
+        // output comes from setOutputView, and there's no backward
+        return;
+    }
+    outputWrapper = new CLDeviceWrapper(cl, getOutputNumElements());
+    gradInputWrapper = new CLDeviceWrapper(cl, previousLayer->getOutputNumElements());
+}
+VIRTUAL bool PoolingLayer::takesOutputView() const {
+    return true;
+}
+VIRTUAL void PoolingLayer::setOutputView(CLDeviceWrapper *outputView) {
+    outputWrapper = outputView;
 }
 VIRTUAL int PoolingLayer::getOutputNumElements() {
     return batchSize * numPlanes * outputSize * outputSize;
 }
 VIRTUAL float *PoolingLayer::getOutput() {
-    if(outputWrapper->isDeviceDirty()) {
-        outputWrapper->copyToHost();
-//        outputCopiedToHost = true;
-    }
-    return output;
+    return outputWrapper->copyToStaging();
 }
 VIRTUAL bool PoolingLayer::needsBackProp() {
     return previousLayer->needsBackProp();
@@ -152,7 +135,7 @@ VIRTUAL CLWrapper *PoolingLayer::getOutputWrapper() {
     return outputWrapper;
 }
 VIRTUAL float *PoolingLayer::getGradInput() {
-    return gradInput;
+    return gradInputWrapper->copyToStaging();
 }
 VIRTUAL ActivationFunction const *PoolingLayer::getActivationFunction() {
     //return previousLayer->getActivationFunction(); // I guess???
@@ -164,13 +147,11 @@ VIRTUAL void PoolingLayer::forward() {
         upstreamOutputWrapper = previousLayer->getOutputWrapper();
     } else {
         float *upstreamOutput = previousLayer->getOutput();
-        upstreamOutputWrapper = cl->wrap(previousLayer->getOutputNumElements(), upstreamOutput);
+        upstreamOutputWrapper = upstreamWrapperCache->wrap(previousLayer->getOutputNumElements(), upstreamOutput);
         upstreamOutputWrapper->copyToDevice();
     }
+    outputWrapper->releaseStaging();
     poolingForwardImpl->forward(batchSize, upstreamOutputWrapper, selectorsWrapper, outputWrapper);
-    if(!previousLayer->hasOutputWrapper()) {
-        delete upstreamOutputWrapper;
-    }
 
 //    cout << "PoolingLayer::forward() selectors after forward: " << endl;
 //    for(int i = 0; i < outputSize; i++) {
@@ -187,13 +168,11 @@ VIRTUAL void PoolingLayer::backward() {
     // have no weights to backprop to, just need to backprop the errors
 
     CLWrapper *gradOutputWrapper = 0;
-    bool weOwnErrorsWrapper = false;
     if(nextLayer->providesGradInputWrapper()) {
         gradOutputWrapper = nextLayer->getGradInputWrapper();
     } else {
-        gradOutputWrapper = cl->wrap(getOutputNumElements(), nextLayer->getGradInput());
+        gradOutputWrapper = gradOutputWrapperCache->wrap(getOutputNumElements(), nextLayer->getGradInput());
         gradOutputWrapper->copyToDevice();
-        weOwnErrorsWrapper = true;
     }
 
 //    cout << "PoolingLayer::backward selectorsWrapper:" << endl;
@@ -219,6 +198,7 @@ VIRTUAL void PoolingLayer::backward() {
 
 //    selectorsWrapper->copyToHost();
 
+    gradInputWrapper->releaseStaging();
     poolingBackpropImpl->backward(batchSize, gradOutputWrapper, selectorsWrapper, gradInputWrapper);
 
 //    gradInputWrapper->copyToHost();
@@ -236,9 +216,6 @@ VIRTUAL void PoolingLayer::backward() {
 //        cout << endl;
 //    }
 
-    if(weOwnErrorsWrapper) {
-        delete gradOutputWrapper;
-    }
 }
 VIRTUAL std::string PoolingLayer::asString() const {
     return "PoolingLayer{ inputPlanes=" + toString(numPlanes) + " inputSize=" + toString(inputSize) + " poolingSize=" + toString(poolingSize) + " }";
@@ -17,6 +17,8 @@ class PoolingForward;
 class PoolingBackward;
 
 class PoolingMaker;
+class CLWrapperCache;
+class CLDeviceWrapper;
 
 class PoolingLayer : public Layer {
 public:
@@ -31,13 +33,14 @@ public:
     PoolingForward *poolingForwardImpl;
     PoolingBackward *poolingBackpropImpl;
 
-    float *output;
-    int *selectors;
-    float *gradInput;
+    // device only, see CLDeviceWrapper.  the selectors are ints
+    CLDeviceWrapper *outputWrapper;
+    CLDeviceWrapper *selectorsWrapper;
+    CLDeviceWrapper *gradInputWrapper;
 
-    CLWrapper *outputWrapper;
-    CLWrapper *selectorsWrapper;
-    CLWrapper *gradInputWrapper;
+    // only used if our neighbours dont have their own wrappers
+    CLWrapperCache *upstreamWrapperCache;
+    CLWrapperCache *gradOutputWrapperCache;
 
 //    bool outputCopiedToHost;
 //    bool gradInputCopiedToHost;
@@ -54,6 +57,8 @@ public:
     VIRTUAL ~PoolingLayer();
     VIRTUAL std::string getClassName() const;
     VIRTUAL void setBatchSize(int batchSize);
+    VIRTUAL bool takesOutputView() const;
+    VIRTUAL void setOutputView(CLDeviceWrapper *outputView);
     VIRTUAL int getOutputNumElements();
     VIRTUAL float *getOutput();
     VIRTUAL bool needsBackProp();
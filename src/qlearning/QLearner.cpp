@@ -4,8 +4,14 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
 #include "net/NeuralNet.h"
 #include "qlearning/array_helper.h"
+#include "util/stringhelper.h"
+#include "qlearning/ReplayMemory.h"
 #include "trainers/Trainer.h"
 #include "qlearning/QLearner.h"
 
@@ -25,134 +31,310 @@ QLearner::QLearner(Trainer *trainer, Scenario *scenario, NeuralNet *net) :
     planes = scenario->getPerceptionPlanes();
     numActions = scenario->getNumActions();
 
-    lastPerception = new float[ size * size * planes ];
+    numEnvironments = 1;
+    replayCapacity = 10000;
+    histories.push_back(new ReplayMemory(replayCapacity, size * size * planes));
+    lastActions.push_back(-1);
+    priorityExponent = 0.6f;
+    importanceExponent = 0.4f;
+    allocatedBatchSize = 0;
+    samples = 0;
+    sampleHistories = 0;
+    batch = 0;
+    expectedValues = 0;
+    sampleWeights = 0;
     game = 0;
-    lastAction = -1;
 }
 
 QLearner::~QLearner() {
-    delete[] lastPerception;
+    delete[] sampleWeights;
+    delete[] expectedValues;
+    delete[] batch;
+    delete[] sampleHistories;
+    delete[] samples;
+    for(int i = 0; i < (int)histories.size(); i++) {
+        delete histories[i];
+    }
+}
+
+// the environments stepped together by stepAll(), each with its own history,
+// sharing replayCapacity between them; call before the first step
+void QLearner::setNumEnvironments(int numEnvironments) {
+    if(numEnvironments < 1) {
+        throw runtime_error("QLearner needs at least 1 environment, not " + toString(numEnvironments));
+    }
+    for(int i = 0; i < this->numEnvironments; i++) {
+        if(lastActions[i] != -1) {
+            throw runtime_error("QLearner::setNumEnvironments: call before the first step");
+        }
+    }
+    bool prioritized = histories[0]->isPrioritized();
+    for(int i = 0; i < (int)histories.size(); i++) {
+        delete histories[i];
+    }
+    histories.clear();
+    lastActions.clear();
+    this->numEnvironments = numEnvironments;
+    for(int i = 0; i < numEnvironments; i++) {
+        histories.push_back(new ReplayMemory(capacityPerEnvironment(), size * size * planes));
+        histories[i]->setPrioritized(prioritized);
+        lastActions.push_back(-1);
+    }
+}
+
+int QLearner::getNumEnvironments() {
+    return numEnvironments;
+}
+
+int QLearner::getPerceptionCubeSize() {
+    return size * size * planes;
+}
+
+// keeps the most recent transitions, as many as fit
+void QLearner::setReplayCapacity(int replayCapacity) {
+    if(replayCapacity < numEnvironments) {
+        throw runtime_error("QLearner replayCapacity must be at least 1 per environment, not " +
+            toString(replayCapacity));
+    }
+    this->replayCapacity = replayCapacity;
+    for(int i = 0; i < numEnvironments; i++) {
+        histories[i]->setCapacity(capacityPerEnvironment());
+    }
+}
+
+int QLearner::getReplayCapacity() {
+    return replayCapacity;
+}
+
+// samples past moves in proportion to how wrong q was about them, last time
+// they were seen, rather than uniformly
+void QLearner::setPrioritizedReplay(bool prioritizedReplay) {
+    for(int i = 0; i < numEnvironments; i++) {
+        histories[i]->setPrioritized(prioritizedReplay);
+    }
+}
+
+// rounds down, so all the histories together hold at most replayCapacity,
+// except that each holds at least one
+int QLearner::capacityPerEnvironment() {
+    return std::max(1, replayCapacity / numEnvironments);
+}
+
+void QLearner::ensureBatchAllocated(int batchSize) {
+    if(batchSize <= allocatedBatchSize) {
+        return;
+    }
+    delete[] sampleWeights;
+    delete[] expectedValues;
+    delete[] batch;
+    delete[] sampleHistories;
+    delete[] samples;
+    samples = new int[ batchSize ];
+    sampleHistories = new int[ batchSize ];
+    batch = new float[ 2 * batchSize * planes * size * size ];
+    expectedValues = new float[ batchSize * numActions ];
+    sampleWeights = new float[ batchSize ];
+    allocatedBatchSize = batchSize;
+}
+
+int QLearner::numAvailableSamples() {
+    int available = 0;
+    for(int i = 0; i < numEnvironments; i++) {
+        available += histories[i]->size();
+    }
+    return available;
+}
+
+// with prioritized replay, draws one sample from each of batchSize equal
+// slices of the total priority, and weights each by 1 / (N * P(sample)) to
+// the power importanceExponent, scaled so the biggest weight is 1, to make
+// up for sampling some more often than others
+// with several environments, the slices run across their histories in turn
+void QLearner::drawSamples(int batchSize) {
+    const int availableSamples = numAvailableSamples();
+    if(!histories[0]->isPrioritized()) {
+        for(int n = 0; n < batchSize; n++) {
+            int sample = myrand() % availableSamples;
+            int h = 0;
+            while(sample >= histories[h]->size()) {
+                sample -= histories[h]->size();
+                h++;
+            }
+            sampleHistories[n] = h;
+            samples[n] = sample;
+            sampleWeights[n] = 1.0f;
+        }
+        return;
+    }
+    float total = 0;
+    for(int h = 0; h < numEnvironments; h++) {
+        if(histories[h]->size() > 0) {
+            total += histories[h]->getTotalPriority();
+        }
+    }
+    const float slice = total / batchSize;
+    float maxWeight = 0;
+    for(int n = 0; n < batchSize; n++) {
+        float value = (n + (myrand() % 10000) / 10000.0f) * slice;
+        int h = 0;
+        int lastNonEmpty = 0;
+        for(h = 0; h < numEnvironments; h++) {
+            if(histories[h]->size() == 0) {
+                continue;
+            }
+            lastNonEmpty = h;
+            float historyTotal = histories[h]->getTotalPriority();
+            if(value < historyTotal) {
+                break;
+            }
+            value -= historyTotal;
+        }
+        if(h == numEnvironments) {
+            // rounding took us past the end, so take the last sample there is
+            h = lastNonEmpty;
+            value = histories[h]->getTotalPriority();
+        }
+        sampleHistories[n] = h;
+        samples[n] = histories[h]->sample(value);
+        float probability = histories[h]->getPriority(samples[n]) / total;
+        sampleWeights[n] = pow(availableSamples * probability, -importanceExponent);
+        if(sampleWeights[n] > maxWeight) {
+            maxWeight = sampleWeights[n];
+        }
+    }
+    for(int n = 0; n < batchSize; n++) {
+        sampleWeights[n] /= maxWeight;
+    }
 }
 
 void QLearner::learnFromPast() {
-    const int availableSamples = history.size();
+    const int availableSamples = numAvailableSamples();
     int batchSize = availableSamples >= maxSamples ? maxSamples : availableSamples;
-//    batchSize = ;
-    const int size = scenario->getPerceptionSize();
-    const int numActions = scenario->getNumActions();
-    net->setBatchSize(batchSize);
+    const int perceptionSize = planes * size * size;
+    ensureBatchAllocated(batchSize);
 
 //    cout << "batchSize: " << batchSize << endl;
 
-    // draw samples
-    Experience **experiences = new Experience *[ batchSize ];
-    for(int n = 0; n < batchSize; n++) {
-        int sampleIdx = myrand() % availableSamples;
-        Experience *experience = history[sampleIdx];
-        experiences[n] = experience;
-    }    
-
-    // copy in data 
-    float *afters = new float[ batchSize * planes * size * size ];
-    float *befores = new float[ batchSize * planes * size * size ];
+    drawSamples(batchSize);
+
+    // copy in data: befores, then afters, so one forward prop gives q for
+    // both
+    float *befores = batch;
+    float *afters = batch + batchSize * perceptionSize;
     for(int n = 0; n < batchSize; n++) {
-        Experience *experience = experiences[n]; 
-        arrayCopy(afters + n * planes * size * size, experience->after, planes * size * size);
-        arrayCopy(befores + n * planes * size * size, experience->before, planes * size * size);
+        histories[sampleHistories[n]]->gather(1, samples + n, befores + n * perceptionSize,
+            afters + n * perceptionSize);
     }
-
-    // get next q values, based on forward prop 'afters'
-    net->forward(afters);
+    net->setBatchSize(2 * batchSize);
+    net->forward(batch);
     float const *allOutput = net->getOutput();
-    float *bestQ = new float[ batchSize ];
-    int *bestAction = new int[ batchSize ];
+
+    // set up expected values, from the best q values for the 'afters', and
+    // backprop new q values for the 'befores'
+    arrayCopy(expectedValues, allOutput, batchSize * numActions);
     for(int n = 0; n < batchSize; n++) {
-        float const *output = allOutput + n * numActions;
-        float thisBestQ = output[0];
-        int thisBestAction = 0;
+        float const *afterOutput = allOutput + (batchSize + n) * numActions;
+        float bestQ = afterOutput[0];
         for(int action = 1; action < numActions; action++) {
-            if(output[action] > thisBestQ) {
-                thisBestQ = output[action];
-                thisBestAction = action;
+            if(afterOutput[action] > bestQ) {
+                bestQ = afterOutput[action];
             }
         }
-        bestQ[n] = thisBestQ;
-        bestAction[n] = thisBestAction;
-    }
-    // forward prop 'befores', set up expected values, and backprop
-    // new q values
-    net->forward(befores);
-    allOutput = net->getOutput();
-    float *expectedValues = new float[ numActions * batchSize ];
-    arrayCopy(expectedValues, allOutput, batchSize * numActions);
-    for(int n = 0; n < batchSize; n++) {
-        Experience *experience = experiences[n]; 
-        if(experience->isEndState) {
-            expectedValues[ n * numActions + experience->action ] = experience->reward; 
-        } else {
-            expectedValues[ n * numActions + experience->action ] = experience->reward + lambda * bestQ[n];        
+        ReplayMemory *history = histories[sampleHistories[n]];
+        int action = history->getAction(samples[n]);
+        float target = history->getReward(samples[n]);
+        if(!history->getIsEndState(samples[n])) {
+            target += lambda * bestQ;
+        }
+        float q = expectedValues[ n * numActions + action ];
+        // moving the target only sampleWeight of the way from q scales this
+        // sample's gradient, under a square loss, by sampleWeight
+        expectedValues[ n * numActions + action ] = q + sampleWeights[n] * (target - q);
+        if(history->isPrioritized()) {
+            history->setPriority(samples[n], pow(fabs(target - q) + 0.01f, priorityExponent));
         }
     }
     // backprop...
 //    throw runtime_error("need to implement this");
     TrainingContext context(epoch, 0);
+    net->setBatchSize(batchSize);
     trainer->train(net, &context, befores, expectedValues);
 //    net->backward(learningRate / batchSize, expectedValues);
-    net->setBatchSize(1);
 
     epoch++;
-
-    delete[] expectedValues;
-    delete[] bestQ;
-    delete[] bestAction;
-    delete[] afters;
-    delete[] befores;
-    delete[] experiences;
 }
 
 // this is now a scenario-free zone, and therefore no callbacks, and easy to wrap with
 // swig, cython etc.
 int QLearner::step(float lastReward, bool wasReset, float *perception) { // do one frame
-    if(lastAction != -1) {
-        Experience *experience = new Experience(); 
-        experience->action = lastAction;
-        experience->reward = lastReward;
-        experience->isEndState = wasReset;
-        experience->before = new float[ size * size * planes ];
-        arrayCopy(experience->before, this->lastPerception, size * size * planes);
-//        scenario->getPerception(perception);
-        experience->after = new float[ size * size * planes ];
-        arrayCopy(experience->after, perception, size * size * planes);
-        history.push_back(experience);
-        if(wasReset) {
+    if(numEnvironments != 1) {
+        throw runtime_error("QLearner::step: there are " + toString(numEnvironments) +
+            " environments, so use stepAll");
+    }
+    int action = -1;
+    stepAll(&lastReward, &wasReset, perception, &action);
+    return action;
+}
+
+// one frame for each environment: perceptions is [numEnvironments][planes][size][size],
+// and an action comes back for each, all picked with a single forward prop
+void QLearner::stepAll(float const *lastRewards, bool const *wasResets, float const *perceptions,
+        int *actions) {
+    const int perceptionSize = size * size * planes;
+    bool learnt = false;
+    for(int i = 0; i < numEnvironments; i++) {
+        float const *perception = perceptions + i * perceptionSize;
+        if(lastActions[i] == -1) {
+            histories[i]->addFrame(perception);
+            continue;
+        }
+        // the previous perception is already in history, as the after of the
+        // previous transition, so this only adds the new one
+        histories[i]->addTransition(lastActions[i], lastRewards[i], wasResets[i], perception);
+        if(wasResets[i]) {
             game++;
         }
+        learnt = true;
+    }
+    if(learnt) {
         learnFromPast();
     }
 //        cout << "see: " << toString(perception, perceptionSize + numActions) << endl;
-    int action = -1;
-    if(lastAction == -1 || (myrand() % 10000 / 10000.0f) <= epsilon) {
-        action = myrand() % numActions;
+    bool anyExploiting = false;
+    for(int i = 0; i < numEnvironments; i++) {
+        if(lastActions[i] == -1 || (myrand() % 10000 / 10000.0f) <= epsilon) {
+            actions[i] = myrand() % numActions;
 //            cout << "action, rand: " << action << endl;
-    } else {
-        net->setBatchSize(1);
-        net->forward(perception);
-        float highestQ = 0;
-        int bestAction = 0;
-        float const*output = net->getOutput();
-        for(int i = 0; i < numActions; i++) {
-            if(i == 0 || output[i] > highestQ) {
-                highestQ = output[i];
-                bestAction = i;
-            }
+        } else {
+            actions[i] = -1;
+            anyExploiting = true;
         }
-        action = bestAction;
+    }
+    if(anyExploiting) {
+        net->setBatchSize(numEnvironments);
+        net->forward(perceptions);
+        float const *allOutput = net->getOutput();
+        for(int i = 0; i < numEnvironments; i++) {
+            if(actions[i] != -1) {
+                continue;
+            }
+            float const *output = allOutput + i * numActions;
+            float highestQ = 0;
+            int bestAction = 0;
+            for(int action = 0; action < numActions; action++) {
+                if(action == 0 || output[action] > highestQ) {
+                    highestQ = output[action];
+                    bestAction = action;
+                }
+            }
+            actions[i] = bestAction;
 //            cout << "action, q: " << action << endl;
+        }
     }
-    arrayCopy(this->lastPerception, perception, size * size * planes);
 //        printDirections(net, scenario->height, scenario->width);
-    this->lastAction = action;
-    return action;
+    for(int i = 0; i < numEnvironments; i++) {
+        lastActions[i] = actions[i];
+    }
 }
 
 void QLearner::run() {
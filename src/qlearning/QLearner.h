@@ -16,15 +16,7 @@
 #include "DeepCLDllExport.h"
 
 class NeuralNet;
-
-class Experience {
-public:
-    float *before;
-    int action;
-    float reward;
-    bool isEndState;
-    float *after;
-};
+class ReplayMemory;
 
 class DeepCL_EXPORT QLearner {
     int epoch;
@@ -34,6 +26,8 @@ public:
     // following 4 parameters are user-configurable:
     float lambda; // means: how far into the future do we look? (any number from 0.0 to 1.0 is possible)
     int maxSamples;  // how many samples from history do we revise after each action? (default: 32)
+                     // history holds the last replayCapacity transitions (default: 10000), shared
+                     // out between the environments, if there's more than one, rounding down
     float epsilon; // probability of exploring, instead of exploiting, 0.0 to 1.0 ok
 //    float learningRate; // learning rate for the neuralnet; depends on what is appropriate for your particular
 //                        // network design
@@ -41,6 +35,8 @@ public:
     QLearner(Trainer *trainer, Scenario *scenario, NeuralNet *net);
     // do one frame:
     int step(float lastReward, bool wasReset, float *perception);
+    // do one frame in each of numEnvironments environments at once:
+    void stepAll(float const *lastRewards, bool const *wasResets, float const *perceptions, int *actions);
     void run();  // main entry point
     virtual ~QLearner();
 
@@ -49,6 +45,12 @@ public:
     void setLambda(float lambda) { this->lambda = lambda; }
     void setMaxSamples(int maxSamples) { this->maxSamples = maxSamples; }
     void setEpsilon(float epsilon) { this->epsilon = epsilon; }
+    void setNumEnvironments(int numEnvironments);
+    int getNumEnvironments();
+    int getPerceptionCubeSize(); // floats per environment, in stepAll's perceptions
+    void setReplayCapacity(int replayCapacity);
+    int getReplayCapacity();
+    void setPrioritizedReplay(bool prioritizedReplay);
 //    void setLearningRate(float learningRate) { this->learningRate = learningRate; }
 
 protected:
@@ -57,13 +59,27 @@ protected:
     int numActions;
 
   //  float *perception;
-    float *lastPerception;
     int game;
-    int lastAction;
+    int numEnvironments;
+    std::vector< int > lastActions; // one per environment, -1 before its first step
 
     MT19937 myrand;
 
-    std::vector< Experience * > history;
+    std::vector< ReplayMemory * > histories; // one per environment
+    int replayCapacity; // across all the histories
+    float priorityExponent; // how much prioritized replay favours surprising samples, 0 being not at all
+    float importanceExponent; // how much of that bias the sample weights take out, 1 being all of it
+    // learnFromPast's batches, kept from one step to the next
+    int allocatedBatchSize;
+    int *samples;
+    int *sampleHistories;
+    float *batch; // befores, then afters
+    float *expectedValues;
+    float *sampleWeights;
+    int capacityPerEnvironment();
+    int numAvailableSamples();
+    void ensureBatchAllocated(int batchSize);
+    void drawSamples(int batchSize);
     Scenario *scenario; // NOT belong to us, dont delete
     NeuralNet *net; // NOT belong to us, dont delete
 };
@@ -99,9 +99,17 @@ public:
         int action = qlearner->step(lastReward, wasReset, perception);
         return action;
     }
+    // one step in each of getNumEnvironments() environments, see QLearner::stepAll
+    void stepAll(float const *lastRewards, bool const *wasResets, float const *perceptions, int *actions) {
+        qlearner->stepAll(lastRewards, wasResets, perceptions, actions);
+    }
+    void setNumEnvironments(int numEnvironments) { qlearner->setNumEnvironments(numEnvironments); }
+    int getNumEnvironments() { return qlearner->getNumEnvironments(); }
     void setLambda(float lambda) { qlearner->setLambda(lambda); }
     void setMaxSamples(int maxSamples) { qlearner->setMaxSamples(maxSamples); }
     void setEpsilon(float epsilon) { qlearner->setEpsilon(epsilon); }
+    void setReplayCapacity(int replayCapacity) { qlearner->setReplayCapacity(replayCapacity); }
+    void setPrioritizedReplay(bool prioritizedReplay) { qlearner->setPrioritizedReplay(prioritizedReplay); }
 //    void setLearningRate(float learningRate) { qlearner->setLearningRate(learningRate); }
 };
 
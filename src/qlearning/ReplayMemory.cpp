@@ -0,0 +1,205 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cstring>
+#include <stdexcept>
+
+#include "util/stringhelper.h"
+#include "qlearning/SumTree.h"
+#include "qlearning/ReplayMemory.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC ReplayMemory::ReplayMemory(int capacity, int frameSize) :
+        capacity(capacity),
+        frameSize(frameSize),
+        numFrames(0),
+        count(0),
+        priorities(0),
+        maxPriority(1.0f) {
+    if(capacity < 1) {
+        throw runtime_error("ReplayMemory capacity must be at least 1, not " + toString(capacity));
+    }
+    frames = new float[(long)(capacity + 1) * frameSize];
+    actions = new int[capacity];
+    rewards = new float[capacity];
+    isEndStates = new bool[capacity];
+}
+PUBLIC ReplayMemory::~ReplayMemory() {
+    delete priorities;
+    delete[] isEndStates;
+    delete[] rewards;
+    delete[] actions;
+    delete[] frames;
+}
+PUBLIC int ReplayMemory::getCapacity() const {
+    return capacity;
+}
+PUBLIC int ReplayMemory::getFrameSize() const {
+    return frameSize;
+}
+// number of transitions held, at most capacity
+PUBLIC int ReplayMemory::size() const {
+    return count;
+}
+// the first perception, which has no transition leading to it
+PUBLIC void ReplayMemory::addFrame(float const *frame) {
+    memcpy(frameAt(numFrames), frame, sizeof(float) * frameSize);
+    numFrames++;
+}
+// the transition from the latest frame, taking action, to after, which
+// becomes the latest frame
+PUBLIC void ReplayMemory::addTransition(int action, float reward, bool isEndState, float const *after) {
+    if(numFrames == 0) {
+        throw runtime_error("ReplayMemory::addTransition: call addFrame first, for the first perception");
+    }
+    long transition = numFrames - 1;
+    int newSlot = (int)(transition % capacity);
+    actions[newSlot] = action;
+    rewards[newSlot] = reward;
+    isEndStates[newSlot] = isEndState;
+    if(priorities != 0) {
+        priorities->set(newSlot, maxPriority);
+    }
+    addFrame(after);
+    if(count < capacity) {
+        count++;
+    }
+}
+PUBLIC float const *ReplayMemory::getBefore(int transition) const {
+    return frameAt(absoluteTransition(transition));
+}
+PUBLIC float const *ReplayMemory::getAfter(int transition) const {
+    return frameAt(absoluteTransition(transition) + 1);
+}
+PUBLIC int ReplayMemory::getAction(int transition) const {
+    return actions[slot(transition)];
+}
+PUBLIC float ReplayMemory::getReward(int transition) const {
+    return rewards[slot(transition)];
+}
+PUBLIC bool ReplayMemory::getIsEndState(int transition) const {
+    return isEndStates[slot(transition)];
+}
+// copies the befores and afters of numSamples transitions into
+// [numSamples][frameSize] arrays, ready to forward as a batch
+PUBLIC void ReplayMemory::gather(int numSamples, int const *transitions, float *befores, float *afters) {
+    for(int n = 0; n < numSamples; n++) {
+        long transition = absoluteTransition(transitions[n]);
+        memcpy(befores + (long)n * frameSize, frameAt(transition), sizeof(float) * frameSize);
+        memcpy(afters + (long)n * frameSize, frameAt(transition + 1), sizeof(float) * frameSize);
+    }
+}
+// keeps the most recent transitions, as many as fit
+PUBLIC void ReplayMemory::setCapacity(int capacity) {
+    if(capacity < 1) {
+        throw runtime_error("ReplayMemory capacity must be at least 1, not " + toString(capacity));
+    }
+    if(capacity == this->capacity) {
+        return;
+    }
+    int newCount = count < capacity ? count : capacity;
+    SumTree *newPriorities = priorities == 0 ? 0 : new SumTree(capacity);
+    float *newFrames = new float[(long)(capacity + 1) * frameSize];
+    int *newActions = new int[capacity];
+    float *newRewards = new float[capacity];
+    bool *newIsEndStates = new bool[capacity];
+    long firstFrame = numFrames == 0 ? 0 : numFrames - 1 - newCount;
+    for(long frame = firstFrame; frame < numFrames; frame++) {
+        memcpy(newFrames + (frame % (capacity + 1)) * frameSize, frameAt(frame), sizeof(float) * frameSize);
+    }
+    for(long transition = numFrames - 1 - newCount; transition < numFrames - 1; transition++) {
+        int oldSlot = (int)(transition % this->capacity);
+        int newSlot = (int)(transition % capacity);
+        newActions[newSlot] = actions[oldSlot];
+        newRewards[newSlot] = rewards[oldSlot];
+        newIsEndStates[newSlot] = isEndStates[oldSlot];
+        if(priorities != 0) {
+            newPriorities->set(newSlot, priorities->get(oldSlot));
+        }
+    }
+    delete priorities;
+    delete[] isEndStates;
+    delete[] rewards;
+    delete[] actions;
+    delete[] frames;
+    frames = newFrames;
+    actions = newActions;
+    rewards = newRewards;
+    isEndStates = newIsEndStates;
+    priorities = newPriorities;
+    this->capacity = capacity;
+    count = newCount;
+}
+// transitions held already start with priority 1
+PUBLIC void ReplayMemory::setPrioritized(bool prioritized) {
+    if(!prioritized) {
+        delete priorities;
+        priorities = 0;
+        return;
+    }
+    if(priorities != 0) {
+        return;
+    }
+    priorities = new SumTree(capacity);
+    maxPriority = 1.0f;
+    for(int transition = 0; transition < count; transition++) {
+        priorities->set(slot(transition), maxPriority);
+    }
+}
+PUBLIC bool ReplayMemory::isPrioritized() const {
+    return priorities != 0;
+}
+PUBLIC float ReplayMemory::getTotalPriority() const {
+    checkPrioritized();
+    return priorities->getTotal();
+}
+PUBLIC float ReplayMemory::getPriority(int transition) const {
+    checkPrioritized();
+    return priorities->get(slot(transition));
+}
+PUBLIC void ReplayMemory::setPriority(int transition, float priority) {
+    checkPrioritized();
+    priorities->set(slot(transition), priority);
+    if(priority > maxPriority) {
+        maxPriority = priority;
+    }
+}
+// the transition where the running total of priorities passes value, for
+// value in [0, getTotalPriority()), so, for value drawn uniformly, a
+// transition drawn in proportion to its priority
+PUBLIC int ReplayMemory::sample(float value) const {
+    checkPrioritized();
+    if(count == 0) {
+        throw runtime_error("ReplayMemory::sample: no transitions to sample from");
+    }
+    int oldestSlot = (int)((numFrames - 1 - count) % capacity);
+    return (priorities->find(value) - oldestSlot + capacity) % capacity;
+}
+PRIVATE void ReplayMemory::checkPrioritized() const {
+    if(priorities == 0) {
+        throw runtime_error("ReplayMemory: call setPrioritized(true) first");
+    }
+}
+PRIVATE int ReplayMemory::slot(int transition) const {
+    return (int)(absoluteTransition(transition) % capacity);
+}
+PRIVATE long ReplayMemory::absoluteTransition(int transition) const {
+    if(transition < 0 || transition >= count) {
+        throw runtime_error("ReplayMemory: transition " + toString(transition) + " out of range, holding " +
+            toString(count));
+    }
+    return numFrames - 1 - count + transition;
+}
+PRIVATE float *ReplayMemory::frameAt(long absoluteFrame) const {
+    return frames + (absoluteFrame % (capacity + 1)) * frameSize;
+}
+
@@ -0,0 +1,77 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+class SumTree;
+
+// the last capacity transitions seen by QLearner, for experience replay
+// the perceptions come in as one stream, and each transition goes from one
+// perception to the next, so each perception is stored once, as the after of
+// one transition, and the before of the next.  they're kept in one array,
+// as a ring of capacity + 1 frames, alongside a ring of capacity actions,
+// rewards and end flags.  once full, each new transition overwrites the
+// oldest
+// transitions are numbered from 0, the oldest still held, to size() - 1
+// once setPrioritized(true), each transition also has a priority, held in a
+// SumTree by slot, and sample() draws transitions in proportion to them;
+// new transitions get the highest priority given so far, so they're sure to
+// be seen soon
+class DeepCL_EXPORT ReplayMemory {
+    private:
+    int capacity;
+    int frameSize;
+    float *frames; // [capacity + 1][frameSize]
+    int *actions; // [capacity]
+    float *rewards;
+    bool *isEndStates;
+    long numFrames; // since the start, including ones overwritten
+    int count; // transitions held
+    SumTree *priorities; // [capacity], or 0 if not prioritized
+    float maxPriority;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ReplayMemory(int capacity, int frameSize);
+    ~ReplayMemory();
+    int getCapacity() const;
+    int getFrameSize() const;
+    int size() const;
+    void addFrame(float const *frame);
+    void addTransition(int action, float reward, bool isEndState, float const *after);
+    float const *getBefore(int transition) const;
+    float const *getAfter(int transition) const;
+    int getAction(int transition) const;
+    float getReward(int transition) const;
+    bool getIsEndState(int transition) const;
+    void gather(int numSamples, int const *transitions, float *befores, float *afters);
+    void setCapacity(int capacity);
+    void setPrioritized(bool prioritized);
+    bool isPrioritized() const;
+    float getTotalPriority() const;
+    float getPriority(int transition) const;
+    void setPriority(int transition, float priority);
+    int sample(float value) const;
+
+    private:
+    void checkPrioritized() const;
+    int slot(int transition) const;
+    long absoluteTransition(int transition) const;
+    float *frameAt(long absoluteFrame) const;
+
+    // [[[end]]]
+};
+
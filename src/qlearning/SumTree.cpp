@@ -0,0 +1,74 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "util/stringhelper.h"
+#include "qlearning/SumTree.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// all priorities start at 0
+PUBLIC SumTree::SumTree(int numItems) :
+        numItems(numItems) {
+    if(numItems < 1) {
+        throw runtime_error("SumTree needs at least 1 item, not " + toString(numItems));
+    }
+    nodes = new float[2 * numItems];
+    for(int i = 0; i < 2 * numItems; i++) {
+        nodes[i] = 0;
+    }
+}
+PUBLIC SumTree::~SumTree() {
+    delete[] nodes;
+}
+PUBLIC int SumTree::size() const {
+    return numItems;
+}
+PUBLIC float SumTree::getTotal() const {
+    return nodes[1];
+}
+PUBLIC float SumTree::get(int item) const {
+    return nodes[numItems + item];
+}
+PUBLIC void SumTree::set(int item, float priority) {
+    if(item < 0 || item >= numItems) {
+        throw runtime_error("SumTree::set: item " + toString(item) + " out of range, size " + toString(numItems));
+    }
+    if(priority < 0) {
+        throw runtime_error("SumTree::set: priority must not be negative, not " + toString(priority));
+    }
+    int node = numItems + item;
+    nodes[node] = priority;
+    // each sum is redone from its children, rather than adding the change,
+    // so rounding doesnt build up, and an all-zero subtree sums to exactly 0
+    for(node /= 2; node >= 1; node /= 2) {
+        nodes[node] = nodes[2 * node] + nodes[2 * node + 1];
+    }
+}
+// the item where the running total of priorities, in tree order, passes
+// value, for value in [0, getTotal()); never an item with priority 0, unless
+// they all are
+PUBLIC int SumTree::find(float value) const {
+    int node = 1;
+    while(node < numItems) {
+        float left = nodes[2 * node];
+        float right = nodes[2 * node + 1];
+        if(left > 0 && (value < left || right <= 0)) {
+            node = 2 * node;
+        } else {
+            value -= left;
+            node = 2 * node + 1;
+        }
+    }
+    return node - numItems;
+}
+
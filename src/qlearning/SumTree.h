@@ -0,0 +1,41 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// priorities for size items, where each node holds the sum of its two
+// children, so find() draws an item with probability proportional to its
+// priority, and set() updates the sums, both in O(log size)
+// node 1 is the root, the children of node i are 2i and 2i + 1, and item i
+// is the leaf at size + i
+class DeepCL_EXPORT SumTree {
+    private:
+    int numItems;
+    float *nodes; // [2 * numItems]
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    SumTree(int numItems);
+    ~SumTree();
+    int size() const;
+    float getTotal() const;
+    float get(int item) const;
+    void set(int item, float priority);
+    int find(float value) const;
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,126 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "qlearning/Scenario.h"
+#include "qlearning/QLearner.h"
+#include "util/ThreadPool.h"
+#include "util/stringhelper.h"
+#include "qlearning/VectorQLearner.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// acts on one scenario, and reads what it sees next
+class ScenarioActTask : public ThreadPoolTask {
+public:
+    Scenario * const *scenarios;
+    int const *actions;
+    float *lastRewards;
+    bool *wasResets;
+    float *perceptions;
+    int perceptionSize;
+    ScenarioActTask(Scenario * const *scenarios, int const *actions, float *lastRewards, bool *wasResets,
+            float *perceptions, int perceptionSize) :
+        scenarios(scenarios),
+        actions(actions),
+        lastRewards(lastRewards),
+        wasResets(wasResets),
+        perceptions(perceptions),
+        perceptionSize(perceptionSize) {
+    }
+    virtual void run(int index) {
+        Scenario *scenario = scenarios[index];
+        lastRewards[index] = scenario->act(actions[index]);
+        if(scenario->hasFinished()) {
+            scenario->reset();
+            wasResets[index] = true;
+        } else {
+            wasResets[index] = false;
+        }
+        scenario->getPerception(perceptions + index * perceptionSize);
+    }
+};
+
+// the scenarios must all see the same size of perception, and offer the same
+// actions
+PUBLIC VectorQLearner::VectorQLearner(Trainer *trainer, std::vector<Scenario *> const &scenarios,
+        NeuralNet *net, int numThreads) :
+        scenarios(scenarios),
+        threadPool(0) {
+    if(scenarios.size() == 0) {
+        throw runtime_error("VectorQLearner needs at least one scenario");
+    }
+    Scenario *first = scenarios[0];
+    for(int i = 1; i < (int)scenarios.size(); i++) {
+        if(scenarios[i]->getPerceptionSize() != first->getPerceptionSize() ||
+                scenarios[i]->getPerceptionPlanes() != first->getPerceptionPlanes() ||
+                scenarios[i]->getNumActions() != first->getNumActions()) {
+            throw runtime_error("VectorQLearner: scenario " + toString(i) +
+                " doesnt match scenario 0, in perception size, planes, or number of actions");
+        }
+    }
+    int numEnvironments = (int)scenarios.size();
+    int perceptionSize = first->getPerceptionSize() * first->getPerceptionSize() * first->getPerceptionPlanes();
+    qlearner = new QLearner(trainer, first, net);
+    qlearner->setNumEnvironments(numEnvironments);
+    if(numThreads > 1) {
+        threadPool = new ThreadPool(numThreads);
+    }
+    perceptions = new float[numEnvironments * perceptionSize];
+    lastRewards = new float[numEnvironments];
+    wasResets = new bool[numEnvironments];
+    actions = new int[numEnvironments];
+    for(int i = 0; i < numEnvironments; i++) {
+        lastRewards[i] = 0;
+        wasResets[i] = false;
+        scenarios[i]->getPerception(perceptions + i * perceptionSize);
+    }
+}
+PUBLIC VectorQLearner::~VectorQLearner() {
+    delete[] actions;
+    delete[] wasResets;
+    delete[] lastRewards;
+    delete[] perceptions;
+    delete threadPool;
+    delete qlearner;
+    for(int i = 0; i < (int)scenarios.size(); i++) {
+        delete scenarios[i];
+    }
+}
+// for setLambda, setMaxSamples, and so on
+PUBLIC QLearner *VectorQLearner::getQLearner() {
+    return qlearner;
+}
+PUBLIC int VectorQLearner::getNumEnvironments() const {
+    return (int)scenarios.size();
+}
+// one frame in every scenario
+PUBLIC void VectorQLearner::step() {
+    int numEnvironments = (int)scenarios.size();
+    qlearner->stepAll(lastRewards, wasResets, perceptions, actions);
+    Scenario *first = scenarios[0];
+    int perceptionSize = first->getPerceptionSize() * first->getPerceptionSize() * first->getPerceptionPlanes();
+    ScenarioActTask task(&scenarios[0], actions, lastRewards, wasResets, perceptions, perceptionSize);
+    if(threadPool != 0) {
+        threadPool->run(numEnvironments, &task);
+        return;
+    }
+    for(int i = 0; i < numEnvironments; i++) {
+        task.run(i);
+    }
+}
+PUBLIC void VectorQLearner::run() {
+    while(true) {
+        step();
+    }
+}
+
@@ -0,0 +1,62 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+class Scenario;
+class NeuralNet;
+class Trainer;
+class QLearner;
+class ThreadPool;
+
+// runs one QLearner over several Scenarios at once, like QLearner::run does
+// for one: each step, the scenarios' perceptions go into one batch, and all
+// their actions come from a single forward prop, via QLearner::stepAll
+// the scenarios belong to us, and are deleted with us
+// with numThreads more than 1, the scenarios act on worker threads, so they
+// mustnt share state, or call into python
+class DeepCL_EXPORT VectorQLearner {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<Scenario *> scenarios;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    QLearner *qlearner;
+    ThreadPool *threadPool; // 0 to run the scenarios on this thread
+
+    float *perceptions; // [numEnvironments][planes][size][size]
+    float *lastRewards;
+    bool *wasResets;
+    int *actions;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    VectorQLearner(Trainer *trainer, std::vector<Scenario *> const &scenarios,
+    NeuralNet *net, int numThreads);
+    ~VectorQLearner();
+    QLearner *getQLearner();
+    int getNumEnvironments() const;
+    void step();
+    void run();
+
+    // [[[end]]]
+};
+
@@ -5,9 +5,12 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <iostream>
+#include <cmath>
 
+#include "EasyCL.h"
 #include "util/stringhelper.h"
 #include "net/NeuralNet.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "layer/Layer.h"
 #include "loss/LossLayer.h"
 #include "trainers/AdadeltaStateMaker.h"
@@ -15,7 +18,6 @@
 #include "trainers/Adadelta.h"
 #include "loss/IAcceptsLabels.h"
 #include "batch/NetAction.h"
-#include "clmath/CLMathWrapper.h"
 #include "batch/BatchData.h"
 
 //#include "test/Sampler.h"
@@ -27,6 +29,18 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
+// one Adadelta step, on whatever Trainer::_updateWeights hands us
+class AdadeltaWeightsUpdate : public WeightsUpdate {
+public:
+    Adadelta *trainer;
+    AdadeltaWeightsUpdate(Adadelta *trainer) :
+        trainer(trainer) {
+    }
+    virtual void update(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
+            TrainerState *trainerState) {
+        trainer->updateWeights(weightsWrapper, gradWeightsWrapper, dynamic_cast< AdadeltaState * >(trainerState));
+    }
+};
 
 VIRTUAL Adadelta::~Adadelta() {
 }
@@ -40,41 +54,29 @@ VIRTUAL void Adadelta::updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradW
     // update = - sumUpdateSquared.sqrt() / sumGradSquared.sqrt() * grad
     // sumUpdateSquared = decay * sumUpdateSquared + (1 - decay) * update.squared()
     // weights += update
-
-    int numWeights = trainerState->numWeights;
-    float *working = new float[ numWeights ];
-    CLWrapper *workingWrapper = cl->wrap(numWeights, working);
-    workingWrapper->createOnDevice();
-
-    CLMathWrapper clWeights(weightsWrapper);
-    CLMathWrapper clGradWeights(gradWeightsWrapper);
-    CLMathWrapper clSumGradSquared(trainerState->sumGradSquaredWrapper);
-    CLMathWrapper clSumUpdateSquared(trainerState->sumUpdateSquaredWrapper);
-    CLMathWrapper clWorking(workingWrapper);
-
-    // following all happens on gpu, via clmathwrapper:
-    clWorking = clGradWeights;
-    clWorking.squared();
-    clWorking *= (1 - decay);
-    clSumGradSquared *= decay;
-    clSumGradSquared += clWorking;
-
-    clWorking = clSumGradSquared;
-    clWorking.inv();
-    clWorking *= clSumUpdateSquared;
-    clWorking.sqrt();
-    clWorking *= clGradWeights;
-    clWorking *= - 1;
-
-    clWeights += clWorking;
-
-    clSumUpdateSquared *= decay;
-    clWorking.squared();
-    clWorking *= (1 - decay);
-    clSumUpdateSquared += clWorking;
-
-    delete workingWrapper;
-    delete[] working;
+    // all in one kernel, from cl/Adadelta.cl, same maths as updateWeightsCpu
+    int N = weightsWrapper->size();
+    CLKernel *updateKernel = getUpdateKernel(weightsWrapper->getCl());
+    updateKernel->in(N)
+                ->in(decay)
+                ->inout(weightsWrapper)
+                ->in(gradWeightsWrapper)
+                ->inout(trainerState->sumGradSquaredWrapper)
+                ->inout(trainerState->sumUpdateSquaredWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    updateKernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
+// host version of updateWeights, for testing
+STATIC void Adadelta::updateWeightsCpu(int N, float decay, float *weights, float const *gradWeights,
+        float *sumGradSquared, float *sumUpdateSquared) {
+    for(int i = 0; i < N; i++) {
+        float grad = gradWeights[i];
+        sumGradSquared[i] = decay * sumGradSquared[i] + (1 - decay) * grad * grad;
+        float update = grad == 0 ? 0.0f : - sqrt(sumUpdateSquared[i] / sumGradSquared[i]) * grad;
+        weights[i] += update;
+        sumUpdateSquared[i] = decay * sumUpdateSquared[i] + (1 - decay) * update * update;
+    }
 }
 VIRTUAL BatchResult Adadelta::trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, OutputData *outputData) {
@@ -88,21 +90,8 @@ VIRTUAL BatchResult Adadelta::trainNet(NeuralNet *net, TrainingContext *context,
     float loss = net->calcLoss(outputData);
     net->backward(outputData);
 
-    int numLayers = net->getNumLayers();
-    for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
-        Layer *layer = net->getLayer(layerIdx);
-        if(!layer->needsBackProp()) {
-            break;
-        }
-        if(layer->needsTrainerState()) {
-            updateWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
-                dynamic_cast< AdadeltaState * >(layer->getTrainerState()) );
-            if(layer->biased()) {
-                updateWeights(layer->getBiasWrapper(), layer->getGradBiasWrapper(),
-                    dynamic_cast< AdadeltaState * >(layer->getBiasTrainerState()) );
-            }
-        }
-    }
+    AdadeltaWeightsUpdate update(this);
+    _updateWeights(net, &update);
     return BatchResult(loss, numRight);
 }
 VIRTUAL BatchResult Adadelta::trainNet(NeuralNet *net, TrainingContext *context,
@@ -119,6 +108,56 @@ VIRTUAL void Adadelta::bindState(NeuralNet *net) {
     AdadeltaStateMaker stateMaker;
     this->_bindState(net, &stateMaker);
 }
+// built once for each EasyCL, rather than once for the trainer, since the
+// columns of a concurrent MultiNet each have their own
+STATIC CLKernel *Adadelta::getUpdateKernel(EasyCL *cl) {
+    if(cl->kernelExists("Adadelta.updateWeights")) {
+        return cl->getKernel("Adadelta.updateWeights");
+    }
+    CLKernel *updateKernel = 0;
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("updateKernel", "cl/Adadelta.cl", "updateWeights", '""')
+    // ]]]
+    // generated using cog, from cl/Adadelta.cl:
+    const char * updateKernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// one Adadelta step, reading and writing each element of the weights and\n"
+    "// the state once, see Adadelta::updateWeightsCpu\n"
+    "kernel void updateWeights(\n"
+    "        const int N,\n"
+    "        const float decay,\n"
+    "        global float *weights,\n"
+    "        global const float *gradWeights,\n"
+    "        global float *sumGradSquared,\n"
+    "        global float *sumUpdateSquared\n"
+    "            ) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const float grad = gradWeights[globalId];\n"
+    "    const float newSumGradSquared = decay * sumGradSquared[globalId] + (1 - decay) * grad * grad;\n"
+    "    const float oldSumUpdateSquared = sumUpdateSquared[globalId];\n"
+    "    // a zero gradient gives a zero update, even once the sums have decayed\n"
+    "    // to zero, eg in the padding of a ParameterArena\n"
+    "    const float update = grad == 0 ? 0.0f : - sqrt(oldSumUpdateSquared / newSumGradSquared) * grad;\n"
+    "    sumGradSquared[globalId] = newSumGradSquared;\n"
+    "    weights[globalId] += update;\n"
+    "    sumUpdateSquared[globalId] = decay * oldSumUpdateSquared + (1 - decay) * update * update;\n"
+    "}\n"
+    "\n"
+    "";
+    updateKernel = cl->buildKernelFromString(updateKernelSource, "updateWeights", "", "cl/Adadelta.cl");
+    // [[[end]]]
+    cl->storeKernel("Adadelta.updateWeights", updateKernel, true);
+    return updateKernel;
+}
 STATIC Adadelta *Adadelta::instance(EasyCL *cl, float decay) {
     Adadelta *trainer = new Adadelta(cl, decay);
     return trainer;
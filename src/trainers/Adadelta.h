@@ -14,6 +14,7 @@
 #include "trainers/Trainer.h"
 
 class AdadeltaState;
+class CLKernel;
 class CLWrapper;
 class EasyCL;
 class OutputData;
@@ -37,6 +38,8 @@ public:
     VIRTUAL std::string asString();
     VIRTUAL void updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
     AdadeltaState *trainerState);
+    STATIC void updateWeightsCpu(int N, float decay, float *weights, float const *gradWeights,
+    float *sumGradSquared, float *sumUpdateSquared);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, OutputData *outputData);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
@@ -44,6 +47,7 @@ public:
     VIRTUAL BatchResult trainNetFromLabels(NeuralNet *net, TrainingContext *context,
     float const*input, int const*labels);
     VIRTUAL void bindState(NeuralNet *net);
+    STATIC CLKernel *getUpdateKernel(EasyCL *cl);
     STATIC Adadelta *instance(EasyCL *cl, float decay);
     Adadelta(EasyCL *cl, float decay);
 
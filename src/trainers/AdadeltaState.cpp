@@ -8,6 +8,7 @@
 
 #include "EasyCL.h"
 #include "util/StatefulTimer.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "trainers/AdadeltaState.h"
 
 using namespace std;
@@ -20,22 +21,14 @@ using namespace std;
 VIRTUAL AdadeltaState::~AdadeltaState() {
     delete sumGradSquaredWrapper;
     delete sumUpdateSquaredWrapper;
-    delete[] sumGradSquared;
-    delete[] sumUpdateSquared;
 }
 
 AdadeltaState::AdadeltaState(EasyCL *cl, int numWeights) :
         numWeights(numWeights) {
-    sumGradSquared = new float[numWeights];
-    sumUpdateSquared = new float[numWeights];
-    for(int i = 0; i < numWeights; i++) {
-        sumGradSquared[i] = 0.0000001f; // should move this into fudgefactor I guess?
-        sumUpdateSquared[i] = 0.0000001f; // should move this into fudgefactor I guess?
-    }
-    sumGradSquaredWrapper = cl->wrap(numWeights, sumGradSquared);
-    sumUpdateSquaredWrapper = cl->wrap(numWeights, sumUpdateSquared);
-    sumGradSquaredWrapper->copyToDevice();
-    sumUpdateSquaredWrapper->copyToDevice();
+    sumGradSquaredWrapper = new CLDeviceWrapper(cl, numWeights);
+    sumUpdateSquaredWrapper = new CLDeviceWrapper(cl, numWeights);
+    sumGradSquaredWrapper->fill(0.0000001f); // should move this into fudgefactor I guess?
+    sumUpdateSquaredWrapper->fill(0.0000001f);
 }
 
 
@@ -15,6 +15,7 @@
 
 class EasyCL;
 class CLKernel;
+class CLDeviceWrapper;
 
 #include "DeepCLDllExport.h"
 
@@ -25,11 +26,9 @@ class DeepCL_EXPORT AdadeltaState : public TrainerState {
 public:
     const int numWeights;
 
-    float *sumGradSquared;
-    float *sumUpdateSquared;
 
-    CLWrapper *sumGradSquaredWrapper;
-    CLWrapper *sumUpdateSquaredWrapper;
+    CLDeviceWrapper *sumGradSquaredWrapper;
+    CLDeviceWrapper *sumUpdateSquaredWrapper;
 
     // [[[cog
     // import cog_addheaders
@@ -5,9 +5,12 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <iostream>
+#include <cmath>
 
+#include "EasyCL.h"
 #include "util/stringhelper.h"
 #include "net/NeuralNet.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "layer/Layer.h"
 #include "loss/LossLayer.h"
 #include "trainers/AdagradStateMaker.h"
@@ -15,7 +18,6 @@
 #include "trainers/Adagrad.h"
 #include "loss/IAcceptsLabels.h"
 #include "batch/NetAction.h"
-#include "clmath/CLMathWrapper.h"
 #include "batch/BatchData.h"
 
 //#include "test/Sampler.h"
@@ -27,6 +29,18 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
+// one Adagrad step, on whatever Trainer::_updateWeights hands us
+class AdagradWeightsUpdate : public WeightsUpdate {
+public:
+    Adagrad *trainer;
+    AdagradWeightsUpdate(Adagrad *trainer) :
+        trainer(trainer) {
+    }
+    virtual void update(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
+            TrainerState *trainerState) {
+        trainer->updateWeights(weightsWrapper, gradWeightsWrapper, dynamic_cast< AdagradState * >(trainerState));
+    }
+};
 
 VIRTUAL Adagrad::~Adagrad() {
 }
@@ -39,31 +53,28 @@ VIRTUAL std::string Adagrad::asString() {
 }
 VIRTUAL void Adagrad::updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
         AdagradState *trainerState) {
-
-    int numWeights = trainerState->numWeights;
-    float *working = new float[ numWeights ];
-    CLWrapper *workingWrapper = cl->wrap(numWeights, working);
-    workingWrapper->createOnDevice();
-
-    CLMathWrapper clWeights(weightsWrapper);
-    CLMathWrapper clGradWeights(gradWeightsWrapper);
-    CLMathWrapper clSumSquares(trainerState->sumSquaresWrapper);
-    CLMathWrapper clWorking(workingWrapper);
-
-    // following all happens on gpu, via clmathwrapper:
-    clWorking = clGradWeights;
-    clWorking.squared();
-    clSumSquares += clWorking;
-
-    clWorking = clSumSquares;
-    clWorking.sqrt();
-    clWorking.inv();
-    clWorking *= clGradWeights;
-    clWorking *= - learningRate;
-    clWeights += clWorking;
-
-    delete workingWrapper;
-    delete[] working;
+    // all in one kernel, from cl/Adagrad.cl, same maths as updateWeightsCpu
+    int N = weightsWrapper->size();
+    CLKernel *updateKernel = getUpdateKernel(weightsWrapper->getCl());
+    updateKernel->in(N)
+                ->in(learningRate)
+                ->inout(weightsWrapper)
+                ->in(gradWeightsWrapper)
+                ->inout(trainerState->sumSquaresWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    updateKernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
+// host version of updateWeights, for testing
+STATIC void Adagrad::updateWeightsCpu(int N, float learningRate, float *weights, float const *gradWeights,
+        float *sumSquares) {
+    for(int i = 0; i < N; i++) {
+        float grad = gradWeights[i];
+        sumSquares[i] += grad * grad;
+        if(grad != 0) {
+            weights[i] -= learningRate * grad / sqrt(sumSquares[i]);
+        }
+    }
 }
 VIRTUAL BatchResult Adagrad::trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, OutputData *outputData) {
@@ -77,21 +88,8 @@ VIRTUAL BatchResult Adagrad::trainNet(NeuralNet *net, TrainingContext *context,
     float loss = net->calcLoss(outputData);
     net->backward(outputData);
 
-    int numLayers = net->getNumLayers();
-    for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
-        Layer *layer = net->getLayer(layerIdx);
-        if(!layer->needsBackProp()) {
-            break;
-        }
-        if(layer->needsTrainerState()) {
-            updateWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
-                dynamic_cast< AdagradState * >(layer->getTrainerState()) );
-            if(layer->biased()) {
-                updateWeights(layer->getBiasWrapper(), layer->getGradBiasWrapper(),
-                    dynamic_cast< AdagradState * >(layer->getBiasTrainerState()) );
-            }
-        }
-    }
+    AdagradWeightsUpdate update(this);
+    _updateWeights(net, &update);
     return BatchResult(loss, numRight);
 }
 VIRTUAL BatchResult Adagrad::trainNet(NeuralNet *net, TrainingContext *context,
@@ -108,6 +106,54 @@ VIRTUAL void Adagrad::bindState(NeuralNet *net) {
     AdagradStateMaker stateMaker(fudgeFactor);
     this->_bindState(net, &stateMaker);
 }
+// built once for each EasyCL, rather than once for the trainer, since the
+// columns of a concurrent MultiNet each have their own
+STATIC CLKernel *Adagrad::getUpdateKernel(EasyCL *cl) {
+    if(cl->kernelExists("Adagrad.updateWeights")) {
+        return cl->getKernel("Adagrad.updateWeights");
+    }
+    CLKernel *updateKernel = 0;
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("updateKernel", "cl/Adagrad.cl", "updateWeights", '""')
+    // ]]]
+    // generated using cog, from cl/Adagrad.cl:
+    const char * updateKernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// one Adagrad step, reading and writing each element of the weights and\n"
+    "// the state once, see Adagrad::updateWeightsCpu\n"
+    "kernel void updateWeights(\n"
+    "        const int N,\n"
+    "        const float learningRate,\n"
+    "        global float *weights,\n"
+    "        global const float *gradWeights,\n"
+    "        global float *sumSquares\n"
+    "            ) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const float grad = gradWeights[globalId];\n"
+    "    const float newSumSquares = sumSquares[globalId] + grad * grad;\n"
+    "    sumSquares[globalId] = newSumSquares;\n"
+    "    // a zero gradient leaves the weight alone, even with no sum of squares\n"
+    "    // yet to divide by, eg in the padding of a ParameterArena\n"
+    "    if (grad != 0) {\n"
+    "        weights[globalId] -= learningRate * grad / sqrt(newSumSquares);\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "";
+    updateKernel = cl->buildKernelFromString(updateKernelSource, "updateWeights", "", "cl/Adagrad.cl");
+    // [[[end]]]
+    cl->storeKernel("Adagrad.updateWeights", updateKernel, true);
+    return updateKernel;
+}
 STATIC Adagrad *Adagrad::instance(EasyCL *cl, float learningRate) {
     Adagrad *sgd = new Adagrad(cl);
     sgd->setLearningRate(learningRate);
@@ -14,6 +14,7 @@
 #include "trainers/Trainer.h"
 
 class AdagradState;
+class CLKernel;
 class CLWrapper;
 class EasyCL;
 class OutputData;
@@ -39,6 +40,8 @@ public:
     VIRTUAL std::string asString();
     VIRTUAL void updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
     AdagradState *trainerState);
+    STATIC void updateWeightsCpu(int N, float learningRate, float *weights, float const *gradWeights,
+    float *sumSquares);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, OutputData *outputData);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
@@ -46,6 +49,7 @@ public:
     VIRTUAL BatchResult trainNetFromLabels(NeuralNet *net, TrainingContext *context,
     float const*input, int const*labels);
     VIRTUAL void bindState(NeuralNet *net);
+    STATIC CLKernel *getUpdateKernel(EasyCL *cl);
     STATIC Adagrad *instance(EasyCL *cl, float learningRate);
     Adagrad(EasyCL *cl);
 
@@ -8,6 +8,7 @@
 
 #include "EasyCL.h"
 #include "util/StatefulTimer.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "trainers/AdagradState.h"
 
 using namespace std;
@@ -19,17 +20,12 @@ using namespace std;
 
 VIRTUAL AdagradState::~AdagradState() {
     delete sumSquaresWrapper;
-    delete[] sumSquares;
 }
 
 AdagradState::AdagradState(EasyCL *cl, int numWeights, float fudgeFactor) :
         numWeights(numWeights) {
-    sumSquares = new float[numWeights];
-    for(int i = 0; i < numWeights; i++) {
-        sumSquares[i] = fudgeFactor;
-    }
-    sumSquaresWrapper = cl->wrap(numWeights, sumSquares);
-    sumSquaresWrapper->copyToDevice();
+    sumSquaresWrapper = new CLDeviceWrapper(cl, numWeights);
+    sumSquaresWrapper->fill(fudgeFactor);
 }
 
 
@@ -15,6 +15,7 @@
 
 class EasyCL;
 class CLKernel;
+class CLDeviceWrapper;
 
 #include "DeepCLDllExport.h"
 
@@ -34,8 +35,7 @@ class DeepCL_EXPORT AdagradState : public TrainerState {
 public:
     const int numWeights;
 
-    float *sumSquares;
-    CLWrapper *sumSquaresWrapper;
+    CLDeviceWrapper *sumSquaresWrapper;
 
     // [[[cog
     // import cog_addheaders
@@ -11,8 +11,11 @@
 #include "EasyCL.h"
 #include "util/stringhelper.h"
 #include "net/NeuralNet.h"
+#include "net/ParameterArena.h"
 #include "layer/Layer.h"
 #include "clmath/CLMathWrapper.h"
+#include "clmath/CLMathExpression.h"
+#include "clmath/FusedGpuOp.h"
 #include "loss/LossLayer.h"
 #include "loss/IAcceptsLabels.h"
 #include "batch/BatchData.h"
@@ -24,6 +27,21 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
+// one annealed step, on whatever Trainer::_updateWeights hands us
+class AnnealerWeightsUpdate : public WeightsUpdate {
+public:
+    Annealer *trainer;
+    float annealedLearningRate;
+    AnnealerWeightsUpdate(Annealer *trainer, float annealedLearningRate) :
+        trainer(trainer),
+        annealedLearningRate(annealedLearningRate) {
+    }
+    virtual void update(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
+            TrainerState *trainerState) {
+        trainer->updateWeights(annealedLearningRate, weightsWrapper, gradWeightsWrapper);
+    }
+};
+
 STATIC Annealer *Annealer::instance(EasyCL *cl, float learningRate, float anneal) {
     Annealer *annealer = new Annealer(cl);
     annealer->setLearningRate(learningRate);
@@ -55,23 +73,11 @@ VIRTUAL void Annealer::updateWeights(float annealedLearningRate, CLWrapper *weig
     // annealedLearningRate = learningRate * pow(anneal, epoch)
     // weightsWrapper = weightsWrapper - annealedLearningRate * gradWeightsWrapper
 
-    int numWeights = weightsWrapper->size();
-
-    float *gradWeightsCopy = new float[ numWeights ];
-    CLWrapper *gradWeightsCopyWrapper = cl->wrap(numWeights, gradWeightsCopy);
-    gradWeightsCopyWrapper->createOnDevice();
-
     CLMathWrapper gradWeights_(gradWeightsWrapper);
-    CLMathWrapper gradWeightsCopy_(gradWeightsCopyWrapper);
     CLMathWrapper weights_(weightsWrapper);
 
-    // following all happens on gpu, via CLMathWrapper:
-    gradWeightsCopy_ = gradWeights_;
-    gradWeightsCopy_ *= - annealedLearningRate;
-    weights_ += gradWeightsCopy_;
-
-    delete gradWeightsCopyWrapper;
-    delete[] gradWeightsCopy;
+    // following all happens on gpu, in a single kernel, via CLMathExpression:
+    weights_ = weights_ + gradWeights_ * (- annealedLearningRate);
 }
 VIRTUAL BatchResult Annealer::trainNet( 
         NeuralNet *net, TrainingContext *context,
@@ -94,19 +100,8 @@ VIRTUAL BatchResult Annealer::trainNet(
     float loss = net->calcLoss(outputData);
     net->backward(outputData);
 
-    int numLayers = net->getNumLayers();
-    for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
-        Layer *layer = net->getLayer(layerIdx);
-        if(!layer->needsBackProp()) {
-            break;
-        }
-        if(layer->needsTrainerState()) {
-            updateWeights(annealedLearningRate, layer->getWeightsWrapper(), layer->getGradWeightsWrapper());
-            if(layer->biased()) {
-                updateWeights(annealedLearningRate, layer->getBiasWrapper(), layer->getGradBiasWrapper());
-            }
-        }
-    }
+    AnnealerWeightsUpdate update(this, annealedLearningRate);
+    _updateWeights(net, &update);
     return BatchResult(loss, numRight);
 }
 VIRTUAL BatchResult Annealer::trainNet(NeuralNet *net, TrainingContext *context,
@@ -123,6 +118,10 @@ VIRTUAL void Annealer::bindState(NeuralNet *net) {
     // since we have no state, all we will do is strip any existing state,
     // so that if another trainer trains the net, it wont come across
     // some stale state
+    ParameterArena *arena = net->getParameterArena();
+    if(arena != 0 && arena->getTrainerState() != 0) {
+        arena->setTrainerState(0);
+    }
     for(int layerIdx = 0; layerIdx < net->getNumLayers(); layerIdx++) {
         Layer *layer = net->getLayer(layerIdx);
         if(layer->needsTrainerState()) {
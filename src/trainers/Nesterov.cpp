@@ -6,8 +6,10 @@
 
 #include <iostream>
 
+#include "EasyCL.h"
 #include "util/stringhelper.h"
 #include "net/NeuralNet.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "layer/Layer.h"
 #include "loss/LossLayer.h"
 #include "trainers/NesterovStateMaker.h"
@@ -15,7 +17,6 @@
 #include "trainers/Nesterov.h"
 #include "loss/IAcceptsLabels.h"
 #include "batch/NetAction.h"
-#include "clmath/CLMathWrapper.h"
 #include "batch/BatchData.h"
 
 using namespace std;
@@ -25,6 +26,27 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
+// one of Nesterov's two steps, on whatever Trainer::_updateWeights hands us:
+// loading the future weights, before forward and backward, or the update
+// proper, after
+class NesterovWeightsUpdate : public WeightsUpdate {
+public:
+    Nesterov *trainer;
+    bool loadFuture;
+    NesterovWeightsUpdate(Nesterov *trainer, bool loadFuture) :
+        trainer(trainer),
+        loadFuture(loadFuture) {
+    }
+    virtual void update(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
+            TrainerState *trainerState) {
+        NesterovState *nesterovState = dynamic_cast< NesterovState * >(trainerState);
+        if(loadFuture) {
+            trainer->loadFutureWeights(weightsWrapper, gradWeightsWrapper, nesterovState);
+        } else {
+            trainer->updateWeights(weightsWrapper, gradWeightsWrapper, nesterovState);
+        }
+    }
+};
 
 VIRTUAL Nesterov::~Nesterov() {
 }
@@ -40,17 +62,17 @@ VIRTUAL void Nesterov::loadFutureWeights(
         NesterovState *trainerState) {
     // this will save the old weights, into the trainerState,
     // and then add mom * dweights to them
-
-    // create CLMathWrapper objects, so we can do per-element maths on the gpu:
-    CLMathWrapper clOldWeights(trainerState->oldWeightsWrapper);
-    CLMathWrapper clWeights(weightsWrapper);
-    CLMathWrapper clGradWeights(gradWeightsWrapper);
-
-    // following happens on the gpu:
-    clOldWeights = clWeights;
-    clWeights = clGradWeights;
-    clWeights *= momentum;
-    clWeights += clOldWeights;
+    // in one kernel, from cl/Nesterov.cl, same maths as loadFutureWeightsCpu
+    int N = weightsWrapper->size();
+    CLKernel *loadFutureKernel = getLoadFutureKernel(weightsWrapper->getCl());
+    loadFutureKernel->in(N)
+                    ->in(momentum)
+                    ->inout(weightsWrapper)
+                    ->in(gradWeightsWrapper)
+                    ->out(trainerState->oldWeightsWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    loadFutureKernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
 }
 VIRTUAL void Nesterov::updateWeights(CLWrapper *weightsWrapper,
         CLWrapper *gradWeightsWrapper,
@@ -62,20 +84,34 @@ VIRTUAL void Nesterov::updateWeights(CLWrapper *weightsWrapper,
     //      dweights[t+1] = mom * dweights[t] - learningrate * gradient( 
     //                          weights[t] + mom * dweights[t])
     //      weights[t+1] = weights[t] + dweights[t+1]
-
-    // create CLMathWrapper objects, so we can do per-element maths on the gpu:
-    CLMathWrapper clLastUpdate(trainerState->lastUpdateWrapper);
-    CLMathWrapper clOldWeights(trainerState->oldWeightsWrapper);
-    CLMathWrapper clGradWeights(gradWeightsWrapper);
-    CLMathWrapper clWeights(weightsWrapper);
-
-    // following happens on the gpu, via CLMathWrapper:
-
-    clGradWeights *= - learningRate;
-    clLastUpdate *= momentum;
-    clLastUpdate += clGradWeights;
-    clWeights = clOldWeights;
-    clWeights += clLastUpdate;
+    // in one kernel, from cl/Nesterov.cl, same maths as updateWeightsCpu
+    int N = weightsWrapper->size();
+    CLKernel *updateKernel = getUpdateKernel(weightsWrapper->getCl());
+    updateKernel->in(N)
+                ->in(learningRate)
+                ->in(momentum)
+                ->out(weightsWrapper)
+                ->in(gradWeightsWrapper)
+                ->inout(trainerState->lastUpdateWrapper)
+                ->in(trainerState->oldWeightsWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    updateKernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
+// host versions of loadFutureWeights and updateWeights, for testing
+STATIC void Nesterov::loadFutureWeightsCpu(int N, float momentum, float *weights, float const *gradWeights,
+        float *oldWeights) {
+    for(int i = 0; i < N; i++) {
+        oldWeights[i] = weights[i];
+        weights[i] = momentum * gradWeights[i] + oldWeights[i];
+    }
+}
+STATIC void Nesterov::updateWeightsCpu(int N, float learningRate, float momentum, float *weights,
+        float const *gradWeights, float *lastUpdate, float const *oldWeights) {
+    for(int i = 0; i < N; i++) {
+        lastUpdate[i] = momentum * lastUpdate[i] - learningRate * gradWeights[i];
+        weights[i] = oldWeights[i] + lastUpdate[i];
+    }
 }
 VIRTUAL BatchResult Nesterov::trainNet( 
     NeuralNet *net, TrainingContext *context,
@@ -98,21 +134,8 @@ VIRTUAL BatchResult Nesterov::trainNet(
     // calculate them first
     // save old weights first I suppose?
 
-    int numLayers = net->getNumLayers();
-    for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
-        Layer *layer = net->getLayer(layerIdx);
-        if(!layer->needsBackProp()) {
-            break;
-        }
-        if(layer->needsTrainerState()) {
-            loadFutureWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
-                dynamic_cast< NesterovState * >(layer->getTrainerState()) );
-            if(layer->biased()) {
-                loadFutureWeights(layer->getBiasWrapper(), layer->getGradBiasWrapper(),
-                    dynamic_cast< NesterovState * >(layer->getBiasTrainerState()) );
-            }
-        }
-    }
+    NesterovWeightsUpdate loadFuture(this, true);
+    _updateWeights(net, &loadFuture);
 
     // now, we have loaded in weigths + mom * dweights into the weights
     // do forward/backward:
@@ -122,20 +145,8 @@ VIRTUAL BatchResult Nesterov::trainNet(
     net->backward(outputData);
 
     // now, calculate the new weights
-    for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
-        Layer *layer = net->getLayer(layerIdx);
-        if(!layer->needsBackProp()) {
-            break;
-        }
-        if(layer->needsTrainerState()) {
-            updateWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
-                dynamic_cast< NesterovState * >(layer->getTrainerState()) );
-            if(layer->biased()) {
-                updateWeights(layer->getBiasWrapper(), layer->getGradBiasWrapper(),
-                    dynamic_cast< NesterovState * >(layer->getBiasTrainerState()) );
-            }
-        }
-    }
+    NesterovWeightsUpdate update(this, false);
+    _updateWeights(net, &update);
 
     return BatchResult(loss, numRight);
 }
@@ -155,6 +166,130 @@ VIRTUAL void Nesterov::bindState(NeuralNet *net) {
     NesterovStateMaker stateMaker;
     this->_bindState(net, &stateMaker);
 }
+// built once for each EasyCL, rather than once for the trainer, since the
+// columns of a concurrent MultiNet each have their own
+STATIC CLKernel *Nesterov::getLoadFutureKernel(EasyCL *cl) {
+    if(cl->kernelExists("Nesterov.loadFutureWeights")) {
+        return cl->getKernel("Nesterov.loadFutureWeights");
+    }
+    CLKernel *loadFutureKernel = 0;
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("loadFutureKernel", "cl/Nesterov.cl", "loadFutureWeights", '""')
+    // ]]]
+    // generated using cog, from cl/Nesterov.cl:
+    const char * loadFutureKernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// the two halves of a Nesterov step, each reading and writing each element\n"
+    "// once, see Nesterov::loadFutureWeightsCpu and Nesterov::updateWeightsCpu\n"
+    "\n"
+    "// saves the weights, then adds momentum * gradWeights to them\n"
+    "kernel void loadFutureWeights(\n"
+    "        const int N,\n"
+    "        const float momentum,\n"
+    "        global float *weights,\n"
+    "        global const float *gradWeights,\n"
+    "        global float *oldWeights\n"
+    "            ) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const float weight = weights[globalId];\n"
+    "    oldWeights[globalId] = weight;\n"
+    "    weights[globalId] = momentum * gradWeights[globalId] + weight;\n"
+    "}\n"
+    "\n"
+    "kernel void updateWeights(\n"
+    "        const int N,\n"
+    "        const float learningRate,\n"
+    "        const float momentum,\n"
+    "        global float *weights,\n"
+    "        global const float *gradWeights,\n"
+    "        global float *lastUpdate,\n"
+    "        global const float *oldWeights\n"
+    "            ) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const float newLastUpdate = momentum * lastUpdate[globalId] - learningRate * gradWeights[globalId];\n"
+    "    lastUpdate[globalId] = newLastUpdate;\n"
+    "    weights[globalId] = oldWeights[globalId] + newLastUpdate;\n"
+    "}\n"
+    "\n"
+    "";
+    loadFutureKernel = cl->buildKernelFromString(loadFutureKernelSource, "loadFutureWeights", "", "cl/Nesterov.cl");
+    // [[[end]]]
+    cl->storeKernel("Nesterov.loadFutureWeights", loadFutureKernel, true);
+    return loadFutureKernel;
+}
+STATIC CLKernel *Nesterov::getUpdateKernel(EasyCL *cl) {
+    if(cl->kernelExists("Nesterov.updateWeights")) {
+        return cl->getKernel("Nesterov.updateWeights");
+    }
+    CLKernel *updateKernel = 0;
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("updateKernel", "cl/Nesterov.cl", "updateWeights", '""')
+    // ]]]
+    // generated using cog, from cl/Nesterov.cl:
+    const char * updateKernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// the two halves of a Nesterov step, each reading and writing each element\n"
+    "// once, see Nesterov::loadFutureWeightsCpu and Nesterov::updateWeightsCpu\n"
+    "\n"
+    "// saves the weights, then adds momentum * gradWeights to them\n"
+    "kernel void loadFutureWeights(\n"
+    "        const int N,\n"
+    "        const float momentum,\n"
+    "        global float *weights,\n"
+    "        global const float *gradWeights,\n"
+    "        global float *oldWeights\n"
+    "            ) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const float weight = weights[globalId];\n"
+    "    oldWeights[globalId] = weight;\n"
+    "    weights[globalId] = momentum * gradWeights[globalId] + weight;\n"
+    "}\n"
+    "\n"
+    "kernel void updateWeights(\n"
+    "        const int N,\n"
+    "        const float learningRate,\n"
+    "        const float momentum,\n"
+    "        global float *weights,\n"
+    "        global const float *gradWeights,\n"
+    "        global float *lastUpdate,\n"
+    "        global const float *oldWeights\n"
+    "            ) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const float newLastUpdate = momentum * lastUpdate[globalId] - learningRate * gradWeights[globalId];\n"
+    "    lastUpdate[globalId] = newLastUpdate;\n"
+    "    weights[globalId] = oldWeights[globalId] + newLastUpdate;\n"
+    "}\n"
+    "\n"
+    "";
+    updateKernel = cl->buildKernelFromString(updateKernelSource, "updateWeights", "", "cl/Nesterov.cl");
+    // [[[end]]]
+    cl->storeKernel("Nesterov.updateWeights", updateKernel, true);
+    return updateKernel;
+}
 STATIC Nesterov *Nesterov::instance(EasyCL *cl, float learningRate) {
     Nesterov *sgd = new Nesterov(cl);
     sgd->setLearningRate(learningRate);
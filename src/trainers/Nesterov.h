@@ -16,6 +16,7 @@
 #include "DeepCLDllExport.h"
 
 class NesterovState;
+class CLKernel;
 
 #define VIRTUAL virtual
 #define STATIC static
@@ -48,6 +49,10 @@ public:
     VIRTUAL void updateWeights(CLWrapper *weightsWrapper,
     CLWrapper *gradWeightsWrapper,
     NesterovState *trainerState);
+    STATIC void loadFutureWeightsCpu(int N, float momentum, float *weights, float const *gradWeights,
+    float *oldWeights);
+    STATIC void updateWeightsCpu(int N, float learningRate, float momentum, float *weights,
+    float const *gradWeights, float *lastUpdate, float const *oldWeights);
     VIRTUAL BatchResult trainNet(
     NeuralNet *net, TrainingContext *context,
     float const *input, OutputData *outputData);
@@ -56,6 +61,8 @@ public:
     VIRTUAL BatchResult trainNetFromLabels(NeuralNet *net, TrainingContext *context,
     float const*input, int const*labels);
     VIRTUAL void bindState(NeuralNet *net);
+    STATIC CLKernel *getLoadFutureKernel(EasyCL *cl);
+    STATIC CLKernel *getUpdateKernel(EasyCL *cl);
     STATIC Nesterov *instance(EasyCL *cl, float learningRate);
     STATIC Nesterov *instance(EasyCL *cl, float learningRate, float momentum);
     Nesterov(EasyCL *cl);
@@ -8,6 +8,7 @@
 
 #include "EasyCL.h"
 #include "util/StatefulTimer.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "trainers/NesterovState.h"
 
 using namespace std;
@@ -19,9 +20,7 @@ using namespace std;
 
 VIRTUAL NesterovState::~NesterovState() {
     delete lastUpdateWrapper;
-    delete[] lastUpdate;
-    delete oldWeights;
-    delete[] oldWeightsWrapper;
+    delete oldWeightsWrapper;
 }
 
 NesterovState::NesterovState(EasyCL *cl, int numWeights) :
@@ -32,16 +31,10 @@ NesterovState::NesterovState(EasyCL *cl, int numWeights) :
 
     // lastUpdate buffer never needs to change size,
     //  since number of weights is invariant with batchSize etc
-    lastUpdate = new float[numWeights];
-    for(int i = 0; i < numWeights; i++) {
-        lastUpdate[i] = 0.0f;
-    }
-    lastUpdateWrapper = cl->wrap(numWeights, lastUpdate);
-    lastUpdateWrapper->copyToDevice();
-
-    oldWeights = new float[numWeights];
-    oldWeightsWrapper = cl->wrap(numWeights, oldWeights);
-    oldWeightsWrapper->createOnDevice();
+    lastUpdateWrapper = new CLDeviceWrapper(cl, numWeights);
+    lastUpdateWrapper->fill(0.0f);
+
+    oldWeightsWrapper = new CLDeviceWrapper(cl, numWeights);
 }
 
 
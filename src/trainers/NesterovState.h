@@ -15,6 +15,7 @@
 
 class EasyCL;
 class CLKernel;
+class CLDeviceWrapper;
 
 #include "DeepCLDllExport.h"
 
@@ -34,11 +35,9 @@ class DeepCL_EXPORT NesterovState : public TrainerState {
 public:
     const int numWeights;
 
-    float *lastUpdate;
-    CLWrapper *lastUpdateWrapper;
+    CLDeviceWrapper *lastUpdateWrapper;
 
-    float *oldWeights;
-    CLWrapper *oldWeightsWrapper;
+    CLDeviceWrapper *oldWeightsWrapper;
 
     // [[[cog
     // import cog_addheaders
@@ -5,9 +5,12 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <iostream>
+#include <cmath>
 
+#include "EasyCL.h"
 #include "util/stringhelper.h"
 #include "net/NeuralNet.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "layer/Layer.h"
 #include "loss/LossLayer.h"
 #include "trainers/RmspropStateMaker.h"
@@ -15,7 +18,6 @@
 #include "trainers/Rmsprop.h"
 #include "loss/IAcceptsLabels.h"
 #include "batch/NetAction.h"
-#include "clmath/CLMathWrapper.h"
 #include "batch/BatchData.h"
 
 //#include "test/Sampler.h"
@@ -27,6 +29,18 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
+// one Rmsprop step, on whatever Trainer::_updateWeights hands us
+class RmspropWeightsUpdate : public WeightsUpdate {
+public:
+    Rmsprop *trainer;
+    RmspropWeightsUpdate(Rmsprop *trainer) :
+        trainer(trainer) {
+    }
+    virtual void update(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
+            TrainerState *trainerState) {
+        trainer->updateWeights(weightsWrapper, gradWeightsWrapper, dynamic_cast< RmspropState * >(trainerState));
+    }
+};
 
 VIRTUAL Rmsprop::~Rmsprop() {
 }
@@ -35,33 +49,29 @@ VIRTUAL std::string Rmsprop::asString() {
 }
 VIRTUAL void Rmsprop::updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
         RmspropState *trainerState) {
-
-    int numWeights = trainerState->numWeights;
-    float *working = new float[ numWeights ];
-    CLWrapper *workingWrapper = cl->wrap(numWeights, working);
-    workingWrapper->createOnDevice();
-
-    CLMathWrapper clWeights(weightsWrapper);
-    CLMathWrapper clGradWeights(gradWeightsWrapper);
-    CLMathWrapper clMeanSquares(trainerState->meanSquareWrapper);
-    CLMathWrapper clWorking(workingWrapper);
-
-    // following all happens on gpu, via clmathwrapper:
-    clWorking = clGradWeights;
-    clWorking.squared();
-    clWorking *= 0.1f; // I guess this should be a hyper-parameter?
-    clMeanSquares *= 0.9f;
-    clMeanSquares += clWorking;
-
-    clWorking = clMeanSquares;
-    clWorking.sqrt();
-    clWorking.inv();
-    clWorking *= clGradWeights;
-    clWorking *= - learningRate;
-    clWeights += clWorking;
-
-    delete workingWrapper;
-    delete[] working;
+    // all in one kernel, from cl/Rmsprop.cl, same maths as updateWeightsCpu
+    int N = weightsWrapper->size();
+    CLKernel *updateKernel = getUpdateKernel(weightsWrapper->getCl());
+    updateKernel->in(N)
+                ->in(learningRate)
+                ->inout(weightsWrapper)
+                ->in(gradWeightsWrapper)
+                ->inout(trainerState->meanSquareWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    updateKernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
+// host version of updateWeights, for testing
+STATIC void Rmsprop::updateWeightsCpu(int N, float learningRate, float *weights, float const *gradWeights,
+        float *meanSquare) {
+    for(int i = 0; i < N; i++) {
+        float grad = gradWeights[i];
+        // I guess the 0.9f / 0.1f should be a hyper-parameter?
+        meanSquare[i] = 0.9f * meanSquare[i] + 0.1f * grad * grad;
+        if(grad != 0) {
+            weights[i] -= learningRate * grad / sqrt(meanSquare[i]);
+        }
+    }
 }
 VIRTUAL BatchResult Rmsprop::trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, OutputData *outputData) {
@@ -75,21 +85,8 @@ VIRTUAL BatchResult Rmsprop::trainNet(NeuralNet *net, TrainingContext *context,
     float loss = net->calcLoss(outputData);
     net->backward(outputData);
 
-    int numLayers = net->getNumLayers();
-    for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
-        Layer *layer = net->getLayer(layerIdx);
-        if(!layer->needsBackProp()) {
-            break;
-        }
-        if(layer->needsTrainerState()) {
-            updateWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
-                dynamic_cast< RmspropState * >(layer->getTrainerState()) );
-            if(layer->biased()) {
-                updateWeights(layer->getBiasWrapper(), layer->getGradBiasWrapper(),
-                    dynamic_cast< RmspropState * >(layer->getBiasTrainerState()) );
-            }
-        }
-    }
+    RmspropWeightsUpdate update(this);
+    _updateWeights(net, &update);
     return BatchResult(loss, numRight);
 }
 VIRTUAL BatchResult Rmsprop::trainNet(NeuralNet *net, TrainingContext *context,
@@ -106,6 +103,54 @@ VIRTUAL void Rmsprop::bindState(NeuralNet *net) {
     RmspropStateMaker stateMaker;
     this->_bindState(net, &stateMaker);
 }
+// built once for each EasyCL, rather than once for the trainer, since the
+// columns of a concurrent MultiNet each have their own
+STATIC CLKernel *Rmsprop::getUpdateKernel(EasyCL *cl) {
+    if(cl->kernelExists("Rmsprop.updateWeights")) {
+        return cl->getKernel("Rmsprop.updateWeights");
+    }
+    CLKernel *updateKernel = 0;
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("updateKernel", "cl/Rmsprop.cl", "updateWeights", '""')
+    // ]]]
+    // generated using cog, from cl/Rmsprop.cl:
+    const char * updateKernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// one Rmsprop step, reading and writing each element of the weights and\n"
+    "// the state once, see Rmsprop::updateWeightsCpu\n"
+    "kernel void updateWeights(\n"
+    "        const int N,\n"
+    "        const float learningRate,\n"
+    "        global float *weights,\n"
+    "        global const float *gradWeights,\n"
+    "        global float *meanSquare\n"
+    "            ) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const float grad = gradWeights[globalId];\n"
+    "    const float newMeanSquare = 0.9f * meanSquare[globalId] + 0.1f * grad * grad;\n"
+    "    meanSquare[globalId] = newMeanSquare;\n"
+    "    // a zero gradient leaves the weight alone, even once the mean square has\n"
+    "    // decayed to zero, eg in the padding of a ParameterArena\n"
+    "    if (grad != 0) {\n"
+    "        weights[globalId] -= learningRate * grad / sqrt(newMeanSquare);\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "";
+    updateKernel = cl->buildKernelFromString(updateKernelSource, "updateWeights", "", "cl/Rmsprop.cl");
+    // [[[end]]]
+    cl->storeKernel("Rmsprop.updateWeights", updateKernel, true);
+    return updateKernel;
+}
 STATIC Rmsprop *Rmsprop::instance(EasyCL *cl, float learningRate) {
     Rmsprop *sgd = new Rmsprop(cl);
     sgd->setLearningRate(learningRate);
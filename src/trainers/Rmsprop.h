@@ -14,6 +14,7 @@
 #include "trainers/Trainer.h"
 
 class RmspropState;
+class CLKernel;
 class CLWrapper;
 class EasyCL;
 class OutputData;
@@ -27,7 +28,6 @@ class OutputData;
 // page 29
 class DeepCL_EXPORT Rmsprop : public Trainer{
 public:
-
     // [[[cog
     // import cog_addheaders
     // cog_addheaders.add()
@@ -37,6 +37,8 @@ public:
     VIRTUAL std::string asString();
     VIRTUAL void updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
     RmspropState *trainerState);
+    STATIC void updateWeightsCpu(int N, float learningRate, float *weights, float const *gradWeights,
+    float *meanSquare);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, OutputData *outputData);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
@@ -44,6 +46,7 @@ public:
     VIRTUAL BatchResult trainNetFromLabels(NeuralNet *net, TrainingContext *context,
     float const*input, int const*labels);
     VIRTUAL void bindState(NeuralNet *net);
+    STATIC CLKernel *getUpdateKernel(EasyCL *cl);
     STATIC Rmsprop *instance(EasyCL *cl, float learningRate);
     Rmsprop(EasyCL *cl);
 
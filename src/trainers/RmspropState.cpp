@@ -8,6 +8,7 @@
 
 #include "EasyCL.h"
 #include "util/StatefulTimer.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "trainers/RmspropState.h"
 
 using namespace std;
@@ -19,17 +20,12 @@ using namespace std;
 
 VIRTUAL RmspropState::~RmspropState() {
     delete meanSquareWrapper;
-    delete[] meanSquare;
 }
 
 RmspropState::RmspropState(EasyCL *cl, int numWeights) :
         numWeights(numWeights) {
-    meanSquare = new float[numWeights];
-    for(int i = 0; i < numWeights; i++) {
-        meanSquare[i] = 0.0000001f; // should move this into fudgefactor I guess?
-    }
-    meanSquareWrapper = cl->wrap(numWeights, meanSquare);
-    meanSquareWrapper->copyToDevice();
+    meanSquareWrapper = new CLDeviceWrapper(cl, numWeights);
+    meanSquareWrapper->fill(0.0000001f); // should move this into fudgefactor I guess?
 }
 
 
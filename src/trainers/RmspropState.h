@@ -15,6 +15,7 @@
 
 class EasyCL;
 class CLKernel;
+class CLDeviceWrapper;
 
 #include "DeepCLDllExport.h"
 
@@ -25,8 +26,7 @@ class DeepCL_EXPORT RmspropState : public TrainerState {
 public:
     const int numWeights;
 
-    float *meanSquare;
-    CLWrapper *meanSquareWrapper;
+    CLDeviceWrapper *meanSquareWrapper;
 
     // [[[cog
     // import cog_addheaders
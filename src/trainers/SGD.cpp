@@ -8,6 +8,7 @@
 
 #include "util/stringhelper.h"
 #include "net/NeuralNet.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "layer/Layer.h"
 #include "loss/LossLayer.h"
 #include "trainers/SGDStateMaker.h"
@@ -16,6 +17,8 @@
 #include "loss/IAcceptsLabels.h"
 #include "batch/NetAction.h"
 #include "clmath/CLMathWrapper.h"
+#include "clmath/CLMathExpression.h"
+#include "clmath/FusedGpuOp.h"
 #include "batch/BatchData.h"
 
 using namespace std;
@@ -25,6 +28,18 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
+// one SGD step, on whatever Trainer::_updateWeights hands us
+class SGDWeightsUpdate : public WeightsUpdate {
+public:
+    SGD *trainer;
+    SGDWeightsUpdate(SGD *trainer) :
+        trainer(trainer) {
+    }
+    virtual void update(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
+            TrainerState *trainerState) {
+        trainer->updateWeights(weightsWrapper, gradWeightsWrapper, dynamic_cast< SGDState * >(trainerState));
+    }
+};
 
 VIRTUAL SGD::~SGD() {
 }
@@ -40,33 +55,24 @@ VIRTUAL std::string SGD::asString() {
 }
 VIRTUAL void SGD::updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
         SGDState *trainerState) {
-    int numWeights = trainerState->numWeights;
     CLWrapper *lastUpdateWrapper = trainerState->lastUpdateWrapper;
-    float *gradWeightsCopy = new float[ numWeights ];
-    CLWrapper *gradWeightsCopyWrapper = cl->wrap(numWeights, gradWeightsCopy);
-    gradWeightsCopyWrapper->createOnDevice();
 
     CLMathWrapper lastUpdates_(lastUpdateWrapper);
     CLMathWrapper gradWeights_(gradWeightsWrapper);
-    CLMathWrapper gradWeightsCopy_(gradWeightsCopyWrapper);
     CLMathWrapper weights_(weightsWrapper);
 
-    // following all happens on gpu, via clmathwrapper:
-    lastUpdates_ *= momentum;
-    gradWeightsCopy_ = gradWeights_;
-    gradWeightsCopy_ *= - learningRate;
-    lastUpdates_ += gradWeightsCopy_;
-    weights_ += lastUpdates_;
-
+    // following all happens on gpu, in a single kernel, via FusedGpuOp:
+    FusedGpuOp fusedOp(weightsWrapper->getCl());
+    fusedOp.assign(lastUpdates_, lastUpdates_ * momentum + gradWeights_ * (- learningRate));
     if(weightDecay > 0) {
         // apply weight decay, by multiplying the weights by (1.0f - weightDecay)
         // so weightDecay == 0 means no decay; and weightDecay == 1.0f means
         // weights go immediately to zero
-        weights_ *= 1.0f - weightDecay;
+        fusedOp.assign(weights_, (weights_ + lastUpdates_) * (1.0f - weightDecay));
+    } else {
+        fusedOp.assign(weights_, weights_ + lastUpdates_);
     }
-
-    delete gradWeightsCopyWrapper;
-    delete[] gradWeightsCopy;
+    fusedOp.run();
 }
 VIRTUAL BatchResult SGD::trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, OutputData *outputData) {
@@ -80,21 +86,8 @@ VIRTUAL BatchResult SGD::trainNet(NeuralNet *net, TrainingContext *context,
     float loss = net->calcLoss(outputData);
     net->backward(outputData);
 
-    int numLayers = net->getNumLayers();
-    for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
-        Layer *layer = net->getLayer(layerIdx);
-        if(!layer->needsBackProp()) {
-            break;
-        }
-        if(layer->needsTrainerState()) {
-            updateWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
-                dynamic_cast< SGDState * >(layer->getTrainerState()) );
-            if(layer->biased()) {
-                updateWeights(layer->getBiasWrapper(), layer->getGradBiasWrapper(),
-                    dynamic_cast< SGDState * >(layer->getBiasTrainerState()) );
-            }
-        }
-    }
+    SGDWeightsUpdate update(this);
+    _updateWeights(net, &update);
     return BatchResult(loss, numRight);
 }
 VIRTUAL BatchResult SGD::trainNet(NeuralNet *net, TrainingContext *context,
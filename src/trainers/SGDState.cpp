@@ -8,6 +8,7 @@
 
 #include "EasyCL.h"
 #include "util/StatefulTimer.h"
+#include "clmath/CLDeviceWrapper.h"
 #include "trainers/SGDState.h"
 
 using namespace std;
@@ -19,7 +20,6 @@ using namespace std;
 
 VIRTUAL SGDState::~SGDState() {
     delete lastUpdateWrapper;
-    delete[] lastUpdate;
 }
 
 SGDState::SGDState(EasyCL *cl, int numWeights) :
@@ -30,11 +30,7 @@ SGDState::SGDState(EasyCL *cl, int numWeights) :
 
     // lastUpdate buffer never needs to change size,
     //  since number of weights is invariant with batchSize etc
-    lastUpdate = new float[numWeights];
-    for(int i = 0; i < numWeights; i++) {
-        lastUpdate[i] = 0.0f;
-    }
-    lastUpdateWrapper = cl->wrap(numWeights, lastUpdate);
-    lastUpdateWrapper->copyToDevice();
+    lastUpdateWrapper = new CLDeviceWrapper(cl, numWeights);
+    lastUpdateWrapper->fill(0.0f);
 }
 
@@ -15,6 +15,7 @@
 
 class EasyCL;
 class CLKernel;
+class CLDeviceWrapper;
 
 #include "DeepCLDllExport.h"
 
@@ -35,8 +36,7 @@ public:
     const int numWeights;
 
     // should store last weights
-    float *lastUpdate;
-    CLWrapper *lastUpdateWrapper;
+    CLDeviceWrapper *lastUpdateWrapper;
 
     // [[[cog
     // import cog_addheaders
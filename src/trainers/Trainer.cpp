@@ -8,13 +8,16 @@
 
 #include "EasyCL.h"
 #include "net/NeuralNet.h"
+#include "net/ParameterArena.h"
 #include "util/stringhelper.h"
+#include "util/AllocationCounter.h"
 #include "trainers/Trainer.h"
 #include "net/MultiNet.h"
 #include "batch/NetAction.h"
 #include "trainers/TrainerStateMaker.h"
 #include "trainers/TrainerState.h"
 #include "layer/Layer.h"
+#include "util/ThreadPool.h"
 
 using namespace std;
 
@@ -24,6 +27,38 @@ using namespace std;
 #define VIRTUAL
 
 
+// trains one column of a MultiNet, from labels, or from expectedOutput
+// goes straight to trainNet, since the batch was counted already, for the
+// MultiNet as a whole
+class TrainerColumnTask : public ThreadPoolTask {
+public:
+    Trainer *trainer;
+    MultiNet *multiNet;
+    TrainingContext *context;
+    float const *input;
+    float const *expectedOutput;
+    int const *labels;
+    std::vector<BatchResult> results;
+    TrainerColumnTask(Trainer *trainer, MultiNet *multiNet, TrainingContext *context, float const *input,
+            float const *expectedOutput, int const *labels) :
+        trainer(trainer),
+        multiNet(multiNet),
+        context(context),
+        input(input),
+        expectedOutput(expectedOutput),
+        labels(labels),
+        results(multiNet->getNumNets()) {
+    }
+    virtual void run(int column) {
+        NeuralNet *child = dynamic_cast< NeuralNet * >(multiNet->getNet(column));
+        if(labels != 0) {
+            results[column] = trainer->trainNetFromLabels(child, context, input, labels);
+        } else {
+            results[column] = trainer->trainNet(child, context, input, expectedOutput);
+        }
+    }
+};
+
 Trainer::Trainer(EasyCL *cl) :
     cl(cl),
     learningRate(0) {
@@ -39,13 +74,15 @@ VIRTUAL std::string Trainer::asString() {
 VIRTUAL BatchResult Trainer::train(Trainable *trainable, 
         TrainingContext *context,
         float const*input, float const*expectedOutput) {
+    AllocationCounter::countBatch();
     MultiNet *multiNet = dynamic_cast< MultiNet *>(trainable);
     float loss = 0;
     if(multiNet != 0) {
+        // the columns train concurrently, if the MultiNet is concurrent
+        TrainerColumnTask task(this, multiNet, context, input, expectedOutput, 0);
+        multiNet->runColumns(&task);
         for(int i = 0; i < multiNet->getNumNets(); i++) {
-            Trainable *child = multiNet->getNet(i);
-            BatchResult result = this->train(child, context, input, expectedOutput);
-            loss += result.loss;
+            loss += task.results[i].loss;
         }
     } else {
         NeuralNet *net = dynamic_cast< NeuralNet * > (trainable);
@@ -56,15 +93,16 @@ VIRTUAL BatchResult Trainer::train(Trainable *trainable,
 VIRTUAL BatchResult Trainer::trainFromLabels(Trainable *trainable,
     TrainingContext *context,
     float const*input, int const*labels) {
+    AllocationCounter::countBatch();
     MultiNet *multiNet = dynamic_cast< MultiNet *>(trainable);
     float loss = 0;
     int numRight = 0;
     if(multiNet != 0) {
+        TrainerColumnTask task(this, multiNet, context, input, 0, labels);
+        multiNet->runColumns(&task);
         for(int i = 0; i < multiNet->getNumNets(); i++) {
-            Trainable *child = multiNet->getNet(i);
-            BatchResult result = this->trainFromLabels(child, context, input, labels);
-            loss += result.loss;
-            numRight += result.numRight;
+            loss += task.results[i].loss;
+            numRight += task.results[i].numRight;
         }
     } else {
         NeuralNet *net = dynamic_cast< NeuralNet * > (trainable);
@@ -73,6 +111,15 @@ VIRTUAL BatchResult Trainer::trainFromLabels(Trainable *trainable,
     return BatchResult(loss, numRight);
 }
 VIRTUAL void Trainer::_bindState(NeuralNet *net, TrainerStateMaker *stateMaker) {
+    // with a parameter arena, there's just one TrainerState, covering
+    // all the parameters
+    ParameterArena *arena = net->getParameterArena();
+    if(arena != 0) {
+        if(!stateMaker->created(arena->getTrainerState())) {
+            arena->setTrainerState(stateMaker);
+        }
+        return;
+    }
     // go through network layers, and assign TrainerState objects
     for(int layerIdx = 0; layerIdx < net->getNumLayers(); layerIdx++) {
         Layer *layer = net->getLayer(layerIdx);
@@ -84,4 +131,29 @@ VIRTUAL void Trainer::_bindState(NeuralNet *net, TrainerStateMaker *stateMaker)
         }
     }
 }
+// applies update to everything the trainers train: with a parameter arena,
+// all the weights and biases are in one buffer, so one update does the lot;
+// otherwise each layer's weights and bias, from the top down, stopping at
+// the first layer that doesnt need backprop
+VIRTUAL void Trainer::_updateWeights(NeuralNet *net, WeightsUpdate *update) {
+    ParameterArena *arena = net->getParameterArena();
+    if(arena != 0) {
+        update->update(arena->getParamsWrapper(), arena->getGradParamsWrapper(), arena->getTrainerState());
+        return;
+    }
+    for(int layerIdx = net->getNumLayers() - 2; layerIdx > 0; layerIdx--) {
+        Layer *layer = net->getLayer(layerIdx);
+        if(!layer->needsBackProp()) {
+            break;
+        }
+        if(layer->needsTrainerState()) {
+            update->update(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(),
+                layer->getTrainerState());
+            if(layer->biased()) {
+                update->update(layer->getBiasWrapper(), layer->getGradBiasWrapper(),
+                    layer->getBiasTrainerState());
+            }
+        }
+    }
+}
 
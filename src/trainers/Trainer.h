@@ -16,7 +16,9 @@ class NeuralNet;
 class Trainable;
 class EpochResult;
 class TrainerStateMaker;
+class TrainerState;
 class BatchResult;
+class CLWrapper;
 
 #include "trainers/TrainingContext.h"
 
@@ -45,6 +47,15 @@ public:
     }
 };
 
+// what a trainer does to one set of weights, given their gradients: see
+// Trainer::_updateWeights.  trainerState is 0 for trainers without state
+class DeepCL_EXPORT WeightsUpdate {
+public:
+    virtual ~WeightsUpdate() {}
+    virtual void update(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
+        TrainerState *trainerState) = 0;
+};
+
 // responsible for handling one batch of learning for the passed in network
 // TODO: ponder NeuralNet vs Trainable
 // Assumptions: this class and its children can assume that the NeuralNet
@@ -81,6 +92,7 @@ public:
     TrainingContext *context,
     float const*input, int const*labels);
     VIRTUAL void _bindState(NeuralNet *net, TrainerStateMaker *stateMaker);
+    VIRTUAL void _updateWeights(NeuralNet *net, WeightsUpdate *update);
 
     // [[[end]]]
 };
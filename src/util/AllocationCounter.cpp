@@ -0,0 +1,66 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "util/AllocationCounter.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+#ifndef NOTHREADS
+#define ALLOCATIONCOUNTER_LOCK lock_guard<std::mutex> lock(mutex)
+#else
+#define ALLOCATIONCOUNTER_LOCK
+#endif
+
+#ifndef NOTHREADS
+std::mutex AllocationCounter::mutex;
+#endif
+
+PUBLIC STATIC void AllocationCounter::countAllocation() {
+    ALLOCATIONCOUNTER_LOCK;
+    numAllocations()++;
+}
+PUBLIC STATIC void AllocationCounter::countBatch() {
+    ALLOCATIONCOUNTER_LOCK;
+    numBatches()++;
+}
+PUBLIC STATIC int AllocationCounter::getNumAllocations() {
+    ALLOCATIONCOUNTER_LOCK;
+    return numAllocations();
+}
+PUBLIC STATIC int AllocationCounter::getNumBatches() {
+    ALLOCATIONCOUNTER_LOCK;
+    return numBatches();
+}
+PUBLIC STATIC void AllocationCounter::reset() {
+    ALLOCATIONCOUNTER_LOCK;
+    numAllocations() = 0;
+    numBatches() = 0;
+}
+// prints nothing if there were no batches since the last dump
+PUBLIC STATIC void AllocationCounter::dump() {
+    if(numBatches() > 0) {
+        float perBatch = (float)numAllocations() / (float)numBatches();
+        cout << "allocations per batch: " << perBatch << " (" << numAllocations() << " allocations, " <<
+            numBatches() << " batches)" << endl;
+    }
+    reset();
+}
+PRIVATE STATIC int &AllocationCounter::numAllocations() {
+    static int count = 0;
+    return count;
+}
+PRIVATE STATIC int &AllocationCounter::numBatches() {
+    static int count = 0;
+    return count;
+}
+
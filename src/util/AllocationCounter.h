@@ -0,0 +1,60 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#ifndef NOTHREADS
+#include <mutex>
+#endif
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// counts buffer allocations made while training, so we can see how many
+// happen per batch; in steady state this should be zero
+// counted are: every CLDeviceWrapper, which is what layers, their
+// workspaces, and OutputArenas allocate on the device; CLWrapperCache
+// rewraps; HostStagingPool arrays; and SoftMaxLayer's labels.  the float *
+// overloads of Forward, Backward and so on wrap their arguments each call,
+// uncounted, but training doesnt use them
+// dump() is printed alongside StatefulTimer::dump(), and resets the counts
+// the counts can be added to from several threads, eg the columns of a
+// concurrent MultiNet
+class DeepCL_EXPORT AllocationCounter {
+    private:
+    #ifndef NOTHREADS
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    STATIC std::mutex mutex;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    #endif
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC void countAllocation();
+    STATIC void countBatch();
+    STATIC int getNumAllocations();
+    STATIC int getNumBatches();
+    STATIC void reset();
+    STATIC void dump();
+
+    private:
+    STATIC int &numAllocations();
+    STATIC int &numBatches();
+
+    // [[[end]]]
+};
+
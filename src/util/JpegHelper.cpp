@@ -6,12 +6,15 @@
 
 #include <iostream>
 #include <cstdio>
+#include <csetjmp>
 extern "C" {
     #include <jpeglib.h>
+    #include <jerror.h>
 }
 #include <stdexcept>
 
 #include "util/stringhelper.h"
+#include "util/MappedFile.h"
 #include "util/JpegHelper.h"
 
 using namespace std;
@@ -83,62 +86,127 @@ PUBLIC STATIC void JpegHelper::write(std::string filename, int planes, int width
     delete[] image_buffer;
 }
 
+// libjpeg's default error handler calls exit(), which isnt great, and
+// especially not from a decode thread, so we jump back out, and throw instead
+struct JpegHelperErrorManager {
+    struct jpeg_error_mgr pub;
+    jmp_buf setjmpBuffer;
+    char message[JMSG_LENGTH_MAX];
+};
+static void JpegHelper_errorExit(j_common_ptr cinfo) {
+    JpegHelperErrorManager *errorManager = (JpegHelperErrorManager *)cinfo->err;
+    (*cinfo->err->format_message)(cinfo, errorManager->message);
+    longjmp(errorManager->setjmpBuffer, 1);
+}
+
+// source manager that hands libjpeg the whole, already in memory, jpeg in one go
+// (libjpeg 6b has no jpeg_mem_src)
+static void JpegHelper_initSource(j_decompress_ptr cinfo) {
+}
+static boolean JpegHelper_fillInputBuffer(j_decompress_ptr cinfo) {
+    // run out of data: give libjpeg an EOI marker, and let it warn about it
+    static const JOCTET eoi[2] = { (JOCTET)0xFF, (JOCTET)JPEG_EOI };
+    WARNMS(cinfo, JWRN_JPEG_EOF);
+    cinfo->src->next_input_byte = eoi;
+    cinfo->src->bytes_in_buffer = 2;
+    return TRUE;
+}
+static void JpegHelper_skipInputData(j_decompress_ptr cinfo, long numBytes) {
+    if(numBytes <= 0) {
+        return;
+    }
+    if((size_t)numBytes > cinfo->src->bytes_in_buffer) {
+        JpegHelper_fillInputBuffer(cinfo);
+    } else {
+        cinfo->src->next_input_byte += numBytes;
+        cinfo->src->bytes_in_buffer -= numBytes;
+    }
+}
+static void JpegHelper_termSource(j_decompress_ptr cinfo) {
+}
+
 PUBLIC STATIC void JpegHelper::read(std::string filename, int planes, int width, int height, unsigned char *values) {
-    unsigned char *image_buffer = new unsigned char[width * height * planes];
+    MappedFile file(filename);
+    decode(filename, file.getData(), file.getSize(), planes, width, height, values);
+}
+// decodes a jpeg that's already in memory, eg from a MappedFile, into values,
+// as [plane][row][col].  name is just for error messages
+// if the jpeg is 2, 4 or 8 times bigger than width x height, lets libjpeg
+// scale it down in the DCT, which is much quicker than decoding the whole
+// thing; otherwise the jpeg has to be exactly width x height
+// threadsafe
+PUBLIC STATIC void JpegHelper::decode(std::string name, unsigned char const *jpegData, int64 jpegSize, int planes, int width, int height, unsigned char *values) {
+    if(jpegData == 0 || jpegSize <= 0) {
+        throw runtime_error("error reading " + name + ": file is empty");
+    }
+    unsigned char *rowBuffer = new unsigned char[width * planes];
 
     struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    cinfo.err = jpeg_std_error(&jerr);
+    JpegHelperErrorManager errorManager;
+    cinfo.err = jpeg_std_error(&errorManager.pub);
+    errorManager.pub.error_exit = JpegHelper_errorExit;
+    // no C++ objects with destructors in scope from here, until the
+    // decompress is destroyed, since longjmp would skip them
+    if(setjmp(errorManager.setjmpBuffer)) {
+        jpeg_destroy_decompress(&cinfo);
+        delete[] rowBuffer;
+        throw runtime_error("error reading " + name + ": " + errorManager.message);
+    }
     jpeg_create_decompress(&cinfo);
 
-//    string filename = "foo.jpeg";
-    FILE * infile;
-    if ((infile = fopen(filename.c_str(), "rb")) == NULL) {
-        throw runtime_error("can't open "  + filename);
-    }
-    jpeg_stdio_src(&cinfo, infile);
+    struct jpeg_source_mgr source;
+    source.init_source = JpegHelper_initSource;
+    source.fill_input_buffer = JpegHelper_fillInputBuffer;
+    source.skip_input_data = JpegHelper_skipInputData;
+    source.resync_to_restart = jpeg_resync_to_restart;
+    source.term_source = JpegHelper_termSource;
+    source.next_input_byte = (JOCTET const *)jpegData;
+    source.bytes_in_buffer = (size_t)jpegSize;
+    cinfo.src = &source;
     jpeg_read_header(&cinfo, TRUE);
 
-    jpeg_start_decompress(&cinfo);
-    if((int)cinfo.output_width != width) {
-        throw runtime_error("error reading " + filename + ":" + 
-            " width is " + toString(cinfo.output_width) + 
-            " and not " + toString(width) );
-    }
-    if((int)cinfo.output_height != height) {
-        throw runtime_error("error reading " + filename + ":" + 
-            " height is " + toString(cinfo.output_height) + 
-            " and not " + toString(height) );
-    }
-    if((int)cinfo.output_components != planes) {
-        throw runtime_error("error reading " + filename + ":" + 
-            " planes is " + toString(cinfo.output_components) + 
-            " and not " + toString(planes) );
+    // smallest DCT downscale that still gives us the full target size
+    for(int denom = 8; denom > 1; denom /= 2) {
+        if((int)(cinfo.image_width + denom - 1) / denom == width &&
+                (int)(cinfo.image_height + denom - 1) / denom == height) {
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = denom;
+            break;
+        }
     }
 
-    JSAMPROW row_pointer[1];        /* pointer to a single row */
-    int row_stride;                 /* physical row width in buffer */
-
-    row_stride = cinfo.image_width * planes;   /* JSAMPLEs per row in image_buffer */
-
-    while (cinfo.output_scanline < cinfo.output_height) {
-        row_pointer[0] = & image_buffer[cinfo.output_scanline * row_stride];
-        jpeg_read_scanlines(&cinfo, row_pointer, 1);
+    jpeg_start_decompress(&cinfo);
+    if((int)cinfo.output_width != width || (int)cinfo.output_height != height ||
+            (int)cinfo.output_components != planes) {
+        int outputWidth = cinfo.output_width;
+        int outputHeight = cinfo.output_height;
+        int outputPlanes = cinfo.output_components;
+        jpeg_destroy_decompress(&cinfo);
+        delete[] rowBuffer;
+        throw runtime_error("error reading " + name + ":" +
+            " size is " + toString(outputPlanes) + "x" + toString(outputWidth) + "x" + toString(outputHeight) +
+            " and not " + toString(planes) + "x" + toString(width) + "x" + toString(height) );
     }
 
-    jpeg_finish_decompress(&cinfo);
-    jpeg_destroy_decompress(&cinfo);
-
-    fclose(infile);
-
-    for(int row = 0; row < height; row++) {
-        for(int col = 0; col < width; col++) {
-            for(int plane = 0; plane < planes; plane++) {
-                values[plane*width*height + row*width + col] = image_buffer[row*width*planes + col*planes + plane];
+    // one scanline at a time, straight into the planes
+    int planeSize = width * height;
+    JSAMPROW rowPointer[1];
+    rowPointer[0] = rowBuffer;
+    while(cinfo.output_scanline < cinfo.output_height) {
+        int row = cinfo.output_scanline;
+        jpeg_read_scanlines(&cinfo, rowPointer, 1);
+        for(int plane = 0; plane < planes; plane++) {
+            unsigned char const *src = rowBuffer + plane;
+            unsigned char *dest = values + plane * planeSize + row * width;
+            for(int col = 0; col < width; col++) {
+                dest[col] = src[col * planes];
             }
         }
     }
 
-    delete[] image_buffer;
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    delete[] rowBuffer;
 }
 
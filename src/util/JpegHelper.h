@@ -24,6 +24,7 @@ class DeepCL_EXPORT JpegHelper {
     public:
     STATIC void write(std::string filename, int planes, int width, int height, unsigned char *values);
     STATIC void read(std::string filename, int planes, int width, int height, unsigned char *values);
+    STATIC void decode(std::string name, unsigned char const *jpegData, int64 jpegSize, int planes, int width, int height, unsigned char *values);
 
     // [[[end]]]
 };
@@ -0,0 +1,133 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "util/FileHelper.h"
+#include "util/MappedFile.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC MappedFile::MappedFile(std::string filepath) :
+        filepath(filepath),
+        data(0),
+        size(0) {
+    string localPath = FileHelper::localizePath(filepath);
+    #ifdef _WIN32
+    fileHandle = 0;
+    mappingHandle = 0;
+    HANDLE file = CreateFile(localPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) {
+        throw runtime_error("failed to open file: " + filepath);
+    }
+    fileHandle = file;
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw runtime_error("failed to get size of file: " + filepath);
+    }
+    size = (int64)fileSize.QuadPart;
+    if(size == 0) {
+        return;
+    }
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping == NULL) {
+        CloseHandle(file);
+        throw runtime_error("failed to map file: " + filepath);
+    }
+    mappingHandle = mapping;
+    data = (unsigned char const *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(data == 0) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw runtime_error("failed to map file: " + filepath);
+    }
+    #else
+    int fd = open(localPath.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw runtime_error("failed to open file: " + filepath);
+    }
+    struct stat status;
+    if(fstat(fd, &status) != 0) {
+        close(fd);
+        throw runtime_error("failed to get size of file: " + filepath);
+    }
+    size = (int64)status.st_size;
+    if(size == 0) {
+        close(fd);
+        return;
+    }
+    if((int64)(size_t)size != size) {
+        close(fd);
+        throw runtime_error("file too large to map, in a 32-bit build: " + filepath);
+    }
+    void *mapped = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps its own reference to the file
+    if(mapped == MAP_FAILED) {
+        throw runtime_error("failed to map file: " + filepath);
+    }
+    data = (unsigned char const *)mapped;
+    #endif
+}
+PUBLIC MappedFile::~MappedFile() {
+    #ifdef _WIN32
+    if(data != 0) {
+        UnmapViewOfFile(data);
+    }
+    if(mappingHandle != 0) {
+        CloseHandle(mappingHandle);
+    }
+    if(fileHandle != 0) {
+        CloseHandle(fileHandle);
+    }
+    #else
+    if(data != 0) {
+        munmap((void *)data, size);
+    }
+    #endif
+}
+PUBLIC std::string MappedFile::getFilepath() const {
+    return filepath;
+}
+// 0 if the file is empty
+PUBLIC unsigned char const *MappedFile::getData() const {
+    return data;
+}
+PUBLIC int64 MappedFile::getSize() const {
+    return size;
+}
+// hint to the os that we're about to read this range, so it can start
+// reading it in, in the background.  just a hint: does nothing on windows
+PUBLIC void MappedFile::adviseWillNeed(int64 offset, int64 length) const {
+    if(data == 0 || offset >= size || length <= 0) {
+        return;
+    }
+    if(offset + length > size) {
+        length = size - offset;
+    }
+    #ifndef _WIN32
+    int64 pageSize = sysconf(_SC_PAGESIZE);
+    int64 alignedOffset = offset / pageSize * pageSize;
+    madvise((void *)(data + alignedOffset), (size_t)(length + offset - alignedOffset), MADV_WILLNEED);
+    #endif
+}
+
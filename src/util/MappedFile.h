@@ -0,0 +1,51 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// read-only memory map of a whole file, unmapped again by the destructor
+// lets readers pull out just the bytes they need, without a read() call
+// and a copy each time, and the pages are shared between threads
+class DeepCL_EXPORT MappedFile {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::string filepath;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    unsigned char const *data;
+    int64 size;
+    #ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+    #endif
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    MappedFile(std::string filepath);
+    ~MappedFile();
+    std::string getFilepath() const;
+    unsigned char const *getData() const;
+    int64 getSize() const;
+    void adviseWillNeed(int64 offset, int64 length) const;
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,173 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "util/ThreadPool.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC ThreadPool::ThreadPool(int numThreads) :
+        numThreads(numThreads < 1 ? 1 : numThreads),
+        task(0),
+        numTasks(0),
+        nextTask(0),
+        numRemaining(0),
+        stopping(false) {
+    #ifndef NOTHREADS
+    for(int i = 1; i < this->numThreads; i++) {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+    #else
+    this->numThreads = 1;
+    #endif
+}
+PUBLIC ThreadPool::~ThreadPool() {
+    #ifndef NOTHREADS
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    tasksAvailable.notify_all();
+    for(int i = 0; i < (int)workers.size(); i++) {
+        workers[i].join();
+    }
+    #endif
+}
+PUBLIC STATIC int ThreadPool::defaultNumThreads() {
+    #ifndef NOTHREADS
+    int numCores = (int)std::thread::hardware_concurrency();
+    if(numCores >= 1) {
+        return numCores;
+    }
+    #endif
+    return 1;
+}
+// shared pool, one thread per core, created on first use, and never deleted
+PUBLIC STATIC ThreadPool *ThreadPool::instance() {
+    static ThreadPool *thisinstance = new ThreadPool(defaultNumThreads());
+    return thisinstance;
+}
+PUBLIC int ThreadPool::getNumThreads() const {
+    return numThreads;
+}
+// calls task->run(i) for each i in [0, numTasks), spread over the pool, and
+// returns once they have all finished
+// if any of them throw, the first error is rethrown here, as a runtime_error
+PUBLIC void ThreadPool::run(int numTasks, ThreadPoolTask *task) {
+    if(numTasks <= 0) {
+        return;
+    }
+    #ifdef NOTHREADS
+    for(int i = 0; i < numTasks; i++) {
+        task->run(i);
+    }
+    #else
+    bool nested = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for(int i = 0; i < (int)taskThreads.size(); i++) {
+            if(taskThreads[i] == std::this_thread::get_id()) {
+                nested = true;
+            }
+        }
+    }
+    if(nested) {
+        // the outer batch holds runMutex, and waits for this task to finish
+        for(int i = 0; i < numTasks; i++) {
+            task->run(i);
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> runLock(runMutex);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        this->task = task;
+        this->numTasks = numTasks;
+        this->nextTask = 0;
+        this->numRemaining = numTasks;
+        this->firstError = "";
+    }
+    tasksAvailable.notify_all();
+    while(runOne()) {
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    while(numRemaining > 0) {
+        tasksDone.wait(lock);
+    }
+    this->task = 0;
+    if(firstError != "") {
+        string error = firstError;
+        firstError = "";
+        throw runtime_error("ThreadPool task failed: " + error);
+    }
+    #endif
+}
+// grabs one task from the current batch, and runs it
+// returns false if there was nothing left to grab
+PRIVATE bool ThreadPool::runOne() {
+    #ifdef NOTHREADS
+    return false;
+    #else
+    ThreadPoolTask *thisTask = 0;
+    int index = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if(task == 0 || nextTask >= numTasks) {
+            return false;
+        }
+        thisTask = task;
+        index = nextTask;
+        nextTask++;
+        taskThreads.push_back(std::this_thread::get_id());
+    }
+    string error = "";
+    try {
+        thisTask->run(index);
+    } catch(std::exception &e) {
+        error = e.what();
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if(error != "" && firstError == "") {
+            firstError = error;
+        }
+        for(int i = 0; i < (int)taskThreads.size(); i++) {
+            if(taskThreads[i] == std::this_thread::get_id()) {
+                taskThreads.erase(taskThreads.begin() + i);
+                break;
+            }
+        }
+        numRemaining--;
+        if(numRemaining == 0) {
+            tasksDone.notify_all();
+        }
+    }
+    return true;
+    #endif
+}
+PRIVATE void ThreadPool::workerLoop() {
+    #ifndef NOTHREADS
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while(!stopping && (task == 0 || nextTask >= numTasks)) {
+                tasksAvailable.wait(lock);
+            }
+            if(stopping) {
+                return;
+            }
+        }
+        runOne();
+    }
+    #endif
+}
+
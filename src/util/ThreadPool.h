@@ -0,0 +1,88 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+#if defined(_MSC_VER) && _MSC_VER < 1700 // visual studio 2010 and earlier have no std::thread
+#define NOTHREADS
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// one unit of work for the ThreadPool: run(index) is called once for each
+// index in [0, numTasks), from whichever thread picks it up
+// implementations should not touch RandomSingleton, StatefulTimer, or an
+// EasyCL that another index uses too, from run()
+class DeepCL_EXPORT ThreadPoolTask {
+public:
+    virtual ~ThreadPoolTask() {}
+    virtual void run(int index) = 0;
+};
+
+// fixed set of worker threads, that we can hand a batch of independent tasks
+// to, and then block until they're all done
+// the calling thread works on the tasks too, so a pool of 1 thread
+// has no workers, and just runs everything inline
+// a run() from inside one of this pool's own tasks runs inline too, on that
+// task's thread, rather than waiting for the outer batch, which is waiting
+// for it
+// if NOTHREADS is defined, everything runs inline
+class DeepCL_EXPORT ThreadPool {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    #ifndef NOTHREADS
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::mutex runMutex; // one batch of tasks at a time
+    std::condition_variable tasksAvailable;
+    std::condition_variable tasksDone;
+    std::vector<std::thread::id> taskThreads; // those in the middle of one of our tasks
+    #endif
+    std::string firstError;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+
+    int numThreads;
+    ThreadPoolTask *task;
+    int numTasks;
+    int nextTask;
+    int numRemaining;
+    bool stopping;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ThreadPool(int numThreads);
+    ~ThreadPool();
+    STATIC int defaultNumThreads();
+    STATIC ThreadPool *instance();
+    int getNumThreads() const;
+    void run(int numTasks, ThreadPoolTask *task);
+
+    private:
+    bool runOne();
+    void workerLoop();
+
+    // [[[end]]]
+};
+
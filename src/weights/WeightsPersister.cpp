@@ -9,6 +9,7 @@
 
 #include "util/FileHelper.h"
 #include "net/NeuralNet.h"
+#include "net/ParameterArena.h"
 #include "layer/Layer.h"
 #include "weights/WeightsPersister.h"
 
@@ -40,6 +41,11 @@ STATIC void WeightsPersister::copyNetWeightsToArray(NeuralNet *net, float *targe
     copyNetWeightsToArray(latestVersion, net, target);
 }
 STATIC void WeightsPersister::copyNetWeightsToArray(int version, NeuralNet *net, float *target) {
+    // with a parameter arena, bring all the weights back in one transfer,
+    // rather than one per layer
+    if(net->getParameterArena() != 0) {
+        net->getParameterArena()->copyParamsToHost();
+    }
     int pos = 0;
     for(int layerIdx = 1; layerIdx < net->getNumLayers(); layerIdx++) {
         Layer *layer = net->getLayer(layerIdx);
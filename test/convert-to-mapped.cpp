@@ -0,0 +1,57 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// converts any dataset that deepcl_train can read (mnist, norb, kgsgo,
+// jpeg manifest, ...) into the deepcl mapped dataset format, which loads
+// with no copying, straight out of a memory map
+
+#include <iostream>
+#include <algorithm>
+
+#include "loaders/GenericLoaderv2.h"
+#include "loaders/MappedDatasetWriter.h"
+#include "util/stringhelper.h"
+
+using namespace std;
+
+int main( int argc, char *argv[] ) {
+    if( argc < 3 || argc > 5 ) {
+        cout << "Usage: " << argv[0] << " [images file (input)] [mapped dataset file (output, overwritten)] [num examples, 0 for all] [labels 1|0]" << endl;
+        return 1;
+    }
+    string inFile = argv[1];
+    string outFile = argv[2];
+    int numExamples = argc > 3 ? atoi(argv[3]) : 0;
+    bool hasLabels = argc > 4 ? atoi(argv[4]) != 0 : true;
+
+    GenericLoaderv2 loader( inFile );
+    int N = loader.getN();
+    if( numExamples == 0 || numExamples > N ) {
+        numExamples = N;
+    }
+    int planes = loader.getPlanes();
+    int size = loader.getImageSize();
+    int cubeSize = planes * size * size;
+    cout << "converting " << numExamples << " examples, planes=" << planes << " size=" << size << endl;
+
+    MappedDatasetWriter writer( outFile, numExamples, planes, size, hasLabels );
+    const int chunkSize = 1024;
+    unsigned char *images = new unsigned char[ (long)chunkSize * cubeSize ];
+    int *labels = hasLabels ? new int[chunkSize] : 0;
+    for( int start = 0; start < numExamples; start += chunkSize ) {
+        int thisChunkSize = std::min( chunkSize, numExamples - start );
+        loader.load( images, labels, start, thisChunkSize );
+        writer.append( images, labels, thisChunkSize );
+    }
+    writer.close();
+    cout << "wrote " << outFile << endl;
+
+    delete[] labels;
+    delete[] images;
+
+    return 0;
+}
+
@@ -0,0 +1,163 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "EasyCL.h"
+#include "conv/AutoTuneCache.h"
+#include "conv/AutoTuner.h"
+#include "conv/KernelTimer.h"
+#include "clmath/ProfilingQueue.h"
+#include "util/FileHelper.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+TEST( testAutoTuneCache, storeandreload ) {
+    FileHelper::remove( "~testtunecache.txt" );
+    vector<int> microseconds;
+    microseconds.push_back( 1200 );
+    microseconds.push_back( -1 );
+    microseconds.push_back( 700 );
+    microseconds.push_back( 3000 );
+    {
+        AutoTuneCache cache( "~testtunecache.txt" );
+        int chosen = -1;
+        EXPECT_FALSE( cache.lookup( "gpu|1.0|forward|1,28,8,5,1,1,0|128", &chosen ) );
+        cache.store( "gpu|1.0|forward|1,28,8,5,1,1,0|128", 2, microseconds );
+        cache.store( "gpu|1.0|backward|1,28,8,5,1,1,0|128", 3, microseconds );
+        EXPECT_TRUE( cache.lookup( "gpu|1.0|forward|1,28,8,5,1,1,0|128", &chosen ) );
+        EXPECT_EQ( 2, chosen );
+    }
+
+    // a new process sees the choices, but only for the exact same key
+    AutoTuneCache cache( "~testtunecache.txt" );
+    EXPECT_EQ( 2, cache.size() );
+    int chosen = -1;
+    EXPECT_TRUE( cache.lookup( "gpu|1.0|forward|1,28,8,5,1,1,0|128", &chosen ) );
+    EXPECT_EQ( 2, chosen );
+    EXPECT_TRUE( cache.lookup( "gpu|1.0|backward|1,28,8,5,1,1,0|128", &chosen ) );
+    EXPECT_EQ( 3, chosen );
+    EXPECT_FALSE( cache.lookup( "gpu|1.0|forward|1,28,8,5,1,1,0|64", &chosen ) );
+    EXPECT_FALSE( cache.lookup( "gpu|1.1|forward|1,28,8,5,1,1,0|128", &chosen ) );
+
+    // entries from another process are kept when we save
+    AutoTuneCache other( "~testtunecache.txt" );
+    other.store( "gpu|1.0|backpropweights|1,28,8,5,1,1,0|128", 1, microseconds );
+    cache.store( "gpu|1.0|forward|1,28,8,5,1,1,0|64", 0, microseconds );
+    AutoTuneCache reloaded( "~testtunecache.txt" );
+    EXPECT_EQ( 4, reloaded.size() );
+
+    FileHelper::remove( "~testtunecache.txt" );
+}
+
+TEST( testAutoTuneCache, emptyfilepathdoesntwrite ) {
+    FileHelper::remove( "~testtunecache.txt" );
+    vector<int> microseconds( 2, 500 );
+    AutoTuneCache cache( "~testtunecache.txt" );
+    cache.setFilepath( "" );
+    cache.store( "gpu|1.0|forward|1,28,8,5,1,1,0|128", 0, microseconds );
+    int chosen = -1;
+    EXPECT_TRUE( cache.lookup( "gpu|1.0|forward|1,28,8,5,1,1,0|128", &chosen ) );
+    EXPECT_EQ( 0, chosen );
+    EXPECT_FALSE( FileHelper::exists( "~testtunecache.txt" ) );
+}
+
+TEST( testAutoTuneCache, median ) {
+    vector<float> times;
+    EXPECT_EQ( -1, AutoTuner::median( times ) );
+    times.push_back( 40 );
+    times.push_back( 10 );
+    times.push_back( 900 ); // outlier, eg host jitter
+    EXPECT_EQ( 40, AutoTuner::median( times ) );
+    times.push_back( 20 );
+    EXPECT_EQ( 30, AutoTuner::median( times ) );
+}
+
+TEST( testAutoTuneCache, tunerchoosesbymedian_perbatchsize ) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    string oldFilepath = AutoTuneCache::instance()->getFilepath();
+    AutoTuneCache::instance()->setFilepath( "" );
+
+    LayerDimensions dim( 3, 16, 8, 3, true, true );
+    AutoTuner tuner( cl, "testtuner", dim, 3 );
+    EXPECT_EQ( -1, tuner.getChosenIndex( 128 ) );
+    vector<float> slow( 3, 500.0f );
+    vector<float> fast( 3, 20.0f );
+    fast[1] = 5000.0f; // one bad run shouldnt matter
+    EXPECT_EQ( 0, tuner.nextCandidate( 128 ) );
+    tuner.recordTimes( 128, 0, slow );
+    EXPECT_EQ( 1, tuner.nextCandidate( 128 ) );
+    tuner.recordTimes( 128, 1, fast );
+    EXPECT_EQ( 2, tuner.nextCandidate( 128 ) );
+    tuner.markUnusable( 128, 2, "testing" );
+    EXPECT_EQ( -1, tuner.nextCandidate( 128 ) );
+    EXPECT_EQ( 1, tuner.choose( 128 ) );
+    EXPECT_EQ( 1, tuner.getChosenIndex( 128 ) );
+
+    // a different batchsize is tuned afresh
+    EXPECT_EQ( -1, tuner.getChosenIndex( 1 ) );
+    EXPECT_EQ( 0, tuner.nextCandidate( 1 ) );
+
+    // and a new tuner, for the same dimensions, picks up the choice
+    AutoTuner tuner2( cl, "testtuner", dim, 3 );
+    EXPECT_EQ( 1, tuner2.getChosenIndex( 128 ) );
+
+    AutoTuneCache::instance()->clear();
+    AutoTuneCache::instance()->setFilepath( oldFilepath );
+    delete cl;
+}
+
+
+TEST( testAutoTuneCache, choiceoutofrange ) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    LayerDimensions dim( 3, 16, 8, 3, true, true );
+    AutoTuneCache cache( "" );
+    vector<int> microseconds( 6, 500 );
+    // eg from a version with more kernels
+    cache.storeChoice( cl, "testtuner", dim, 128, 5, microseconds );
+    int chosen = -1;
+    EXPECT_FALSE( cache.lookupChoice( cl, "testtuner", dim, 128, 3, &chosen ) );
+    EXPECT_EQ( -1, chosen );
+    EXPECT_TRUE( cache.lookupChoice( cl, "testtuner", dim, 128, 6, &chosen ) );
+    EXPECT_EQ( 5, chosen );
+    EXPECT_FALSE( cache.lookupChoice( cl, "testtuner", dim, 64, 6, &chosen ) );
+
+    // a different number of implementations is a different key altogether
+    EXPECT_NE( AutoTuneCache::makeKey( cl, "testtuner", dim, 128, 6 ),
+        AutoTuneCache::makeKey( cl, "testtuner", dim, 128, 7 ) );
+    delete cl;
+}
+
+TEST( testAutoTuneCache, kerneltimerusesevents ) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    float data[1024];
+    for( int i = 0; i < 1024; i++ ) {
+        data[i] = i;
+    }
+    CLWrapper *wrapper = cl->wrap( 1024, data );
+    KernelTimer timer( cl );
+    // the tuner's timer turns profiling on for the queue, rather than wait
+    // for it, and use the host clock
+    EXPECT_TRUE( timer.usesDeviceEvents() );
+    EXPECT_TRUE( ProfilingQueue::isEnabled( cl ) );
+    timer.start();
+    wrapper->copyToDevice();
+    float microseconds = timer.stop();
+    EXPECT_TRUE( microseconds >= 0 );
+    EXPECT_TRUE( timer.usesDeviceEvents() );
+
+    // and the queue still works, after the switch
+    for( int i = 0; i < 1024; i++ ) {
+        data[i] = 0;
+    }
+    wrapper->copyToHost();
+    EXPECT_EQ( 1023, data[1023] );
+    delete wrapper;
+    delete cl;
+}
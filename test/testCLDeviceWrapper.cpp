@@ -0,0 +1,105 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "EasyCL.h"
+
+#include "clmath/CLDeviceWrapper.h"
+#include "clmath/HostStagingPool.h"
+#include "clmath/CLMathWrapper.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+TEST(testCLDeviceWrapper, staging) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    float data[] = { 1, 3, 9, 12.5f, 2.5f };
+    CLDeviceWrapper *wrapper = new CLDeviceWrapper(cl, 5);
+    EXPECT_FALSE(wrapper->hasStaging());
+    wrapper->copyFromHost(data);
+    EXPECT_FALSE(wrapper->hasStaging());
+
+    float *staging = wrapper->copyToStaging();
+    EXPECT_TRUE(wrapper->hasStaging());
+    for(int i = 0; i < 5; i++) {
+        EXPECT_FLOAT_NEAR(data[i], staging[i]);
+    }
+
+    // a kernel writes to it, so the next read copies again, into the same array
+    CLMathWrapper a(wrapper);
+    a = 3.4f;
+    EXPECT_TRUE(wrapper->isDeviceDirty());
+    EXPECT_EQ(staging, wrapper->copyToStaging());
+    EXPECT_FLOAT_NEAR(3.4f, staging[0]);
+    EXPECT_FLOAT_NEAR(3.4f, staging[4]);
+
+    wrapper->fill(-2.0f);
+    EXPECT_FLOAT_NEAR(-2.0f, staging[2]);
+    EXPECT_FLOAT_NEAR(-2.0f, wrapper->copyToStaging()[3]);
+
+    delete wrapper;
+    delete cl;
+}
+
+TEST(testCLDeviceWrapper, view) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    float data[] = { 1, 2, 3, 4, 5, 6 };
+    CLDeviceWrapper *parent = new CLDeviceWrapper(cl, 6);
+    parent->copyFromHost(data);
+    CLDeviceWrapper *view = new CLDeviceWrapper(parent, 0, 4);
+    EXPECT_EQ(4, view->size());
+    float *staging = view->copyToStaging();
+    for(int i = 0; i < 4; i++) {
+        EXPECT_FLOAT_NEAR(data[i], staging[i]);
+    }
+
+    view->fill(7.0f);
+    float *parentStaging = parent->copyToStaging();
+    EXPECT_FLOAT_NEAR(7.0f, parentStaging[3]);
+    EXPECT_FLOAT_NEAR(5.0f, parentStaging[4]);
+
+    bool threw = false;
+    try {
+        CLDeviceWrapper tooBig(parent, 0, 7);
+    } catch(runtime_error &e) {
+        threw = true;
+    }
+    EXPECT_TRUE(threw);
+
+    delete view;
+    delete parent;
+    delete cl;
+}
+
+TEST(testCLDeviceWrapper, poolreuse) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    HostStagingPool::clear();
+    CLDeviceWrapper *first = new CLDeviceWrapper(cl, 1000);
+    float *staging = first->copyToStaging();
+    delete first;
+    EXPECT_EQ(1000, HostStagingPool::getNumFreeFloats());
+
+    // big enough to take over the freed array, but not one of under half its size
+    CLDeviceWrapper *second = new CLDeviceWrapper(cl, 800);
+    CLDeviceWrapper *small = new CLDeviceWrapper(cl, 400);
+    EXPECT_EQ(staging, second->copyToStaging());
+    EXPECT_EQ(0, HostStagingPool::getNumFreeFloats());
+    EXPECT_NE(staging, small->copyToStaging());
+
+    HostStagingPool::setMaxFreeFloats(500);
+    delete second;
+    delete small;
+    EXPECT_EQ(400, HostStagingPool::getNumFreeFloats());
+
+    HostStagingPool::setMaxFreeFloats(16 * 1024 * 1024);
+    HostStagingPool::clear();
+    EXPECT_EQ(0, HostStagingPool::getNumFreeFloats());
+    delete cl;
+}
+
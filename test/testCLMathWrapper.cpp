@@ -7,6 +7,8 @@
 #include "EasyCL.h"
 
 #include "clmath/CLMathWrapper.h"
+#include "clmath/CLMathExpression.h"
+#include "clmath/FusedGpuOp.h"
 
 #include "gtest/gtest.h"
 #include "test/gtest_supp.h"
@@ -233,3 +235,117 @@ TEST(testCLMathWrapper, perelementmult) {
     delete cl;
 }
 
+TEST(testCLMathWrapper, expression) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    float adat[] = { 1,3,9,12.5f,2.5f };
+    float bdat[] = { 4,2.1f, 5,3,9.2f };
+    CLWrapper *a_ = cl->wrap(5,adat);
+    CLWrapper *b_ = cl->wrap(5,bdat);
+    a_->copyToDevice();
+    b_->copyToDevice();
+
+    CLMathWrapper a(a_);
+    CLMathWrapper b(b_);
+    a = a * 0.5f + CLMathExpression(b).squared() / a - 1.0f;
+    a_->copyToHost();
+    b_->copyToHost();
+
+    for(int i = 0; i < 5; i++) {
+        cout << "a[" << i << "]=" << adat[i] << endl;
+    }
+    EXPECT_FLOAT_NEAR(0.5f + 16.0f - 1.0f, adat[0]);
+    EXPECT_FLOAT_NEAR(1.5f + 2.1f * 2.1f / 3.0f - 1.0f, adat[1]);
+    EXPECT_FLOAT_NEAR(1.25f + 9.2f * 9.2f / 2.5f - 1.0f, adat[4]);
+    // b is only read, so untouched
+    EXPECT_FLOAT_NEAR(2.1f, bdat[1]);
+
+    delete a_;
+    delete b_;
+    delete cl;
+}
+
+TEST(testCLMathWrapper, fusedmultipleassigns) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    float adat[] = { 1,3,9,12.5f,2.5f };
+    float bdat[] = { 4,2.1f, 5,3,9.2f };
+    float cdat[] = { 0,0,0,0,0 };
+    CLWrapper *a_ = cl->wrap(5,adat);
+    CLWrapper *b_ = cl->wrap(5,bdat);
+    CLWrapper *c_ = cl->wrap(5,cdat);
+    a_->copyToDevice();
+    b_->copyToDevice();
+    c_->createOnDevice();
+
+    CLMathWrapper a(a_);
+    CLMathWrapper b(b_);
+    CLMathWrapper c(c_);
+    FusedGpuOp fusedOp(cl);
+    // c is only written, b sees the new a, and a is updated twice
+    fusedOp.assign(a, a * 2.0f);
+    fusedOp.assign(b, b + a);
+    fusedOp.assign(c, CLMathExpression(b).sqrt());
+    fusedOp.assign(a, a + 1.0f);
+    string kernelName = fusedOp.getKernelName();
+    EXPECT_FALSE(cl->kernelExists(kernelName));
+    fusedOp.run();
+    EXPECT_TRUE(cl->kernelExists(kernelName));
+    CLKernel *kernel = cl->getKernel(kernelName);
+    a_->copyToHost();
+    b_->copyToHost();
+    c_->copyToHost();
+
+    for(int i = 0; i < 5; i++) {
+        cout << "a[" << i << "]=" << adat[i] << " b[" << i << "]=" << bdat[i] << " c[" << i << "]=" << cdat[i] << endl;
+    }
+    EXPECT_FLOAT_NEAR(3.0f, adat[0]);
+    EXPECT_FLOAT_NEAR(7.0f, adat[1]);
+    EXPECT_FLOAT_NEAR(6.0f, adat[4]);
+    EXPECT_FLOAT_NEAR(6.0f, bdat[0]);
+    EXPECT_FLOAT_NEAR(8.1f, bdat[1]);
+    EXPECT_FLOAT_NEAR(14.2f, bdat[4]);
+    EXPECT_FLOAT_NEAR(sqrt(6.0f), cdat[0]);
+    EXPECT_FLOAT_NEAR(sqrt(8.1f), cdat[1]);
+    EXPECT_FLOAT_NEAR(sqrt(14.2f), cdat[4]);
+
+    // same shape, different scalars, reuses the kernel
+    fusedOp.assign(a, a * 0.5f);
+    fusedOp.assign(b, b + a);
+    fusedOp.assign(c, CLMathExpression(b).sqrt());
+    fusedOp.assign(a, a + 0.0f);
+    EXPECT_EQ(kernelName, fusedOp.getKernelName());
+    fusedOp.run();
+    EXPECT_TRUE(kernel == cl->getKernel(kernelName));
+    a_->copyToHost();
+    EXPECT_FLOAT_NEAR(1.5f, adat[0]);
+    EXPECT_FLOAT_NEAR(3.0f, adat[4]);
+
+    delete a_;
+    delete b_;
+    delete c_;
+    delete cl;
+}
+
+TEST(testCLMathWrapper, expressionsizemismatch) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    float adat[] = { 1,3,9,12.5f,2.5f };
+    float bdat[] = { 4,2.1f, 5 };
+    CLWrapper *a_ = cl->wrap(5,adat);
+    CLWrapper *b_ = cl->wrap(3,bdat);
+    a_->copyToDevice();
+    b_->copyToDevice();
+
+    CLMathWrapper a(a_);
+    CLMathWrapper b(b_);
+    bool threw = false;
+    try {
+        a = a + b;
+    } catch(runtime_error &e) {
+        threw = true;
+    }
+    EXPECT_TRUE(threw);
+
+    delete a_;
+    delete b_;
+    delete cl;
+}
+
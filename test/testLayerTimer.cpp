@@ -0,0 +1,80 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "net/LayerTimer.h"
+#include "clmath/ProfilingQueue.h"
+#include "netdef/NetdefToNet.h"
+#include "layer/LayerMakers.h"
+#include "util/stringhelper.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+TEST(testLayerTimer, forwardbackward) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *net = new NeuralNet(cl);
+    net->addLayer(InputLayerMaker::instance()->numPlanes(1)->imageSize(8));
+    EXPECT_TRUE(NetdefToNet::createNetFromNetdef(net, "4c3z-relu-10n"));
+    net->setBatchSize(4);
+    float input[4 * 8 * 8];
+    int labels[] = { 1, 5, 9, 0 };
+    WeightRandomizer::randomize(input, 4 * 8 * 8, -1.0f, 1.0f);
+
+    // off by default
+    net->forward(input);
+    EXPECT_EQ(0, LayerTimer::getCount("layer1 forward"));
+    EXPECT_FALSE(ProfilingQueue::isEnabled(cl));
+
+    LayerTimer::setEnabled(true);
+    for(int it = 0; it < 3; it++) {
+        net->forward(input);
+        net->backwardFromLabels(labels);
+    }
+    LayerTimer::setEnabled(false);
+    for(int i = 0; i < net->getNumLayers(); i++) {
+        EXPECT_EQ(3, LayerTimer::getCount("layer" + toString(i) + " forward"));
+    }
+    EXPECT_EQ(3, LayerTimer::getCount("layer1 backward"));
+    EXPECT_TRUE(LayerTimer::getTotalMicroseconds("layer1 forward") >= 0);
+    EXPECT_EQ(0, LayerTimer::getCount("layer0 backward"));
+
+    // the queue was switched to profiling, so every timing came from the
+    // device's timestamps, without waiting for the queue
+    EXPECT_TRUE(ProfilingQueue::isEnabled(cl));
+    int numTimings = 0;
+    for(int i = 0; i < net->getNumLayers(); i++) {
+        numTimings += LayerTimer::getCount("layer" + toString(i) + " forward");
+        numTimings += LayerTimer::getCount("layer" + toString(i) + " backward");
+    }
+    EXPECT_EQ(numTimings, LayerTimer::getNumDeviceTimings());
+
+    LayerTimer::dump();
+    EXPECT_EQ(0, LayerTimer::getCount("layer1 forward"));
+    EXPECT_EQ(0, LayerTimer::getNumDeviceTimings());
+
+    // and the net still gives the same answer, on the new queue
+    float const *output = net->getOutput();
+    float before[4 * 10];
+    for(int i = 0; i < 4 * 10; i++) {
+        before[i] = output[i];
+    }
+    net->forward(input);
+    output = net->getOutput();
+    for(int i = 0; i < 4 * 10; i++) {
+        EXPECT_FLOAT_NEAR(before[i], output[i]);
+    }
+
+    delete net;
+    delete cl;
+}
+
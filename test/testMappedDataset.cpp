@@ -0,0 +1,75 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "loaders/MappedDatasetWriter.h"
+#include "loaders/MappedDatasetLoader.h"
+#include "loaders/GenericLoader.h"
+#include "loaders/GenericLoaderv2.h"
+#include "util/FileHelper.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+TEST( testMappedDataset, writeread ) {
+    // 2 x 5 x 5 = 50 bytes per image, so the records get padded, and written
+    // in two lots, to check the writer gets the offsets right
+    const int N = 7;
+    const int planes = 2;
+    const int size = 5;
+    const int cubeSize = planes * size * size;
+    unsigned char *images = new unsigned char[N * cubeSize];
+    int *labels = new int[N];
+    for( int n = 0; n < N; n++ ) {
+        for( int i = 0; i < cubeSize; i++ ) {
+            images[n * cubeSize + i] = (unsigned char)( ( n * 31 + i * 7 ) % 256 );
+        }
+        labels[n] = n * 3 + 1;
+    }
+    MappedDatasetWriter writer( "~testmapped.dat", N, planes, size, true );
+    writer.append( images, labels, 3 );
+    writer.append( images + 3 * cubeSize, labels + 3, N - 3 );
+    writer.close();
+
+    EXPECT_TRUE( MappedDatasetLoader::isFormatFor( "~testmapped.dat" ) );
+    int N2, planes2, size2;
+    GenericLoader::getDimensions( "~testmapped.dat", &N2, &planes2, &size2 );
+    EXPECT_EQ( N, N2 );
+    EXPECT_EQ( planes, planes2 );
+    EXPECT_EQ( size, size2 );
+
+    // bytes, via the Loader interface, from the middle of the file
+    GenericLoaderv2 loader( "~testmapped.dat" );
+    unsigned char *images2 = new unsigned char[N * cubeSize];
+    int *labels2 = new int[N];
+    loader.load( images2, labels2, 2, 4 );
+    for( int n = 0; n < 4; n++ ) {
+        EXPECT_EQ( labels[n + 2], labels2[n] );
+        for( int i = 0; i < cubeSize; i++ ) {
+            EXPECT_EQ( images[(n + 2) * cubeSize + i], images2[n * cubeSize + i] );
+        }
+    }
+
+    // floats, normalized straight out of the mapping
+    float *floats = new float[N * cubeSize];
+    loader.load( floats, labels2, 0, N, -10.0f, 0.5f );
+    for( int n = 0; n < N; n++ ) {
+        EXPECT_EQ( labels[n], labels2[n] );
+        for( int i = 0; i < cubeSize; i++ ) {
+            EXPECT_EQ( ( images[n * cubeSize + i] - 10.0f ) * 0.5f, floats[n * cubeSize + i] );
+        }
+    }
+
+    delete[] floats;
+    delete[] labels2;
+    delete[] images2;
+    delete[] labels;
+    delete[] images;
+}
+
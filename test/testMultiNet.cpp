@@ -0,0 +1,160 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "EasyCL.h"
+#include "DevicesInfo.h"
+#include "net/NeuralNet.h"
+#include "net/MultiNet.h"
+#include "netdef/NetdefToNet.h"
+#include "layer/LayerMakers.h"
+#include "activate/ActivationLayer.h"
+#include "trainers/SGD.h"
+#include "trainers/TrainingContext.h"
+#include "util/AllocationCounter.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+using namespace easycl;
+
+namespace testMultiNet {
+
+NeuralNet *createModel(EasyCL *cl) {
+    NeuralNet *net = new NeuralNet(cl);
+    net->addLayer(InputLayerMaker::instance()->numPlanes(1)->imageSize(8));
+    EXPECT_TRUE(NetdefToNet::createNetFromNetdef(net, "4c3z-relu-10n"));
+    return net;
+}
+
+// the multinet's output is the average of its columns' outputs
+void checkAverage(MultiNet *multiNet, int batchSize) {
+    float *input = new float[batchSize * 8 * 8];
+    WeightRandomizer::randomize(input, batchSize * 8 * 8, -1.0f, 1.0f);
+    multiNet->setBatchSize(batchSize);
+    multiNet->forward(input);
+    int outputNumElements = batchSize * 10;
+    float *expected = new float[outputNumElements];
+    for(int i = 0; i < outputNumElements; i++) {
+        expected[i] = 0;
+    }
+    for(int column = 0; column < multiNet->getNumNets(); column++) {
+        float const *columnOutput = multiNet->getNet(column)->getOutput();
+        for(int i = 0; i < outputNumElements; i++) {
+            expected[i] += columnOutput[i] / multiNet->getNumNets();
+        }
+    }
+    float const *output = multiNet->getOutput();
+    for(int i = 0; i < outputNumElements; i++) {
+        EXPECT_FLOAT_NEAR(expected[i], output[i]);
+    }
+    delete[] expected;
+    delete[] input;
+}
+
+TEST(testMultiNet, averageondevice) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *model = createModel(cl);
+    MultiNet *multiNet = new MultiNet(3, model);
+    EXPECT_FALSE(multiNet->isConcurrent());
+    checkAverage(multiNet, 4);
+    checkAverage(multiNet, 2);
+
+    delete multiNet;
+    delete model;
+    delete cl;
+}
+
+TEST(testMultiNet, columnsfusedlikemodel) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *model = createModel(cl);
+    model->fuseLayers();
+    // layer 2 is the relu, after the convolution
+    ActivationLayer *modelRelu = dynamic_cast< ActivationLayer * >(model->getLayer(2));
+    ASSERT_TRUE(modelRelu != 0);
+    EXPECT_TRUE(modelRelu->isFused());
+    for(int concurrent = 0; concurrent <= 1; concurrent++) {
+        MultiNet *multiNet = new MultiNet(2, model, concurrent == 1);
+        for(int column = 0; column < 2; column++) {
+            NeuralNet *columnNet = dynamic_cast< NeuralNet * >(multiNet->getNet(column));
+            EXPECT_TRUE(dynamic_cast< ActivationLayer * >(columnNet->getLayer(2))->isFused());
+        }
+        checkAverage(multiNet, 4);
+        delete multiNet;
+    }
+
+    // and an unfused model gives unfused columns
+    NeuralNet *unfused = createModel(cl);
+    MultiNet *multiNet = new MultiNet(2, unfused);
+    EXPECT_FALSE(dynamic_cast< ActivationLayer * >(dynamic_cast< NeuralNet * >(multiNet->getNet(0))->getLayer(2))->isFused());
+    delete multiNet;
+    delete unfused;
+    delete model;
+    delete cl;
+}
+
+TEST(testMultiNet, concurrent) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *model = createModel(cl);
+    MultiNet *multiNet = new MultiNet(3, model, true);
+    EXPECT_TRUE(multiNet->isConcurrent());
+    for(int column = 0; column < 3; column++) {
+        EasyCL *columnCl = dynamic_cast< NeuralNet * >(multiNet->getNet(column))->getCl();
+        EXPECT_TRUE(columnCl != cl);
+        if(DevicesInfo::getNumGpus() <= 1) {
+            // a queue of its own, in the model's context
+            EXPECT_TRUE(*columnCl->context == *cl->context);
+            EXPECT_TRUE(*columnCl->queue != *cl->queue);
+        }
+    }
+    checkAverage(multiNet, 4);
+    if(DevicesInfo::getNumGpus() <= 1) {
+        // so the average is still done on the device
+        EXPECT_EQ(3, (int)multiNet->getColumnOutputWrappers().size());
+    }
+
+    // train all three columns, each with a trainer on the model's EasyCL
+    multiNet->setBatchSize(4);
+    float input[4 * 8 * 8];
+    int labels[] = { 1, 5, 9, 0 };
+    WeightRandomizer::randomize(input, 4 * 8 * 8, -1.0f, 1.0f);
+    SGD *sgd = SGD::instance(cl, 0.1f, 0.0f);
+    TrainingContext context(0, 0);
+    float firstLoss = 0;
+    float lastLoss = 0;
+    for(int it = 0; it < 20; it++) {
+        BatchResult result = sgd->trainFromLabels(multiNet, &context, input, labels);
+        if(it == 0) {
+            firstLoss = result.getLoss();
+        }
+        lastLoss = result.getLoss();
+    }
+    cout << "loss " << firstLoss << " -> " << lastLoss << endl;
+    EXPECT_TRUE(lastLoss < firstLoss);
+    checkAverage(multiNet, 4);
+
+    // a batch for the MultiNet is one batch, not one per column
+    multiNet->setBatchSize(4);
+    AllocationCounter::reset();
+    sgd->trainFromLabels(multiNet, &context, input, labels);
+    EXPECT_EQ(1, AllocationCounter::getNumBatches());
+    float expectedOutput[4 * 10];
+    WeightRandomizer::randomize(expectedOutput, 4 * 10, 0.0f, 1.0f);
+    sgd->train(multiNet, &context, input, expectedOutput);
+    EXPECT_EQ(2, AllocationCounter::getNumBatches());
+    AllocationCounter::reset();
+
+    delete sgd;
+    delete multiNet;
+    delete model;
+    delete cl;
+}
+
+}
+
@@ -13,6 +13,8 @@
 #include "fc/FullyConnectedLayer.h"
 #include "conv/ConvolutionalLayer.h"
 #include "loss/SoftMaxLayer.h"
+#include "activate/ActivationLayer.h"
+#include "test/WeightRandomizer.h"
 #include "layer/LayerMakers.h"
 
 TEST( testNetdefToNet, empty ) {
@@ -198,3 +200,59 @@ TEST( testNetdefToNet, 2x32c7_3x32c5z ) {
     delete cl;
 }
 
+// the netdef folds each activation into the layer before it: same layers as
+// without, and the same results
+TEST( testNetdefToNet, fusedactivations ) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *net = new NeuralNet(cl);
+    net->addLayer( InputLayerMaker::instance()->numPlanes(2)->imageSize(7) );
+    ASSERT_EQ( true, NetdefToNet::createNetFromNetdef( net, "8c3z-relu-10n-tanh" ) );
+    ASSERT_EQ( 6, net->getNumLayers() );
+    EXPECT_TRUE( dynamic_cast< ActivationLayer * >( net->getLayer(2) )->isFused() );
+    EXPECT_TRUE( dynamic_cast< ActivationLayer * >( net->getLayer(4) )->isFused() );
+
+    NeuralNet *unfused = new NeuralNet(cl);
+    unfused->addLayer( InputLayerMaker::instance()->numPlanes(2)->imageSize(7) );
+    unfused->addLayer( ConvolutionalMaker::instance()->numFilters(8)->filterSize(3)->padZeros()->biased() );
+    unfused->addLayer( ActivationMaker::instance()->relu() );
+    unfused->addLayer( FullyConnectedMaker::instance()->numPlanes(10)->imageSize(1)->biased() );
+    unfused->addLayer( ActivationMaker::instance()->tanh() );
+    unfused->addLayer( SoftMaxMaker::instance() );
+    EXPECT_FALSE( dynamic_cast< ActivationLayer * >( unfused->getLayer(2) )->isFused() );
+    unfused->getLayer(1)->setWeights( net->getLayer(1)->getWeights(), net->getLayer(1)->getBias() );
+    unfused->getLayer(3)->setWeights( net->getLayer(3)->getWeights(), net->getLayer(3)->getBias() );
+
+    const int batchSize = 4;
+    net->setBatchSize( batchSize );
+    unfused->setBatchSize( batchSize );
+    float *input = new float[ batchSize * 2 * 7 * 7 ];
+    WeightRandomizer::randomize( input, batchSize * 2 * 7 * 7, -1.0f, 1.0f );
+    int labels[] = { 3, 0, 9, 5 };
+
+    net->forward( input );
+    unfused->forward( input );
+    float const *output = net->getOutput();
+    float const *unfusedOutput = unfused->getOutput();
+    for( int i = 0; i < batchSize * 10; i++ ) {
+        EXPECT_FLOAT_NEAR( unfusedOutput[i], output[i] );
+    }
+
+    net->backwardFromLabels( labels );
+    unfused->backwardFromLabels( labels );
+    float const *gradWeights = net->getLayer(1)->getGradWeights();
+    float const *unfusedGradWeights = unfused->getLayer(1)->getGradWeights();
+    for( int i = 0; i < net->getLayer(1)->getWeightsSize(); i++ ) {
+        EXPECT_FLOAT_NEAR( unfusedGradWeights[i], gradWeights[i] );
+    }
+    float const *gradBias = net->getLayer(1)->getGradBias();
+    float const *unfusedGradBias = unfused->getLayer(1)->getGradBias();
+    for( int i = 0; i < net->getLayer(1)->getBiasSize(); i++ ) {
+        EXPECT_FLOAT_NEAR( unfusedGradBias[i], gradBias[i] );
+    }
+
+    delete[] input;
+    delete unfused;
+    delete net;
+    delete cl;
+}
+
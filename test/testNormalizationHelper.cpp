@@ -0,0 +1,84 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "normalize/NormalizationHelper.h"
+#include "normalize/NormalizationLayer.h"
+#include "net/NeuralNet.h"
+#include "net/NeuralNetMould.h"
+#include "layer/LayerMakers.h"
+#include "EasyCL.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+TEST( testNormalizationHelper, translateandscalebytes ) {
+    // odd length, so we go through both the simd part and the tail
+    const int length = 16 * 5 + 7;
+    unsigned char *source = new unsigned char[length];
+    for( int i = 0; i < length; i++ ) {
+        source[i] = (unsigned char)( ( i * 37 + 11 ) % 256 );
+    }
+    float translate = -127.5f;
+    float scale = 1.0f / 64.0f;
+    float *dest = new float[length];
+    NormalizationHelper::translateAndScale( source, dest, length, translate, scale );
+    for( int i = 0; i < length; i++ ) {
+        // has to match NormalizationLayer exactly
+        float expected = ( (float)source[i] + translate ) * scale;
+        EXPECT_EQ( expected, dest[i] );
+    }
+
+    // float version, in place
+    float *floats = new float[length];
+    for( int i = 0; i < length; i++ ) {
+        floats[i] = source[i];
+    }
+    NormalizationHelper::translateAndScale( floats, floats, length, translate, scale );
+    for( int i = 0; i < length; i++ ) {
+        EXPECT_EQ( dest[i], floats[i] );
+    }
+
+    delete[] floats;
+    delete[] dest;
+    delete[] source;
+}
+
+TEST( testNormalizationHelper, layeronthedevice ) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    const int batchSize = 3;
+    const int numPlanes = 2;
+    const int imageSize = 5;
+    const int length = batchSize * numPlanes * imageSize * imageSize;
+    float translate = -127.5f;
+    float scale = 1.0f / 64.0f;
+    NeuralNet *net = NeuralNet::maker( cl )->planes( numPlanes )->imageSize( imageSize )->instance();
+    net->addLayer( NormalizationLayerMaker::instance()->translate( translate )->scale( scale ) );
+    net->setBatchSize( batchSize );
+    float *input = new float[length];
+    for( int i = 0; i < length; i++ ) {
+        input[i] = (float)( ( i * 37 + 11 ) % 256 );
+    }
+    float *expected = new float[length];
+    NormalizationHelper::translateAndScale( input, expected, length, translate, scale );
+
+    net->forward( input );
+    NormalizationLayer *layer = dynamic_cast< NormalizationLayer * >( net->getLayer( 1 ) );
+    EXPECT_TRUE( layer->hasOutputWrapper() );
+    float *output = layer->getOutput();
+    for( int i = 0; i < length; i++ ) {
+        EXPECT_FLOAT_NEAR( expected[i], output[i] );
+    }
+
+    delete[] expected;
+    delete[] input;
+    delete net;
+    delete cl;
+}
+
@@ -0,0 +1,235 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <mutex>
+
+#include "batch/NetAction.h"
+#include "batch/OnDemandBatcherv2.h"
+#include "loaders/Loader.h"
+#include "loaders/GenericLoaderv2.h"
+#include "net/Trainable.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/sleep.h"
+
+using namespace std;
+
+// OnDemandBatcherv2's prefetch thread, against a fake loader: record n has
+// label n, and every byte of its image is n % 256, so each batch the net
+// sees says where it came from
+namespace testOnDemandBatcherv2 {
+
+const int planes = 1;
+const int imageSize = 2;
+const int cubeSize = planes * imageSize * imageSize;
+
+class FakeLoader : public Loader {
+public:
+    const int N;
+    int failFrom; // records from here on throw, if >= 0
+    float delaySeconds; // per load, so tests can catch a load in progress
+    std::mutex mutex;
+    int numLoads;
+    FakeLoader(int N) :
+        N(N),
+        failFrom(-1),
+        delaySeconds(0),
+        numLoads(0) {
+    }
+    virtual std::string getType() {
+        return "FakeLoader";
+    }
+    virtual void load(unsigned char *data, int *labels, int startRecord, int numRecords) {
+        if(delaySeconds > 0) {
+            Sleep::sleep(delaySeconds);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            numLoads++;
+        }
+        if(failFrom >= 0 && startRecord + numRecords > failFrom) {
+            throw runtime_error("fake failure at record " + to_string((long long)failFrom));
+        }
+        for(int n = 0; n < numRecords; n++) {
+            labels[n] = startRecord + n;
+            for(int i = 0; i < cubeSize; i++) {
+                data[n * cubeSize + i] = (unsigned char)((startRecord + n) % 256);
+            }
+        }
+    }
+    virtual int getImageCubeSize() {
+        return cubeSize;
+    }
+    virtual int getN() {
+        return N;
+    }
+    virtual int getPlanes() {
+        return planes;
+    }
+    virtual int getImageSize() {
+        return imageSize;
+    }
+    int getNumLoads() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return numLoads;
+    }
+};
+
+// just enough net for the Batcher: remembers the batch size it was given
+class FakeNet : public Trainable {
+public:
+    int batchSize;
+    FakeNet() :
+        batchSize(0) {
+    }
+    virtual int getOutputNumElements() const { return batchSize; }
+    virtual float calcLoss(float const *expectedValues) { return 0; }
+    virtual float calcLossFromLabels(int const *labels) { return 0; }
+    virtual void setBatchSize(int batchSize) { this->batchSize = batchSize; }
+    virtual void setTraining(bool training) {}
+    virtual int calcNumRight(int const *labels) { return batchSize; }
+    virtual void forward(float const*images) {}
+    virtual void backwardFromLabels(int const *labels) {}
+    virtual void backward(float const *expectedOutput) {}
+    virtual float const *getOutput() const { return 0; }
+    virtual LossLayerMaker *cloneLossLayerMaker() const { return 0; }
+    virtual int getOutputPlanes() const { return 1; }
+    virtual int getOutputSize() const { return 1; }
+    virtual int getInputCubeSize() const { return cubeSize; }
+    virtual int getOutputCubeSize() const { return 1; }
+    virtual bool isTuning() { return false; }
+};
+
+// the labels of every example the net was given, in order, checking that
+// each image matches its label
+class RecordingAction : public NetAction {
+public:
+    vector<int> labelsSeen;
+    virtual void run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels) {
+        int batchSize = dynamic_cast< FakeNet * >(net)->batchSize;
+        for(int n = 0; n < batchSize; n++) {
+            labelsSeen.push_back(batchLabels[n]);
+            for(int i = 0; i < cubeSize; i++) {
+                EXPECT_EQ((float)(batchLabels[n] % 256), batchData[n * cubeSize + i]);
+            }
+        }
+    }
+};
+
+void expectLabels(vector<int> const &labelsSeen, int start, int end) {
+    ASSERT_EQ(end - start, (int)labelsSeen.size());
+    for(int i = 0; i < end - start; i++) {
+        EXPECT_EQ(start + i, labelsSeen[i]);
+    }
+}
+
+// 10 examples, in file batches of 4, 4, and 2, each of two batches
+const int N = 10;
+const int fileReadBatches = 2;
+const int batchSize = 2;
+
+TEST(testOnDemandBatcherv2, twoepochs) {
+    for(int prefetchDepth = 0; prefetchDepth <= 3; prefetchDepth++) {
+        FakeNet net;
+        RecordingAction action;
+        GenericLoaderv2 loader(new FakeLoader(N));
+        OnDemandBatcherv2 batcher(&net, &action, &loader, N, fileReadBatches, batchSize);
+        batcher.setPrefetchDepth(prefetchDepth);
+        EXPECT_EQ(prefetchDepth, batcher.getPrefetchDepth());
+
+        EpochResult result = batcher.run(0);
+        EXPECT_EQ(N, result.numRight);
+        expectLabels(action.labelsSeen, 0, N);
+        EXPECT_TRUE(batcher.getEpochDone());
+
+        // the prefetch thread wraps round into the second epoch
+        action.labelsSeen.clear();
+        batcher.run(1);
+        expectLabels(action.labelsSeen, 0, N);
+    }
+}
+
+TEST(testOnDemandBatcherv2, restartpartial) {
+    FakeNet net;
+    RecordingAction action;
+    GenericLoaderv2 loader(new FakeLoader(N));
+    OnDemandBatcherv2 batcher(&net, &action, &loader, N, fileReadBatches, batchSize);
+    batcher.setPrefetchDepth(2);
+
+    // two file batches in, with the third already loading, start again
+    EXPECT_TRUE(batcher.tick(0));
+    EXPECT_TRUE(batcher.tick(0));
+    expectLabels(action.labelsSeen, 0, 8);
+    batcher.reset();
+    action.labelsSeen.clear();
+    batcher.run(0);
+    expectLabels(action.labelsSeen, 0, N);
+
+    // and from batch 2, ie file batch 1, eg resuming from a checkpoint
+    batcher.tick(1);
+    batcher.setBatchState(2, 0, 0);
+    EXPECT_EQ(1, batcher.getNextFileBatch());
+    action.labelsSeen.clear();
+    batcher.run(1);
+    expectLabels(action.labelsSeen, 4, N);
+}
+
+TEST(testOnDemandBatcherv2, loaderexception) {
+    FakeNet net;
+    RecordingAction action;
+    FakeLoader *fakeLoader = new FakeLoader(N);
+    fakeLoader->failFrom = 6;
+    GenericLoaderv2 loader(fakeLoader);
+    OnDemandBatcherv2 batcher(&net, &action, &loader, N, fileReadBatches, batchSize);
+    batcher.setPrefetchDepth(2);
+
+    // the first file batch is fine, the second fails in the prefetch thread,
+    // and should come out of tick, on this thread
+    EXPECT_TRUE(batcher.tick(0));
+    EXPECT_THROW(batcher.tick(0), runtime_error);
+    expectLabels(action.labelsSeen, 0, 4);
+    EXPECT_EQ(1, batcher.getNextFileBatch());
+
+    // once the loader recovers, carries on from the batch that failed
+    fakeLoader->failFrom = -1;
+    batcher.run(0);
+    expectLabels(action.labelsSeen, 0, N);
+}
+
+TEST(testOnDemandBatcherv2, shutdownwhileprefetching) {
+    FakeNet net;
+    RecordingAction action;
+    FakeLoader *fakeLoader = new FakeLoader(N);
+    fakeLoader->delaySeconds = 0.05f;
+    GenericLoaderv2 loader(fakeLoader);
+    OnDemandBatcherv2 *batcher = new OnDemandBatcherv2(&net, &action, &loader, N, fileReadBatches, batchSize);
+    batcher->setPrefetchDepth(3);
+    batcher->tick(0);
+    expectLabels(action.labelsSeen, 0, 4);
+    // the prefetch thread is now part way through loading the next ones
+    delete batcher;
+    int numLoads = fakeLoader->getNumLoads();
+    Sleep::sleep(0.2f);
+    // nothing left running, to touch the loader after we've gone
+    EXPECT_EQ(numLoads, fakeLoader->getNumLoads());
+
+    // and changing the depth mid-epoch stops the thread too
+    batcher = new OnDemandBatcherv2(&net, &action, &loader, N, fileReadBatches, batchSize);
+    batcher->setPrefetchDepth(3);
+    batcher->tick(0);
+    batcher->setPrefetchDepth(1);
+    action.labelsSeen.clear();
+    batcher->run(0);
+    expectLabels(action.labelsSeen, 4, N);
+    delete batcher;
+}
+
+}
+
@@ -0,0 +1,131 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "net/OutputArenas.h"
+#include "layer/Layer.h"
+#include "netdef/NetdefToNet.h"
+#include "layer/LayerMakers.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+namespace testOutputArenas {
+
+// input, normalization, conv, fused relu, pooling, fc, softmax
+TEST(testOutputArenas, planchain) {
+    bool passesThroughArray[] = { false, false, false, true, false, false, false };
+    int viewSizesArray[] = { 0, 100, 400, 0, 100, 10, 0 };
+    vector<bool> passesThrough(passesThroughArray, passesThroughArray + 7);
+    vector<int> viewSizes(viewSizesArray, viewSizesArray + 7);
+    vector<int> arenaOfLayer;
+    vector<int> arenaSizes;
+    OutputArenas::plan(passesThrough, viewSizes, &arenaOfLayer, &arenaSizes);
+
+    int expectedArenas[] = { -1, 0, 1, -1, 0, 1, -1 };
+    for(int i = 0; i < 7; i++) {
+        EXPECT_EQ(expectedArenas[i], arenaOfLayer[i]);
+    }
+    ASSERT_EQ(2, (int)arenaSizes.size());
+    EXPECT_EQ(100, arenaSizes[0]);
+    EXPECT_EQ(400, arenaSizes[1]);
+}
+
+// the pooling reads the conv output through two pass-throughs, so it cant
+// go in the conv's arena, but the fc after it can
+TEST(testOutputArenas, planpassthroughs) {
+    bool passesThroughArray[] = { false, false, true, true, false, false };
+    int viewSizesArray[] = { 0, 40, 0, 0, 10, 5 };
+    vector<bool> passesThrough(passesThroughArray, passesThroughArray + 6);
+    vector<int> viewSizes(viewSizesArray, viewSizesArray + 6);
+    vector<int> arenaOfLayer;
+    vector<int> arenaSizes;
+    OutputArenas::plan(passesThrough, viewSizes, &arenaOfLayer, &arenaSizes);
+
+    int expectedArenas[] = { -1, 0, -1, -1, 1, 0 };
+    for(int i = 0; i < 6; i++) {
+        EXPECT_EQ(expectedArenas[i], arenaOfLayer[i]);
+    }
+    ASSERT_EQ(2, (int)arenaSizes.size());
+    EXPECT_EQ(40, arenaSizes[0]);
+    EXPECT_EQ(10, arenaSizes[1]);
+}
+
+NeuralNet *createNet(EasyCL *cl) {
+    NeuralNet *net = new NeuralNet(cl);
+    net->addLayer(InputLayerMaker::instance()->numPlanes(2)->imageSize(12));
+    net->addLayer(NormalizationLayerMaker::instance()->translate(-0.5f)->scale(2.0f));
+    EXPECT_TRUE(NetdefToNet::createNetFromNetdef(net, "8c3z-relu-mp2-16c3z-relu-10n"));
+    return net;
+}
+
+// same outputs as the same net, run as usual, in less memory
+TEST(testOutputArenas, sameasnoninference) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *net = createNet(cl);
+    NeuralNet *inferenceNet = createNet(cl);
+    inferenceNet->setInference(true);
+    ASSERT_EQ(9, net->getNumLayers());
+    int weightedLayers[] = { 2, 5, 7 }; // the convs and the fc
+    for(int i = 0; i < 3; i++) {
+        Layer *layer = net->getLayer(weightedLayers[i]);
+        inferenceNet->getLayer(weightedLayers[i])->setWeights(layer->getWeights(), layer->getBias());
+    }
+    bool threw = false;
+    try {
+        inferenceNet->setTraining(true);
+    } catch(runtime_error &e) {
+        threw = true;
+    }
+    EXPECT_TRUE(threw);
+
+    int batchSizes[] = { 4, 2, 9 };
+    for(int it = 0; it < 3; it++) {
+        int batchSize = batchSizes[it];
+        net->setBatchSize(batchSize);
+        inferenceNet->setBatchSize(batchSize);
+        OutputArenas *arenas = inferenceNet->getOutputArenas();
+        ASSERT_TRUE(arenas != 0);
+        EXPECT_EQ(2, arenas->getNumArenas());
+        int ownOutputs = 0;
+        for(int i = 0; i < net->getNumLayers(); i++) {
+            if(arenas->getArenaOfLayer(i) >= 0) {
+                ownOutputs += net->getLayer(i)->getOutputNumElements();
+            }
+        }
+        // the arenas are only replanned when the batch size grows
+        ownOutputs = ownOutputs / batchSize * arenas->getBatchSize();
+        cout << "batchsize " << batchSize << " arenas " << arenas->getNumFloats() << " floats, instead of "
+            << ownOutputs << endl;
+        EXPECT_TRUE(arenas->getNumFloats() < ownOutputs);
+
+        float *input = new float[batchSize * 2 * 12 * 12];
+        WeightRandomizer::randomize(input, batchSize * 2 * 12 * 12, 0.0f, 1.0f);
+        net->forward(input);
+        inferenceNet->forward(input);
+        float const *output = net->getOutput();
+        float const *inferenceOutput = inferenceNet->getOutput();
+        for(int i = 0; i < batchSize * 10; i++) {
+            EXPECT_FLOAT_NEAR(output[i], inferenceOutput[i]);
+        }
+        delete[] input;
+    }
+
+    delete inferenceNet;
+    delete net;
+    delete cl;
+}
+
+}
+
@@ -0,0 +1,170 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <stdexcept>
+
+#include "qlearning/ReplayMemory.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+namespace testReplayMemory {
+
+const int frameSize = 5;
+
+// frame i is filled with i, so it's easy to see which frame we got back
+void makeFrame(int i, float *frame) {
+    for(int j = 0; j < frameSize; j++) {
+        frame[j] = (float)i;
+    }
+}
+
+// adds frame 0, then transitions to frames 1 to numTransitions, with
+// transition t taking action t, reward t / 10, and ending a game every 3
+void addTransitions(ReplayMemory *memory, int numTransitions) {
+    float frame[frameSize];
+    makeFrame(0, frame);
+    memory->addFrame(frame);
+    for(int t = 0; t < numTransitions; t++) {
+        makeFrame(t + 1, frame);
+        memory->addTransition(t, t / 10.0f, t % 3 == 2, frame);
+    }
+}
+
+// transition i should be the one added as newest - size() + 1 + i
+void expectTransitions(ReplayMemory *memory, int newest) {
+    int oldest = newest - memory->size() + 1;
+    for(int i = 0; i < memory->size(); i++) {
+        int t = oldest + i;
+        EXPECT_EQ(t, memory->getAction(i));
+        EXPECT_FLOAT_NEAR(t / 10.0f, memory->getReward(i));
+        EXPECT_EQ(t % 3 == 2, memory->getIsEndState(i));
+        for(int j = 0; j < frameSize; j++) {
+            EXPECT_EQ((float)t, memory->getBefore(i)[j]);
+            EXPECT_EQ((float)(t + 1), memory->getAfter(i)[j]);
+        }
+    }
+}
+
+TEST(testReplayMemory, notfull) {
+    ReplayMemory memory(10, frameSize);
+    EXPECT_EQ(0, memory.size());
+    addTransitions(&memory, 4);
+    EXPECT_EQ(4, memory.size());
+    expectTransitions(&memory, 3);
+}
+
+TEST(testReplayMemory, wraps) {
+    ReplayMemory memory(10, frameSize);
+    addTransitions(&memory, 27);
+    EXPECT_EQ(10, memory.size());
+    EXPECT_EQ(10, memory.getCapacity());
+    expectTransitions(&memory, 26);
+}
+
+TEST(testReplayMemory, gather) {
+    ReplayMemory memory(7, frameSize);
+    addTransitions(&memory, 20);
+    int transitions[] = { 0, 6, 3, 3 };
+    float befores[4 * frameSize];
+    float afters[4 * frameSize];
+    memory.gather(4, transitions, befores, afters);
+    for(int n = 0; n < 4; n++) {
+        int t = 13 + transitions[n];
+        for(int j = 0; j < frameSize; j++) {
+            EXPECT_EQ((float)t, befores[n * frameSize + j]);
+            EXPECT_EQ((float)(t + 1), afters[n * frameSize + j]);
+        }
+    }
+}
+
+TEST(testReplayMemory, setcapacity) {
+    ReplayMemory memory(10, frameSize);
+    addTransitions(&memory, 15);
+
+    memory.setCapacity(4);
+    EXPECT_EQ(4, memory.size());
+    expectTransitions(&memory, 14);
+
+    // grows again, but only has the 4 it kept, until more come in
+    memory.setCapacity(12);
+    EXPECT_EQ(4, memory.size());
+    expectTransitions(&memory, 14);
+    float frame[frameSize];
+    for(int t = 15; t < 30; t++) {
+        makeFrame(t + 1, frame);
+        memory.addTransition(t, t / 10.0f, t % 3 == 2, frame);
+    }
+    EXPECT_EQ(12, memory.size());
+    expectTransitions(&memory, 29);
+}
+
+TEST(testReplayMemory, prioritized) {
+    ReplayMemory memory(6, frameSize);
+    EXPECT_THROW(memory.getTotalPriority(), runtime_error);
+    addTransitions(&memory, 3);
+    memory.setPrioritized(true);
+    EXPECT_FLOAT_NEAR(3.0f, memory.getTotalPriority());
+
+    // wrap around, so the oldest transition isnt in slot 0
+    float frame[frameSize];
+    for(int t = 3; t < 10; t++) {
+        makeFrame(t + 1, frame);
+        memory.addTransition(t, t / 10.0f, t % 3 == 2, frame);
+    }
+    EXPECT_EQ(6, memory.size());
+    expectTransitions(&memory, 9);
+    EXPECT_FLOAT_NEAR(6.0f, memory.getTotalPriority());
+
+    for(int i = 0; i < 6; i++) {
+        memory.setPriority(i, 0.0f);
+    }
+    memory.setPriority(4, 3.0f);
+    memory.setPriority(1, 1.0f);
+    // the sum tree goes by slot, not by transition, so only how often each
+    // is drawn is certain, not in what order
+    int found[6] = { 0, 0, 0, 0, 0, 0 };
+    for(float value = 0.5f; value < 4.0f; value += 1.0f) {
+        found[memory.sample(value)]++;
+    }
+    EXPECT_EQ(1, found[1]);
+    EXPECT_EQ(3, found[4]);
+
+    // new transitions come in at the highest priority so far
+    makeFrame(11, frame);
+    memory.addTransition(10, 1.0f, false, frame);
+    EXPECT_FLOAT_NEAR(3.0f, memory.getPriority(5));
+    // which overwrote the oldest, transition 0, so the rest moved down one
+    EXPECT_FLOAT_NEAR(1.0f, memory.getPriority(0));
+    EXPECT_FLOAT_NEAR(3.0f, memory.getPriority(3));
+
+    // priorities survive a change in capacity
+    memory.setCapacity(3);
+    EXPECT_FLOAT_NEAR(3.0f, memory.getPriority(0));
+    EXPECT_FLOAT_NEAR(0.0f, memory.getPriority(1));
+    EXPECT_FLOAT_NEAR(3.0f, memory.getPriority(2));
+    EXPECT_FLOAT_NEAR(6.0f, memory.getTotalPriority());
+    for(float value = 0.5f; value < 6.0f; value += 1.0f) {
+        EXPECT_NE(1, memory.sample(value));
+    }
+}
+
+TEST(testReplayMemory, outofrange) {
+    ReplayMemory memory(10, frameSize);
+    float frame[frameSize];
+    makeFrame(0, frame);
+    EXPECT_THROW(memory.addTransition(0, 0, false, frame), runtime_error);
+    addTransitions(&memory, 3);
+    EXPECT_THROW(memory.getAction(3), runtime_error);
+    EXPECT_THROW(memory.getBefore(-1), runtime_error);
+    EXPECT_THROW(ReplayMemory(0, frameSize), runtime_error);
+}
+
+}
+
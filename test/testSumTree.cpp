@@ -0,0 +1,74 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <stdexcept>
+
+#include "qlearning/SumTree.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+namespace testSumTree {
+
+// find() against a walk along the items, for sizes that arent powers of 2
+void checkFind(int numItems) {
+    SumTree tree(numItems);
+    for(int i = 0; i < numItems; i++) {
+        tree.set(i, (float)(i % 4));
+    }
+    float total = 0;
+    for(int i = 0; i < numItems; i++) {
+        total += tree.get(i);
+    }
+    EXPECT_FLOAT_NEAR(total, tree.getTotal());
+    // every item with a priority is found, exactly as often as its priority,
+    // over values spaced 1 apart, and the ones with priority 0 never are
+    int *found = new int[numItems];
+    for(int i = 0; i < numItems; i++) {
+        found[i] = 0;
+    }
+    for(float value = 0.5f; value < total; value += 1.0f) {
+        int item = tree.find(value);
+        ASSERT_TRUE(item >= 0 && item < numItems);
+        found[item]++;
+    }
+    for(int i = 0; i < numItems; i++) {
+        EXPECT_EQ((int)tree.get(i), found[i]);
+    }
+    delete[] found;
+}
+
+TEST(testSumTree, find) {
+    checkFind(1);
+    checkFind(2);
+    checkFind(7);
+    checkFind(16);
+    checkFind(37);
+}
+
+TEST(testSumTree, update) {
+    SumTree tree(5);
+    EXPECT_EQ(0, tree.getTotal());
+    tree.set(3, 2.0f);
+    EXPECT_EQ(3, tree.find(0));
+    EXPECT_EQ(3, tree.find(1.99f));
+    // values at or past the total still land on an item with a priority
+    EXPECT_EQ(3, tree.find(2.0f));
+    tree.set(1, 1.0f);
+    EXPECT_FLOAT_NEAR(3.0f, tree.getTotal());
+    tree.set(3, 0.0f);
+    EXPECT_FLOAT_NEAR(1.0f, tree.getTotal());
+    EXPECT_EQ(1, tree.find(0.5f));
+    EXPECT_EQ(1, tree.find(1.5f));
+    EXPECT_THROW(tree.set(5, 1.0f), runtime_error);
+    EXPECT_THROW(tree.set(0, -1.0f), runtime_error);
+}
+
+}
+
@@ -0,0 +1,86 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "util/ThreadPool.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+namespace testThreadPool {
+
+// marks off each index it's given, in its own slot, so needs no locking
+class MarkTask : public ThreadPoolTask {
+public:
+    vector<int> counts;
+    MarkTask(int numTasks) :
+        counts(numTasks, 0) {
+    }
+    virtual void run(int index) {
+        counts[index]++;
+        if(index == 3) {
+            throw runtime_error("index 3 failed");
+        }
+    }
+};
+
+// each index runs a whole inner batch, on the same pool
+class OuterTask : public ThreadPoolTask {
+public:
+    ThreadPool *pool;
+    vector<MarkTask *> inner;
+    OuterTask(ThreadPool *pool, int numOuter, int numInner) :
+        pool(pool) {
+        for(int i = 0; i < numOuter; i++) {
+            inner.push_back(new MarkTask(numInner));
+        }
+    }
+    ~OuterTask() {
+        for(int i = 0; i < (int)inner.size(); i++) {
+            delete inner[i];
+        }
+    }
+    virtual void run(int index) {
+        try {
+            pool->run((int)inner[index]->counts.size(), inner[index]);
+        } catch(runtime_error &e) {
+        }
+    }
+};
+
+TEST(testThreadPool, basic) {
+    ThreadPool pool(4);
+    MarkTask task(50);
+    EXPECT_THROW(pool.run(50, &task), runtime_error);
+    for(int i = 0; i < 50; i++) {
+        EXPECT_EQ(1, task.counts[i]);
+    }
+}
+
+TEST(testThreadPool, nested) {
+    for(int numThreads = 1; numThreads <= 4; numThreads++) {
+        ThreadPool pool(numThreads);
+        OuterTask task(&pool, 8, 3);
+        pool.run(8, &task);
+        for(int i = 0; i < 8; i++) {
+            for(int j = 0; j < 3; j++) {
+                EXPECT_EQ(1, task.inner[i]->counts[j]);
+            }
+        }
+        // and the pool still works, after
+        MarkTask after(10);
+        EXPECT_THROW(pool.run(10, &after), runtime_error);
+        EXPECT_EQ(1, after.counts[9]);
+    }
+}
+
+}
+
@@ -0,0 +1,169 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "layer/LayerMakers.h"
+#include "qlearning/Scenario.h"
+#include "qlearning/QLearner.h"
+#include "qlearning/VectorQLearner.h"
+#include "trainers/SGD.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+namespace testVectorQLearner {
+
+// a 2x2 world, where action 0 pays 1, and action 1 nothing, and each game
+// lasts gameLength moves; the perception shows how far into the game we are
+class CountingScenario : public Scenario {
+public:
+    int gameLength;
+    int movesThisGame;
+    int numActs;
+    int numResets;
+    CountingScenario(int gameLength) :
+        gameLength(gameLength),
+        movesThisGame(0),
+        numActs(0),
+        numResets(0) {
+    }
+    virtual int getPerceptionSize() {
+        return 2;
+    }
+    virtual int getPerceptionPlanes() {
+        return 1;
+    }
+    virtual void getPerception(float *perception) {
+        for(int i = 0; i < 4; i++) {
+            perception[i] = i == movesThisGame % 4 ? 1.0f : 0.0f;
+        }
+    }
+    virtual void reset() {
+        movesThisGame = 0;
+        numResets++;
+    }
+    virtual int getNumActions() {
+        return 2;
+    }
+    virtual float act(int index) {
+        EXPECT_TRUE(index == 0 || index == 1);
+        movesThisGame++;
+        numActs++;
+        return index == 0 ? 1.0f : 0.0f;
+    }
+    virtual bool hasFinished() {
+        return movesThisGame >= gameLength;
+    }
+};
+
+NeuralNet *createNet(EasyCL *cl) {
+    NeuralNet *net = new NeuralNet(cl);
+    net->addLayer(InputLayerMaker::instance()->numPlanes(1)->imageSize(2));
+    net->addLayer(FullyConnectedMaker::instance()->numPlanes(2)->imageSize(1)->biased());
+    net->addLayer(SquareLossMaker::instance());
+    return net;
+}
+
+void runScenarios(int numThreads) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *net = createNet(cl);
+    SGD *sgd = SGD::instance(cl, 0.1f, 0.0f);
+    vector<Scenario *> scenarios;
+    for(int i = 0; i < 4; i++) {
+        scenarios.push_back(new CountingScenario(3 + i));
+    }
+    VectorQLearner *vectorQLearner = new VectorQLearner(sgd, scenarios, net, numThreads);
+    EXPECT_EQ(4, vectorQLearner->getNumEnvironments());
+    EXPECT_EQ(4, vectorQLearner->getQLearner()->getNumEnvironments());
+    EXPECT_EQ(4, vectorQLearner->getQLearner()->getPerceptionCubeSize());
+    vectorQLearner->getQLearner()->setMaxSamples(8);
+    vectorQLearner->getQLearner()->setReplayCapacity(30);
+    EXPECT_EQ(30, vectorQLearner->getQLearner()->getReplayCapacity());
+    // one batch of 4 perceptions per step, not 4 steps
+    EXPECT_THROW(vectorQLearner->getQLearner()->step(0, false, 0), runtime_error);
+
+    const int numSteps = 40;
+    for(int it = 0; it < numSteps; it++) {
+        vectorQLearner->step();
+    }
+    for(int i = 0; i < 4; i++) {
+        CountingScenario *scenario = dynamic_cast< CountingScenario * >(scenarios[i]);
+        EXPECT_EQ(numSteps, scenario->numActs);
+        EXPECT_EQ(numSteps / (3 + i), scenario->numResets);
+    }
+
+    delete vectorQLearner; // and the scenarios with it
+    delete sgd;
+    delete net;
+    delete cl;
+}
+
+TEST(testVectorQLearner, samethread) {
+    runScenarios(1);
+}
+
+TEST(testVectorQLearner, threads) {
+    runScenarios(4);
+}
+
+TEST(testVectorQLearner, prioritized) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *net = createNet(cl);
+    SGD *sgd = SGD::instance(cl, 0.1f, 0.0f);
+    vector<Scenario *> scenarios;
+    for(int i = 0; i < 3; i++) {
+        scenarios.push_back(new CountingScenario(4));
+    }
+    VectorQLearner *vectorQLearner = new VectorQLearner(sgd, scenarios, net, 1);
+    vectorQLearner->getQLearner()->setPrioritizedReplay(true);
+    vectorQLearner->getQLearner()->setMaxSamples(16);
+    // smaller than maxSamples, so some samples come up more than once
+    vectorQLearner->getQLearner()->setReplayCapacity(9);
+    for(int it = 0; it < 30; it++) {
+        vectorQLearner->step();
+    }
+    EXPECT_EQ(30, dynamic_cast< CountingScenario * >(scenarios[2])->numActs);
+
+    delete vectorQLearner;
+    delete sgd;
+    delete net;
+    delete cl;
+}
+
+TEST(testVectorQLearner, setnumenvironments) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *net = createNet(cl);
+    SGD *sgd = SGD::instance(cl, 0.1f, 0.0f);
+    CountingScenario one(3);
+    QLearner qlearner(sgd, &one, net);
+    EXPECT_THROW(qlearner.setNumEnvironments(0), runtime_error);
+    qlearner.setNumEnvironments(2);
+    float perceptions[2 * 4];
+    float lastRewards[] = { 0, 0 };
+    bool wasResets[] = { false, false };
+    int actions[2];
+    one.getPerception(perceptions);
+    one.getPerception(perceptions + 4);
+    qlearner.stepAll(lastRewards, wasResets, perceptions, actions);
+    EXPECT_TRUE(actions[0] == 0 || actions[0] == 1);
+    EXPECT_TRUE(actions[1] == 0 || actions[1] == 1);
+    // too late, now that they've started
+    EXPECT_THROW(qlearner.setNumEnvironments(3), runtime_error);
+
+    delete sgd;
+    delete net;
+    delete cl;
+}
+
+}
+
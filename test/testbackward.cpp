@@ -10,6 +10,7 @@
 
 #include "net/NeuralNet.h"
 #include "conv/Backward.h"
+#include "conv/Im2ColWorkspace.h"
 #include "activate/ActivationFunction.h"
 #include "loss/LossLayer.h"
 #include "forcebackprop/ForceBackpropLayerMaker.h"
@@ -808,6 +809,9 @@ TEST(testbackward, compare_1_n_kgsgo_32c5) {
 
     compareSpecific(0, 1, 1, batchSize, dim);
     for(int instance=2; instance < Backward::getNumImplementations(); instance++) {
+        if(instance == 4) {
+            continue; // winograd, 3x3 filters only
+        }
         cout << "instance " << instance << endl;
         dim.setInputSize(19);
         if(instance == 2 && maxWorkgroupSize < 19 * 19) {
@@ -817,6 +821,55 @@ TEST(testbackward, compare_1_n_kgsgo_32c5) {
     }
 }
 
+TEST(testbackward, compare_1_3_smallworkspace) {
+    // room to unroll two images at a time, so the batch goes in two full
+    // chunks and a partial one
+    int batchSize = 5;
+    LayerDimensions dim;
+    dim.setInputPlanes(4).setInputSize(13).setNumFilters(6).setFilterSize(5)
+        .setPadZeros(true).setBiased(true);
+    long oldMaxBytes = Im2ColWorkspace::getMaxBytes();
+    Im2ColWorkspace::setMaxBytes(2l * (dim.inputPlanes * dim.filterSizeSquared + dim.numFilters) * dim.outputSizeSquared * 4l);
+    compareSpecific(1, 3, 1, batchSize, dim);
+    Im2ColWorkspace::setMaxBytes(oldMaxBytes);
+}
+
+TEST(testbackward, compare_0_3_skip) {
+    int batchSize = 3;
+    LayerDimensions dim;
+    dim.setInputPlanes(4).setInputSize(13).setNumFilters(6).setFilterSize(5)
+        .setPadZeros(true).setBiased(true).setSkip(1);
+    compareSpecific(0, 3, 1, batchSize, dim);
+    dim.setPadZeros(false).setSkip(2);
+    compareSpecific(0, 3, 1, batchSize, dim);
+}
+
+TEST(testbackward, compare_0_4_winograd) {
+    int batchSize = 5;
+    LayerDimensions dim;
+    dim.setInputPlanes(6).setInputSize(19).setNumFilters(8).setFilterSize(3)
+        .setPadZeros(true).setBiased(true);
+    compareSpecific(0, 4, 1, batchSize, dim);
+    dim.setInputSize(16);
+    compareSpecific(0, 4, 1, batchSize, dim);
+    dim.setPadZeros(false);
+    compareSpecific(0, 4, 1, batchSize, dim);
+    dim.setInputSize(19);
+    compareSpecific(0, 4, 1, batchSize, dim);
+}
+
+TEST(testbackward, compare_0_5_fft) {
+    int batchSize = 5;
+    LayerDimensions dim;
+    dim.setInputPlanes(4).setInputSize(13).setNumFilters(5).setFilterSize(7)
+        .setPadZeros(true).setBiased(true);
+    compareSpecific(0, 5, 1, batchSize, dim);
+    dim.setPadZeros(false);
+    compareSpecific(0, 5, 1, batchSize, dim);
+    dim.setInputSize(16).setFilterSize(9);
+    compareSpecific(0, 5, 1, batchSize, dim);
+}
+
 TEST(SLOW_testbackward, compare_kgsgo_32c5mini) {
     int batchSize = 4;
     LayerDimensions dim;
@@ -7,6 +7,7 @@
 #include "EasyCL.h"
 
 #include "dropout/DropoutForward.h"
+#include "dropout/DropoutMasks.h"
 #include "activate/ActivationFunction.h"
 
 #include "gtest/gtest.h"
@@ -148,7 +149,9 @@ TEST( testdropoutforward, fromwrappers ) {
     float *output = new float[outputNumElements];
 
     const int inputNumElements = batchSize * numPlanes * imageSize * imageSize;
-    CLWrapper *maskWrapper = cl->wrap( inputNumElements, mask );
+    int *maskWords = new int[ DropoutMasks::numWords( inputNumElements ) ];
+    DropoutMasks::pack( inputNumElements, mask, maskWords );
+    CLWrapper *maskWrapper = cl->wrap( DropoutMasks::numWords( inputNumElements ), maskWords );
     CLWrapper *inputWrapper = cl->wrap( inputNumElements, input );
     CLWrapper *outputWrapper = cl->wrap( outputNumElements, output );
 
@@ -172,6 +175,7 @@ TEST( testdropoutforward, fromwrappers ) {
     delete inputWrapper;
     delete outputWrapper;
     delete dropoutForward;
+    delete[] maskWords;
     delete[] output;
     delete cl;
 }
@@ -252,11 +256,13 @@ void compareSpecific( CompareSpecificArgs args ) {
     float *input = new float[ inputNumElements ];
     float *output = new float[ outputNumElements ];
 
-    CLWrapper *maskWrapper = cl->wrap( inputNumElements, mask );
+    int *maskWords = new int[ DropoutMasks::numWords( inputNumElements ) ];
+    CLWrapper *maskWrapper = cl->wrap( DropoutMasks::numWords( inputNumElements ), maskWords );
     CLWrapper *inputWrapper = cl->wrap( inputNumElements, input );
     CLWrapper *outputWrapper = cl->wrap( outputNumElements, output );
 
     WeightRandomizer::randomizeInts( mask, inputNumElements, 0, 2 );
+    DropoutMasks::pack( inputNumElements, mask, maskWords );
 //    for( int i = 0; i < inputNumElements; i++ ) {
 //        cout << (int)mask[i] << " ";
 //    }
@@ -340,6 +346,7 @@ void compareSpecific( CompareSpecificArgs args ) {
     delete[] output0;
     delete[] output;
     delete[] input;
+    delete[] maskWords;
     delete[] mask;
     delete cl;
 }
@@ -386,5 +393,86 @@ TEST( testdropoutforward, comparespecific_0_1_dropout3_small2_tanh ) {
         .instance0(0).instance1(1) );
 }
 
+
+// both implementations generate the masks from the seed and batch counter
+// alone, so, given the same ones, they drop exactly the same elements
+TEST( testdropoutforward, generate_0_1_sameseed ) {
+    int batchSize = 7;
+    int numPlanes = 5;
+    int imageSize = 9;
+    float dropRatio = 0.6f;
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    DropoutForward *dropoutForward0 = DropoutForward::instanceSpecific( 0, cl, numPlanes, imageSize, dropRatio );
+    DropoutForward *dropoutForward1 = DropoutForward::instanceSpecific( 1, cl, numPlanes, imageSize, dropRatio );
+
+    const int numElements = batchSize * numPlanes * imageSize * imageSize;
+    const int numWords = DropoutMasks::numWords( numElements );
+    float *input = new float[ numElements ];
+    float *output0 = new float[ numElements ];
+    float *output1 = new float[ numElements ];
+    int *masks0 = new int[ numWords ];
+    int *masks1 = new int[ numWords ];
+    int *masksHost = new int[ numWords ];
+    WeightRandomizer::randomize( input, numElements, 0.5f, 1.5f );
+
+    CLWrapper *inputWrapper = cl->wrap( numElements, input );
+    CLWrapper *output0Wrapper = cl->wrap( numElements, output0 );
+    CLWrapper *output1Wrapper = cl->wrap( numElements, output1 );
+    CLWrapper *masks0Wrapper = cl->wrap( numWords, masks0 );
+    CLWrapper *masks1Wrapper = cl->wrap( numWords, masks1 );
+    inputWrapper->copyToDevice();
+
+    dropoutForward0->generateAndForward( batchSize, 12345, 3, masks0Wrapper, inputWrapper, output0Wrapper );
+    dropoutForward1->generateAndForward( batchSize, 12345, 3, masks1Wrapper, inputWrapper, output1Wrapper );
+    masks0Wrapper->copyToHost();
+    masks1Wrapper->copyToHost();
+    output0Wrapper->copyToHost();
+    output1Wrapper->copyToHost();
+
+    int numMaskErrors = 0;
+    for( int w = 0; w < numWords; w++ ) {
+        if( masks0[w] != masks1[w] ) {
+            numMaskErrors++;
+        }
+    }
+    EXPECT_EQ( 0, numMaskErrors );
+    int numKept = 0;
+    int numOutputErrors = 0;
+    for( int i = 0; i < numElements; i++ ) {
+        bool kept = DropoutMasks::isKept( masks0, i );
+        numKept += kept ? 1 : 0;
+        if( output0[i] != output1[i] || output0[i] != ( kept ? input[i] : 0 ) ) {
+            numOutputErrors++;
+        }
+    }
+    EXPECT_EQ( 0, numOutputErrors );
+    float keptFraction = (float)numKept / numElements;
+    cout << "kept fraction " << keptFraction << endl;
+    EXPECT_TRUE( keptFraction > 0.35f && keptFraction < 0.45f );
+
+    // same as the host reference
+    DropoutMasks::generate( numElements, 12345, 3, dropRatio, masksHost );
+    EXPECT_EQ( 0, memcmp( masks0, masksHost, sizeof(int) * numWords ) );
+
+    // and the next batch gets different masks
+    DropoutMasks::generate( numElements, 12345, 4, dropRatio, masksHost );
+    EXPECT_NE( 0, memcmp( masks0, masksHost, sizeof(int) * numWords ) );
+
+    delete inputWrapper;
+    delete output0Wrapper;
+    delete output1Wrapper;
+    delete masks0Wrapper;
+    delete masks1Wrapper;
+    delete dropoutForward0;
+    delete dropoutForward1;
+    delete[] input;
+    delete[] output0;
+    delete[] output1;
+    delete[] masks0;
+    delete[] masks1;
+    delete[] masksHost;
+    delete cl;
+}
+
 }
 
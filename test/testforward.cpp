@@ -7,6 +7,7 @@
 #include "EasyCL.h"
 #include "net/NeuralNet.h"
 #include "conv/Forward.h"
+#include "conv/Im2ColWorkspace.h"
 #include "activate/ActivationFunction.h"
 #include "layer/Layer.h"
 #include "layer/LayerMakers.h"
@@ -557,6 +558,154 @@ TEST( testforward, compare_0_1_biased_pad ) {
     compareSpecific( false, N, batchSize, dim, 0, 1 );
 }
 
+TEST( testforward, compare_0_8_biased_pad ) {
+    LayerDimensions dim;
+    int batchSize = 5;
+    int N = 10;
+    dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 9 )
+        .setFilterSize( 5 )
+        .setPadZeros( true ).setBiased( true );
+    compareSpecific( false, N, batchSize, dim, 0, 8 );
+}
+
+TEST( testforward, compare_0_8_unbiased_nopad ) {
+    LayerDimensions dim;
+    int batchSize = 3;
+    int N = 3;
+    dim.setInputPlanes( 3 ).setInputSize(33).setNumFilters( 7 )
+        .setFilterSize( 3 )
+        .setPadZeros( false ).setBiased( false );
+    compareSpecific( false, N, batchSize, dim, 0, 8 );
+}
+
+TEST( testforward, cpuim2col_notcandidateongpu ) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    LayerDimensions dim;
+    dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 9 )
+        .setFilterSize( 5 )
+        .setPadZeros( true ).setBiased( true );
+    cl_device_type deviceType = 0;
+    clGetDeviceInfo( cl->device, CL_DEVICE_TYPE, sizeof(deviceType), &deviceType, 0 );
+    bool isGpu = ( deviceType & CL_DEVICE_TYPE_GPU ) != 0;
+    EXPECT_EQ( !isGpu, Forward::plausiblyOptimal( 8, 5, cl, dim ) );
+    EXPECT_TRUE( Forward::plausiblyOptimal( 7, 5, cl, dim ) );
+    // asking for it by name still gets it
+    Forward *forward = Forward::instanceSpecific( "cpuim2col", cl, dim );
+    EXPECT_TRUE( forward != 0 );
+    delete forward;
+    delete cl;
+}
+
+TEST( testforward, compare_0_7_smallworkspace ) {
+    // room for ForwardIm2Col to unroll two images at a time, so the batch
+    // goes in two full chunks and a partial one
+    LayerDimensions dim;
+    int batchSize = 5;
+    int N = 10;
+    dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 9 )
+        .setFilterSize( 5 )
+        .setPadZeros( true ).setBiased( true );
+    long oldMaxBytes = Im2ColWorkspace::getMaxBytes();
+    Im2ColWorkspace::setMaxBytes( 2l * ( dim.inputPlanes * dim.filterSizeSquared + dim.numFilters ) * dim.outputSizeSquared * 4l );
+    compareSpecific( false, N, batchSize, dim, 0, 7 );
+    Im2ColWorkspace::setMaxBytes( oldMaxBytes );
+}
+
+TEST( testforward, compare_0_n_skip ) {
+    // 19 isnt a multiple of the stride, so the last input row and column
+    // arent covered, when padding
+    LayerDimensions dim;
+    int batchSize = 3;
+    int N = 3;
+    dim.setInputPlanes( 4 ).setInputSize(19).setNumFilters( 5 )
+        .setFilterSize( 5 )
+        .setPadZeros( true ).setBiased( true ).setSkip( 1 );
+    EXPECT_EQ( 9, dim.outputSize );
+    compareSpecific( false, N, batchSize, dim, 0, 1 );
+    compareSpecific( false, N, batchSize, dim, 0, 7 );
+    compareSpecific( false, N, batchSize, dim, 0, 8 );
+
+    dim.setPadZeros( false ).setSkip( 2 );
+    EXPECT_EQ( 5, dim.outputSize );
+    compareSpecific( false, N, batchSize, dim, 0, 1 );
+    compareSpecific( false, N, batchSize, dim, 0, 7 );
+    compareSpecific( false, N, batchSize, dim, 0, 8 );
+}
+
+TEST( testforward, compare_0_9_winograd ) {
+    // odd output sizes leave the last tiles hanging over the edge
+    LayerDimensions dim;
+    int batchSize = 5;
+    int N = 3;
+    dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 9 )
+        .setFilterSize( 3 )
+        .setPadZeros( true ).setBiased( true );
+    compareSpecific( false, N, batchSize, dim, 0, 9 );
+    dim.setInputSize( 16 );
+    compareSpecific( false, N, batchSize, dim, 0, 9 );
+    dim.setPadZeros( false );
+    compareSpecific( false, N, batchSize, dim, 0, 9 );
+    dim.setInputSize( 19 );
+    compareSpecific( false, N, batchSize, dim, 0, 9 );
+}
+
+TEST( testforward, compare_0_10_fft ) {
+    LayerDimensions dim;
+    int batchSize = 5;
+    int N = 3;
+    dim.setInputPlanes( 4 ).setInputSize(13).setNumFilters( 5 )
+        .setFilterSize( 7 )
+        .setPadZeros( true ).setBiased( true );
+    compareSpecific( false, N, batchSize, dim, 0, 10 );
+    dim.setPadZeros( false );
+    compareSpecific( false, N, batchSize, dim, 0, 10 );
+    dim.setInputSize( 16 ).setFilterSize( 9 );
+    compareSpecific( false, N, batchSize, dim, 0, 10 );
+}
+
+TEST( testforward, fft_weightschangedinplace ) {
+    // as during training: the same weights wrapper, with new values each time,
+    // so the cached filter transforms have to be redone
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    ClBlasInstance clblasInstance;
+    LayerDimensions dim;
+    dim.setInputPlanes( 3 ).setInputSize( 11 ).setNumFilters( 4 )
+        .setFilterSize( 7 )
+        .setPadZeros( true ).setBiased( false );
+    int batchSize = 2;
+    float *inputs = new float[ batchSize * dim.inputCubeSize ];
+    float *filters = new float[ dim.filtersSize ];
+    float *output = new float[ batchSize * dim.outputCubeSize ];
+    WeightRandomizer::randomize( 0, inputs, batchSize * dim.inputCubeSize, -0.1f, 0.1f );
+    Forward *cpu = Forward::instanceSpecific( 0, cl, dim );
+    Forward *fft = Forward::instanceSpecific( 10, cl, dim );
+    CLWrapper *inputsWrapper = cl->wrap( batchSize * dim.inputCubeSize, inputs );
+    CLWrapper *filtersWrapper = cl->wrap( dim.filtersSize, filters );
+    CLWrapper *outputWrapper = cl->wrap( batchSize * dim.outputCubeSize, output );
+    inputsWrapper->copyToDevice();
+    for( int it = 0; it < 3; it++ ) {
+        WeightRandomizer::randomize( 1 + it, filters, dim.filtersSize, -0.1f, 0.1f );
+        filtersWrapper->copyToDevice();
+        fft->forward( batchSize, inputsWrapper, filtersWrapper, 0, outputWrapper );
+        outputWrapper->copyToHost();
+        float *expected = new float[ batchSize * dim.outputCubeSize ];
+        cpu->forward( batchSize, inputs, filters, 0, expected );
+        for( int i = 0; i < batchSize * dim.outputCubeSize; i++ ) {
+            ASSERT_FLOAT_NEAR( expected[i], output[i] );
+        }
+        delete[] expected;
+    }
+    delete inputsWrapper;
+    delete filtersWrapper;
+    delete outputWrapper;
+    delete fft;
+    delete cpu;
+    delete[] output;
+    delete[] filters;
+    delete[] inputs;
+    delete cl;
+}
+
 TEST( testforward, compare_1_n_biased_nopad ) {
     LayerDimensions dim;
     int batchSize = 4;
@@ -567,7 +716,7 @@ TEST( testforward, compare_1_n_biased_nopad ) {
     dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 8 )
         .setFilterSize( 5 )
         .setPadZeros( false ).setBiased( true );
-    for( int instance = 2; instance <= 7; instance++ ) {
+    for( int instance = 2; instance <= 8; instance++ ) {
         if( instance == 5 ) {
             continue; // forwardfc, cant use for inputimagesize != filtersize
         }
@@ -588,7 +737,7 @@ TEST( testforward, compare_1_n_biased_pad ) {
     dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 8 )
         .setFilterSize( 5 )
         .setPadZeros( true ).setBiased( true );
-    for( int instance = 2; instance <= 7; instance++ ) {
+    for( int instance = 2; instance <= 8; instance++ ) {
         if( instance == 5 ) {
             continue; // forwardfc, cant use for inputimagesize != filtersize
         }
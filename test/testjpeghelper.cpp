@@ -5,6 +5,7 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <iostream>
+#include <stdexcept>
 using namespace std;
 
 #include "util/JpegHelper.h"
@@ -44,3 +45,41 @@ TEST( testjpeghelper, writeread ) {
     delete[] data;
 }
 
+
+TEST( testjpeghelper, readscaled ) {
+    // a jpeg twice the size we ask for should come back downscaled, rather
+    // than being rejected
+    int bigSize = 56;
+    int imageSize = 28;
+    uchar *data = new uchar[3 * bigSize * bigSize];
+    for( int plane = 0; plane < 3; plane++ ) {
+        for( int row = 0; row < bigSize; row++ ) {
+            for( int col = 0; col < bigSize; col++ ) {
+                data[ plane * bigSize * bigSize + row * bigSize + col ] = (uchar)( 40 + plane * 30 + row + col );
+            }
+        }
+    }
+    JpegHelper::write("~foo.jpeg", 3, bigSize, bigSize, data );
+    uchar *data2 = new uchar[3 * imageSize * imageSize];
+    JpegHelper::read( "~foo.jpeg", 3, imageSize, imageSize, data2 );
+    bool allOk = true;
+    for( int plane = 0; plane < 3; plane++ ) {
+        for( int row = 0; row < imageSize; row++ ) {
+            for( int col = 0; col < imageSize; col++ ) {
+                int expected = 40 + plane * 30 + row * 2 + col * 2 + 1;
+                int diff = expected - data2[ plane * imageSize * imageSize + row * imageSize + col ];
+                int absdiff = diff > 0 ? diff : - diff;
+                if( absdiff > 20 ) {
+                    allOk = false;
+                }
+            }
+        }
+    }
+    EXPECT_TRUE( allOk );
+
+    // but other sizes are still an error
+    EXPECT_THROW( JpegHelper::read( "~foo.jpeg", 3, 30, 30, data2 ), std::runtime_error );
+
+    delete[] data2;
+    delete[] data;
+}
@@ -0,0 +1,228 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "EasyCL.h"
+#include "clmath/CLDeviceWrapper.h"
+#include "trainers/Adadelta.h"
+#include "trainers/AdadeltaState.h"
+#include "trainers/Adagrad.h"
+#include "trainers/AdagradState.h"
+#include "trainers/Rmsprop.h"
+#include "trainers/RmspropState.h"
+#include "trainers/Nesterov.h"
+#include "trainers/NesterovState.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+// each optimizer's update kernel, against its updateWeightsCpu, over a few
+// steps, on a size that isnt a multiple of the workgroup size
+namespace testoptimizerkernels {
+
+const int N = 1001;
+const int numSteps = 3;
+
+void expectSame(float const *expected, CLDeviceWrapper *wrapper) {
+    float const *actual = wrapper->copyToStaging();
+    for(int i = 0; i < N; i++) {
+        EXPECT_FLOAT_NEAR(expected[i], actual[i]);
+    }
+}
+
+TEST(testoptimizerkernels, adadelta) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    float *weights = new float[N];
+    float *gradWeights = new float[N];
+    float *sumGradSquared = new float[N];
+    float *sumUpdateSquared = new float[N];
+    WeightRandomizer::randomize(0, weights, N, -0.5f, 0.5f);
+    WeightRandomizer::randomize(1, sumGradSquared, N, 0.01f, 1.0f);
+    WeightRandomizer::randomize(2, sumUpdateSquared, N, 0.01f, 1.0f);
+
+    Adadelta *trainer = Adadelta::instance(cl, 0.9f);
+    AdadeltaState *state = new AdadeltaState(cl, N);
+    CLDeviceWrapper *weightsWrapper = new CLDeviceWrapper(cl, N);
+    CLDeviceWrapper *gradWeightsWrapper = new CLDeviceWrapper(cl, N);
+    weightsWrapper->copyFromHost(weights);
+    state->sumGradSquaredWrapper->copyFromHost(sumGradSquared);
+    state->sumUpdateSquaredWrapper->copyFromHost(sumUpdateSquared);
+    for(int step = 0; step < numSteps; step++) {
+        WeightRandomizer::randomize(10 + step, gradWeights, N, -1.0f, 1.0f);
+        gradWeightsWrapper->copyFromHost(gradWeights);
+        trainer->updateWeights(weightsWrapper, gradWeightsWrapper, state);
+        Adadelta::updateWeightsCpu(N, 0.9f, weights, gradWeights, sumGradSquared, sumUpdateSquared);
+    }
+    expectSame(weights, weightsWrapper);
+    expectSame(sumGradSquared, state->sumGradSquaredWrapper);
+    expectSame(sumUpdateSquared, state->sumUpdateSquaredWrapper);
+
+    delete gradWeightsWrapper;
+    delete weightsWrapper;
+    delete state;
+    delete trainer;
+    delete[] sumUpdateSquared;
+    delete[] sumGradSquared;
+    delete[] gradWeights;
+    delete[] weights;
+    delete cl;
+}
+
+TEST(testoptimizerkernels, adagrad) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    float *weights = new float[N];
+    float *gradWeights = new float[N];
+    float *sumSquares = new float[N];
+    WeightRandomizer::randomize(0, weights, N, -0.5f, 0.5f);
+    WeightRandomizer::randomize(1, sumSquares, N, 0.01f, 1.0f);
+
+    Adagrad *trainer = Adagrad::instance(cl, 0.02f);
+    AdagradState *state = new AdagradState(cl, N, 0.000001f);
+    CLDeviceWrapper *weightsWrapper = new CLDeviceWrapper(cl, N);
+    CLDeviceWrapper *gradWeightsWrapper = new CLDeviceWrapper(cl, N);
+    weightsWrapper->copyFromHost(weights);
+    state->sumSquaresWrapper->copyFromHost(sumSquares);
+    for(int step = 0; step < numSteps; step++) {
+        WeightRandomizer::randomize(10 + step, gradWeights, N, -1.0f, 1.0f);
+        gradWeightsWrapper->copyFromHost(gradWeights);
+        trainer->updateWeights(weightsWrapper, gradWeightsWrapper, state);
+        Adagrad::updateWeightsCpu(N, 0.02f, weights, gradWeights, sumSquares);
+    }
+    expectSame(weights, weightsWrapper);
+    expectSame(sumSquares, state->sumSquaresWrapper);
+
+    delete gradWeightsWrapper;
+    delete weightsWrapper;
+    delete state;
+    delete trainer;
+    delete[] sumSquares;
+    delete[] gradWeights;
+    delete[] weights;
+    delete cl;
+}
+
+TEST(testoptimizerkernels, rmsprop) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    float *weights = new float[N];
+    float *gradWeights = new float[N];
+    float *meanSquare = new float[N];
+    WeightRandomizer::randomize(0, weights, N, -0.5f, 0.5f);
+    WeightRandomizer::randomize(1, meanSquare, N, 0.01f, 1.0f);
+
+    Rmsprop *trainer = Rmsprop::instance(cl, 0.01f);
+    RmspropState *state = new RmspropState(cl, N);
+    CLDeviceWrapper *weightsWrapper = new CLDeviceWrapper(cl, N);
+    CLDeviceWrapper *gradWeightsWrapper = new CLDeviceWrapper(cl, N);
+    weightsWrapper->copyFromHost(weights);
+    state->meanSquareWrapper->copyFromHost(meanSquare);
+    for(int step = 0; step < numSteps; step++) {
+        WeightRandomizer::randomize(10 + step, gradWeights, N, -1.0f, 1.0f);
+        gradWeightsWrapper->copyFromHost(gradWeights);
+        trainer->updateWeights(weightsWrapper, gradWeightsWrapper, state);
+        Rmsprop::updateWeightsCpu(N, 0.01f, weights, gradWeights, meanSquare);
+    }
+    expectSame(weights, weightsWrapper);
+    expectSame(meanSquare, state->meanSquareWrapper);
+
+    delete gradWeightsWrapper;
+    delete weightsWrapper;
+    delete state;
+    delete trainer;
+    delete[] meanSquare;
+    delete[] gradWeights;
+    delete[] weights;
+    delete cl;
+}
+
+// loadFutureWeights, then updateWeights, as Nesterov::trainNet does
+TEST(testoptimizerkernels, nesterov) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    float *weights = new float[N];
+    float *gradWeights = new float[N];
+    float *lastUpdate = new float[N];
+    float *oldWeights = new float[N];
+    WeightRandomizer::randomize(0, weights, N, -0.5f, 0.5f);
+    WeightRandomizer::randomize(1, lastUpdate, N, -0.1f, 0.1f);
+
+    Nesterov *trainer = Nesterov::instance(cl, 0.02f, 0.9f);
+    NesterovState *state = new NesterovState(cl, N);
+    CLDeviceWrapper *weightsWrapper = new CLDeviceWrapper(cl, N);
+    CLDeviceWrapper *gradWeightsWrapper = new CLDeviceWrapper(cl, N);
+    weightsWrapper->copyFromHost(weights);
+    state->lastUpdateWrapper->copyFromHost(lastUpdate);
+    for(int step = 0; step < numSteps; step++) {
+        WeightRandomizer::randomize(10 + step, gradWeights, N, -1.0f, 1.0f);
+        gradWeightsWrapper->copyFromHost(gradWeights);
+        trainer->loadFutureWeights(weightsWrapper, gradWeightsWrapper, state);
+        Nesterov::loadFutureWeightsCpu(N, 0.9f, weights, gradWeights, oldWeights);
+
+        WeightRandomizer::randomize(20 + step, gradWeights, N, -1.0f, 1.0f);
+        gradWeightsWrapper->copyFromHost(gradWeights);
+        trainer->updateWeights(weightsWrapper, gradWeightsWrapper, state);
+        Nesterov::updateWeightsCpu(N, 0.02f, 0.9f, weights, gradWeights, lastUpdate, oldWeights);
+    }
+    expectSame(weights, weightsWrapper);
+    expectSame(lastUpdate, state->lastUpdateWrapper);
+    expectSame(oldWeights, state->oldWeightsWrapper);
+
+    delete gradWeightsWrapper;
+    delete weightsWrapper;
+    delete state;
+    delete trainer;
+    delete[] oldWeights;
+    delete[] lastUpdate;
+    delete[] gradWeights;
+    delete[] weights;
+    delete cl;
+}
+
+
+// zero gradients, against state that has decayed to zero, as in the padding
+// of a ParameterArena: the weights should stay at zero, not go to NaN
+TEST(testoptimizerkernels, zerogradients) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    CLDeviceWrapper *weightsWrapper = new CLDeviceWrapper(cl, N);
+    CLDeviceWrapper *gradWeightsWrapper = new CLDeviceWrapper(cl, N);
+    weightsWrapper->fill(0.0f);
+    gradWeightsWrapper->fill(0.0f);
+    float zeros[N];
+    for(int i = 0; i < N; i++) {
+        zeros[i] = 0.0f;
+    }
+
+    Adadelta *adadelta = Adadelta::instance(cl, 0.9f);
+    AdadeltaState *adadeltaState = new AdadeltaState(cl, N);
+    adadeltaState->sumGradSquaredWrapper->fill(0.0f);
+    adadeltaState->sumUpdateSquaredWrapper->fill(0.0f);
+    Adagrad *adagrad = Adagrad::instance(cl, 0.02f);
+    AdagradState *adagradState = new AdagradState(cl, N, 0.0f);
+    Rmsprop *rmsprop = Rmsprop::instance(cl, 0.01f);
+    RmspropState *rmspropState = new RmspropState(cl, N);
+    rmspropState->meanSquareWrapper->fill(0.0f);
+    for(int step = 0; step < numSteps; step++) {
+        adadelta->updateWeights(weightsWrapper, gradWeightsWrapper, adadeltaState);
+        adagrad->updateWeights(weightsWrapper, gradWeightsWrapper, adagradState);
+        rmsprop->updateWeights(weightsWrapper, gradWeightsWrapper, rmspropState);
+    }
+    expectSame(zeros, weightsWrapper);
+
+    delete rmspropState;
+    delete rmsprop;
+    delete adagradState;
+    delete adagrad;
+    delete adadeltaState;
+    delete adadelta;
+    delete gradWeightsWrapper;
+    delete weightsWrapper;
+    delete cl;
+}
+
+}
+
@@ -25,6 +25,8 @@
 #include "test/WeightRandomizer.h"
 
 #include "trainers/SGD.h"
+#include "util/AllocationCounter.h"
+#include "net/ParameterArena.h"
 
 using namespace std;
 
@@ -67,3 +69,116 @@ TEST( testsgd, basic ) {
     delete cl;
 }
 
+TEST( testsgd, noallocationsinsteadystate ) {
+    // input layer and square loss layer are host-side only, so the conv layer
+    // has to wrap their buffers; it should only do that on the first batch
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *net = new NeuralNet( cl, 1, 5 );
+    net->addLayer( ConvolutionalMaker::instance()->numFilters(1)->filterSize(3)->biased(1)->padZeros(0) );
+    net->addLayer( SquareLossMaker::instance() );
+    net->setBatchSize(2);
+
+    // room for the bigger batch, later
+    int inputTotalSize = net->getInputCubeSize() * 4;
+    int outputTotalSize = net->getOutputCubeSize() * 4;
+    float *input = new float[inputTotalSize];
+    float *expectedOutput = new float[outputTotalSize];
+    WeightRandomizer::randomize( 0, input, inputTotalSize, 0.0f, 1.0f );
+    WeightRandomizer::randomize( 1, expectedOutput, outputTotalSize, 0.0f, 1.0f );
+
+    SGD *sgd = new SGD( cl );
+    sgd->setLearningRate( 0.002f );
+    sgd->setMomentum( 0.1f );
+    sgd->setWeightDecay( 0.001f );
+
+    TrainingContext context( 0, 0 );
+    sgd->train( net, &context, input, expectedOutput );
+    AllocationCounter::reset();
+    for( int i = 0; i < 3; i++ ) {
+        sgd->train( net, &context, input, expectedOutput );
+    }
+    EXPECT_EQ( 3, AllocationCounter::getNumBatches() );
+    EXPECT_EQ( 0, AllocationCounter::getNumAllocations() );
+
+    // a bigger batch means new layer buffers, and the counter sees them,
+    // but then it's steady again
+    AllocationCounter::reset();
+    net->setBatchSize(4);
+    sgd->train( net, &context, input, expectedOutput );
+    EXPECT_LT( 0, AllocationCounter::getNumAllocations() );
+    AllocationCounter::reset();
+    sgd->train( net, &context, input, expectedOutput );
+    EXPECT_EQ( 0, AllocationCounter::getNumAllocations() );
+    AllocationCounter::reset();
+
+    delete sgd;
+    delete[] expectedOutput;
+    delete[] input;
+    delete net;
+    delete cl;
+}
+
+TEST( testsgd, parameterarenamatchesperlayer ) {
+    // training with all the weights in one arena should give the same
+    // weights as training with one buffer per layer
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *nets[2];
+    for( int n = 0; n < 2; n++ ) {
+        nets[n] = new NeuralNet( cl, 2, 7 );
+        nets[n]->addLayer( ConvolutionalMaker::instance()->numFilters(3)->filterSize(3)->biased(1)->padZeros(0) );
+        nets[n]->addLayer( ConvolutionalMaker::instance()->numFilters(2)->filterSize(3)->biased(1)->padZeros(0) );
+        nets[n]->addLayer( SquareLossMaker::instance() );
+        nets[n]->setBatchSize(2);
+        for( int layerIdx = 1; layerIdx <= 2; layerIdx++ ) {
+            Layer *layer = nets[n]->getLayer(layerIdx);
+            float *weights = new float[layer->getWeightsSize()];
+            float *bias = new float[layer->getBiasSize()];
+            WeightRandomizer::randomize( layerIdx, weights, layer->getWeightsSize(), -0.1f, 0.1f );
+            WeightRandomizer::randomize( layerIdx + 10, bias, layer->getBiasSize(), -0.1f, 0.1f );
+            layer->initWeights( weights );
+            layer->initBias( bias );
+            delete[] bias;
+            delete[] weights;
+        }
+    }
+    nets[1]->useParameterArena();
+    EXPECT_GT( nets[1]->getParameterArena()->getNumParams(), 0 );
+
+    int inputTotalSize = nets[0]->getInputCubeSize() * 2;
+    int outputTotalSize = nets[0]->getOutputCubeSize() * 2;
+    float *input = new float[inputTotalSize];
+    float *expectedOutput = new float[outputTotalSize];
+    WeightRandomizer::randomize( 0, input, inputTotalSize, 0.0f, 1.0f );
+    WeightRandomizer::randomize( 1, expectedOutput, outputTotalSize, 0.0f, 1.0f );
+
+    SGD *sgd = new SGD( cl );
+    sgd->setLearningRate( 0.01f );
+    sgd->setMomentum( 0.1f );
+    TrainingContext context( 0, 0 );
+    for( int n = 0; n < 2; n++ ) {
+        for( int i = 0; i < 3; i++ ) {
+            sgd->train( nets[n], &context, input, expectedOutput );
+        }
+    }
+    for( int layerIdx = 1; layerIdx <= 2; layerIdx++ ) {
+        Layer *layer = nets[0]->getLayer(layerIdx);
+        Layer *arenaLayer = nets[1]->getLayer(layerIdx);
+        float *weights = layer->getWeights();
+        float *arenaWeights = arenaLayer->getWeights();
+        for( int i = 0; i < layer->getWeightsSize(); i++ ) {
+            EXPECT_FLOAT_NEAR( weights[i], arenaWeights[i] );
+        }
+        float *bias = layer->getBias();
+        float *arenaBias = arenaLayer->getBias();
+        for( int i = 0; i < layer->getBiasSize(); i++ ) {
+            EXPECT_FLOAT_NEAR( bias[i], arenaBias[i] );
+        }
+    }
+
+    delete sgd;
+    delete[] expectedOutput;
+    delete[] input;
+    delete nets[1];
+    delete nets[0];
+    delete cl;
+}
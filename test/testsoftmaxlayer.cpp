@@ -0,0 +1,157 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <cmath>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "net/NeuralNetMould.h"
+#include "layer/LayerMakers.h"
+#include "loss/SoftMaxLayer.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+namespace testsoftmaxlayer {
+
+// checks the device softmax, loss, gradInput and numRight against the same
+// sums on the host, for numVectors vectors of vectorSize values
+void checkAgainstHost(int numVectors, int vectorSize, float const *input, int const *labels,
+        SoftMaxLayer *layer) {
+    float *output = layer->getOutput();
+    double loss = 0;
+    int numRight = 0;
+    int numErrors = 0;
+    for(int v = 0; v < numVectors; v++) {
+        float const *in = input + v * vectorSize;
+        float maxValue = in[0];
+        for(int i = 1; i < vectorSize; i++) {
+            maxValue = std::max(maxValue, in[i]);
+        }
+        float denominator = 0;
+        for(int i = 0; i < vectorSize; i++) {
+            denominator += exp(in[i] - maxValue);
+        }
+        int iMax = 0;
+        for(int i = 0; i < vectorSize; i++) {
+            float expected = exp(in[i] - maxValue) / denominator;
+            if(abs(expected - output[v * vectorSize + i]) > 0.0001f) {
+                numErrors++;
+            }
+            if(expected > exp(in[iMax] - maxValue) / denominator) {
+                iMax = i;
+            }
+        }
+        loss += - log(exp(in[labels[v]] - maxValue) / denominator);
+        if(iMax == labels[v]) {
+            numRight++;
+        }
+    }
+    EXPECT_EQ(0, numErrors);
+    EXPECT_EQ(numRight, layer->calcNumRightFromLabels(labels));
+    float deviceLoss = layer->calcLossFromLabels(labels);
+    cout << "loss " << loss << " device " << deviceLoss << endl;
+    EXPECT_TRUE(abs(deviceLoss - loss) < 0.0001 * loss);
+
+    float *gradInput = layer->getGradInput();
+    numErrors = 0;
+    for(int v = 0; v < numVectors; v++) {
+        for(int i = 0; i < vectorSize; i++) {
+            float expected = output[v * vectorSize + i] - (i == labels[v] ? 1 : 0);
+            if(abs(expected - gradInput[v * vectorSize + i]) > 0.0001f) {
+                numErrors++;
+            }
+        }
+    }
+    EXPECT_EQ(0, numErrors);
+}
+
+TEST(testsoftmaxlayer, percolumn) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    int batchSize = 37;
+    int numPlanes = 10;
+    NeuralNet *net = NeuralNet::maker(cl)->planes(numPlanes)->imageSize(1)->instance();
+    net->addLayer(SoftMaxMaker::instance());
+    net->setBatchSize(batchSize);
+    SoftMaxLayer *layer = dynamic_cast< SoftMaxLayer * >(net->getLastLayer());
+
+    float *input = new float[batchSize * numPlanes];
+    int *labels = new int[batchSize];
+    WeightRandomizer::randomize(input, batchSize * numPlanes, -3.0f, 3.0f);
+    WeightRandomizer::randomizeInts(labels, batchSize, 0, numPlanes);
+
+    net->forward(input);
+    // gradient first, as in training, then loss and numRight, from the same run
+    net->backwardFromLabels(labels);
+    checkAgainstHost(batchSize, numPlanes, input, labels, layer);
+
+    // new labels, same forward, so the kernel runs again
+    for(int n = 0; n < batchSize; n++) {
+        labels[n] = (labels[n] + 1) % numPlanes;
+    }
+    checkAgainstHost(batchSize, numPlanes, input, labels, layer);
+
+    delete[] labels;
+    delete[] input;
+    delete net;
+    delete cl;
+}
+
+TEST(testsoftmaxlayer, perplane) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    int batchSize = 5;
+    int numPlanes = 3;
+    int imageSize = 4;
+    NeuralNet *net = NeuralNet::maker(cl)->planes(numPlanes)->imageSize(imageSize)->instance();
+    net->addLayer(SoftMaxMaker::instance()->perPlane());
+    net->setBatchSize(batchSize);
+    SoftMaxLayer *layer = dynamic_cast< SoftMaxLayer * >(net->getLastLayer());
+
+    const int numVectors = batchSize * numPlanes;
+    const int vectorSize = imageSize * imageSize;
+    float *input = new float[numVectors * vectorSize];
+    int *labels = new int[numVectors];
+    WeightRandomizer::randomize(input, numVectors * vectorSize, -3.0f, 3.0f);
+    WeightRandomizer::randomizeInts(labels, numVectors, 0, vectorSize);
+
+    net->forward(input);
+    // output first this time, so the softmax is done without the labels
+    layer->getOutput();
+    checkAgainstHost(numVectors, vectorSize, input, labels, layer);
+
+    delete[] labels;
+    delete[] input;
+    delete net;
+    delete cl;
+}
+
+TEST(testsoftmaxlayer, badlabel) {
+    EasyCL *cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    NeuralNet *net = NeuralNet::maker(cl)->planes(4)->imageSize(1)->instance();
+    net->addLayer(SoftMaxMaker::instance());
+    net->setBatchSize(2);
+    float input[] = { 1, 2, 3, 4,
+                      4, 3, 2, 1 };
+    int labels[] = { 3, 4 };
+    net->forward(input);
+    bool threw = false;
+    try {
+        net->calcLossFromLabels(labels);
+    } catch(runtime_error &e) {
+        threw = true;
+    }
+    EXPECT_TRUE(threw);
+
+    delete net;
+    delete cl;
+}
+
+}
+
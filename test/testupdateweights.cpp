@@ -12,6 +12,7 @@
 #include "net/NeuralNet.h"
 #include "conv/BackpropWeights.h"
 #include "conv/BackpropWeightsNaive.h"
+#include "conv/Im2ColWorkspace.h"
 #include "layer/Layer.h"
 #include "conv/ConvolutionalLayer.h"
 #include "conv/ConvolutionalMaker.h"
@@ -824,6 +825,46 @@ void compareSpecific(bool debug, float learningRate, int its, int batchSize, Lay
     delete cl;
 }
 
+TEST(testupdateweights, compare_1_4_smallworkspace) {
+    // room to unroll two images at a time, so the batch goes in two full
+    // chunks and a partial one
+    LayerDimensions dim;
+    dim.setInputSize(13).setInputPlanes(4).setNumFilters(6).setFilterSize(5)
+        .setBiased(1).setPadZeros(1);
+    int batchSize = 5;
+    long oldMaxBytes = Im2ColWorkspace::getMaxBytes();
+    Im2ColWorkspace::setMaxBytes(2l * (dim.inputPlanes * dim.filterSizeSquared + dim.numFilters) * dim.outputSizeSquared * 4l);
+    compareSpecific(false, 1.0f, 1, batchSize, dim, 1, 4);
+    Im2ColWorkspace::setMaxBytes(oldMaxBytes);
+}
+
+TEST(testupdateweights, compare_0_4_skip) {
+    LayerDimensions dim;
+    dim.setInputSize(13).setInputPlanes(4).setNumFilters(6).setFilterSize(5)
+        .setBiased(1).setPadZeros(1).setSkip(1);
+    int batchSize = 3;
+    compareSpecific(false, 1.0f, 1, batchSize, dim, 0, 4);
+    dim.setPadZeros(0).setSkip(2);
+    compareSpecific(false, 1.0f, 1, batchSize, dim, 0, 4);
+}
+
+TEST(testupdateweights, compare_0_5_fft) {
+    LayerDimensions dim;
+    dim.setInputSize(13).setInputPlanes(4).setNumFilters(5).setFilterSize(7)
+        .setBiased(1).setPadZeros(1);
+    int batchSize = 5;
+    compareSpecific(false, 1.0f, 1, batchSize, dim, 0, 5);
+    dim.setPadZeros(0);
+    compareSpecific(false, 1.0f, 1, batchSize, dim, 0, 5);
+
+    // two images per chunk, so the sums carry over between chunks
+    dim.setPadZeros(1);
+    long oldMaxBytes = Im2ColWorkspace::getMaxBytes();
+    Im2ColWorkspace::setMaxBytes(2l * 2 * 32 * 32 * (dim.inputPlanes + dim.numFilters) * 4l);
+    compareSpecific(false, 1.0f, 1, batchSize, dim, 0, 5);
+    Im2ColWorkspace::setMaxBytes(oldMaxBytes);
+}
+
 TEST(SLOW_testupdateweights, compare_args) {
     bool debug = false;
     int instance0 = 1;
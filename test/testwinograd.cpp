@@ -0,0 +1,140 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "conv/LayerDimensions.h"
+#include "conv/ForwardCpu.h"
+#include "conv/BackwardCpu.h"
+#include "conv/WinogradCpu.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+// the reference implementation only needs the cpu, so these run anywhere
+// the opencl version is compared against ForwardCpu and BackwardCpu in
+// testforward and testbackward
+
+namespace testwinograd {
+
+void compareForward( LayerDimensions dim, int batchSize ) {
+    int inputsSize = batchSize * dim.inputCubeSize;
+    int outputSize = batchSize * dim.outputCubeSize;
+    float *inputs = new float[inputsSize];
+    float *filters = new float[dim.filtersSize];
+    float *bias = new float[dim.numFilters];
+    WeightRandomizer::randomize( 0, inputs, inputsSize, -0.1f, 0.1f );
+    WeightRandomizer::randomize( 1, filters, dim.filtersSize, -0.1f, 0.1f );
+    for( int i = 0; i < dim.numFilters; i++ ) {
+        bias[i] = 0;
+    }
+
+    ForwardCpu forwardCpu( 0, dim );
+    float *expected = forwardCpu.forward( batchSize, inputs, filters, bias );
+    float *output = new float[outputSize];
+    WinogradCpu::convolve( batchSize, dim.inputPlanes, dim.inputSize, dim.numFilters, dim.outputSize,
+        dim.padZeros ? 1 : 0, false, inputs, filters, output );
+    for( int i = 0; i < outputSize; i++ ) {
+        ASSERT_NEAR( expected[i], output[i], 0.0001f ) << "i=" << i;
+    }
+
+    delete[] output;
+    delete[] expected;
+    delete[] bias;
+    delete[] filters;
+    delete[] inputs;
+}
+
+void compareBackward( LayerDimensions dim, int batchSize ) {
+    int inputsSize = batchSize * dim.inputCubeSize;
+    int gradOutputSize = batchSize * dim.outputCubeSize;
+    float *inputs = new float[inputsSize];
+    float *gradOutput = new float[gradOutputSize];
+    float *filters = new float[dim.filtersSize];
+    WeightRandomizer::randomize( 0, inputs, inputsSize, -0.1f, 0.1f );
+    WeightRandomizer::randomize( 1, gradOutput, gradOutputSize, -0.1f, 0.1f );
+    WeightRandomizer::randomize( 2, filters, dim.filtersSize, -0.1f, 0.1f );
+
+    BackwardCpu backwardCpu( 0, dim );
+    float *expected = backwardCpu.backward( batchSize, inputs, gradOutput, filters );
+    float *gradInput = new float[inputsSize];
+    WinogradCpu::convolve( batchSize, dim.numFilters, dim.outputSize, dim.inputPlanes, dim.inputSize,
+        dim.padZeros ? 1 : 2, true, gradOutput, filters, gradInput );
+    for( int i = 0; i < inputsSize; i++ ) {
+        ASSERT_NEAR( expected[i], gradInput[i], 0.0001f ) << "i=" << i;
+    }
+
+    delete[] gradInput;
+    delete[] expected;
+    delete[] filters;
+    delete[] gradOutput;
+    delete[] inputs;
+}
+
+TEST( testwinograd, transforms_singletile ) {
+    // a 4x4 patch and a 3x3 filter give a 2x2 output tile
+    float d[16];
+    float g[9];
+    for( int i = 0; i < 16; i++ ) {
+        d[i] = (float)( i % 5 ) - 1.5f;
+    }
+    for( int i = 0; i < 9; i++ ) {
+        g[i] = (float)( i % 4 ) * 0.5f - 0.7f;
+    }
+    float U[16];
+    float V[16];
+    float M[16];
+    float Y[4];
+    WinogradCpu::transformFilter( g, U );
+    WinogradCpu::transformInput( d, V );
+    for( int i = 0; i < 16; i++ ) {
+        M[i] = U[i] * V[i];
+    }
+    WinogradCpu::transformOutput( M, Y );
+    for( int row = 0; row < 2; row++ ) {
+        for( int col = 0; col < 2; col++ ) {
+            float sum = 0;
+            for( int r = 0; r < 3; r++ ) {
+                for( int s = 0; s < 3; s++ ) {
+                    sum += d[( row + r ) * 4 + col + s] * g[r * 3 + s];
+                }
+            }
+            EXPECT_NEAR( sum, Y[row * 2 + col], 0.0001f );
+        }
+    }
+}
+
+TEST( testwinograd, forward_vs_cpu ) {
+    LayerDimensions dim;
+    dim.setInputPlanes( 3 ).setInputSize( 9 ).setNumFilters( 4 ).setFilterSize( 3 )
+        .setPadZeros( true ).setBiased( false );
+    compareForward( dim, 2 ); // odd output size, so the last tiles overhang
+    dim.setInputSize( 8 );
+    compareForward( dim, 2 );
+    dim.setPadZeros( false );
+    compareForward( dim, 2 );
+    dim.setInputSize( 9 );
+    compareForward( dim, 2 );
+}
+
+TEST( testwinograd, backward_vs_cpu ) {
+    LayerDimensions dim;
+    dim.setInputPlanes( 3 ).setInputSize( 9 ).setNumFilters( 4 ).setFilterSize( 3 )
+        .setPadZeros( true ).setBiased( false );
+    compareBackward( dim, 2 );
+    dim.setInputSize( 8 );
+    compareBackward( dim, 2 );
+    dim.setPadZeros( false );
+    compareBackward( dim, 2 );
+    dim.setInputSize( 9 );
+    compareBackward( dim, 2 );
+}
+
+}
+